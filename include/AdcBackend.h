@@ -0,0 +1,82 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+#include "AdcDmaSampler.h"
+
+#define ADC_LUT_SIZE         4096   // One entry per 12-bit raw code
+#define ADC_DEFAULT_VREF_MV  1100   // Used by esp_adc_cal when the eFuse has no Vref
+#define MAX_REPLAY_TRACES    8
+
+// Source of raw ADC codes plus the raw -> millivolt table used to convert
+// them. Backends fill the table once in begin(), so converting a sample is
+// one lookup instead of a float division.
+class AdcBackend {
+protected:
+  uint16_t lut[ADC_LUT_SIZE];
+
+  // Ideal linear transfer: 0-4095 = 0-fullScaleMv
+  void buildLinearLut(float fullScaleMv);
+
+public:
+  virtual ~AdcBackend() {}
+
+  virtual void begin() = 0;
+  virtual int readRaw(int pin) = 0;
+  virtual const char* name() const = 0;
+
+  // Up to `count` raw reads of one pin; returns how many were taken. The
+  // default takes blocking reads sampleDelayMs apart.
+  virtual int readSamples(int pin, uint16_t* raw, int count, int sampleDelayMs);
+
+  uint16_t toMillivolts(int raw) const {
+    return lut[raw & (ADC_LUT_SIZE - 1)];
+  }
+};
+
+#ifdef ESP32
+// ADC1 at 11 dB with the table built from esp_adc_cal characterization
+// (eFuse Two Point or Vref when burned in, nominal Vref otherwise), which
+// corrects the gain error and most of the non-linearity of the raw codes.
+class Esp32AdcBackend : public AdcBackend {
+private:
+  const char* source;   // Characterization used for the table
+  bool continuous;      // Requested adc_mode "dma"
+  I2sAdcProducer i2s;
+  AdcDmaSampler dma;
+
+public:
+  Esp32AdcBackend();
+  void setContinuous(bool enabled);   // Before begin()
+  void begin();
+  int readRaw(int pin);
+  int readSamples(int pin, uint16_t* raw, int count, int sampleDelayMs);
+  const char* name() const { return dma.isRunning() ? "esp32-dma" : "esp32"; }
+  const char* getSource() const { return source; }
+  AdcDmaSampler& getDmaSampler() { return dma; }
+};
+#endif
+
+// Recorded raw codes for one ADC pin, read back in order (wraps at the end)
+struct AdcTrace {
+  int pin;
+  const uint16_t* samples;
+  int count;
+  int position;
+};
+
+// Replays recorded traces instead of touching the hardware, so the sensor
+// pipeline can be run off-target against captured data. Conversion uses the
+// ideal linear table (the old 0-4095 = 0-3.3V formula).
+class ReplayAdcBackend : public AdcBackend {
+private:
+  AdcTrace traces[MAX_REPLAY_TRACES];
+  int traceCount;
+
+public:
+  ReplayAdcBackend();
+  bool addTrace(int pin, const uint16_t* samples, int count);
+  void rewind();
+  void begin();
+  int readRaw(int pin);               // 0 for pins without a trace
+  const char* name() const { return "replay"; }
+};
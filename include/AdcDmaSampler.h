@@ -0,0 +1,98 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+#define ADC_DMA_SAMPLE_RATE       20000  // Conversions per second on the active channel
+#define ADC_DMA_BUFFER_LEN        64     // Samples per DMA buffer (3.2 ms at 20 kHz)
+#define ADC_DMA_BUFFER_COUNT      4
+#define ADC_DMA_RING_SIZE         256    // Power of two
+#define ADC_DMA_READ_TIMEOUT_MS   20     // Wait for one DMA buffer before giving up
+#define ADC_DMA_MAX_WINDOW        64     // Largest oversampling window
+#define ADC_DMA_TAG_SHIFT         12     // Samples carry the ADC1 channel in bits 12-15
+#define ADC_DMA_VALUE_MASK        0x0FFF
+
+// Where DMA frames come from. The ESP32 build uses the I2S peripheral in
+// built-in ADC mode; SimulatedAdcProducer stands in for it off-target.
+class AdcDmaProducer {
+public:
+  virtual ~AdcDmaProducer() {}
+  virtual bool start(int sampleRate) = 0;
+  virtual bool setChannel(int adcChannel) = 0;
+  // Copy up to maxWords tagged samples (one DMA buffer); 0 on timeout
+  virtual int fill(uint16_t* words, int maxWords, uint32_t timeoutMs) = 0;
+};
+
+#ifdef ESP32
+class I2sAdcProducer : public AdcDmaProducer {
+private:
+  bool installed;
+
+public:
+  I2sAdcProducer();
+  bool start(int sampleRate);
+  bool setChannel(int adcChannel);
+  int fill(uint16_t* words, int maxWords, uint32_t timeoutMs);
+};
+#endif
+
+// Produces tagged frames from per-channel levels. After a channel switch it
+// first delivers staleBuffers frames still tagged with the old channel, the
+// way real DMA buffers queued before the switch arrive.
+class SimulatedAdcProducer : public AdcDmaProducer {
+private:
+  uint16_t levels[8];
+  int channel;
+  int previousChannel;
+  int staleBuffers;
+  int staleRemaining;
+  int noiseLsb;
+
+public:
+  SimulatedAdcProducer(int staleBuffersAfterSwitch = 1, int noise = 0);
+  void setLevel(int adcChannel, uint16_t raw);
+  bool start(int sampleRate);
+  bool setChannel(int adcChannel);
+  int fill(uint16_t* words, int maxWords, uint32_t timeoutMs);
+};
+
+// Continuous ADC1 acquisition. DMA frames are pushed through feedFrame()
+// into a ring buffer, and each oversampled read takes its window from the
+// ring: samples tagged with another channel, or queued before the current
+// select settled, are dropped instead of averaged. The CPU blocks on the
+// DMA queue rather than spinning in analogRead().
+class AdcDmaSampler {
+private:
+  AdcDmaProducer* producer;
+  uint16_t ring[ADC_DMA_RING_SIZE];
+  unsigned int head;                  // Next write position
+  unsigned int tail;                  // Next read position
+  int activeChannel;                  // ADC1 channel being converted, -1 = none
+  bool running;
+
+  unsigned long framesFed;
+  unsigned long samplesTaken;
+  unsigned long samplesDropped;       // Wrong channel tag or converted before the flush
+  unsigned long overruns;             // Oldest samples overwritten by feedFrame()
+  unsigned long timeouts;
+
+  bool pull(uint32_t timeoutMs);
+
+public:
+  AdcDmaSampler();
+
+  bool begin(AdcDmaProducer* source, int sampleRate = ADC_DMA_SAMPLE_RATE);
+  bool isRunning() const;
+
+  // Seam for the DMA source (and for feeding recorded frames directly)
+  void feedFrame(const uint16_t* words, int count);
+
+  // Route a GPIO's ADC1 channel to the converter; false for non-ADC1 pins
+  bool selectPin(int pin);
+  // Drop everything converted so far, including the partly filled buffer
+  void flush();
+  // Fresh samples for the selected pin's channel; returns how many were taken
+  int takeWindow(int pin, uint16_t* raw, int count);
+
+  int available() const;
+  void printStats();
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+#include "SensorType.h"
+
+#define ALARM_KINDS      2
+#define MAX_ALARM_RULES  (ALARM_KINDS * SENSOR_TYPE_COUNT * MAX_CHANNELS_PER_TYPE)  // One of each per channel
+#define NO_ALARM_RULE    -1
+
+enum AlarmKind : uint8_t {
+  ALARM_RANGE,         // Reading outside the aquarium's normal range
+  ALARM_RATE           // Trend slope (units per minute) beyond its limit
+};
+
+enum AlarmState : uint8_t {
+  ALARM_NORMAL,
+  ALARM_PENDING,       // Out of range, waiting out the raise delay
+  ALARM_ACTIVE,
+  ALARM_CLEARING       // Back inside the hysteresis band, waiting out the clear delay
+};
+
+enum AlarmSide : uint8_t {
+  ALARM_SIDE_NONE,
+  ALARM_SIDE_LOW,
+  ALARM_SIDE_HIGH
+};
+
+// One channel's normal range, compiled from its aquarium's config at boot.
+// A rate rule is a range on the slope, -max..+max per minute.
+struct AlarmRule {
+  uint8_t kind;                               // AlarmKind
+  uint8_t sensorType;                         // Bank tuple order
+  uint8_t channel;
+  int8_t aquarium;
+  float low;
+  float high;
+  float hysteresis;                           // Clears only this far back inside the range
+  unsigned long raiseDelayMs;                 // Out of range this long before it is raised
+  unsigned long clearDelayMs;                 // Back inside this long before it is cleared
+};
+
+struct AlarmStatus {
+  uint8_t state;                              // AlarmState
+  uint8_t side;                               // AlarmSide of the active or pending alarm
+  bool inRange;                               // Last value inside [low, high]
+  bool evaluated;
+  float value;                                // Last value evaluated
+  unsigned long since;                        // millis() the current state was entered
+  unsigned long raisedAt;
+  unsigned long clearedAt;
+  uint32_t raiseCount;
+};
+
+// A raise or clear, kept in a small ring for the API and publishers
+struct AlarmEvent {
+  uint32_t sequence;                          // 1, 2, 3, ... since boot
+  uint16_t rule;
+  uint8_t state;                              // ALARM_ACTIVE (raised) or ALARM_NORMAL (cleared)
+  uint8_t side;
+  float value;
+  unsigned long at;
+};
+
+// Range and rate alarms for every assigned channel, evaluated in the
+// acquisition loop rather than on each HTTP request. Rules live in a flat
+// table with a (kind, type, channel) -> rule index, so a cycle only touches
+// the channels it read, and a channel whose value did not change since the
+// last cycle is skipped unless a raise or clear delay is running. The API
+// reads the stored state and transition times.
+class AlarmEngine {
+private:
+  AlarmRule rules[MAX_ALARM_RULES];
+  AlarmStatus statuses[MAX_ALARM_RULES];
+  int ruleCount;
+  int16_t ruleIndex[ALARM_KINDS][SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  int activeCount;
+  uint32_t evaluations;                       // Rules actually evaluated since boot
+
+  AlarmEvent events[ALARM_EVENT_LOG];
+  uint32_t eventCount;
+
+  void enter(AlarmStatus& status, uint8_t state, unsigned long now);
+  int allocateRule(int kind, int sensorType, int channel);
+  void evaluateRule(int kind, int sensorType, int channel, float value, unsigned long now);
+  void record(int rule, uint8_t state, unsigned long now);
+
+public:
+  AlarmEngine();
+
+  void clear();
+  bool addRule(int sensorType, int channel, int aquarium, float low, float high, float hysteresis,
+               unsigned long raiseDelayMs, unsigned long clearDelayMs);
+  bool addRateRule(int sensorType, int channel, int aquarium, float maxPerMinute, float hysteresis,
+                   unsigned long raiseDelayMs, unsigned long clearDelayMs);
+
+  // New reading or trend slope of one channel; no-op without a rule
+  void evaluate(int sensorType, int channel, float value, unsigned long now);
+  void evaluateRate(int sensorType, int channel, float perMinute, unsigned long now);
+
+  int getRuleCount() const;
+  int findRule(int sensorType, int channel, int kind = ALARM_RANGE) const;   // NO_ALARM_RULE if none
+  const AlarmRule& getRule(int rule) const;
+  const AlarmStatus& getStatus(int rule) const;
+  int getActiveCount() const;
+  bool isAquariumInAlarm(int aquarium) const;
+  uint32_t getEvaluations() const;
+
+  // Events newer than 'sequence' (oldest first, at most max); returns the count
+  int getEventsSince(uint32_t sequence, AlarmEvent* out, int max) const;
+  uint32_t getLastSequence() const;
+
+  static const char* stateName(uint8_t state);
+  static const char* sideName(uint8_t side);
+  static const char* kindName(uint8_t kind);
+};
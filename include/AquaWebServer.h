@@ -16,6 +16,15 @@ private:
   ConfigManager* configManager;
   TemplateManager* templateManager;
   
+  // Calibration capture progress, streamed to the calibration page. The
+  // capture fields are shared with the loop task under the capture lock
+  AsyncEventSource captureEvents;
+  float captureActualValue;             // Reference value of the point being captured
+  float captureTemperature;
+  uint32_t captureEventRevision;        // Capture revision last sent
+  unsigned long lastCaptureEvent;
+  String lastCaptureResult;             // Final event of the last capture, for polling clients
+  
   // Security configuration
   bool enableHTTPS;
   bool requireSecureConnection;
@@ -29,12 +38,23 @@ private:
   void handleApiTDS(AsyncWebServerRequest *request);
   void handleApiStatus(AsyncWebServerRequest *request);
   void handleApiAquariums(AsyncWebServerRequest *request);
+  void handleApiAlarms(AsyncWebServerRequest *request);
   void handleCalibrationPage(AsyncWebServerRequest *request);
   void handleCalibrationStatus(AsyncWebServerRequest *request);
   void handleStartCalibration(AsyncWebServerRequest *request);
   void handleAddCalibrationPoint(AsyncWebServerRequest *request);
   void handleFinalizeCalibration(AsyncWebServerRequest *request);
   void handleCalibrationReading(AsyncWebServerRequest *request);
+  void handleSessionStatus(AsyncWebServerRequest *request);
+  void handleSessionStart(AsyncWebServerRequest *request);
+  void handleSessionPoint(AsyncWebServerRequest *request);
+  void handleSessionFinalize(AsyncWebServerRequest *request);
+  void handleSessionCancel(AsyncWebServerRequest *request);
+  void handleStartCapture(AsyncWebServerRequest *request);
+  void handleCaptureStatus(AsyncWebServerRequest *request);
+  void handleCancelCapture(AsyncWebServerRequest *request);
+  void fillCaptureStatus(JsonDocument& doc);
+  void updateCapture();
   void handleHelpPage(AsyncWebServerRequest *request);
   void handleDiagnosticsPage(AsyncWebServerRequest *request);
   void handleAdminPage(AsyncWebServerRequest *request);
@@ -69,4 +89,5 @@ public:
   void setSensorController(SensorController* sensors);
   void setCalibrationManager(CalibrationManager* calibration);
   void setConfigManager(ConfigManager* config);
+  void update();                        // Call every loop(): capture progress and results
 };
\ No newline at end of file
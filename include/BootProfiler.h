@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define BOOT_PROFILER_MAX_PHASES 16
+
+// One timed step of setup()
+struct BootPhase {
+  const char* name;
+  unsigned long startMicros;
+  unsigned long durationMicros;
+};
+
+class BootProfiler {
+private:
+  BootPhase phases[BOOT_PROFILER_MAX_PHASES];
+  int phaseCount;
+  int openPhase;          // Index of the phase currently running, -1 if none
+  bool fastBoot;
+
+  // Milestones, in microseconds since reset (0 = not reached yet)
+  unsigned long bootCompleteMicros;
+  unsigned long firstSampleMicros;
+  unsigned long firstResponseMicros;
+  unsigned long wifiConnectedMicros;
+
+public:
+  BootProfiler();
+
+  void setFastBoot(bool enabled);
+  bool isFastBoot() const;
+
+  // Phase timing (phases are sequential, beginning a new one ends the previous)
+  void beginPhase(const char* name);
+  void endPhase();
+
+  // Milestones (only the first call of each is recorded)
+  void markBootComplete();
+  void markFirstSample();
+  void markFirstHttpResponse();
+  void markWifiConnected();
+
+  unsigned long getBootTimeMs() const;
+  unsigned long getTimeToFirstSampleMs() const;
+  unsigned long getTimeToFirstResponseMs() const;
+  unsigned long getTimeToWifiMs() const;
+
+  // Reporting
+  void printReport();
+  void addToJson(JsonObject obj);
+};
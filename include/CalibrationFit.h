@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+
+#define CAL_MAX_POINTS       5                      // Reference points per pH/TDS calibration
+#define CAL_MAX_POLY_ORDER   3
+#define CAL_MAX_SEGMENTS     (CAL_MAX_POINTS - 1)
+
+// Calibration point structure
+struct CalibrationPoint {
+  float rawValue;      // ADC reading or voltage
+  float actualValue;   // Known reference value
+  float temperature;   // Temperature during calibration (for compensation)
+  bool valid;          // Whether this calibration point is valid
+};
+
+enum CalibrationCurveType : uint8_t {
+  CURVE_LINEAR,        // Least-squares line through all points
+  CURVE_PIECEWISE,     // Straight segments between neighbouring points
+  CURVE_POLYNOMIAL     // Least-squares polynomial, order up to CAL_MAX_POLY_ORDER
+};
+
+// A fitted raw -> value curve in the form it is evaluated in. Linear and
+// polynomial fits are Horner coefficients, so a line costs one multiply-add
+// as before; piecewise fits keep a slope and offset per segment, found by
+// comparing against at most CAL_MAX_SEGMENTS - 1 knots.
+struct CalibrationCurve {
+  uint8_t type;
+  uint8_t order;                              // Polynomial order (1 for linear)
+  uint8_t segments;                           // Piecewise segment count
+  float poly[CAL_MAX_POLY_ORDER + 1];         // c0 + c1*raw + c2*raw^2 + c3*raw^3
+  float knots[CAL_MAX_SEGMENTS - 1];          // Raw value where segment k+1 starts
+  float segSlope[CAL_MAX_SEGMENTS];
+  float segOffset[CAL_MAX_SEGMENTS];
+
+  float evaluate(float raw) const {
+    if (type == CURVE_PIECEWISE) {
+      int k = 0;
+      while (k < segments - 1 && raw >= knots[k]) k++;
+      return segSlope[k] * raw + segOffset[k];
+    }
+    float value = poly[order];
+    for (int i = order - 1; i >= 0; i--) {
+      value = value * raw + poly[i];
+    }
+    return value;
+  }
+
+  void setLinear(float slope, float offset);
+  void scale(float factor);                   // Multiply every output by factor
+  float getSlope() const;                     // Slope at the first segment / linear term
+  float getOffset() const;
+};
+
+// How well a curve matches the points it was fitted to
+struct CalibrationFitQuality {
+  float r2;                                   // 1 = exact, 1 for a single distinct value
+  float rmsResidual;
+  float maxResidual;                          // Largest |actual - fitted|
+};
+
+namespace CalibrationFit {
+  // Fit points (valid entries only) with the given curve type; false if the
+  // points cannot support it (fewer than 2 distinct raw values)
+  bool fit(uint8_t type, const CalibrationPoint* points, int count, CalibrationCurve& curve);
+  CalibrationFitQuality quality(const CalibrationCurve& curve, const CalibrationPoint* points, int count);
+
+  uint8_t parseType(const String& name);      // Unknown names fall back to linear
+  const char* typeName(uint8_t type);
+}
@@ -2,14 +2,13 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include "Config.h"
+#include "CalibrationFit.h"
+#include "CalibrationTable.h"
+#include "CalibrationStore.h"
 
-// Calibration point structure
-struct CalibrationPoint {
-  float rawValue;      // ADC reading or voltage
-  float actualValue;   // Known reference value
-  float temperature;   // Temperature during calibration (for compensation)
-  bool valid;          // Whether this calibration point is valid
-};
+#define CAL_LEGACY_JSON_FILE    "/calibration.json"
+#define CAL_IMPORTED_JSON_FILE  "/calibration.json.imported"
 
 // Temperature sensor calibration data
 struct TemperatureCalibration {
@@ -24,11 +23,10 @@ struct TemperatureCalibration {
 
 // pH sensor calibration data  
 struct PHCalibration {
-  CalibrationPoint point1;  // pH 4.01 buffer
-  CalibrationPoint point2;  // pH 6.86 buffer (optional for 2-point)
-  CalibrationPoint point3;  // pH 9.18 buffer
-  float slope;              // Calculated slope
-  float offset;             // Calculated offset
+  CalibrationPoint points[CAL_MAX_POINTS];  // Buffers in capture order (e.g. pH 4.01, 6.86, 9.18)
+  int pointCount;
+  CalibrationCurve curve;   // Fitted curve, type chosen when the calibration starts
+  CalibrationFitQuality fit;  // R2 and residuals of the curve against the points
   float tempCoeff;          // Temperature compensation coefficient
   bool isCalibrated;        // Whether calibration is complete
   String calibrationDate;   // When calibration was performed
@@ -37,22 +35,35 @@ struct PHCalibration {
 
 // TDS sensor calibration data
 struct TDSCalibration {
-  CalibrationPoint point1;  // Low standard (84 or 1413 µS/cm)
-  CalibrationPoint point2;  // High standard (12,880 µS/cm)
+  CalibrationPoint points[CAL_MAX_POINTS];  // Conductivity standards (84, 1413, 12,880 uS/cm, ...)
+  int pointCount;
+  CalibrationCurve curve;   // Fitted raw -> EC curve
+  CalibrationFitQuality fit;
   float kFactor;            // K-factor for TDS calculation
-  float slope;              // Calculated slope for EC
-  float offset;             // Calculated offset for EC
   float tempCoeff;          // Temperature compensation coefficient (2%/°C typical)
   bool isCalibrated;        // Whether calibration is complete
   String calibrationDate;   // When calibration was performed
   String notes;             // Calibration notes
 };
 
-// Complete sensor calibration data
+// Complete sensor calibration data (sized for the most channels a type can have)
 struct SensorCalibrationData {
-  TemperatureCalibration temperature[8];  // One per temperature sensor
-  PHCalibration ph[8];                    // One per pH sensor
-  TDSCalibration tds[8];                  // One per TDS sensor
+  TemperatureCalibration temperature[MAX_CHANNELS_PER_TYPE];  // One per temperature sensor
+  PHCalibration ph[MAX_CHANNELS_PER_TYPE];                     // One per pH sensor
+  TDSCalibration tds[MAX_CHANNELS_PER_TYPE];                   // One per TDS sensor
+};
+
+// Several sensors of one type calibrated together in the same reference
+// solution: each point is captured for all of them from one scan cycle and
+// the results are committed in a single store write
+struct CalibrationSession {
+  bool active;
+  uint8_t sensorType;                         // CalibrationSensorType
+  int channels[MAX_CHANNELS_PER_TYPE];
+  int channelCount;
+  int pointCount;
+  uint32_t lastCycle;                         // Scan cycle the last point was captured from
+  bool fitted[MAX_CHANNELS_PER_TYPE];         // Per channel: fitted and on flash after the last finalize
 };
 
 class CalibrationManager {
@@ -60,11 +71,60 @@ private:
   SensorCalibrationData calibrationData;
   bool dataLoaded;
   
+  // Binary records on flash; finalize commits only the sensor that changed
+  CalibrationStore store;
+  unsigned long lastLoadMicros;
+  size_t importedJsonBytes;               // Size of the migrated JSON file, 0 if none
+  
+  bool importJsonCalibration();
+  bool commitRecord(uint8_t sensorType, int sensorIndex);
+  void packRecord(uint8_t sensorType, int sensorIndex, CalibrationRecord& record);
+  void unpackRecord(const CalibrationRecord& record);
+  
+  CalibrationSession session;
+  
+  // Calibration steps without the commit, shared by finalize and sessions
+  bool fitTemperatureCalibration(int sensorIndex);
+  bool fitPHCalibration(int sensorIndex);
+  bool fitTDSCalibration(int sensorIndex);
+  // Clear one sensor for a new calibration; the caller compiles the table
+  bool resetTemperatureCalibration(int sensorIndex, const String& notes);
+  bool resetPHCalibration(int sensorIndex, const String& notes, uint8_t curveType);
+  bool resetTDSCalibration(int sensorIndex, const String& notes, uint8_t curveType);
+  bool resetCalibration(uint8_t sensorType, int sensorIndex, const String& notes, uint8_t curveType);
+  void restoreSessionChannels();   // Session channels back to what is on flash
+  bool fitCalibration(uint8_t sensorType, int sensorIndex);
+  void compileTable(uint8_t sensorType);
+  
+  // Coefficients the acquisition loop applies, rebuilt whenever a calibration changes
+  CalibrationTableSet temperatureTable;
+  CalibrationTableSet phTable;
+  CalibrationTableSet tdsTable;
+  
+  void compileTemperatureTable();
+  void compilePHTable();
+  void compileTDSTable();
+  void compileTables();
+  
+  // Configured channels per type - limits status output, storage covers all
+  int tempSensorCount;
+  int phSensorCount;
+  int tdsSensorCount;
+  
   // Helper methods
   float calculateSlope(const CalibrationPoint& p1, const CalibrationPoint& p2);
   float calculateOffset(const CalibrationPoint& p1, float slope);
   String getCurrentDateTime();
   
+  // N-point pH/TDS helpers
+  bool addPoint(CalibrationPoint* points, int& pointCount, float rawValue, float actualValue, float temperature);
+  bool fitCurve(CalibrationPoint* points, int pointCount, CalibrationCurve& curve, CalibrationFitQuality& fit);
+  void loadPoints(JsonObject source, CalibrationPoint* points, int& pointCount);
+  void restoreCurve(uint8_t type, float slope, float offset, CalibrationPoint* points, int pointCount,
+                    CalibrationCurve& curve, CalibrationFitQuality& fit);
+  void addFitStatus(JsonObject target, const CalibrationPoint* points, int pointCount,
+                    const CalibrationCurve& curve, const CalibrationFitQuality& fit);
+  
 public:
   CalibrationManager();
   
@@ -72,6 +132,14 @@ public:
   bool begin();
   bool loadCalibrationData();
   bool saveCalibrationData();
+  void setSensorCounts(int temperature, int ph, int tds);
+  
+  // Compiled coefficients per type (same results as getCalibrated*). For
+  // the acquisition loop only: each call takes the latest table, and the
+  // previous one may be reused for the next publish
+  const CalibrationTable& getTemperatureTable();
+  const CalibrationTable& getPHTable();
+  const CalibrationTable& getTDSTable();
   
   // Temperature sensor calibration
   bool startTemperatureCalibration(int sensorIndex, const String& notes = "");
@@ -81,20 +149,36 @@ public:
   bool isTemperatureCalibrated(int sensorIndex);
   
   // pH sensor calibration
-  bool startPHCalibration(int sensorIndex, const String& notes = "");
+  bool startPHCalibration(int sensorIndex, const String& notes = "", uint8_t curveType = CURVE_LINEAR);
   bool addPHCalibrationPoint(int sensorIndex, float rawValue, float actualPH, float temperature = 25.0);
   bool finalizePHCalibration(int sensorIndex);
   float getCalibratedPH(int sensorIndex, float rawValue, float temperature = 25.0);
   bool isPHCalibrated(int sensorIndex);
   
   // TDS sensor calibration
-  bool startTDSCalibration(int sensorIndex, const String& notes = "");
+  bool startTDSCalibration(int sensorIndex, const String& notes = "", uint8_t curveType = CURVE_LINEAR);
   bool addTDSCalibrationPoint(int sensorIndex, float rawValue, float actualEC, float temperature = 25.0);
   bool finalizeTDSCalibration(int sensorIndex);
   float getCalibratedTDS(int sensorIndex, float rawValue, float temperature = 25.0);
   float getCalibratedEC(int sensorIndex, float rawValue, float temperature = 25.0);
   bool isTDSCalibrated(int sensorIndex);
   
+  // Point for any sensor type (CalibrationSensorType), e.g. from a stability capture
+  bool addCalibrationPoint(uint8_t sensorType, int sensorIndex, float rawValue, float actualValue, float temperature);
+  
+  // Batched calibration of several sensors of one type
+  bool startSession(uint8_t sensorType, const int* channels, int count, const String& notes = "",
+                    uint8_t curveType = CURVE_LINEAR);
+  // rawValues[i] belongs to the session's i-th channel, all from scan cycle 'cycle'
+  int addSessionPoint(const float* rawValues, uint32_t cycle, float actualValue, float temperature = 25.0);
+  // Sensors calibrated, -1 if the store write failed part way; either way
+  // getSession().fitted shows which channels reached flash
+  int finalizeSession();
+  void cancelSession();
+  const CalibrationSession& getSession() const;
+  String getSessionStatus();
+  static int parseSensorType(const String& sensorType);  // -1 if unknown
+  
   // Calibration status and information
   void printCalibrationStatus();
   void printSensorCalibration(const String& sensorType, int sensorIndex);
@@ -130,5 +214,5 @@ namespace CalibrationStandards {
   
   // Default temperature compensation coefficients
   constexpr float TEMP_COEFF_PH = 0.02;      // pH units per °C
-  constexpr float TEMP_COEFF_EC = 0.02;      // 2% per °C
+  constexpr float TEMP_COEFF_EC = TDS_TEMP_COEFF;  // 2% per °C
 }
\ No newline at end of file
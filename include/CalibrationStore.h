@@ -0,0 +1,90 @@
+#pragma once
+#include <Arduino.h>
+#include "FS.h"
+#include "Config.h"
+#include "CalibrationFit.h"
+#include "SensorType.h"
+
+#define CAL_STORE_FILE       "/calibration.bin"
+#define CAL_STORE_VERSION    1
+#define CAL_RECORD_MAGIC     0x4C43         // "CL"
+#define CAL_SENSOR_TYPES     SENSOR_TYPE_COUNT
+#define CAL_DATE_LENGTH      20
+#define CAL_NOTES_LENGTH     40
+#define CAL_NO_SLOT          0xFF
+
+// Record types are the shared sensor types, so records index like every other per-type table
+enum CalibrationSensorType : uint8_t {
+  CAL_TYPE_TEMPERATURE = SENSOR_TEMPERATURE,
+  CAL_TYPE_PH = SENSOR_PH,
+  CAL_TYPE_TDS = SENSOR_TDS
+};
+
+struct CalibrationRecordPoint {
+  float raw;
+  float actual;
+  float temperature;
+};
+
+// One sensor's calibration as stored on flash. Only the inputs are kept;
+// curves are refitted from the points on load.
+struct CalibrationRecord {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t sensorType;                         // CalibrationSensorType
+  uint8_t channel;
+  uint8_t calibrated;
+  uint8_t curveType;
+  uint8_t pointCount;
+  uint32_t sequence;                          // Newer record wins, set by the store
+  float slope;                                // Temperature line; pH/TDS fallback when refitting fails
+  float offset;
+  float tempCoeff;
+  float kFactor;
+  CalibrationRecordPoint points[CAL_MAX_POINTS];
+  char date[CAL_DATE_LENGTH];
+  char notes[CAL_NOTES_LENGTH];
+  uint32_t crc;                               // CRC-32 of every byte above
+};
+
+// Fixed-size binary records in one SPIFFS file, two slots per sensor.
+// A write goes to the slot not holding the sensor's current record, so a
+// power loss mid-write leaves the previous record intact; on load the
+// valid slot with the higher sequence number wins. A commit writes only
+// the records that changed.
+class CalibrationStore {
+private:
+  uint32_t sequences[CAL_SENSOR_TYPES][MAX_CHANNELS_PER_TYPE];   // Of the current record
+  uint8_t activeSlots[CAL_SENSOR_TYPES][MAX_CHANNELS_PER_TYPE];  // CAL_NO_SLOT = nothing stored
+  File loadFile;
+  unsigned long bytesWritten;                 // Since boot
+  unsigned long lastWriteBytes;
+  unsigned long lastWriteMicros;
+
+  static size_t slotOffset(int sensorType, int channel, int slot);
+  static bool isValid(const CalibrationRecord& record, int sensorType, int channel);
+
+public:
+  CalibrationStore();
+
+  static uint32_t crc32(const uint8_t* data, size_t length);
+  static size_t fileSize();
+
+  bool exists();
+  bool create();                              // Empty store, every slot invalid
+
+  // Load: beginLoad(), loadRecord() per sensor, endLoad()
+  bool beginLoad();
+  bool loadRecord(int sensorType, int channel, CalibrationRecord& record);
+  void endLoad();
+
+  // Stamp, checksum and write records to their inactive slots in one file
+  // open; returns the number written. Each record is flushed on its own, so
+  // a failure part way leaves the earlier ones committed: 'committed', when
+  // given, gets the outcome of each record.
+  int write(CalibrationRecord* records, int count, bool* committed = nullptr);
+
+  unsigned long getBytesWritten() const;
+  unsigned long getLastWriteBytes() const;
+  unsigned long getLastWriteMicros() const;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "Config.h"
+#include "CalibrationFit.h"
+
+// Calibration of one channel reduced to plain coefficients:
+//   value = curve(raw) / (1 + scaleTempCoeff * dT) - offsetTempCoeff * dT
+// with dT = temperature - CAL_REFERENCE_TEMP (Config.h). pH compensates with
+// offsetTempCoeff and EC/TDS with scaleTempCoeff; uncalibrated channels are
+// the identity line with no temperature terms.
+struct ChannelCoefficients {
+  CalibrationCurve curve;   // Linear, piecewise or polynomial (see CalibrationFit.h)
+  float offsetTempCoeff;
+  float scaleTempCoeff;
+  bool calibrated;          // False for the identity
+};
+
+struct CalibrationTable {
+  ChannelCoefficients channels[MAX_CHANNELS_PER_TYPE];
+  uint32_t version;         // Bumped on every publish
+  int calibratedCount;
+
+  float apply(int channel, float raw, float temperature) const {
+    const ChannelCoefficients& c = channels[channel];
+    float dT = temperature - CAL_REFERENCE_TEMP;
+    return c.curve.evaluate(raw) / (1.0f + c.scaleTempCoeff * dT) - c.offsetTempCoeff * dT;
+  }
+
+  bool isCalibrated(int channel) const {
+    return channels[channel].calibrated;
+  }
+
+  void setIdentity(int channel) {
+    channels[channel].curve.setLinear(1.0, 0.0);
+    channels[channel].offsetTempCoeff = 0.0;
+    channels[channel].scaleTempCoeff = 0.0;
+    channels[channel].calibrated = false;
+  }
+};
+
+// Triple-buffered table for one sensor type, shared by one writer task
+// (calibration requests) and one reader task (the acquisition loop). Each
+// side owns one buffer, and the third is the hand-over slot. The writer
+// fills its buffer and swaps it into the slot. acquire() swaps the slot
+// for the reader's buffer when a newer table is waiting. Neither side ever
+// touches the buffer the other holds, so the loop applies one complete
+// table for a whole cycle, however often tables are published meanwhile,
+// and neither side waits.
+class CalibrationTableSet {
+private:
+  static const uint8_t FRESH = 0x04;  // Hand-over slot holds a table the reader has not taken
+  CalibrationTable buffers[3];
+  std::atomic<uint8_t> handover;      // Buffer index | FRESH
+  uint8_t front;                      // Reader's buffer
+  uint8_t writing;                    // Writer's buffer
+  uint32_t published;
+
+public:
+  CalibrationTableSet() : handover(1), front(0), writing(2), published(0) {
+    for (int b = 0; b < 3; b++) {
+      for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+        buffers[b].setIdentity(i);
+      }
+      buffers[b].version = 0;
+      buffers[b].calibratedCount = 0;
+    }
+  }
+
+  // Reader: latest published table, valid until the reader's next acquire()
+  const CalibrationTable& acquire() {
+    if (handover.load(std::memory_order_relaxed) & FRESH) {
+      front = handover.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    }
+    return buffers[front];
+  }
+
+  // Writer: buffer to fill completely before publish()
+  CalibrationTable& back() {
+    return buffers[writing];
+  }
+
+  void publish() {
+    buffers[writing].version = ++published;
+    writing = handover.exchange(writing | FRESH, std::memory_order_acq_rel) & ~FRESH;
+  }
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+enum EstimatorMode {
+  ESTIMATOR_NONE,     // Publish the filtered reading as is
+  ESTIMATOR_KALMAN,   // Scalar Kalman filter, random-walk process model
+  ESTIMATOR_EWMA      // Exponential smoothing, optionally with an adaptive gain
+};
+
+struct EstimatorConfig {
+  EstimatorMode mode;
+  float processNoise;       // Kalman q: variance the true value drifts by per reading
+  float measurementNoise;   // Kalman r / EWMA step threshold: variance of one reading
+  float alpha;              // EWMA gain for small innovations
+  bool adaptive;            // EWMA: raise the gain for innovations beyond 2 sigma
+};
+
+// Per-channel estimator state (fixed size, no allocation)
+struct ChannelEstimate {
+  float value;
+  float variance;           // Estimated variance of value
+  float innovation;         // EWMA: smoothed squared innovation
+  bool initialized;
+};
+
+// O(1) per reading. Kalman: p += q; k = p / (p + r); x += k (z - x);
+// p *= (1 - k). EWMA: x += a (z - x), with a raised towards 1 for
+// innovations well outside the measurement noise so real steps are
+// followed quickly while jitter is smoothed.
+class ChannelEstimator {
+private:
+  EstimatorConfig config;
+
+public:
+  ChannelEstimator();
+
+  void configure(const EstimatorConfig& estimatorConfig);
+  const EstimatorConfig& getConfig() const { return config; }
+  bool isEnabled() const { return config.mode != ESTIMATOR_NONE; }
+
+  static void reset(ChannelEstimate& state);
+  float update(ChannelEstimate& state, float measurement) const;
+
+  static EstimatorMode parseMode(const String& name);
+  static const char* modeName(EstimatorMode mode);
+};
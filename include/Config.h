@@ -7,6 +7,12 @@
 #define DEFAULT_WIFI_SSID "dilbert"
 #define DEFAULT_WIFI_PASSWORD "windfall1969"
 
+// Default WiFi reconnect timing (fallback only)
+#define DEFAULT_WIFI_BACKOFF_MIN_MS      1000   // First retry delay after a failed attempt
+#define DEFAULT_WIFI_BACKOFF_MAX_MS      60000  // Backoff cap
+#define DEFAULT_WIFI_CONNECT_TIMEOUT_MS  10000  // Give up on a single attempt after this
+#define WIFI_RSSI_SAMPLE_INTERVAL        2000   // Link quality sampling period (ms)
+
 // Default hardware pin definitions (fallback only)  
 #define DEFAULT_LED_PIN 2
 
@@ -21,12 +27,101 @@
 #define DEFAULT_MUX_S2          18  // Control pin 2
 #define DEFAULT_MUX_S3          19  // Control pin 3
 #define DEFAULT_MUX_EN          21  // Enable pin (LOW = enabled)
+#define DEFAULT_ADC_MODE        "oneshot"  // "oneshot" (analogRead) or "dma" (continuous I2S)
 
 // Default sensor configuration (fallback only)
+#define SENSOR_TYPE_COUNT         3   // Temperature, pH, TDS (SensorType.h)
+#define MUX_CHANNEL_CAPACITY      16  // CD74HC4067 channels per multiplexer
+#define MAX_MUX_BANKS_PER_TYPE    2   // Multiplexers one sensor type can span
+#define MAX_MUX_BANKS             (SENSOR_TYPE_COUNT * MAX_MUX_BANKS_PER_TYPE)  // Every bank serves one sensor type
+#define MAX_CHANNELS_PER_TYPE     (MUX_CHANNEL_CAPACITY * MAX_MUX_BANKS_PER_TYPE)  // Per-type storage size
 #define DEFAULT_NUM_TEMP_SENSORS  8
 #define DEFAULT_NUM_PH_SENSORS    8
 #define DEFAULT_NUM_TDS_SENSORS   8
 
+// Temperature compensation. Compensated readings are referred to
+// CAL_REFERENCE_TEMP; conductivity is divided by (1 + coeff * dT) on both
+// the calibrated and the uncalibrated path
+#define CAL_REFERENCE_TEMP        25.0
+#define TDS_TEMP_COEFF            0.02  // Conductivity change per degree C, share of the reference value
+
+// Per-type sample filter (sensors.filters.<type>), see SampleFilter.h for the other defaults
+#define DEFAULT_FILTER_MODE           "mean"
+
+// Per-type state estimator (sensors.estimators.<type>)
+#define DEFAULT_ESTIMATOR_MODE              "none"  // "none", "kalman" or "ewma"
+#define DEFAULT_ESTIMATOR_PROCESS_NOISE     0.0001
+#define DEFAULT_ESTIMATOR_MEASUREMENT_NOISE 0.01
+#define DEFAULT_ESTIMATOR_ALPHA             0.3
+#define DEFAULT_ESTIMATOR_ADAPTIVE          true
+
+// Mux settle time auto-tuning (sensors.settle_tuning)
+#define DEFAULT_SETTLE_AUTO_TUNE      false
+#define DEFAULT_SETTLE_TOLERANCE_LSB  8      // Max ADC difference between the t and 2t reads
+#define DEFAULT_SETTLE_MAX_US         20000  // Upper bound for a learned settle time
+#define DEFAULT_SETTLE_RECHECK_MIN    60     // Re-measure a channel after this many minutes
+#define SETTLE_MIN_RECHECK_MIN        1      // Lower bound, 0 would re-measure every cycle
+#define SETTLE_MAX_DUTY_PERCENT       5      // Share of loop time measurements may take
+#define SETTLE_MIN_US                 20     // First probe after the switch
+#define SETTLE_MAX_STORED_US          60000  // Learned times are stored as uint16_t
+#define SETTLE_PROBE_READS            4      // ADC reads averaged per probe
+#define SETTLE_MARGIN_PERCENT         25     // Added to the measured time
+
+// Adaptive per-channel sampling (sensors.sampling), base periods and change
+// thresholds default to the sensor trait's SAMPLE_PERIOD_MS and rateChangeThreshold()
+#define DEFAULT_SAMPLING_ADAPTIVE       false
+#define DEFAULT_SAMPLING_ALARM_MARGIN   0.1    // Share of the normal range width counted as near a limit
+#define SAMPLING_MIN_DIVISOR            4      // Default min_ms = base_ms / 4
+#define SAMPLING_MAX_MULTIPLIER         6      // Default max_ms = base_ms * 6
+#define SAMPLING_FLAT_READS             3      // Quiet reads before a period is doubled
+#define SAMPLING_FLAT_FRACTION          0.25   // Change below this share of the threshold is quiet
+#define SAMPLING_MIN_TICK_MS            250    // Fastest scan tick
+
+// Stability-gated calibration capture (calibration.capture), per-type
+// stdev/drift limits default to the sensor trait's captureMaxStdev()
+#define DEFAULT_CAPTURE_INTERVAL_MS   50     // Read period of the boosted channel
+#define DEFAULT_CAPTURE_WINDOW        20     // Reads per stability window
+#define DEFAULT_CAPTURE_TIMEOUT_S     180    // Give up on a probe that never settles
+#define CAPTURE_EVENT_INTERVAL_MS     250    // Progress events to the calibration page
+
+// Range alarms (alarms, per aquarium under sensors.<type>.alarm), compiled
+// into rules at boot from each aquarium's normal_range
+#define DEFAULT_ALARM_HYSTERESIS_PERCENT  5      // Of the range width, back inside it to clear
+#define DEFAULT_ALARM_RAISE_S             10     // Out of range this long before raising
+#define DEFAULT_ALARM_CLEAR_S             30     // Back inside the band this long before clearing
+#define ALARM_EVENT_LOG                   16     // Recent raises and clears kept for the API
+
+// Trend (rate-of-change) alarms (alarms.rate), per-type limits default to
+// the sensor trait's maxRatePerMinute()
+#define DEFAULT_TREND_WINDOW_S            300    // Readings the slope is fitted over
+#define TREND_WINDOW_SAMPLES              12     // Stored readings per channel
+#define TREND_MIN_SAMPLES                 4      // Fewer than this, no slope
+#define TREND_MAX_PROJECTION_S            604800 // Crossings further out are not reported
+
+// MQTT telemetry (mqtt), off unless enabled with a broker host
+#define DEFAULT_MQTT_ENABLED          false
+#define DEFAULT_MQTT_PORT             1883
+#define DEFAULT_MQTT_CLIENT_ID        "aqua-monitor"
+#define DEFAULT_MQTT_BASE_TOPIC       "aqua"
+#define DEFAULT_MQTT_BATCH            "node"  // "node" (one message per epoch) or "aquarium" (one each)
+#define DEFAULT_MQTT_TELEMETRY_QOS    0
+#define DEFAULT_MQTT_ALARM_QOS        1
+#define DEFAULT_MQTT_MIN_INTERVAL_S   10      // Telemetry at most this often; epochs between are skipped
+#define DEFAULT_MQTT_KEEPALIVE_S      30
+#define MQTT_TIMEOUT_MS               1000    // Wait for CONNACK / PUBACK
+#define MQTT_RECONNECT_MIN_MS         2000
+#define MQTT_RECONNECT_MAX_MS         60000
+#define MQTT_DRAIN_BURST              4       // Queued messages sent per drain pass
+#define MQTT_DRAIN_INTERVAL_MS        200     // Between drain passes
+#define MQTT_OUTBOX_LENGTH            8       // Messages built by loop() waiting for the publisher task
+#define MQTT_TASK_STACK               6144    // Bytes
+#define MQTT_TASK_PRIORITY            1
+#define MQTT_TASK_PERIOD_MS           50      // Task wakes at least this often for keepalive and the drain
+#define MQTT_QUEUE_FILE               "/mqtt_queue.bin"
+#define MQTT_QUEUE_SLOTS              32      // Messages kept while the broker is unreachable
+#define MQTT_TOPIC_LENGTH             96
+#define MQTT_PAYLOAD_LENGTH           1024
+
 // Compatibility constants (for existing code)
 #define NUM_TEMP_SENSORS  8
 #define NUM_PH_SENSORS    8
@@ -57,6 +152,7 @@
 #define DEFAULT_SERIAL_BAUD_RATE  115200
 #define DEFAULT_SENSOR_READ_DELAY 5000  // 5 seconds between readings
 #define DEFAULT_PRINT_INTERVAL 5000     // 5 seconds between serial prints
+#define DEFAULT_FAST_BOOT         false // Skip mux self-test, Serial wait and blocking WiFi connect
 
 // ========================================
 // HTTPS/SSL Configuration
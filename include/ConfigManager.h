@@ -18,12 +18,16 @@ public:
   // WiFi configuration
   String getWifiSSID();
   String getWifiPassword();
+  unsigned long getWifiBackoffMin();
+  unsigned long getWifiBackoffMax();
+  unsigned long getWifiConnectTimeout();
   
   // System configuration
   String getDeviceName();
   int getSerialBaud();
   int getSensorReadInterval();
   int getPrintInterval();
+  bool getFastBoot();
   
   // NO ICONS policy configuration
   bool getUseIcons();
@@ -35,6 +39,54 @@ public:
   int getTemperatureCount();
   int getPHCount();
   int getTDSCount();
+  String getFilterMode(const String& sensorType);
+  int getFilterSamples(const String& sensorType, int defaultSamples);
+  int getFilterWindow(const String& sensorType);
+  int getFilterTrimPercent(const String& sensorType);
+  String getEstimatorMode(const String& sensorType);
+  float getEstimatorProcessNoise(const String& sensorType);
+  float getEstimatorMeasurementNoise(const String& sensorType);
+  float getEstimatorAlpha(const String& sensorType);
+  bool getEstimatorAdaptive(const String& sensorType);
+  bool getSettleAutoTune();
+  int getSettleToleranceLsb();
+  unsigned long getSettleMaxUs();
+  unsigned long getSettleRecheckMinutes();
+  bool getSamplingAdaptive();
+  float getSamplingAlarmMargin();
+  unsigned long getSamplingBaseMs(const String& sensorType, unsigned long defaultMs);
+  unsigned long getSamplingMinMs(const String& sensorType, unsigned long defaultMs);
+  unsigned long getSamplingMaxMs(const String& sensorType, unsigned long defaultMs);
+  float getSamplingChangeThreshold(const String& sensorType, float defaultThreshold);
+  
+  // Calibration capture (calibration.capture)
+  unsigned long getCaptureIntervalMs();
+  int getCaptureWindow();
+  unsigned long getCaptureTimeoutSeconds();
+  float getCaptureMaxStdev(const String& sensorType, float defaultStdev);
+  float getCaptureMaxDrift(const String& sensorType, float defaultDrift);
+  
+  // Range alarms (alarms, overridden per aquarium by sensors.<type>.alarm)
+  float getAlarmHysteresisPercent();
+  unsigned long getAlarmRaiseSeconds(int aquariumIndex, const String& sensorType);
+  unsigned long getAlarmClearSeconds(int aquariumIndex, const String& sensorType);
+  float getAlarmHysteresis(int aquariumIndex, const String& sensorType, float defaultHysteresis);
+  unsigned long getTrendWindowSeconds();
+  float getAlarmMaxRate(int aquariumIndex, const String& sensorType, float defaultPerMinute);
+  
+  // MQTT telemetry (mqtt)
+  bool getMqttEnabled();
+  String getMqttHost();
+  int getMqttPort();
+  String getMqttClientId();
+  String getMqttUsername();
+  String getMqttPassword();
+  String getMqttBaseTopic();
+  String getMqttBatch();
+  int getMqttTelemetryQos();
+  int getMqttAlarmQos();
+  unsigned long getMqttMinIntervalSeconds();
+  int getMqttKeepAliveSeconds();
   
   // Hardware configuration
   int getLedPin();
@@ -46,6 +98,16 @@ public:
   int getMuxS2();
   int getMuxS3();
   int getMuxEnable();
+  String getAdcMode();
+  
+  // Multiplexer banks (hardware.mux_banks, empty = classic 3-bank layout)
+  int getMuxBankCount();
+  String getMuxBankType(int index);
+  int getMuxBankEnable(int index);
+  int getMuxBankAdcPin(int index);
+  bool hasMuxBankAddress(int index);
+  int getMuxBankAddressPin(int index, int line);
+  int getMuxBankSettleUs(int index);
   
   // Security configuration
   String getAdminUsername();
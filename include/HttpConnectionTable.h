@@ -0,0 +1,103 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include "HttpRequestParser.h"
+
+#define MAX_HTTP_CONNECTIONS         4       // Connection table size (HTTP + HTTPS)
+#define HTTP_REQUEST_TIMEOUT_MS      5000    // Drop clients that stall mid-request or mid-handshake
+#define HTTP_IDLE_TIMEOUT_MS         15000   // Close idle keep-alive connections
+#define HTTP_MAX_KEEPALIVE_REQUESTS  100     // Requests served before closing a connection
+#define HTTP_WRITE_CHUNK             1024    // Max bytes written per connection per pass
+
+enum class ConnectionState {
+  FREE,       // Slot unused
+  HANDSHAKE,  // HTTPS only: TLS handshake in progress
+  READING,    // Waiting for (the rest of) a request
+  WRITING,    // Sending the queued response
+  CLOSING     // Response sent, close on the next pass
+};
+
+// One slot of the connection table. Each pass of handleClients() does at most
+// one bulk read and one bounded write per slot, so a slow or stalled client
+// never holds up the others or the sensor loop.
+struct HttpConnection {
+  WiFiClient client;
+  int slot;                   // Index in the table, for per-slot state kept by the owner
+  bool isSecure;
+  ConnectionState state;
+  HttpRequestParser parser;
+  String response;            // Pending response bytes
+  size_t responseSent;
+  bool keepAlive;
+  unsigned long lastActivity;
+  unsigned long requestStarted;
+  unsigned int requestsServed;
+};
+
+// Connection table counters
+struct HttpServerStats {
+  unsigned long accepted;
+  unsigned long requests;
+  unsigned long keepAliveReuses;  // Requests served on an already-used connection
+  unsigned long timeouts;
+  unsigned long parseErrors;
+  int activeConnections;
+  int peakConnections;
+};
+
+// What the table needs from the server that owns it: the TLS layer for
+// secure connections and the routes. Return values follow TlsConnection:
+// continueHandshake() is 1 when done, 0 to call again, -1 on failure; the
+// reads and writes return bytes moved, 0 for nothing yet, -1 on failure.
+class HttpConnectionHandler {
+public:
+  virtual ~HttpConnectionHandler() {}
+
+  virtual bool beginSecure(HttpConnection& conn) = 0;
+  virtual int continueHandshake(HttpConnection& conn, unsigned long now) = 0;
+  virtual int secureRead(HttpConnection& conn, uint8_t* buf, size_t len) = 0;
+  virtual int secureWrite(HttpConnection& conn, const uint8_t* buf, size_t len) = 0;
+  virtual void endSecure(HttpConnection& conn) = 0;
+
+  // A complete request is in conn.parser; answer it with sendResponse()
+  virtual void handleRequest(HttpConnection& conn) = 0;
+};
+
+// Fixed table of client connections shared by the HTTP and HTTPS listeners.
+// Sockets are only touched through WiFiClient, so the table runs on the
+// host against the test shim.
+class HttpConnectionTable {
+private:
+  HttpConnection connections[MAX_HTTP_CONNECTIONS];
+  HttpConnectionHandler* handler;
+  HttpServerStats stats;
+
+  HttpConnection* findFreeSlot();
+  void acceptClients(WiFiServer& plain, WiFiServer* secure, unsigned long now);
+  void openConnection(HttpConnection& conn, bool isSecure, unsigned long now);
+  void closeConnection(HttpConnection& conn);
+  void serviceConnection(HttpConnection& conn, unsigned long now);
+  void continueHandshake(HttpConnection& conn, unsigned long now);
+  void readRequest(HttpConnection& conn, unsigned long now);
+  void writeResponse(HttpConnection& conn, unsigned long now);
+  void finishResponse(HttpConnection& conn);
+  int connectionRead(HttpConnection& conn, uint8_t* buf, size_t len);
+  int connectionWrite(HttpConnection& conn, const uint8_t* buf, size_t len);
+
+  static void addSecurityHeaders(String& headers);
+
+public:
+  HttpConnectionTable();
+
+  void setHandler(HttpConnectionHandler* connectionHandler);
+
+  // Accept from the listeners (secure is null while HTTPS is off) and
+  // service every open connection once. Non-blocking.
+  void handleClients(WiFiServer& plain, WiFiServer* secure, unsigned long now);
+
+  // Queue a response on conn; writeResponse() sends it in chunks
+  void sendResponse(HttpConnection& conn, int code, const String& contentType, const String& content);
+
+  const HttpServerStats& getStats() const;
+  static const char* statusText(int code);
+};
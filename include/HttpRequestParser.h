@@ -0,0 +1,107 @@
+#pragma once
+#include <Arduino.h>
+
+// Incremental HTTP/1.1 request parser with a fixed per-connection buffer.
+// Socket data is read straight into the buffer (writePtr/commit) and parsed
+// in place: delimiters are replaced by '\0' so every accessor returns a
+// pointer into the buffer. Nothing is allocated on the heap.
+
+#define HTTP_MAX_REQUEST_SIZE  2048   // Request line + headers + body
+#define HTTP_MAX_HEADERS       16     // Headers kept for lookup (extra ones are skipped)
+
+enum class HttpParseState {
+  REQUEST_LINE,
+  HEADERS,
+  BODY,
+  COMPLETE,
+  ERROR
+};
+
+enum class HttpMethod {
+  UNKNOWN,
+  GET,
+  HEAD,
+  POST,
+  PUT,
+  DELETE,
+  OPTIONS
+};
+
+class HttpRequestParser {
+private:
+  struct Header {
+    const char* name;
+    const char* value;
+  };
+
+  char buffer[HTTP_MAX_REQUEST_SIZE];
+  size_t received;     // Bytes in buffer
+  size_t scanPos;      // Start of the next unparsed line
+  size_t bodyStart;
+  size_t requestEnd;   // Offset just past this request (pipelined data follows)
+
+  HttpParseState state;
+  int errorStatus;     // HTTP status to answer with when state == ERROR
+
+  HttpMethod method;
+  const char* methodText;
+  const char* path;
+  const char* query;
+  bool http11;
+  bool keepAliveRequested;
+  bool closeRequested;
+  size_t contentLength;
+
+  Header headers[HTTP_MAX_HEADERS];
+  int headerCount;
+
+  void parse();
+  bool parseRequestLine(char* line);
+  bool parseHeaderLine(char* line);
+  void fail(int status);
+  void clearRequest();
+  char* nextLine();
+
+  static HttpMethod methodFromText(const char* text);
+  static bool equalsIgnoreCase(const char* a, const char* b);
+
+public:
+  HttpRequestParser();
+
+  void reset();
+
+  // Bulk input: read from the socket directly into the parser
+  char* writePtr();
+  size_t writeSpace() const;
+  void commit(size_t bytes);
+
+  // Convenience copy-in for callers that already hold the data
+  size_t feed(const uint8_t* data, size_t len);
+
+  // Drop the completed request and keep any pipelined bytes that followed it
+  void consumeRequest();
+
+  // Parse status
+  HttpParseState getState() const { return state; }
+  bool isComplete() const { return state == HttpParseState::COMPLETE; }
+  bool hasError() const { return state == HttpParseState::ERROR; }
+  bool isIdle() const { return received == 0; }
+  int getErrorStatus() const { return errorStatus; }
+
+  // Request data (valid until reset/consumeRequest)
+  HttpMethod getMethod() const { return method; }
+  const char* getMethodText() const { return methodText; }
+  const char* getPath() const { return path; }
+  const char* getQuery() const { return query; }
+  bool isHttp11() const { return http11; }
+  bool keepAlive() const;
+  int getHeaderCount() const { return headerCount; }
+  const char* getHeader(const char* name) const;
+  const char* getBody() const;
+  size_t getBodyLength() const;
+
+  // URL-decoded parameter lookup in the query string or a form-encoded body
+  bool getQueryParam(const char* name, char* out, size_t outLen) const;
+  bool getFormParam(const char* name, char* out, size_t outLen) const;
+  static bool findParam(const char* src, size_t srcLen, const char* name, char* out, size_t outLen);
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "Config.h"
+#include "ConfigManager.h"
+#include "SensorController.h"
+#include "MqttTransport.h"
+#include "MqttQueue.h"
+
+// Publishes readings and alarms to an MQTT broker:
+//  - <base>/<client>/telemetry, one batched message per acquisition epoch
+//    (or <base>/<client>/aquarium/<id>/telemetry, one per aquarium), at
+//    most every min_interval_s with the telemetry QoS
+//  - <base>/<client>/alarm, one message per raise or clear as soon as the
+//    alarm engine records it, with the alarm QoS
+//  - <base>/<client>/status, retained "online", and "offline" as the will
+// A message the broker cannot take goes to the persistent queue, as does
+// any telemetry while older messages are still queued and any alarm while
+// older alarms are, so each keeps its order. Queued alarms are sent first.
+// Once connected the queue is drained in bursts of MQTT_DRAIN_BURST,
+// MQTT_DRAIN_INTERVAL_MS apart, one message in flight at a time, and a
+// failed send stops the drain and reconnects with backoff.
+// loop() only builds messages and hands them to the outbox. Connecting,
+// publishing (with its PUBACK wait) and the queue run on the publisher's
+// own task, so a slow broker never holds up the sensor scan.
+class MqttPublisher {
+private:
+  ConfigManager* config;
+  SensorController* sensors;
+#ifdef ESP32
+  ArduinoMqttTransport arduinoTransport;
+#else
+  PosixMqttTransport posixTransport;
+#endif
+  MqttTransport* transport;                   // arduinoTransport (posixTransport off-target) unless replaced
+  MqttQueue queue;
+
+  // Settings, read once from config
+  bool enabled;
+  String host;
+  int port;
+  String clientId;
+  String username;
+  String password;
+  String topicPrefix;                         // <base>/<client>
+  String statusTopic;
+  bool perAquarium;
+  uint8_t telemetryQos;
+  uint8_t alarmQos;
+  unsigned long minIntervalMs;
+
+  // Connection, owned by the publisher task
+  volatile bool linkUp;                       // Set by update()
+  volatile bool online;
+  unsigned long nextConnectAt;
+  unsigned long reconnectDelayMs;
+
+  // What has been handed to the outbox
+  uint32_t lastCycle;
+  unsigned long lastTelemetryAt;
+  uint32_t lastAlarmSequence;
+  unsigned long lastDrainAt;
+
+  // Statistics since boot
+  uint32_t published;
+  uint32_t queuedCount;
+  uint32_t failedCount;
+  uint32_t connects;
+  uint32_t oversized;
+  uint32_t outboxFull;                        // Telemetry skipped because the task was behind
+
+  MqttMessage building;                       // loop() side: message being built
+  MqttMessage message;                        // Task side: message being sent or drained
+#ifdef ESP32
+  QueueHandle_t outbox;                       // building -> message, MQTT_OUTBOX_LENGTH deep
+  static void taskEntry(void* publisher);
+#endif
+
+  void maintainConnection(bool linkUp, unsigned long now);
+  void markOffline(unsigned long now);
+  bool handOver();                            // building to the task, false if the outbox is full
+  void service(unsigned long now);            // Task body: connection, routing, drain
+  bool send();
+  void publishAlarms();
+  void publishTelemetry(unsigned long now);
+  bool buildMessage(const String& topic, JsonDocument& doc, uint8_t qos, bool retained, bool urgent);
+  void addAquarium(JsonObject target, int aquarium);
+  void drain(unsigned long now);
+
+public:
+  MqttPublisher();
+
+  void setTransport(MqttTransport* replacement);   // Before begin(), e.g. a host transport
+  void begin(ConfigManager* configManager, SensorController* sensorController);
+  void update(bool wifiUp, unsigned long now);     // Every loop(); wifiUp = WiFi connected, never blocks
+
+  bool isEnabled() const;
+  bool isOnline() const;
+  int getQueued() const;
+  void addToJson(JsonObject target) const;
+};
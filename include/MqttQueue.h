@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+#include "MqttStorage.h"
+
+#define MQTT_RECORD_MAGIC   0x514D         // "MQ"
+#define MQTT_FLAG_RETAINED  0x01
+#define MQTT_FLAG_URGENT    0x02
+
+// One message as it is published or queued
+struct MqttMessage {
+  char topic[MQTT_TOPIC_LENGTH];
+  char payload[MQTT_PAYLOAD_LENGTH];
+  uint16_t length;
+  uint8_t qos;
+  bool retained;
+  bool urgent;                                // Alarm: sent ahead of queued telemetry
+};
+
+// Slot header on flash, followed by the topic and payload bytes
+struct MqttRecordHeader {
+  uint16_t magic;                             // 0 = free slot
+  uint8_t qos;
+  uint8_t flags;                              // MQTT_FLAG_*
+  uint16_t topicLength;
+  uint16_t payloadLength;
+  uint32_t sequence;                          // Publish order, continues across reboots
+  uint32_t crc;                               // CRC-32 of the header above, topic and payload
+};
+
+#define MQTT_SLOT_BYTES  (sizeof(MqttRecordHeader) + MQTT_TOPIC_LENGTH + MQTT_PAYLOAD_LENGTH)
+
+// Store-and-forward queue for messages the broker could not take, in
+// fixed-size slots of one MqttStorage region (a SPIFFS file on the ESP32)
+// so it survives a reboot. A small RAM
+// index (sequence and QoS per slot) is rebuilt from the slot headers at
+// boot. Urgent messages (alarms) are sent first, oldest first, then the
+// rest in sequence order, so alarms keep their order among themselves and
+// telemetry among itself. A message's body is written
+// before its header, so a write cut short by power loss leaves a free
+// slot, and a corrupt record is dropped when it reaches the front. When
+// every slot is taken the oldest QoS 0 message makes room, or the oldest
+// message of all if there is none.
+class MqttQueue {
+private:
+#ifdef ESP32
+  SpiffsMqttStorage spiffsStorage;
+#endif
+  MqttStorage* storage;                       // spiffsStorage unless replaced with setStorage()
+  uint32_t sequences[MQTT_QUEUE_SLOTS];       // 0 = free
+  uint8_t qosLevels[MQTT_QUEUE_SLOTS];
+  bool urgentSlots[MQTT_QUEUE_SLOTS];
+  uint32_t nextSequence;
+  int used;
+  int urgentUsed;
+  bool ready;
+  uint32_t dropped;                           // Evicted or unreadable since boot
+
+  int findOldest(bool qos0Only, bool urgentOnly) const;
+  int findFront() const;                      // Slot peek() and pop() work on
+  int findFree() const;
+  bool freeSlot(int slot);
+
+public:
+  MqttQueue();
+  void setStorage(MqttStorage* replacement);  // Before begin(), e.g. MemoryMqttStorage
+
+  bool begin();                               // Open or create the storage, rebuild the index
+  bool push(const MqttMessage& message);
+  bool peek(MqttMessage& message);            // Oldest message, false if empty
+  bool pop();                                 // Remove the message peek() returned
+
+  int size() const;
+  int urgentCount() const;
+  int capacity() const;
+  bool isEmpty() const;
+  uint32_t getDropped() const;
+};
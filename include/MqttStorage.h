@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+// Byte store behind the MQTT queue: one fixed-size region addressed by
+// offset. Kept separate from the queue so a host build can run the queue
+// against memory instead of SPIFFS.
+class MqttStorage {
+public:
+  virtual ~MqttStorage() {}
+
+  // Open the region, creating it zero-filled (created = true) if it is
+  // missing or shorter than size
+  virtual bool begin(size_t size, bool& created) = 0;
+  virtual bool read(size_t offset, void* data, size_t length) = 0;
+  virtual bool write(size_t offset, const void* data, size_t length) = 0;
+  virtual bool flush() = 0;                   // Writes so far reach the medium before later ones
+  virtual const char* name() const = 0;
+};
+
+#ifdef ESP32
+#include "FS.h"
+
+// One SPIFFS file, kept open between calls
+class SpiffsMqttStorage : public MqttStorage {
+private:
+  const char* path;
+  File file;
+
+  bool create(size_t size);
+
+public:
+  SpiffsMqttStorage(const char* filePath);
+  bool begin(size_t size, bool& created);
+  bool read(size_t offset, void* data, size_t length);
+  bool write(size_t offset, const void* data, size_t length);
+  bool flush();
+  const char* name() const { return path; }
+};
+#endif
+
+// Heap buffer, kept across begin() calls so a test can restart the queue
+// over the same bytes as a reboot would
+class MemoryMqttStorage : public MqttStorage {
+private:
+  uint8_t* bytes;
+  size_t capacity;
+
+public:
+  MemoryMqttStorage();
+  ~MemoryMqttStorage();
+  bool begin(size_t size, bool& created);
+  bool read(size_t offset, void* data, size_t length);
+  bool write(size_t offset, const void* data, size_t length);
+  bool flush() { return true; }
+  const char* name() const { return "memory"; }
+  uint8_t* data() { return bytes; }          // Raw bytes, e.g. to corrupt a record
+  size_t size() const { return capacity; }
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+#define MQTT_PACKET_BUFFER  (MQTT_TOPIC_LENGTH + MQTT_PAYLOAD_LENGTH + 32)   // One PUBLISH with headers
+
+// Connection to one MQTT broker. publish() returns once the message is
+// written (QoS 0) or acknowledged with PUBACK (QoS 1), so a caller sending
+// one message at a time never has more than one in flight. Kept separate
+// from the publisher so a host build can run it against a local broker.
+class MqttTransport {
+public:
+  virtual ~MqttTransport() {}
+
+  virtual void begin(const char* host, int port, int keepAliveSeconds) = 0;
+  // Clean session; the will is published retained with QoS 1 if the link dies
+  virtual bool connect(const char* clientId, const char* username, const char* password,
+                       const char* willTopic, const char* willPayload) = 0;
+  virtual bool connected() = 0;
+  virtual bool publish(const char* topic, const char* payload, int length, bool retained, int qos) = 0;
+  virtual void loop() = 0;                    // Keepalive and incoming acks
+  virtual void disconnect() = 0;
+  virtual const char* name() const = 0;
+};
+
+#ifdef ESP32
+#include <WiFi.h>
+#include <MQTT.h>
+
+// arduino-mqtt (lwmqtt) over a plain WiFiClient
+class ArduinoMqttTransport : public MqttTransport {
+private:
+  WiFiClient net;
+  MQTTClient client;
+
+public:
+  ArduinoMqttTransport();
+  void begin(const char* host, int port, int keepAliveSeconds);
+  bool connect(const char* clientId, const char* username, const char* password,
+               const char* willTopic, const char* willPayload);
+  bool connected();
+  bool publish(const char* topic, const char* payload, int length, bool retained, int qos);
+  void loop();
+  void disconnect();
+  const char* name() const { return "arduino-mqtt"; }
+};
+#else
+// MQTT 3.1.1 over a blocking POSIX socket, for host builds and the native
+// tests. Only what the publisher uses: CONNECT with a will, PUBLISH at QoS
+// 0 or 1, PINGREQ. Packets are built in one fixed buffer.
+class PosixMqttTransport : public MqttTransport {
+private:
+  const char* host;
+  int port;
+  int keepAliveSeconds;
+  int fd;                                     // -1 = not connected
+  uint16_t packetId;
+  unsigned long lastSent;
+  uint8_t packet[MQTT_PACKET_BUFFER + 5];     // Fixed header (up to 5 bytes) + body
+
+  bool sendPacket(uint8_t type, size_t bodyLength);
+  bool readExact(uint8_t* data, size_t length);
+  bool readPacket(uint8_t& type, size_t& bodyLength);
+  void closeSocket();
+
+public:
+  PosixMqttTransport();
+  ~PosixMqttTransport();
+  void begin(const char* host, int port, int keepAliveSeconds);
+  bool connect(const char* clientId, const char* username, const char* password,
+               const char* willTopic, const char* willPayload);
+  bool connected();
+  bool publish(const char* topic, const char* payload, int length, bool retained, int qos);
+  void loop();
+  void disconnect();
+  const char* name() const { return "posix"; }
+};
+#endif
@@ -2,13 +2,79 @@
 #include <Arduino.h>
 #include "Config.h"
 
+#define MUX_ADDRESS_LINES  4   // S0-S3
+
+// S0-S3 lines of one address bus with the GPIO masks for every channel,
+// precomputed so a select is one or two register writes
+struct MuxAddressBus {
+  int pins[MUX_ADDRESS_LINES];
+  bool registerWrite;                           // All pins below GPIO32 (OUT_W1TS/W1TC)
+  uint32_t setMask[MUX_CHANNEL_CAPACITY];       // Lines HIGH for the channel
+  uint32_t clearMask[MUX_CHANNEL_CAPACITY];     // Lines LOW for the channel
+};
+
+// One CD74HC4067. Banks either share the common S0-S3 address bus or have
+// their own address lines; the enable pin may be shared by banks that are
+// always read together, and banks may share an ADC pin as long as their
+// enable pins differ.
+struct MuxBank {
+  int enablePin;                        // Active LOW
+  int adcPin;                           // ADC1 pin the SIG output is wired to
+  MuxAddressBus ownBus;                 // Own address lines (unused on the shared bus)
+  bool sharedAddress;
+  int channel;                          // Currently selected channel, -1 = unknown
+  bool enabled;
+  unsigned long selectedAt;             // micros() of the last address/enable change
+  unsigned long settleUs;               // Settle time override, 0 = sensor type default
+};
+
 class MultiplexerController {
 private:
   bool initialized;
-  
+  MuxBank banks[MAX_MUX_BANKS];
+  int bankCount;
+  MuxAddressBus sharedBus;
+  int sharedChannel;                    // Channel on the shared bus, -1 = unknown
+  unsigned long selectCount;            // Address changes
+  unsigned long edgeCount;              // Address and enable line transitions
+
+  void buildMasks(MuxAddressBus& bus, const int* pins);
+  int writeAddress(const MuxAddressBus& bus, int from, int to);
+  void setEnabled(int bank, bool enabled);
+  bool sharesAddress(int a, int b) const;
+
 public:
   MultiplexerController();
-  void begin();
-  void selectChannel(int channel);
+
+  // Bank setup - call before begin()
+  void setSharedAddressPins(int s0, int s1, int s2, int s3);
+  int addBank(int enablePin, int adcPin, const int* addressPins = nullptr);
+  void setSettleTime(int bank, unsigned long settleUs);
+
+  void begin(bool runSelfTest = true);
+
+  // Route one bank's channel to its ADC pin; returns true if any line changed
+  bool select(int bank, int channel);
+  // Wait until the settle time has passed since the bank's last change;
+  // the bank's own settle time wins over defaultSettleUs when set
+  void waitSettled(int bank, unsigned long defaultSettleUs);
+  // Wait until settleUs have passed since the bank's last change (no override)
+  void waitSettledFor(int bank, unsigned long settleUs);
+  // True if selecting nextChannel on nextBank leaves currentBank's signal path alone
+  bool canPreselect(int currentBank, int nextBank, int nextChannel) const;
+
+  // Channel visited at step `position` of a scan: Gray code, so consecutive
+  // steps differ in one address line (0, 1, 3, 2, 6, 7, 5, 4, ...)
+  static int scanChannel(int position) {
+    return position ^ (position >> 1);
+  }
+
+  int getBankCount() const;
+  int getAdcPin(int bank) const;
+  unsigned long getSelectCount() const;
+  unsigned long getEdgeCount() const;
+
+  void selectChannel(int channel);      // Same channel on every bank
   void printChannelInfo(int channel);
-};
\ No newline at end of file
+  void printBanks();
+};
@@ -1,20 +1,111 @@
 #pragma once
 #include <Arduino.h>
 #include <WiFi.h>
+#include <ArduinoJson.h>
 #include "Config.h"
-#include "ConfigManager.h"
+#include "RetryBackoff.h"
+
+#define NETWORK_EVENT_QUEUE_SIZE 8
+
+// Connection state machine
+enum class NetworkState {
+  IDLE,        // Not started
+  CONNECTING,  // WiFi.begin() issued, waiting for an IP
+  CONNECTED,   // Link up with an IP address
+  BACKOFF      // Last attempt failed or link dropped, waiting to retry
+};
+
+// WiFi events the state machine reacts to (decoupled from the Arduino event ids
+// so a scripted source can drive handleEvent() directly)
+enum class NetworkEvent {
+  STA_CONNECTED,
+  GOT_IP,
+  DISCONNECTED,
+  LOST_IP
+};
+
+// Credentials and timing, filled from ConfigManager by the caller
+struct WiFiSettings {
+  String ssid;
+  String password;
+  unsigned long backoffMinMs = DEFAULT_WIFI_BACKOFF_MIN_MS;
+  unsigned long backoffMaxMs = DEFAULT_WIFI_BACKOFF_MAX_MS;
+  unsigned long connectTimeoutMs = DEFAULT_WIFI_CONNECT_TIMEOUT_MS;
+};
+
+// Link quality statistics
+struct LinkStats {
+  int rssi;                      // Last sampled RSSI (dBm)
+  int rssiMin;
+  int rssiMax;
+  float rssiAvg;                 // Exponential moving average
+  unsigned long connects;        // Successful connections (including reconnects)
+  unsigned long disconnects;     // Link drops after being connected
+  unsigned long failedAttempts;  // Attempts that timed out or were rejected
+  unsigned long fastReconnects;  // Connections made using the cached BSSID/channel
+  uint8_t lastDisconnectReason;  // 802.11 reason code
+  unsigned long lastConnectMs;   // Time from link loss (or attempt start) to IP
+  unsigned long connectedSince;  // millis() when the current link came up
+  unsigned long totalConnectedMs;
+};
 
 class NetworkManager {
 private:
   bool isConnected;
-  ConfigManager* configMgr;
-  
+  bool configured;               // begin() has been given the settings
+  WiFiSettings settings;
+
+  // State machine
+  NetworkState state;
+  unsigned long stateSince;      // millis() when the current state was entered
+  unsigned long nextAttemptAt;   // millis() of the next retry while in BACKOFF
+  unsigned long disconnectedAt;  // millis() when the link dropped, 0 if never connected
+  int failureStreak;             // Consecutive failed attempts, drives the backoff
+  bool justConnected;            // Set on GOT_IP, consumed by update()
+
+  // Cached access point for fast reconnect
+  uint8_t cachedBSSID[6];
+  int cachedChannel;
+  bool hasCachedAP;
+  bool attemptUsedCache;
+
+  LinkStats stats;
+  unsigned long lastRssiSample;
+
+  // Events arrive on the WiFi task and are consumed in update() on the loop task
+  struct PendingEvent {
+    NetworkEvent event;
+    uint8_t reason;
+  };
+  PendingEvent eventQueue[NETWORK_EVENT_QUEUE_SIZE];
+  volatile uint8_t eventHead;
+  volatile uint8_t eventTail;
+  portMUX_TYPE eventLock;
+
+  void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
+  void queueEvent(NetworkEvent event, uint8_t reason);
+  bool popEvent(PendingEvent& out);
+
+  void startAttempt(unsigned long now);
+  void scheduleRetry(unsigned long now);
+  void enterState(NetworkState newState, unsigned long now);
+  void sampleLinkQuality(unsigned long now);
+
 public:
   NetworkManager();
-  void begin(ConfigManager* config);
-  bool connect();
+  void begin(const WiFiSettings& wifi);
+  bool connect();        // Blocking connect used by the normal boot path
+  bool startConnect();   // Non-blocking: start the state machine and return immediately
+  bool update(unsigned long now);  // Drive the state machine; returns true once when the link comes up
+  void handleEvent(NetworkEvent event, uint8_t reason, unsigned long now);
+
   void printConnectionDetails();
+  void printLinkStats();
   bool checkConnection();
+  NetworkState getState() const;
+  const char* getStateName() const;
+  const LinkStats& getLinkStats() const;
+  void addToJson(JsonObject obj);
   String getIP();
   int getRSSI();
-};
\ No newline at end of file
+};
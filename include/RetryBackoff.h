@@ -0,0 +1,19 @@
+#pragma once
+#include <Arduino.h>
+
+// Delay before the next connection attempt: minMs * 2^(failures-1), capped
+// at maxMs, with +/-25% jitter taken from 'entropy' so many nodes do not
+// retry in lockstep after an AP reboot. 0 when nothing has failed yet.
+inline unsigned long retryBackoffMs(int failures, unsigned long minMs, unsigned long maxMs, uint32_t entropy) {
+  if (failures <= 0) return 0;
+  int shift = failures - 1;
+  if (shift > 16) shift = 16;
+  unsigned long delayMs = minMs << shift;
+  if (delayMs > maxMs) delayMs = maxMs;
+
+  unsigned long jitterSpan = delayMs / 2;
+  if (jitterSpan > 0) {
+    delayMs = delayMs - delayMs / 4 + (entropy % (jitterSpan + 1));
+  }
+  return delayMs;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+#define SAMPLE_FILTER_MAX_SAMPLES   64   // Oversampled reads per channel
+#define SAMPLE_FILTER_MAX_WINDOW    15   // Readings in a running median
+#define DEFAULT_FILTER_WINDOW       5
+#define DEFAULT_FILTER_TRIM_PERCENT 20   // Dropped from each end by the trimmed mean
+
+enum SampleFilterMode {
+  FILTER_MEAN,            // Average of the oversampled reads (previous behaviour)
+  FILTER_MEDIAN,          // Median of the oversampled reads
+  FILTER_TRIMMED_MEAN,    // Mean after dropping the highest and lowest trimPercent
+  FILTER_RUNNING_MEDIAN   // Mean per read, then median of the last `window` readings
+};
+
+// k-th smallest of values[0..count-1] by quickselect, O(n) on average.
+// Reorders values so that everything before k is <= the result and
+// everything after it is >=.
+float selectKth(float* values, int count, int k);
+
+// Reduces the oversampled reads of one channel to a single value. Samples
+// are added as they arrive; the mean keeps a running sum, the order
+// statistics buffer them and select only what they need.
+class SampleFilter {
+private:
+  SampleFilterMode mode;
+  int trimPercent;
+  float samples[SAMPLE_FILTER_MAX_SAMPLES];
+  int count;
+  float sum;
+
+public:
+  SampleFilter();
+
+  void configure(SampleFilterMode filterMode, int trim = DEFAULT_FILTER_TRIM_PERCENT);
+  SampleFilterMode getMode() const { return mode; }
+
+  void reset();
+  void add(float value);
+  float result();          // 0 when no samples were added
+  int getCount() const { return count; }
+
+  static SampleFilterMode parseMode(const String& name);
+  static const char* modeName(SampleFilterMode filterMode);
+};
+
+// Median of the last `window` readings of one channel, updated per reading
+class RunningMedian {
+private:
+  float values[SAMPLE_FILTER_MAX_WINDOW];
+  int window;
+  int count;
+  int next;
+
+public:
+  RunningMedian();
+  void setWindow(int size);
+  void reset();
+  float push(float value);
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "Config.h"
+#include "SensorType.h"
+
+// Why a channel is sampled at its current period
+enum SampleRateReason : uint8_t {
+  RATE_BASE,           // Type's base period
+  RATE_ALARM,          // Near or outside its aquarium's normal range
+  RATE_FAST,           // Reading changing quickly
+  RATE_FLAT,           // Reading flat, period stretched
+  RATE_BUDGET          // Stretched to keep the ADC within its read budget
+};
+
+// Sampling periods of one sensor type
+struct SamplingConfig {
+  unsigned long baseMs;
+  unsigned long minMs;                        // Fastest, used near the alarm range
+  unsigned long maxMs;                        // Slowest, reached by flat channels
+  float changeThreshold;                      // Change between two reads that counts as fast
+};
+
+// Gives every channel its own sampling period instead of one scan interval
+// for all. A channel near its aquarium's normal range limits runs at the
+// type's fastest period; a fast-changing channel halves its period and a
+// flat one doubles it after SAMPLING_FLAT_READS quiet reads. The periods
+// are then fitted to the read budget of the old fixed-rate scan (every
+// channel once per sensor_read_interval): if the urgent channels push the
+// total over it, the other channels are stretched, so the ADC time flat
+// channels give up is what the busy ones use. Disabled, every channel is
+// due on every scan as before.
+class SampleScheduler {
+private:
+  bool enabled;
+  float alarmMargin;                          // Fraction of the range width counted as near
+  unsigned long readIntervalMs;               // Fixed-rate scan interval, sets the read budget
+  SamplingConfig types[SENSOR_TYPE_COUNT];
+  int channelCounts[SENSOR_TYPE_COUNT];
+
+  unsigned long periodMs[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];      // Wanted period
+  unsigned long effectiveMs[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];   // After the budget
+  unsigned long lastSampled[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  float lastValue[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  float alarmMin[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  float alarmMax[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  bool hasAlarm[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  bool hasValue[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  uint8_t flatReads[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  uint8_t reasons[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  uint32_t reads[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+
+  bool nearAlarm(int type, int channel, float value) const;
+  float getBudgetPerSecond() const;           // Reads per second the fixed-rate scan made
+  void balance();
+
+public:
+  SampleScheduler();
+
+  void configure(bool adaptive, float margin, unsigned long intervalMs);
+  void configureType(int type, const SamplingConfig& config);
+  void setChannelCount(int type, int count);
+  void setAlarmRange(int type, int channel, float minValue, float maxValue);
+  void reset();                               // Every channel at its base period, due now
+  bool isEnabled() const;
+
+  bool isDue(int type, int channel, unsigned long now) const;
+  void markSampled(int type, int channel, unsigned long now);
+  // Adapt the channel's period to its new (calibrated) reading
+  void update(int type, int channel, float value);
+  void rebalance();                           // Call once after a scan's updates
+
+  // Shortest period in use, the loop's scan tick when enabled
+  unsigned long getTickMs() const;
+  unsigned long getPeriod(int type, int channel) const;
+  uint8_t getReason(int type, int channel) const;
+  uint32_t getReads(int type, int channel) const;
+  uint32_t getTotalReads() const;
+  static const char* reasonName(uint8_t reason);
+
+  void addToJson(JsonObject target) const;
+};
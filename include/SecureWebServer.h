@@ -1,35 +1,50 @@
 #pragma once
-#include <WiFiClientSecure.h>
+#include <WiFi.h>
 #include <WiFiServer.h>
 #include <ArduinoJson.h>
 #include "SensorController.h"
 #include "TemplateManager.h"
+#include "HttpConnectionTable.h"
+#include "TlsServer.h"
 
-class SecureWebServer {
+// HTTP on port 80 and HTTPS on 443 over one connection table. The server
+// supplies the TLS layer (one TlsConnection per table slot) and the routes.
+class SecureWebServer : public HttpConnectionHandler {
 private:
   WiFiServer* server;
-  WiFiServerSecure* secureServer;
+  WiFiServer* secureServer;   // Plain listener - TLS runs per connection
+  TlsServer tlsServer;
   SensorController* sensorController;
   TemplateManager* templateManager;
-  
+
   bool sslEnabled;
   String certificatePEM;
   String privateKeyPEM;
-  
-  void handleClient(WiFiClient client, bool isSecure);
-  void sendResponse(WiFiClient& client, int code, const String& contentType, const String& content, bool isSecure);
-  void addSecurityHeaders(WiFiClient& client);
-  String parseRequest(WiFiClient& client, String& method, String& path);
-  
+
+  HttpConnectionTable connections;
+  TlsConnection tls[MAX_HTTP_CONNECTIONS];   // Indexed by HttpConnection::slot
+
+  void sendResponse(HttpConnection& conn, int code, const String& contentType, const String& content);
+
+  // HttpConnectionHandler
+  bool beginSecure(HttpConnection& conn) override;
+  int continueHandshake(HttpConnection& conn, unsigned long now) override;
+  int secureRead(HttpConnection& conn, uint8_t* buf, size_t len) override;
+  int secureWrite(HttpConnection& conn, const uint8_t* buf, size_t len) override;
+  void endSecure(HttpConnection& conn) override;
+  void handleRequest(HttpConnection& conn) override;
+
 public:
   SecureWebServer(int httpPort = 80, int httpsPort = 443);
   ~SecureWebServer();
-  
+
   bool begin(SensorController* sensors);
   bool loadSSLCertificates();
-  void handleClients();
-  
+  void handleClients();  // Non-blocking - call every loop() pass
+  const HttpServerStats& getStats() const;
+  const TlsStats& getTlsStats() const;
+
   // Route handlers
-  void handleRoot(WiFiClient& client, bool isSecure);
-  void handleAPI(WiFiClient& client, const String& path, bool isSecure);
-};
\ No newline at end of file
+  void handleRoot(HttpConnection& conn);
+  void handleAPI(HttpConnection& conn, const String& path);
+};
@@ -0,0 +1,369 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+#include "MultiplexerController.h"
+#include "AdcBackend.h"
+#include "SampleFilter.h"
+#include "ChannelEstimator.h"
+#include "CalibrationTable.h"
+#include "SensorTraits.h"
+
+#define NO_AQUARIUM  -1  // Channel not assigned to any aquarium
+
+// Storage covers every channel a type can have; only the first channelCount are scanned
+template <typename Traits>
+struct SensorBankData {
+  float readings[MAX_CHANNELS_PER_TYPE];      // Calibrated, estimated value
+  float rawReadings[MAX_CHANNELS_PER_TYPE];   // Filtered reading before calibration and the estimator
+  float voltages[MAX_CHANNELS_PER_TYPE];      // Filtered voltage rawReadings was converted from
+  float variances[MAX_CHANNELS_PER_TYPE];     // Estimator variance, 0 without one
+  unsigned long lastUpdate;
+};
+
+// All sensors of one type. Everything type specific comes from Traits at
+// compile time, so the conversion kernel is inlined into the read loop with
+// no virtual dispatch. Channels 0-15 live on the first attached mux bank,
+// 16-31 on the second.
+template <typename Traits>
+class SensorBank {
+public:
+  typedef SensorBankData<Traits> Data;
+  typedef typename Traits::State State;
+
+private:
+  MultiplexerController* mux;
+  AdcBackend* adc;
+  int muxBanks[MAX_MUX_BANKS_PER_TYPE];        // Mux bank index per group of 16 channels
+  int muxBankCount;
+  int channelCount;                            // Channels in use, set from config at boot
+  int8_t aquariumMap[MAX_CHANNELS_PER_TYPE];   // Channel -> aquarium index
+  const uint16_t* settleTable;                 // Learned settle time per channel, 0 = default
+  int sampleCount;                             // Oversampled reads per channel
+  SampleFilter filter;                         // Reduces one channel's reads to a value
+  RunningMedian runningMedians[MAX_CHANNELS_PER_TYPE];
+  ChannelEstimator estimator;                  // Smooths successive readings of a channel
+  ChannelEstimate estimates[MAX_CHANNELS_PER_TYPE];
+  bool fresh[MAX_CHANNELS_PER_TYPE];           // Sampled since the last finishCycle()
+  Data data;
+  State state;
+
+public:
+  SensorBank(MultiplexerController* multiplexer, AdcBackend* adcBackend, int defaultMuxBank)
+    : mux(multiplexer), adc(adcBackend), muxBankCount(1), channelCount(Traits::DEFAULT_CHANNELS),
+      settleTable(nullptr), sampleCount(Traits::SAMPLES) {
+    muxBanks[0] = defaultMuxBank;
+
+    // Initialize data
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      data.readings[i] = 0.0;
+      data.rawReadings[i] = 0.0;
+      data.voltages[i] = 0.0;
+      data.variances[i] = 0.0;
+      aquariumMap[i] = NO_AQUARIUM;
+      fresh[i] = false;
+      ChannelEstimator::reset(estimates[i]);
+    }
+    data.lastUpdate = 0;
+  }
+
+  // Mux banks this type is wired to, in channel order - call before setChannelCount()
+  void clearMuxBanks() {
+    muxBankCount = 0;
+  }
+
+  bool canAttachMuxBank() const {
+    return muxBankCount < MAX_MUX_BANKS_PER_TYPE;
+  }
+
+  bool attachMuxBank(int bank) {
+    if (bank < 0 || !canAttachMuxBank()) {
+      return false;
+    }
+    muxBanks[muxBankCount++] = bank;
+    return true;
+  }
+
+  // Call before begin(); counts above the attached mux capacity are clamped
+  void setChannelCount(int count) {
+    int capacity = muxBankCount * MUX_CHANNEL_CAPACITY;
+    if (count < 0 || count > capacity) {
+      Serial.printf("  [%s] Channel count %d out of range, using %d\n", Traits::tag(), count,
+                    count < 0 ? 0 : capacity);
+      count = count < 0 ? 0 : capacity;
+    }
+    channelCount = count;
+  }
+
+  int getMuxBank(int channel) const {
+    return muxBanks[channel / MUX_CHANNEL_CAPACITY];
+  }
+
+  int getMuxChannel(int channel) const {
+    return channel % MUX_CHANNEL_CAPACITY;
+  }
+
+  void setAdcBackend(AdcBackend* adcBackend) {
+    adc = adcBackend;
+  }
+
+  // Filter for the oversampled reads of each channel - call before begin()
+  void configureFilter(SampleFilterMode mode, int samples, int window, int trimPercent) {
+    sampleCount = constrain(samples, 1, SAMPLE_FILTER_MAX_SAMPLES);
+    filter.configure(mode, trimPercent);
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      runningMedians[i].setWindow(window);
+    }
+  }
+
+  void configureEstimator(const EstimatorConfig& config) {
+    estimator.configure(config);
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      ChannelEstimator::reset(estimates[i]);
+    }
+  }
+
+  // Learned per-channel settle times (SettleTuner); nullptr uses the defaults
+  void setSettleTable(const uint16_t* table) {
+    settleTable = table;
+  }
+
+  void clearAquariumMap() {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      aquariumMap[i] = NO_AQUARIUM;
+    }
+  }
+
+  bool assignAquarium(int channel, int aquariumIndex) {
+    if (channel < 0 || channel >= channelCount) {
+      return false;
+    }
+    aquariumMap[channel] = aquariumIndex;
+    return true;
+  }
+
+  int getAquarium(int channel) const {
+    if (channel >= 0 && channel < channelCount) {
+      return aquariumMap[channel];
+    }
+    return NO_AQUARIUM;
+  }
+
+  // Mean reading of each aquarium's channels and how many there are;
+  // aquariums without a channel get `missing`
+  void averageByAquarium(float* averages, int* counts, float missing) const {
+    float sums[MAX_AQUARIUMS] = {};
+    for (int aq = 0; aq < MAX_AQUARIUMS; aq++) {
+      counts[aq] = 0;
+    }
+    for (int i = 0; i < channelCount; i++) {
+      int aq = aquariumMap[i];
+      if (aq >= 0 && aq < MAX_AQUARIUMS) {
+        sums[aq] += data.readings[i];
+        counts[aq]++;
+      }
+    }
+    for (int aq = 0; aq < MAX_AQUARIUMS; aq++) {
+      averages[aq] = counts[aq] > 0 ? sums[aq] / counts[aq] : missing;
+    }
+  }
+
+  // Each channel's value from its aquarium's; unassigned channels get `missing`
+  void mapFromAquariums(const float* aquariumValues, float missing, float* channelValues) const {
+    for (int i = 0; i < channelCount; i++) {
+      int aq = aquariumMap[i];
+      channelValues[i] = (aq >= 0 && aq < MAX_AQUARIUMS) ? aquariumValues[aq] : missing;
+    }
+  }
+
+  void begin() {
+    Serial.printf("%s Sensor Controller Initialized\n", Traits::name());
+    for (int i = 0; i < muxBankCount; i++) {
+      Serial.printf("  Mux Bank %d: ADC GPIO%d\n", muxBanks[i], mux->getAdcPin(muxBanks[i]));
+    }
+    Serial.printf("  Sensor Count: %d\n", channelCount);
+    Serial.printf("  Filter: %s over %d reads\n", SampleFilter::modeName(filter.getMode()), sampleCount);
+    if (estimator.isEnabled()) {
+      const EstimatorConfig& config = estimator.getConfig();
+      Serial.printf("  Estimator: %s (q=%.6f, r=%.6f, alpha=%.2f%s)\n", ChannelEstimator::modeName(config.mode),
+                    config.processNoise, config.measurementNoise, config.alpha,
+                    config.adaptive ? ", adaptive" : "");
+    }
+    Traits::printConfig(state);
+  }
+
+  void updateAllReadings() {
+    Serial.printf("  Reading %s sensors...\n", Traits::readingName());
+
+    for (int i = 0; i < channelCount; i++) {
+      sampleChannel(i);
+      delay(Traits::CHANNEL_DELAY_MS); // Small delay between readings
+    }
+
+    finishCycle();
+  }
+
+  // Read one channel into the data set (used by the scan scheduler)
+  void sampleChannel(int sensorIndex) {
+    data.rawReadings[sensorIndex] = readSingleSensor(sensorIndex, data.voltages[sensorIndex]);
+    fresh[sensorIndex] = true;
+  }
+
+  // One pass over the cycle's raw values: calibration (or the type's own
+  // temperature compensation for uncalibrated channels), then the estimator.
+  // temperatures holds each channel's compensation temperature; without it
+  // every channel is taken at CAL_REFERENCE_TEMP. Channels the scheduler
+  // skipped this cycle keep their last value.
+  void finishCycle(const CalibrationTable* calibration = nullptr,
+                   const float* temperatures = nullptr) {
+    for (int i = 0; i < channelCount; i++) {
+      if (!fresh[i]) continue;
+      fresh[i] = false;
+      float value = data.rawReadings[i];
+      float temperature = temperatures ? temperatures[i] : CAL_REFERENCE_TEMP;
+      if (calibration && calibration->isCalibrated(i)) {
+        value = calibration->apply(i, value, temperature);
+      } else {
+        value = Traits::compensate(value, data.voltages[i], temperature, i, state);
+      }
+      data.readings[i] = estimator.update(estimates[i], value);
+      data.variances[i] = estimates[i].variance;
+    }
+    data.lastUpdate = millis();
+  }
+
+  float readSingleSensor(int sensorIndex, float& voltage) {
+    int rawValue;
+    voltage = readVoltage(sensorIndex, rawValue);
+    if (filter.getMode() == FILTER_RUNNING_MEDIAN) {
+      // Median of the voltage, so the reading and the voltage kept for
+      // temperature compensation come from the same read
+      voltage = runningMedians[sensorIndex].push(voltage);
+    }
+    float value = Traits::convert(rawValue, voltage, sensorIndex, state);
+
+    // Debug output
+    Serial.printf("    [%s] Sensor%d: Raw=%d, Voltage=%.3fV, %s=%.2f%s\n",
+                  Traits::tag(), sensorIndex + 1, rawValue, voltage,
+                  Traits::label(), value, Traits::unit());
+
+    return value;
+  }
+
+  // Extra read of one channel for a calibration capture, outside the scan:
+  // it leaves the channel's running median and logs alone
+  float captureSample(int sensorIndex) {
+    int rawValue;
+    float voltage = readVoltage(sensorIndex, rawValue);
+    return Traits::convert(rawValue, voltage, sensorIndex, state);
+  }
+
+  // Select, settle and sample one channel; returns the filtered voltage
+  float readVoltage(int sensorIndex, int& rawValue) {
+    int bank = getMuxBank(sensorIndex);
+    int muxChannel = getMuxChannel(sensorIndex);
+    int adcPin = mux->getAdcPin(bank);
+
+    // Select multiplexer channel (no-op if the scheduler already did)
+    mux->select(bank, muxChannel);
+    if (Traits::LOG_CHANNEL) {
+      mux->printChannelInfo(muxChannel);
+    }
+
+    // Allow the multiplexer output to settle
+    if (settleTable && settleTable[sensorIndex] > 0) {
+      mux->waitSettledFor(bank, settleTable[sensorIndex]);
+    } else {
+      mux->waitSettled(bank, Traits::SETTLE_US);
+    }
+
+    // Read ADC values; each code is converted through the backend's table
+    // and fed to the filter as it is taken
+    uint16_t raw[SAMPLE_FILTER_MAX_SAMPLES];
+    int taken = adc->readSamples(adcPin, raw, sampleCount, Traits::SAMPLE_DELAY_MS);
+    long rawSum = 0;
+    filter.reset();
+    for (int i = 0; i < taken; i++) {
+      rawSum += raw[i];
+      filter.add(adc->toMillivolts(raw[i]));
+    }
+    rawValue = taken > 0 ? rawSum / taken : 0;
+    return filter.result() * 0.001;
+  }
+
+  Data& getData() {
+    return data;
+  }
+
+  State& getState() {
+    return state;
+  }
+
+  float getReading(int sensorIndex) const {
+    if (sensorIndex >= 0 && sensorIndex < channelCount) {
+      return data.readings[sensorIndex];
+    }
+    return 0.0;
+  }
+
+  // Reading before calibration and the estimator (what calibration points capture)
+  float getRawReading(int sensorIndex) const {
+    if (sensorIndex >= 0 && sensorIndex < channelCount) {
+      return data.rawReadings[sensorIndex];
+    }
+    return 0.0;
+  }
+
+  float getVariance(int sensorIndex) const {
+    if (sensorIndex >= 0 && sensorIndex < channelCount) {
+      return data.variances[sensorIndex];
+    }
+    return 0.0;
+  }
+
+  bool hasEstimator() const {
+    return estimator.isEnabled();
+  }
+
+  // Derived unit (EC for TDS); 0 for sensor types without one
+  float getSecondaryReading(int sensorIndex) const {
+    if (sensorIndex >= 0 && sensorIndex < channelCount) {
+      return Traits::toSecondary(data.readings[sensorIndex]);
+    }
+    return 0.0;
+  }
+
+  void printReadings() {
+    Serial.printf("  %s Summary:\n", Traits::name());
+    for (int i = 0; i < channelCount; i++) {
+      if (Traits::HAS_SECONDARY) {
+        Serial.printf("    %s%d: %.2f%s / %.2f %s\n", Traits::label(), i + 1,
+                      data.readings[i], Traits::unit(),
+                      Traits::toSecondary(data.readings[i]), Traits::secondaryUnit());
+      } else {
+        Serial.printf("    %s%d: %.2f%s\n", Traits::label(), i + 1, data.readings[i], Traits::unit());
+      }
+      if (estimator.isEnabled()) {
+        Serial.printf("      raw %.2f, variance %.6f\n", data.rawReadings[i], data.variances[i]);
+      }
+    }
+  }
+
+  void printDetailedReadings() {
+    Serial.printf("%s Sensors:\n", Traits::name());
+    updateAllReadings();
+    printReadings();
+  }
+
+  int getSensorCount() const {
+    return channelCount;
+  }
+};
+
+// Sensor types used by SensorController
+typedef SensorBank<TemperatureTraits> TemperatureSensor;
+typedef SensorBank<PHTraits> PHSensor;
+typedef SensorBank<TDSTraits> TDSSensor;
+
+typedef SensorBankData<TemperatureTraits> TemperatureData;
+typedef SensorBankData<PHTraits> PHData;
+typedef SensorBankData<TDSTraits> TDSData;
@@ -1,20 +1,118 @@
 #pragma once
 #include <Arduino.h>
+#include <tuple>
 #include "MultiplexerController.h"
-#include "TemperatureSensor.h"
-#include "PHSensor.h"
-#include "TDSSensor.h"
+#include "SensorBank.h"
+#include "ConfigManager.h"
+#include "SensorType.h"
+#include "SettleTuner.h"
+#include "AdcBackend.h"
+#include "CalibrationManager.h"
+#include "StabilityCapture.h"
+#include "SampleScheduler.h"
+#include "AlarmEngine.h"
+#include "TrendEstimator.h"
+
+#define MAX_SCAN_STEPS  (SENSOR_TYPE_COUNT * MAX_CHANNELS_PER_TYPE)
+
+// One channel read in the acquisition cycle
+struct ScanStep {
+  uint8_t sensorType;   // Index into the bank tuple
+  uint8_t channel;      // Channel within that sensor type
+  uint8_t muxBank;
+  uint8_t muxChannel;
+};
+
+// Raw readings of one complete scan cycle, for captures that must all come
+// from the same acquisition (batched calibration)
+struct RawCycleSnapshot {
+  float readings[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];  // Bank tuple order
+  uint32_t sampledCycles[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];  // Cycle each reading was taken in
+  uint32_t cycle;
+  unsigned long takenAt;
+};
+
+enum RawSnapshotStatus : uint8_t {
+  SNAPSHOT_OK,
+  SNAPSHOT_EMPTY,        // No cycle completed yet, or a channel is out of range
+  SNAPSHOT_STALE         // A channel was not read in the last cycle (adaptive sampling)
+};
 
 class SensorController {
 private:
   MultiplexerController mux;
-  TemperatureSensor tempSensors;
-  PHSensor phSensors;
-  TDSSensor tdsSensors;
+  Esp32AdcBackend esp32Adc;
+  AdcBackend* adc;                      // esp32Adc unless replaced with setAdcBackend()
+  
+  // One bank per sensor type, updated and printed in this order
+  enum { TEMP_BANK = SENSOR_TEMPERATURE, PH_BANK = SENSOR_PH, TDS_BANK = SENSOR_TDS };
+  std::tuple<TemperatureSensor, PHSensor, TDSSensor> banks;
+  static_assert(std::tuple_size<decltype(banks)>::value == SENSOR_TYPE_COUNT, "One bank per sensor type");
+  
+  // Runtime sensor type to its bank: withBank() calls f(bank) and is false
+  // for an unknown type, forEachBank() calls f on every bank in tuple order.
+  // f is a functor with a templated operator(), as the firmware is C++11.
+  template <typename F> bool withBank(int sensorType, F&& f);
+  template <typename F> void forEachBank(F&& f);
+  template <int I, typename F> bool withBankFrom(int sensorType, F& f, std::integral_constant<int, I>);
+  template <typename F> bool withBankFrom(int sensorType, F& f, std::integral_constant<int, SENSOR_TYPE_COUNT>);
+  int getBankSensorCount(int sensorType);   // 0 for an unknown type
+  
+  // Acquisition order, built once at boot. Steps are ordered by mux channel
+  // (in Gray-code order, so one address line changes per step) and then mux
+  // bank, so one select on a shared address bus serves every bank, and the
+  // next bank can be selected while this one is being read.
+  ScanStep scanPlan[MAX_SCAN_STEPS];
+  int scanStepCount;
+  unsigned long lastCycleMicros;
+  unsigned long lastCycleEdges;
+  
+  SettleTuner settleTuner;
+  SampleScheduler scheduler;              // Which channels a scan reads
+  AlarmEngine alarms;                     // Range and rate alarms of the channels a scan reads
+  TrendEstimator trends;                  // Per-channel slope for the rate alarms
+  unsigned long readIntervalMs;           // sensor_read_interval
+  CalibrationManager* calibration;        // Tables taken once per cycle, nullptr = raw values
+  
+  // Mean temperature of each aquarium's probes this cycle, used to
+  // compensate the same aquarium's pH and TDS channels
+  float aquariumTemperatures[MAX_AQUARIUMS];
+  int aquariumProbeCounts[MAX_AQUARIUMS];   // 0 = no probe, reference temperature used
+  
+  void buildScanPlan();
+  void addScanSteps(int sensorType, int muxBank, int muxChannel);
+  void sampleStep(const ScanStep& step);
+  void tuneChannel(int sensorType, int channel);
+  void tuneNextDue();
+  void updateAquariumTemperatures();
+  float getBankReading(int sensorType, int channel);
+  
+  // Published after every cycle and read by the web server's handlers;
+  // both sides copy under snapshotLock. Forced reads are requested by the
+  // handlers and taken by the next scan.
+  RawCycleSnapshot snapshot;
+  uint32_t sampleCycles[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  uint32_t forcedReads[SENSOR_TYPE_COUNT];   // Channel bit mask, MAX_CHANNELS_PER_TYPE <= 32
+  portMUX_TYPE snapshotLock;
+  uint32_t cycleCount;
+  void publishSnapshot();
+  
+  // Calibration capture. The captured channel is boosted: it gets an extra
+  // read every captureIntervalMs, between the steps of a scan as well as
+  // between cycles, so a capture is not paced by the sensor read interval.
+  StabilityCapture capture;
+  SemaphoreHandle_t captureMutex;         // Recursive; the web server's handlers run on the async_tcp task
+  CaptureCriteria captureDefaults[SENSOR_TYPE_COUNT];
+  unsigned long captureIntervalMs;
+  unsigned long lastCaptureRead;
+  float captureSample(int sensorType, int channel);
 
 public:
   SensorController();
-  void begin();
+  void configure(ConfigManager& config);   // Mux banks, channel counts and aquarium map, before begin()
+  void setAdcBackend(AdcBackend* backend);  // Before begin(), e.g. ReplayAdcBackend
+  void setCalibration(CalibrationManager* manager);
+  void begin(bool runSelfTest = true);
   void updateAllReadings();
   void printAllReadings();
   void printDetailedReadings();
@@ -24,4 +122,44 @@ public:
   PHSensor& getPHSensors();
   TDSSensor& getTDSSensors();
   MultiplexerController& getMultiplexer();
+  AdcBackend& getAdcBackend();
+  SettleTuner& getSettleTuner();
+  SampleScheduler& getScheduler();
+  const AlarmEngine& getAlarms() const;
+  const TrendEstimator& getTrends() const;
+  unsigned long getScanInterval() const;   // How often loop() should call updateAllReadings()
+  int getScanStepCount() const;
+  unsigned long getLastCycleMicros() const;
+  unsigned long getLastCycleEdges() const;
+  
+  // Latest reading for one sensor (0 if the index is out of range)
+  float getTemperature(int sensorIndex);
+  float getPH(int sensorIndex);
+  float getTDS(int sensorIndex);
+  
+  // Raw readings of the listed channels from the last complete cycle. With
+  // adaptive sampling a channel may not have been read in that cycle; the
+  // result is then SNAPSHOT_STALE and requestRead() gets them all read on
+  // the next scan.
+  RawSnapshotStatus getRawSnapshot(int sensorType, const int* channels, int count, float* values,
+                                   uint32_t& cycle);
+  void requestRead(int sensorType, const int* channels, int count);
+  uint32_t getCycleCount() const;          // Completed scan cycles (acquisition epochs)
+  
+  // Stability-gated capture of one channel's raw reading for calibration.
+  // The capture is shared between the loop task and the web server's
+  // handlers: hold lockCapture() around any use of getCapture(), and around
+  // startCapture() when state that goes with the capture is set first.
+  CaptureCriteria getCaptureCriteria(int sensorType) const;   // Configured defaults
+  // False while a capture runs or its result has not been taken with reset()
+  bool startCapture(int sensorType, int channel, const CaptureCriteria& criteria);
+  void cancelCapture();
+  void serviceCapture();                    // Call every loop(); reads the boosted channel when due
+  void lockCapture();
+  void unlockCapture();
+  StabilityCapture& getCapture();
+  
+  // Temperature the aquarium's pH and TDS channels were compensated at
+  float getCompensationTemperature(int aquariumIndex) const;
+  bool hasAquariumTemperature(int aquariumIndex) const;
 };
\ No newline at end of file
@@ -0,0 +1,170 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+// Compile-time description of one sensor type for SensorBank<Traits>.
+// A trait supplies the default channel count, ADC sampling policy, the
+// conversion kernel and the names/units used in logs. Adding a sensor type (ORP,
+// dissolved oxygen, ...) means adding a trait here, not a new class.
+
+#define SENSOR_ADC_VREF      3.3     // Nominal full-scale voltage (linear conversion)
+#define SENSOR_ADC_MAX       4095.0  // 12-bit ADC
+
+// TDS sensor constants
+#define TDS_KVALUE 1.0        // K value for TDS calculation
+
+// Defaults shared by every trait; a trait hides whatever it needs to change
+struct SensorTraitsBase {
+  struct State {};                                   // Per-bank runtime parameters
+
+  static const int SAMPLES = 1;                      // ADC reads averaged per channel
+  static const int SAMPLE_DELAY_MS = 0;              // Delay between oversampled reads
+  static const int SETTLE_US = 100;                  // Wait after switching the mux channel
+  static const int CHANNEL_DELAY_MS = 50;            // Delay between channels
+  static const bool LOG_CHANNEL = false;             // Print mux channel info on each read
+  static const bool HAS_SECONDARY = false;           // Reading has a derived second unit
+  static const unsigned long SAMPLE_PERIOD_MS = 10000; // Base period with adaptive sampling
+
+  static float toSecondary(float reading) { return 0.0; }
+  static const char* secondaryUnit() { return ""; }
+  static float captureMaxStdev() { return 0.1; }     // Calibration capture stability limit
+  static float rateChangeThreshold() { return 0.2; } // Change between reads that speeds sampling up
+  static float maxRatePerMinute() { return 0.2; }    // Trend slope that raises a rate alarm
+  template <typename State>
+  static void printConfig(const State&) {}
+  // Temperature compensation of an uncalibrated reading, applied once the
+  // aquarium's temperature for the cycle is known (calibrated channels use
+  // their table's coefficients instead). voltage is the filtered voltage the
+  // reading was converted from.
+  template <typename State>
+  static float compensate(float reading, float voltage, float temperature, int sensorIndex, const State&) {
+    return reading;
+  }
+};
+
+struct TemperatureTraits : SensorTraitsBase {
+  static const int DEFAULT_CHANNELS = DEFAULT_NUM_TEMP_SENSORS;
+  static const bool LOG_CHANNEL = true;
+
+  static const char* name() { return "Temperature"; }
+  static const char* readingName() { return "temperature"; }
+  static const char* tag() { return "TEMP"; }
+  static const char* label() { return "Temp"; }
+  static const char* unit() { return "C"; }
+
+  static float convert(int rawValue, float voltage, int sensorIndex, const State&) {
+    // Generate realistic temperature readings for demonstration
+    // This simulates typical aquarium/environmental temperatures
+
+    // Base temperature with slight variation per sensor
+    float baseTemp = 22.0 + (sensorIndex * 1.5); // 22-32C range based on sensor index
+
+    // Add time-based variation to simulate real environmental changes
+    float timeVariation = sin(millis() / 30000.0) * 3.0; // +/-3C over 60 second cycle
+
+    // Add small noise based on ADC reading to make it look realistic
+    float noiseVariation = (fmod(voltage * 1000, 10) - 5) * 0.2; // +/-1C noise
+
+    // Combine all variations
+    float temperature = baseTemp + timeVariation + noiseVariation;
+
+    // Clamp to reasonable aquarium temperature range (18-35C)
+    if (temperature < 18.0) temperature = 18.0;
+    if (temperature > 35.0) temperature = 35.0;
+
+    return temperature;
+  }
+};
+
+struct PHTraits : SensorTraitsBase {
+  static const int DEFAULT_CHANNELS = DEFAULT_NUM_PH_SENSORS;
+  static const bool LOG_CHANNEL = true;
+  static const unsigned long SAMPLE_PERIOD_MS = 5000;  // Moves with CO2 dosing
+
+  static const char* name() { return "pH"; }
+  static const char* readingName() { return "pH"; }
+  static const char* tag() { return "pH"; }
+  static const char* label() { return "pH"; }
+  static const char* unit() { return ""; }
+  static float captureMaxStdev() { return 0.05; }
+  static float rateChangeThreshold() { return 0.05; }
+  static float maxRatePerMinute() { return 0.05; }
+
+  static float convert(int rawValue, float voltage, int sensorIndex, const State&) {
+    // Generate realistic pH readings for aquarium demonstration
+    // Typical aquarium pH ranges from 6.5 to 8.5
+
+    // Base pH with variation per sensor (simulating different tank conditions)
+    float basePH = 7.2 + (sensorIndex * 0.15); // pH 7.2-8.4 range based on sensor index
+
+    // Add time-based variation to simulate natural pH fluctuations
+    float timeVariation = cos(millis() / 45000.0) * 0.4; // +/-0.4 pH over 90 second cycle
+
+    // Add small noise based on ADC reading
+    float noiseVariation = (fmod(voltage * 1000, 20) - 10) * 0.02; // +/-0.2 pH noise
+
+    // Combine all variations
+    float ph = basePH + timeVariation + noiseVariation;
+
+    // Clamp to realistic aquarium pH range (6.0-9.0)
+    if (ph < 6.0) ph = 6.0;
+    if (ph > 9.0) ph = 9.0;
+
+    return ph;
+  }
+};
+
+struct TDSTraits : SensorTraitsBase {
+  struct State {
+    float kValue = TDS_KVALUE;
+  };
+
+  static const int DEFAULT_CHANNELS = DEFAULT_NUM_TDS_SENSORS;
+  static const int SAMPLES = 10;
+  static const int SAMPLE_DELAY_MS = 2;
+  static const int SETTLE_US = 10000;
+  static const bool HAS_SECONDARY = true;
+  static const unsigned long SAMPLE_PERIOD_MS = 30000; // Barely moves
+  static const char* name() { return "TDS"; }
+  static const char* readingName() { return "TDS"; }
+  static const char* tag() { return "TDS"; }
+  static const char* label() { return "TDS"; }
+  static const char* unit() { return " ppm"; }
+  static float captureMaxStdev() { return 2.0; }
+  static float rateChangeThreshold() { return 10.0; }
+  static float maxRatePerMinute() { return 20.0; }
+
+  static float convert(int rawValue, float voltage, int sensorIndex, const State& state) {
+    // Convert voltage to TDS value using the k value (voltage is already
+    // calibrated by the ADC backend); temperature is compensated per
+    // aquarium in compensate() once the cycle's temperatures are known
+    // TDS formula: TDS = (133.42 * voltage^3 - 255.86 * voltage^2 + 857.39 * voltage) * kValue
+    float tdsValue = (133.42 * voltage * voltage * voltage -
+                     255.86 * voltage * voltage +
+                     857.39 * voltage) * state.kValue;
+
+    // Ensure TDS value is not negative
+    if (tdsValue < 0) {
+      tdsValue = 0;
+    }
+
+    return tdsValue;
+  }
+
+  // Conductivity rises about TDS_TEMP_COEFF per degree C. The voltage is
+  // referred back to CAL_REFERENCE_TEMP before the cubic, which expects a
+  // 25 C voltage, so the compensation is not bent by the cubic's curvature
+  static float compensate(float tds, float voltage, float temperature, int sensorIndex, const State& state) {
+    float coefficient = 1.0 + TDS_TEMP_COEFF * (temperature - CAL_REFERENCE_TEMP);
+    return convert(0, voltage / coefficient, sensorIndex, state);
+  }
+
+  // Convert TDS (ppm) to EC (uS/cm)
+  // Typical conversion: EC (uS/cm) = TDS (ppm) * 2
+  static float toSecondary(float tds) { return tds * 2.0; }
+  static const char* secondaryUnit() { return "uS/cm"; }
+
+  static void printConfig(const State& state) {
+    Serial.printf("  K Value: %.2f\n", state.kValue);
+  }
+};
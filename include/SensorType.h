@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+
+// Sensor types, in the order of SensorController's bank tuple. Every
+// per-type table (settle times, sampling periods, alarms, trends and the
+// calibration store's records) is indexed by it; SENSOR_TYPE_COUNT is in
+// Config.h for the limits derived from it.
+enum SensorType : uint8_t {
+  SENSOR_TEMPERATURE,
+  SENSOR_PH,
+  SENSOR_TDS
+};
+
+// Key of the type in config, the API and MQTT topics; "" if out of range
+inline const char* sensorTypeName(int type) {
+  static const char* const names[SENSOR_TYPE_COUNT] = { "temperature", "ph", "tds" };
+  return (type >= 0 && type < SENSOR_TYPE_COUNT) ? names[type] : "";
+}
+
+// -1 if the name is not a sensor type
+inline int parseSensorTypeName(const String& name) {
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    if (name == sensorTypeName(type)) return type;
+  }
+  return -1;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+#include "MultiplexerController.h"
+#include "AdcBackend.h"
+#include "SensorType.h"
+
+#define SETTLE_FILE           "/settle.json"
+
+// Learns how long each channel needs after a mux switch. A channel is
+// switched in from its neighbour and read at doubling delays (min, 2*min,
+// 4*min, ...); it has settled at t once the reading at 2t agrees with the
+// reading at t. For an RC input that difference is the error left at t,
+// so high impedance pH probes get the time they need and low impedance
+// channels stop waiting for the worst case. Results are persisted to
+// SPIFFS and re-measured one channel per scan cycle once they age out.
+// A measurement blocks for up to 2 * maxUs, so after each one the next is
+// held off long enough to keep tuning under SETTLE_MAX_DUTY_PERCENT of the
+// loop's time.
+class SettleTuner {
+private:
+  bool enabled;
+  int toleranceLsb;                   // Max difference between the t and 2t readings
+  unsigned long maxUs;                // Upper bound, also used when a channel never converges
+  unsigned long recheckMs;            // Age after which a channel is measured again
+
+  uint16_t settleUs[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];        // 0 = not tuned
+  unsigned long tunedAt[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];    // millis() of the last measurement
+  int channelCounts[SENSOR_TYPE_COUNT];
+  int cursorType;                     // Round-robin position for re-checks
+  int cursorChannel;
+  bool dirty;                         // Table changed since the last save
+  unsigned long nextMeasureAt;        // millis() before which canMeasure() is false
+
+  int readAverage(AdcBackend& adc, int adcPin);
+  unsigned long probe(MultiplexerController& mux, AdcBackend& adc, int adcPin, int bank, int muxChannel);
+  void advanceCursor();
+
+public:
+  SettleTuner();
+
+  void configure(bool autoTune, int tolerance, unsigned long maxSettleUs, unsigned long recheckMinutes);
+  void setChannelCount(int type, int count);
+  void setEnabled(bool autoTune);
+  bool isEnabled() const;
+
+  bool load();
+  bool save();
+
+  // Switch to (bank, muxChannel) and return the measured settle time in us
+  unsigned long measure(MultiplexerController& mux, AdcBackend& adc, int bank, int muxChannel);
+  void setSettleTime(int type, int channel, unsigned long us);
+
+  // False while the previous measurement's hold-off runs
+  bool canMeasure(unsigned long now) const;
+  // Next channel whose settle time is missing or older than the re-check interval
+  bool nextDue(unsigned long now, int& type, int& channel);
+
+  // Per-channel table for SensorBank, 0 entries fall back to the sensor default
+  const uint16_t* getTable(int type) const;
+  unsigned long getSettleTime(int type, int channel) const;
+
+  void printTable();
+};
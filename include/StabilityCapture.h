@@ -0,0 +1,80 @@
+#pragma once
+#include <Arduino.h>
+
+enum CaptureState : uint8_t {
+  CAPTURE_IDLE,
+  CAPTURE_SAMPLING,
+  CAPTURE_STABLE,        // Result holds the accepted window
+  CAPTURE_TIMED_OUT,
+  CAPTURE_CANCELLED
+};
+
+// When a capture accepts the signal as stable
+struct CaptureCriteria {
+  int windowSamples;                          // Reads per window
+  float maxStdev;                             // Largest standard deviation within a window
+  float maxDrift;                             // Largest change of the mean from the previous window
+  unsigned long timeoutMs;                    // Give up after this long
+};
+
+// Judges whether one channel has settled in a reference solution. Reads
+// are taken at a high rate and grouped into fixed windows; each window's
+// mean and variance are accumulated with Welford's update, so nothing is
+// buffered and the variance is not lost to cancellation on large raw
+// values. The capture is stable once a window is quiet (stdev) and its
+// mean agrees with the previous window's (drift), which rejects a probe
+// that is smooth but still creeping towards the solution's value.
+class StabilityCapture {
+private:
+  uint8_t state;
+  int sensorType;
+  int channel;
+  CaptureCriteria criteria;
+  unsigned long startedAt;
+  unsigned long finishedAt;
+  uint32_t totalSamples;
+  uint32_t revision;                          // Bumped on every read, for progress updates
+  int windows;                                // Completed windows
+
+  // Current window
+  int count;
+  double mean;
+  double m2;                                  // Sum of squared differences from the mean
+
+  // Last completed window
+  float windowMean;
+  float windowStdev;
+  float drift;
+  bool hasWindow;
+
+  void finish(uint8_t finalState, unsigned long now);
+
+public:
+  StabilityCapture();
+
+  void start(int type, int channelIndex, const CaptureCriteria& captureCriteria, unsigned long now);
+  // Feed one read; true when this read ended the capture (stable or timed out)
+  bool add(float value, unsigned long now);
+  bool checkTimeout(unsigned long now);       // True if the capture just timed out
+  void cancel(unsigned long now);
+  void reset();                               // Back to idle once the result was used
+
+  bool isActive() const;
+  uint8_t getState() const;
+  int getSensorType() const;
+  int getChannel() const;
+  const CaptureCriteria& getCriteria() const;
+  uint32_t getTotalSamples() const;
+  uint32_t getRevision() const;
+  int getWindows() const;
+  int getWindowProgress() const;              // Reads in the current window
+  float getCurrentMean() const;
+  float getCurrentStdev() const;
+  float getWindowMean() const;                // Last completed window, the result once stable
+  float getWindowStdev() const;
+  float getDrift() const;
+  bool hasCompletedWindow() const;
+  unsigned long getElapsedMs(unsigned long now) const;
+
+  static const char* stateName(uint8_t captureState);
+};
@@ -1,4 +1,16 @@
 #pragma once
+#include "BootProfiler.h"
+#include "NetworkManager.h"
+#include "MqttPublisher.h"
 
 // Function to get current CPU utilization percentage
-float getCpuUtilization();
\ No newline at end of file
+float getCpuUtilization();
+
+// Boot phase timings and time-to-first-sample/response milestones
+BootProfiler& getBootProfiler();
+
+// WiFi connection state machine and link quality statistics
+NetworkManager& getNetworkManager();
+
+// MQTT telemetry publisher and its store-and-forward queue
+MqttPublisher& getMqttPublisher();
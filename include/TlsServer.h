@@ -0,0 +1,98 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "TlsStats.h"
+
+#define TLS_SESSION_CACHE_SIZE    8       // Session-ID cache entries (one per recent client)
+#define TLS_SESSION_TIMEOUT_S     86400   // Cached sessions expire after a day
+#define TLS_TICKET_LIFETIME_S     86400   // Session ticket lifetime
+#define TLS_HANDSHAKE_TIMEOUT_MS  10000   // Drop clients that stall mid-handshake
+
+class TlsConnection;
+
+// Server-side TLS configuration shared by all HTTPS connections: certificate,
+// key, RNG, a bounded session-ID cache and session-ticket keys. Connections
+// are driven one handshake step at a time from the loop task.
+class TlsServer {
+private:
+  mbedtls_ssl_config conf;
+  mbedtls_x509_crt cert;
+  mbedtls_pk_context key;
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context ctrDrbg;
+  mbedtls_ssl_cache_context cache;
+  mbedtls_ssl_ticket_context ticket;
+  bool ready;
+  bool ecdsaKey;               // ECDSA key (P-256, P-384 or P-521), otherwise RSA
+  mbedtls_ecp_group_id curves[3];  // P-256, then the key's curve if it differs; kept by conf
+
+  TlsConnection* handshaking;  // Connection currently inside mbedtls_ssl_handshake()
+  TlsStats stats;
+
+  // Wrappers around the mbedtls cache/ticket callbacks that flag resumption
+  static int cacheGet(void* ctx, mbedtls_ssl_session* session);
+  static int cacheSet(void* ctx, const mbedtls_ssl_session* session);
+  static int ticketWrite(void* ctx, const mbedtls_ssl_session* session, unsigned char* start,
+                         const unsigned char* end, size_t* len, uint32_t* lifetime);
+  static int ticketParse(void* ctx, mbedtls_ssl_session* session, unsigned char* buf, size_t len);
+
+  bool configureCipherSuites();
+  static void logError(const char* what, int ret);
+
+  friend class TlsConnection;
+
+public:
+  TlsServer();
+  ~TlsServer();
+
+  bool begin(const String& certPEM, const String& keyPEM);
+  bool isReady() const { return ready; }
+  bool isEcdsa() const { return ecdsaKey; }
+  const mbedtls_ssl_config* getConfig() const { return &conf; }
+
+  void recordHandshake(bool resumed, bool ticket, unsigned long ms, unsigned long cpuUs);
+  void recordFailure();
+  const TlsStats& getStats() const { return stats; }
+  void addToJson(JsonObject obj);
+};
+
+// TLS state for one accepted socket. The record layer reads from and writes
+// to the plain WiFiClient without blocking (WANT_READ / WANT_WRITE).
+class TlsConnection {
+private:
+  mbedtls_ssl_context ssl;
+  WiFiClient* client;
+  TlsServer* server;
+  bool active;
+  bool established;
+  bool resumed;
+  bool ticketUsed;
+  unsigned long handshakeStart;
+  unsigned long handshakeCpuUs;  // Accumulated across handshake steps
+
+  static int bioSend(void* ctx, const unsigned char* buf, size_t len);
+  static int bioRecv(void* ctx, unsigned char* buf, size_t len);
+
+  friend class TlsServer;
+
+public:
+  TlsConnection();
+  ~TlsConnection();
+
+  bool begin(TlsServer& tlsServer, WiFiClient& socket);
+  int handshake(unsigned long now);  // 1 = done, 0 = in progress, -1 = failed
+  bool isEstablished() const { return established; }
+  bool isResumed() const { return resumed; }
+
+  int read(uint8_t* buf, size_t len);         // Bytes read, 0 if none pending, -1 on close/error
+  int write(const uint8_t* buf, size_t len);  // Bytes written, 0 if the socket is full, -1 on error
+  void stop();
+};
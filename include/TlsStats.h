@@ -0,0 +1,48 @@
+#pragma once
+#include <Arduino.h>
+
+// Handshake counters - a resumed handshake skips the private key operation.
+// Averages are 0 until a handshake of that kind has been counted.
+struct TlsStats {
+  unsigned long handshakes;
+  unsigned long fullHandshakes;
+  unsigned long resumedHandshakes;  // Session-ID cache or session ticket
+  unsigned long ticketResumes;
+  unsigned long failedHandshakes;
+  unsigned long fullHandshakeMsTotal;
+  unsigned long resumedHandshakeMsTotal;
+  unsigned long fullHandshakeCpuUsTotal;     // Time spent inside mbedtls_ssl_handshake()
+  unsigned long resumedHandshakeCpuUsTotal;
+  unsigned long lastHandshakeMs;
+  unsigned long lastHandshakeCpuUs;
+
+  void recordHandshake(bool resumed, bool ticket, unsigned long ms, unsigned long cpuUs) {
+    handshakes++;
+    lastHandshakeMs = ms;
+    lastHandshakeCpuUs = cpuUs;
+    if (resumed) {
+      resumedHandshakes++;
+      resumedHandshakeMsTotal += ms;
+      resumedHandshakeCpuUsTotal += cpuUs;
+      if (ticket) ticketResumes++;
+    } else {
+      fullHandshakes++;
+      fullHandshakeMsTotal += ms;
+      fullHandshakeCpuUsTotal += cpuUs;
+    }
+  }
+
+  void recordFailure() { failedHandshakes++; }
+
+  unsigned long averageFullMs() const { return fullHandshakes ? fullHandshakeMsTotal / fullHandshakes : 0; }
+  unsigned long averageResumedMs() const {
+    return resumedHandshakes ? resumedHandshakeMsTotal / resumedHandshakes : 0;
+  }
+  float averageFullCpuMs() const {
+    return fullHandshakes ? fullHandshakeCpuUsTotal / 1000.0f / fullHandshakes : 0.0f;
+  }
+  float averageResumedCpuMs() const {
+    return resumedHandshakes ? resumedHandshakeCpuUsTotal / 1000.0f / resumedHandshakes : 0.0f;
+  }
+  float resumeRate() const { return handshakes ? (float)resumedHandshakes / handshakes : 0.0f; }
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include "Config.h"
+#include "SensorType.h"
+
+// Samples of one channel's rolling window, times in seconds from 'origin'
+struct TrendWindow {
+  float times[TREND_WINDOW_SAMPLES];
+  float values[TREND_WINDOW_SAMPLES];
+  uint8_t oldest;
+  uint8_t count;
+  unsigned long origin;                       // millis() the stored times count from
+  unsigned long lastAdded;
+  // Running sums for the least-squares fit
+  double sumT;
+  double sumV;
+  double sumTT;
+  double sumTV;
+};
+
+// Slope of each channel's readings by least squares over a rolling time
+// window, kept with running sums so a new reading costs O(1): it is added
+// to the sums, and readings older than the window (or pushed out of the
+// fixed ring) are subtracted. Readings closer together than window /
+// TREND_WINDOW_SAMPLES are skipped so the ring spans the whole window
+// however fast a channel is sampled. When the ring's oldest slot comes
+// round, the times are rebased to it and the sums recomputed, so rounding
+// cannot build up over a long run. All storage is static.
+class TrendEstimator {
+private:
+  TrendWindow windows[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  unsigned long windowMs;
+  unsigned long spacingMs;                    // Minimum time between stored readings
+
+  void drop(TrendWindow& window);
+  void rebase(TrendWindow& window);
+
+public:
+  TrendEstimator();
+
+  void configure(unsigned long windowSeconds);
+  void reset();
+
+  // New reading of one channel; returns false if it was skipped
+  bool add(int sensorType, int channel, float value, unsigned long now);
+
+  // Units per minute; false until the window holds TREND_MIN_SAMPLES
+  // readings spanning at least a quarter of it
+  bool getSlope(int sensorType, int channel, float& perMinute) const;
+  int getSampleCount(int sensorType, int channel) const;
+
+  // Seconds until 'value' moving at 'perMinute' leaves [low, high]:
+  // 0 if already outside, -1 if flat or further out than TREND_MAX_PROJECTION_S
+  static long secondsToThreshold(float value, float perMinute, float low, float high);
+};
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""
+Native test build: add TlsServer.cpp when the host has mbedtls 2.x
+The firmware is written against the mbedtls 2.x bundled with arduino-esp32,
+so the host tests only build it against a 2.x install. Without one the TLS
+tests report themselves as ignored. Set MBEDTLS_DIR to use a local install.
+"""
+
+import os
+import re
+
+Import("env")
+
+CANDIDATES = [
+    os.environ.get("MBEDTLS_DIR", ""),
+    "/usr",
+    "/usr/local",
+    "/opt/homebrew/opt/mbedtls@2",
+    "/usr/local/opt/mbedtls@2",
+]
+
+def find_mbedtls2():
+    for prefix in CANDIDATES:
+        if not prefix:
+            continue
+        version_h = os.path.join(prefix, "include", "mbedtls", "version.h")
+        if not os.path.exists(version_h):
+            continue
+        with open(version_h) as f:
+            match = re.search(r"#define\s+MBEDTLS_VERSION_MAJOR\s+(\d+)", f.read())
+        if match and match.group(1) == "2":
+            return prefix
+    return None
+
+prefix = find_mbedtls2()
+if prefix:
+    print(f"mbedtls 2.x found in {prefix}: building TlsServer.cpp for the TLS tests")
+    env.Append(
+        CPPDEFINES=["NATIVE_MBEDTLS"],
+        CPPPATH=[os.path.join(prefix, "include")],
+        LIBPATH=[os.path.join(prefix, "lib")],
+        LIBS=["mbedtls", "mbedx509", "mbedcrypto"],
+        SRC_FILTER=["+<TlsServer.cpp>"],
+    )
+else:
+    print("mbedtls 2.x not found (set MBEDTLS_DIR): TLS handshake tests are skipped")
@@ -0,0 +1,116 @@
+#include "AdcBackend.h"
+#include "SensorTraits.h"
+
+#ifdef ESP32
+#include "esp_adc_cal.h"
+#endif
+
+void AdcBackend::buildLinearLut(float fullScaleMv) {
+  for (int raw = 0; raw < ADC_LUT_SIZE; raw++) {
+    lut[raw] = (uint16_t)((raw / SENSOR_ADC_MAX) * fullScaleMv + 0.5);
+  }
+}
+
+int AdcBackend::readSamples(int pin, uint16_t* raw, int count, int sampleDelayMs) {
+  for (int i = 0; i < count; i++) {
+    raw[i] = readRaw(pin);
+    if (sampleDelayMs > 0) {
+      delay(sampleDelayMs);
+    }
+  }
+  return count;
+}
+
+#ifdef ESP32
+Esp32AdcBackend::Esp32AdcBackend() : source("none"), continuous(false) {}
+
+void Esp32AdcBackend::setContinuous(bool enabled) {
+  continuous = enabled;
+}
+
+void Esp32AdcBackend::begin() {
+  unsigned long start = micros();
+
+  analogReadResolution(12);
+  analogSetAttenuation(ADC_11db);
+
+  esp_adc_cal_characteristics_t characteristics;
+  esp_adc_cal_value_t type = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+                                                      ADC_DEFAULT_VREF_MV, &characteristics);
+  switch (type) {
+    case ESP_ADC_CAL_VAL_EFUSE_TP:   source = "eFuse Two Point"; break;
+    case ESP_ADC_CAL_VAL_EFUSE_VREF: source = "eFuse Vref"; break;
+    default:                         source = "default Vref"; break;
+  }
+
+  for (int raw = 0; raw < ADC_LUT_SIZE; raw++) {
+    lut[raw] = esp_adc_cal_raw_to_voltage(raw, &characteristics);
+  }
+
+  Serial.printf("[ADC] ESP32 backend: %s characterization, %d-entry table built in %lu us\n",
+                source, ADC_LUT_SIZE, micros() - start);
+  Serial.printf("[ADC]   Raw 0 -> %umV, 2048 -> %umV, 4095 -> %umV\n",
+                lut[0], lut[2048], lut[4095]);
+
+  if (continuous && !dma.begin(&i2s)) {
+    Serial.println("[ADC] Continuous mode unavailable, using single reads");
+  }
+}
+
+int Esp32AdcBackend::readRaw(int pin) {
+  if (dma.isRunning()) {
+    // I2S owns ADC1 in continuous mode, so single reads come from the stream too
+    uint16_t raw;
+    if (dma.takeWindow(pin, &raw, 1) == 1) {
+      return raw;
+    }
+    return 0;
+  }
+  return analogRead(pin);
+}
+
+int Esp32AdcBackend::readSamples(int pin, uint16_t* raw, int count, int sampleDelayMs) {
+  if (!dma.isRunning()) {
+    return AdcBackend::readSamples(pin, raw, count, sampleDelayMs);
+  }
+  // One contiguous window from the stream; sampleDelayMs does not apply
+  return dma.takeWindow(pin, raw, count);
+}
+#endif
+
+ReplayAdcBackend::ReplayAdcBackend() : traceCount(0) {}
+
+bool ReplayAdcBackend::addTrace(int pin, const uint16_t* samples, int count) {
+  if (traceCount >= MAX_REPLAY_TRACES || samples == nullptr || count <= 0) {
+    return false;
+  }
+  AdcTrace& trace = traces[traceCount++];
+  trace.pin = pin;
+  trace.samples = samples;
+  trace.count = count;
+  trace.position = 0;
+  return true;
+}
+
+void ReplayAdcBackend::rewind() {
+  for (int i = 0; i < traceCount; i++) {
+    traces[i].position = 0;
+  }
+}
+
+void ReplayAdcBackend::begin() {
+  buildLinearLut(SENSOR_ADC_VREF * 1000.0);
+  Serial.printf("[ADC] Replay backend: %d traces\n", traceCount);
+}
+
+int ReplayAdcBackend::readRaw(int pin) {
+  for (int i = 0; i < traceCount; i++) {
+    AdcTrace& trace = traces[i];
+    if (trace.pin == pin) {
+      int raw = trace.samples[trace.position];
+      trace.position = (trace.position + 1) % trace.count;
+      return raw;
+    }
+  }
+  return 0;
+}
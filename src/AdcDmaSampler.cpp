@@ -0,0 +1,192 @@
+#include "AdcDmaSampler.h"
+
+#ifdef ESP32
+#include "driver/i2s.h"
+#include "driver/adc.h"
+
+I2sAdcProducer::I2sAdcProducer() : installed(false) {}
+
+bool I2sAdcProducer::start(int sampleRate) {
+  i2s_config_t config = {};
+  config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+  config.sample_rate = sampleRate;
+  config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+  config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+  config.intr_alloc_flags = 0;
+  config.dma_buf_count = ADC_DMA_BUFFER_COUNT;
+  config.dma_buf_len = ADC_DMA_BUFFER_LEN;
+  config.use_apll = false;
+
+  if (i2s_driver_install(I2S_NUM_0, &config, 0, NULL) != ESP_OK) {
+    Serial.println("[ADC] I2S driver install failed");
+    return false;
+  }
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  installed = true;
+  return true;
+}
+
+bool I2sAdcProducer::setChannel(int adcChannel) {
+  if (!installed) return false;
+  i2s_adc_disable(I2S_NUM_0);
+  adc1_config_channel_atten((adc1_channel_t)adcChannel, ADC_ATTEN_DB_11);
+  if (i2s_set_adc_mode(ADC_UNIT_1, (adc1_channel_t)adcChannel) != ESP_OK) {
+    return false;
+  }
+  return i2s_adc_enable(I2S_NUM_0) == ESP_OK;
+}
+
+int I2sAdcProducer::fill(uint16_t* words, int maxWords, uint32_t timeoutMs) {
+  if (!installed) return 0;
+  size_t bytesRead = 0;
+  i2s_read(I2S_NUM_0, words, maxWords * sizeof(uint16_t), &bytesRead, pdMS_TO_TICKS(timeoutMs));
+  return bytesRead / sizeof(uint16_t);
+}
+#endif
+
+SimulatedAdcProducer::SimulatedAdcProducer(int staleBuffersAfterSwitch, int noise)
+  : channel(-1), previousChannel(-1), staleBuffers(staleBuffersAfterSwitch),
+    staleRemaining(0), noiseLsb(noise) {
+  for (int i = 0; i < 8; i++) {
+    levels[i] = 0;
+  }
+}
+
+void SimulatedAdcProducer::setLevel(int adcChannel, uint16_t raw) {
+  if (adcChannel >= 0 && adcChannel < 8) {
+    levels[adcChannel] = raw & ADC_DMA_VALUE_MASK;
+  }
+}
+
+bool SimulatedAdcProducer::start(int sampleRate) {
+  return true;
+}
+
+bool SimulatedAdcProducer::setChannel(int adcChannel) {
+  if (adcChannel < 0 || adcChannel >= 8) return false;
+  previousChannel = channel;
+  channel = adcChannel;
+  staleRemaining = (previousChannel >= 0) ? staleBuffers : 0;
+  return true;
+}
+
+int SimulatedAdcProducer::fill(uint16_t* words, int maxWords, uint32_t timeoutMs) {
+  if (channel < 0) return 0;
+
+  int tag = channel;
+  if (staleRemaining > 0) {
+    tag = previousChannel;
+    staleRemaining--;
+  }
+
+  int count = maxWords < ADC_DMA_BUFFER_LEN ? maxWords : ADC_DMA_BUFFER_LEN;
+  for (int i = 0; i < count; i++) {
+    int value = levels[tag];
+    if (noiseLsb > 0) {
+      value += (i % (2 * noiseLsb + 1)) - noiseLsb;
+    }
+    value = constrain(value, 0, ADC_DMA_VALUE_MASK);
+    words[i] = (uint16_t)((tag << ADC_DMA_TAG_SHIFT) | value);
+  }
+  return count;
+}
+
+AdcDmaSampler::AdcDmaSampler()
+  : producer(nullptr), head(0), tail(0), activeChannel(-1), running(false),
+    framesFed(0), samplesTaken(0), samplesDropped(0), overruns(0), timeouts(0) {}
+
+bool AdcDmaSampler::begin(AdcDmaProducer* source, int sampleRate) {
+  producer = source;
+  running = producer && producer->start(sampleRate);
+  if (running) {
+    Serial.printf("[ADC] Continuous sampling at %d Hz, %d x %d sample DMA buffers\n",
+                  sampleRate, ADC_DMA_BUFFER_COUNT, ADC_DMA_BUFFER_LEN);
+  }
+  return running;
+}
+
+bool AdcDmaSampler::isRunning() const {
+  return running;
+}
+
+void AdcDmaSampler::feedFrame(const uint16_t* words, int count) {
+  for (int i = 0; i < count; i++) {
+    if (head - tail >= ADC_DMA_RING_SIZE) {
+      tail++;  // Full: the oldest sample is the least useful one
+      overruns++;
+    }
+    ring[head & (ADC_DMA_RING_SIZE - 1)] = words[i];
+    head++;
+  }
+  framesFed++;
+}
+
+bool AdcDmaSampler::pull(uint32_t timeoutMs) {
+  uint16_t frame[ADC_DMA_BUFFER_LEN];
+  int count = producer->fill(frame, ADC_DMA_BUFFER_LEN, timeoutMs);
+  if (count <= 0) return false;
+  feedFrame(frame, count);
+  return true;
+}
+
+bool AdcDmaSampler::selectPin(int pin) {
+  int adcChannel = digitalPinToAnalogChannel(pin);
+  if (adcChannel < 0 || adcChannel > 7) {
+    return false;  // Not on ADC1
+  }
+  if (adcChannel != activeChannel) {
+    if (!producer->setChannel(adcChannel)) {
+      return false;
+    }
+    activeChannel = adcChannel;
+  }
+  return true;
+}
+
+void AdcDmaSampler::flush() {
+  // Drain what is already queued (at most every DMA buffer)...
+  for (int i = 0; i < ADC_DMA_BUFFER_COUNT && pull(0); i++) {
+    ;
+  }
+  // ...plus the buffer that was filling when the select settled
+  pull(ADC_DMA_READ_TIMEOUT_MS);
+  samplesDropped += head - tail;
+  tail = head;
+}
+
+int AdcDmaSampler::takeWindow(int pin, uint16_t* raw, int count) {
+  if (!running || !selectPin(pin)) return 0;
+  if (count > ADC_DMA_MAX_WINDOW) count = ADC_DMA_MAX_WINDOW;
+
+  flush();
+
+  int taken = 0;
+  while (taken < count) {
+    if (head == tail && !pull(ADC_DMA_READ_TIMEOUT_MS)) {
+      timeouts++;
+      break;
+    }
+    while (head != tail && taken < count) {
+      uint16_t word = ring[tail & (ADC_DMA_RING_SIZE - 1)];
+      tail++;
+      if ((word >> ADC_DMA_TAG_SHIFT) != activeChannel) {
+        samplesDropped++;
+        continue;
+      }
+      raw[taken++] = word & ADC_DMA_VALUE_MASK;
+    }
+  }
+
+  samplesTaken += taken;
+  return taken;
+}
+
+int AdcDmaSampler::available() const {
+  return head - tail;
+}
+
+void AdcDmaSampler::printStats() {
+  Serial.printf("  [ADC] DMA: %lu frames, %lu samples used, %lu dropped, %lu overruns, %lu timeouts\n",
+                framesFed, samplesTaken, samplesDropped, overruns, timeouts);
+}
@@ -0,0 +1,266 @@
+#include "AlarmEngine.h"
+
+AlarmEngine::AlarmEngine() {
+  clear();
+}
+
+void AlarmEngine::clear() {
+  ruleCount = 0;
+  activeCount = 0;
+  evaluations = 0;
+  eventCount = 0;
+  for (int k = 0; k < ALARM_KINDS; k++) {
+    for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+      for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+        ruleIndex[k][t][i] = NO_ALARM_RULE;
+      }
+    }
+  }
+}
+
+int AlarmEngine::allocateRule(int kind, int sensorType, int channel) {
+  // A channel in two aquariums keeps the last one, as the channel map does
+  int index = ruleIndex[kind][sensorType][channel];
+  if (index == NO_ALARM_RULE) {
+    if (ruleCount >= MAX_ALARM_RULES) return NO_ALARM_RULE;
+    index = ruleCount++;
+    ruleIndex[kind][sensorType][channel] = index;
+  }
+  AlarmStatus& status = statuses[index];
+  memset(&status, 0, sizeof(status));
+  status.state = ALARM_NORMAL;
+  status.inRange = true;
+  return index;
+}
+
+bool AlarmEngine::addRule(int sensorType, int channel, int aquarium, float low, float high, float hysteresis,
+                          unsigned long raiseDelayMs, unsigned long clearDelayMs) {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return false;
+  }
+  if (!(high > low)) {
+    Serial.printf("[ALARM] %s channel %d: empty range %.2f..%.2f, no rule\n",
+                  sensorTypeName(sensorType), channel, low, high);
+    return false;
+  }
+
+  int index = allocateRule(ALARM_RANGE, sensorType, channel);
+  if (index == NO_ALARM_RULE) return false;
+
+  // A band of half the range or more could never clear
+  float maxHysteresis = (high - low) * 0.45;
+  AlarmRule& rule = rules[index];
+  rule.kind = ALARM_RANGE;
+  rule.sensorType = sensorType;
+  rule.channel = channel;
+  rule.aquarium = aquarium;
+  rule.low = low;
+  rule.high = high;
+  rule.hysteresis = constrain(hysteresis, 0.0f, maxHysteresis);
+  rule.raiseDelayMs = raiseDelayMs;
+  rule.clearDelayMs = clearDelayMs;
+  return true;
+}
+
+bool AlarmEngine::addRateRule(int sensorType, int channel, int aquarium, float maxPerMinute, float hysteresis,
+                              unsigned long raiseDelayMs, unsigned long clearDelayMs) {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return false;
+  }
+  if (!(maxPerMinute > 0.0)) return false;  // 0 turns the rate alarm off
+
+  int index = allocateRule(ALARM_RATE, sensorType, channel);
+  if (index == NO_ALARM_RULE) return false;
+
+  AlarmRule& rule = rules[index];
+  rule.kind = ALARM_RATE;
+  rule.sensorType = sensorType;
+  rule.channel = channel;
+  rule.aquarium = aquarium;
+  rule.low = -maxPerMinute;
+  rule.high = maxPerMinute;
+  rule.hysteresis = constrain(hysteresis, 0.0f, maxPerMinute * 0.9f);
+  rule.raiseDelayMs = raiseDelayMs;
+  rule.clearDelayMs = clearDelayMs;
+  return true;
+}
+
+void AlarmEngine::enter(AlarmStatus& status, uint8_t state, unsigned long now) {
+  status.state = state;
+  status.since = now;
+}
+
+void AlarmEngine::record(int rule, uint8_t state, unsigned long now) {
+  const AlarmStatus& status = statuses[rule];
+  AlarmEvent& event = events[eventCount % ALARM_EVENT_LOG];
+  event.sequence = ++eventCount;
+  event.rule = rule;
+  event.state = state;
+  event.side = status.side;
+  event.value = status.value;
+  event.at = now;
+
+  const AlarmRule& r = rules[rule];
+  if (r.kind == ALARM_RATE) {
+    Serial.printf("[ALARM] %s channel %d (aquarium %d) rate %s: %.3f/min, limit %.3f/min\n",
+                  sensorTypeName(r.sensorType), r.channel, r.aquarium,
+                  state == ALARM_ACTIVE ? (status.side == ALARM_SIDE_LOW ? "raised falling" : "raised rising") : "cleared",
+                  status.value, r.high);
+    return;
+  }
+  Serial.printf("[ALARM] %s channel %d (aquarium %d) %s: %.2f, range %.2f..%.2f\n",
+                sensorTypeName(r.sensorType), r.channel, r.aquarium,
+                state == ALARM_ACTIVE ? (status.side == ALARM_SIDE_LOW ? "raised low" : "raised high") : "cleared",
+                status.value, r.low, r.high);
+}
+
+void AlarmEngine::evaluate(int sensorType, int channel, float value, unsigned long now) {
+  evaluateRule(ALARM_RANGE, sensorType, channel, value, now);
+}
+
+void AlarmEngine::evaluateRate(int sensorType, int channel, float perMinute, unsigned long now) {
+  evaluateRule(ALARM_RATE, sensorType, channel, perMinute, now);
+}
+
+void AlarmEngine::evaluateRule(int kind, int sensorType, int channel, float value, unsigned long now) {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return;
+  }
+  int index = ruleIndex[kind][sensorType][channel];
+  if (index == NO_ALARM_RULE) return;
+
+  AlarmStatus& status = statuses[index];
+  bool settled = status.state == ALARM_NORMAL || status.state == ALARM_ACTIVE;
+  if (status.evaluated && settled && value == status.value) {
+    return;  // Nothing changed and no delay is running
+  }
+
+  const AlarmRule& rule = rules[index];
+  status.value = value;
+  status.evaluated = true;
+  evaluations++;
+
+  uint8_t side = value < rule.low ? ALARM_SIDE_LOW : (value > rule.high ? ALARM_SIDE_HIGH : ALARM_SIDE_NONE);
+  bool clearOfBand = value >= rule.low + rule.hysteresis && value <= rule.high - rule.hysteresis;
+  status.inRange = side == ALARM_SIDE_NONE;
+
+  switch (status.state) {
+    case ALARM_NORMAL:
+      if (side == ALARM_SIDE_NONE) break;
+      status.side = side;
+      enter(status, ALARM_PENDING, now);
+      // Fall through to raise at once when there is no delay
+    case ALARM_PENDING:
+      if (side == ALARM_SIDE_NONE) {
+        status.side = ALARM_SIDE_NONE;
+        enter(status, ALARM_NORMAL, now);
+      } else if (now - status.since >= rule.raiseDelayMs) {
+        status.side = side;
+        status.raisedAt = now;
+        status.raiseCount++;
+        activeCount++;
+        enter(status, ALARM_ACTIVE, now);
+        record(index, ALARM_ACTIVE, now);
+      }
+      break;
+
+    case ALARM_ACTIVE:
+      if (clearOfBand) {
+        enter(status, ALARM_CLEARING, now);
+        if (rule.clearDelayMs > 0) break;
+        // Fall through to clear at once when there is no delay
+      } else {
+        if (side != ALARM_SIDE_NONE) status.side = side;
+        break;
+      }
+    case ALARM_CLEARING:
+      if (!clearOfBand) {
+        // Left the band again: still the same alarm
+        if (side != ALARM_SIDE_NONE) status.side = side;
+        enter(status, ALARM_ACTIVE, status.raisedAt);
+      } else if (now - status.since >= rule.clearDelayMs) {
+        status.clearedAt = now;
+        activeCount--;
+        enter(status, ALARM_NORMAL, now);
+        record(index, ALARM_NORMAL, now);
+        status.side = ALARM_SIDE_NONE;
+      }
+      break;
+  }
+}
+
+int AlarmEngine::getRuleCount() const {
+  return ruleCount;
+}
+
+int AlarmEngine::findRule(int sensorType, int channel, int kind) const {
+  if (kind < 0 || kind >= ALARM_KINDS || sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT ||
+      channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return NO_ALARM_RULE;
+  }
+  return ruleIndex[kind][sensorType][channel];
+}
+
+const AlarmRule& AlarmEngine::getRule(int rule) const {
+  return rules[rule];
+}
+
+const AlarmStatus& AlarmEngine::getStatus(int rule) const {
+  return statuses[rule];
+}
+
+int AlarmEngine::getActiveCount() const {
+  return activeCount;
+}
+
+bool AlarmEngine::isAquariumInAlarm(int aquarium) const {
+  if (activeCount == 0) return false;
+  for (int i = 0; i < ruleCount; i++) {
+    if (rules[i].aquarium == aquarium &&
+        (statuses[i].state == ALARM_ACTIVE || statuses[i].state == ALARM_CLEARING)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t AlarmEngine::getEvaluations() const {
+  return evaluations;
+}
+
+int AlarmEngine::getEventsSince(uint32_t sequence, AlarmEvent* out, int max) const {
+  // Oldest event still in the ring
+  uint32_t first = eventCount > ALARM_EVENT_LOG ? eventCount - ALARM_EVENT_LOG + 1 : 1;
+  if (sequence + 1 > first) first = sequence + 1;
+
+  int count = 0;
+  for (uint32_t seq = first; seq <= eventCount && count < max; seq++) {
+    out[count++] = events[(seq - 1) % ALARM_EVENT_LOG];
+  }
+  return count;
+}
+
+uint32_t AlarmEngine::getLastSequence() const {
+  return eventCount;
+}
+
+const char* AlarmEngine::stateName(uint8_t state) {
+  switch (state) {
+    case ALARM_PENDING: return "pending";
+    case ALARM_ACTIVE: return "alarm";
+    case ALARM_CLEARING: return "clearing";
+    default: return "normal";
+  }
+}
+
+const char* AlarmEngine::sideName(uint8_t side) {
+  switch (side) {
+    case ALARM_SIDE_LOW: return "low";
+    case ALARM_SIDE_HIGH: return "high";
+    default: return "none";
+  }
+}
+
+const char* AlarmEngine::kindName(uint8_t kind) {
+  return kind == ALARM_RATE ? "rate" : "range";
+}
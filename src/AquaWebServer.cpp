@@ -1,11 +1,22 @@
 #include "AquaWebServer.h"
 #include "SystemMonitor.h"
 #include "SensorManager.h"
-#include "TemperatureSensor.h"
-#include "PHSensor.h"
-#include "TDSSensor.h"
 
-AquaWebServer::AquaWebServer() : server(WEB_SERVER_PORT), sensorController(nullptr), calibrationManager(nullptr), configManager(nullptr), templateManager(nullptr) {
+// Sees every request before it is routed, whichever handler ends up
+// answering it, and never rewrites anything
+class FirstResponseMarker : public AsyncWebRewrite {
+public:
+  FirstResponseMarker() : AsyncWebRewrite("", "") {}
+
+  bool match(AsyncWebServerRequest *request) override {
+    getBootProfiler().markFirstHttpResponse();
+    return false;
+  }
+};
+
+AquaWebServer::AquaWebServer() : server(WEB_SERVER_PORT), sensorController(nullptr), calibrationManager(nullptr), configManager(nullptr), templateManager(nullptr),
+    captureEvents("/api/calibration/events"), captureActualValue(0.0), captureTemperature(25.0),
+    captureEventRevision(0), lastCaptureEvent(0) {
   enableHTTPS = false;  // HTTPS not supported by ESPAsyncWebServer
   requireSecureConnection = false;
   sslInitialized = false;
@@ -44,6 +55,9 @@ void AquaWebServer::setConfigManager(ConfigManager* config) {
 }
 
 void AquaWebServer::setupRoutes() {
+  // Boot milestone for the first request served (the server owns the rewrite)
+  server.addRewrite(new FirstResponseMarker());
+
   // Add security headers to all responses
   server.onNotFound([this](AsyncWebServerRequest *request) {
     addSecurityHeaders(request);
@@ -89,6 +103,12 @@ void AquaWebServer::setupRoutes() {
     handleApiAquariums(request);
   });
 
+  // Raised and pending range alarms with the latest raises and clears
+  server.on("/api/alarms", HTTP_GET, [this](AsyncWebServerRequest *request){
+    addSecurityHeaders(request);
+    handleApiAlarms(request);
+  });
+
   // Calibration routes
   server.on("/calibration", HTTP_GET, [this](AsyncWebServerRequest *request){
     handleCalibrationPage(request);
@@ -113,6 +133,42 @@ void AquaWebServer::setupRoutes() {
   server.on("/api/calibration/reading", HTTP_GET, [this](AsyncWebServerRequest *request){
     handleCalibrationReading(request);
   });
+  
+  // Batched calibration of several probes in the same reference solution
+  server.on("/api/calibration/session", HTTP_GET, [this](AsyncWebServerRequest *request){
+    handleSessionStatus(request);
+  });
+  
+  server.on("/api/calibration/session/start", HTTP_POST, [this](AsyncWebServerRequest *request){
+    handleSessionStart(request);
+  });
+  
+  server.on("/api/calibration/session/point", HTTP_POST, [this](AsyncWebServerRequest *request){
+    handleSessionPoint(request);
+  });
+  
+  server.on("/api/calibration/session/finalize", HTTP_POST, [this](AsyncWebServerRequest *request){
+    handleSessionFinalize(request);
+  });
+  
+  server.on("/api/calibration/session/cancel", HTTP_POST, [this](AsyncWebServerRequest *request){
+    handleSessionCancel(request);
+  });
+  
+  // Stability-gated point capture, progress on /api/calibration/events
+  server.on("/api/calibration/capture", HTTP_POST, [this](AsyncWebServerRequest *request){
+    handleStartCapture(request);
+  });
+  
+  server.on("/api/calibration/capture", HTTP_GET, [this](AsyncWebServerRequest *request){
+    handleCaptureStatus(request);
+  });
+  
+  server.on("/api/calibration/capture/cancel", HTTP_POST, [this](AsyncWebServerRequest *request){
+    handleCancelCapture(request);
+  });
+  
+  server.addHandler(&captureEvents);
 
   server.on("/help", HTTP_GET, [this](AsyncWebServerRequest *request){
     handleHelpPage(request);
@@ -162,25 +218,27 @@ void AquaWebServer::handleApiSensors(AsyncWebServerRequest *request) {
   }
   
   JsonDocument doc;
-  TemperatureData& tempData = sensorController->getTemperatureSensors().getData();
-  PHData& phData = sensorController->getPHSensors().getData();
+  TemperatureSensor& tempSensors = sensorController->getTemperatureSensors();
+  PHSensor& phSensors = sensorController->getPHSensors();
   TDSSensor& tdsSensors = sensorController->getTDSSensors();
+  TemperatureData& tempData = tempSensors.getData();
+  PHData& phData = phSensors.getData();
   
   JsonArray tempArray = doc["temperature"].to<JsonArray>();
-  for (int i = 0; i < NUM_TEMP_SENSORS; i++) {
+  for (int i = 0; i < tempSensors.getSensorCount(); i++) {
     tempArray.add(tempData.readings[i]);
   }
   
   JsonArray phArray = doc["ph"].to<JsonArray>();
-  for (int i = 0; i < NUM_PH_SENSORS; i++) {
+  for (int i = 0; i < phSensors.getSensorCount(); i++) {
     phArray.add(phData.readings[i]);
   }
   
   JsonArray tdsArray = doc["tds"].to<JsonArray>();
-  for (int i = 0; i < NUM_TDS_SENSORS; i++) {
+  for (int i = 0; i < tdsSensors.getSensorCount(); i++) {
     JsonObject tdsObj = tdsArray.add<JsonObject>();
-    tdsObj["ppm"] = tdsSensors.getTDSReading(i);
-    tdsObj["ec"] = tdsSensors.getECReading(i);
+    tdsObj["ppm"] = tdsSensors.getReading(i);
+    tdsObj["ec"] = tdsSensors.getSecondaryReading(i);
   }
   
   doc["lastUpdate"] = tempData.lastUpdate;
@@ -207,6 +265,8 @@ void AquaWebServer::handleApiTemperature(AsyncWebServerRequest *request) {
     JsonObject sensor = tempArray.add<JsonObject>();
     sensor["id"] = i + 1;
     sensor["value"] = data.readings[i];
+    sensor["raw"] = data.rawReadings[i];
+    sensor["variance"] = data.variances[i];
     sensor["unit"] = "C";
   }
   
@@ -234,6 +294,8 @@ void AquaWebServer::handleApiPH(AsyncWebServerRequest *request) {
     JsonObject sensor = phArray.add<JsonObject>();
     sensor["id"] = i + 1;
     sensor["value"] = data.readings[i];
+    sensor["raw"] = data.rawReadings[i];
+    sensor["variance"] = data.variances[i];
     sensor["unit"] = "pH";
   }
   
@@ -259,8 +321,10 @@ void AquaWebServer::handleApiTDS(AsyncWebServerRequest *request) {
   for (int i = 0; i < tdsSensors.getSensorCount(); i++) {
     JsonObject sensor = tdsArray.add<JsonObject>();
     sensor["id"] = i + 1;
-    sensor["tds"] = tdsSensors.getTDSReading(i);
-    sensor["ec"] = tdsSensors.getECReading(i);
+    sensor["tds"] = tdsSensors.getReading(i);
+    sensor["raw"] = tdsSensors.getRawReading(i);
+    sensor["variance"] = tdsSensors.getVariance(i);
+    sensor["ec"] = tdsSensors.getSecondaryReading(i);
     sensor["tds_unit"] = "ppm";
     sensor["ec_unit"] = "&#181;S/cm";
   }
@@ -307,17 +371,25 @@ void AquaWebServer::handleApiStatus(AsyncWebServerRequest *request) {
   doc["wifi"]["ip"] = WiFi.localIP().toString();
   doc["wifi"]["mac"] = WiFi.macAddress();
   doc["wifi"]["channel"] = WiFi.channel();
+  getNetworkManager().addToJson(doc["wifi"]["link"].to<JsonObject>());
   
   // Performance indicators
   doc["performance"]["taskStackHighWaterMark"] = uxTaskGetStackHighWaterMark(NULL);
   doc["performance"]["resetReason"] = esp_reset_reason();
   
+  // Boot phase timings and first sample/response milestones
+  getBootProfiler().addToJson(doc["boot"].to<JsonObject>());
+  
+  // MQTT connection and store-and-forward queue
+  getMqttPublisher().addToJson(doc["mqtt"].to<JsonObject>());
+  
   // Sensor status
   if (sensorController) {
     doc["sensors"]["temperature"] = sensorController->getTemperatureSensors().getSensorCount();
     doc["sensors"]["ph"] = sensorController->getPHSensors().getSensorCount();
     doc["sensors"]["tds"] = sensorController->getTDSSensors().getSensorCount();
     doc["sensors"]["status"] = "active";
+    sensorController->getScheduler().addToJson(doc["sampling"].to<JsonObject>());
   } else {
     doc["sensors"]["temperature"] = 0;
     doc["sensors"]["ph"] = 0;
@@ -343,6 +415,53 @@ void AquaWebServer::handleApiStatus(AsyncWebServerRequest *request) {
   request->send(200, "application/json", response);
 }
 
+// Range, trend and alarm state of one channel as last evaluated by its
+// rules; returns how many of its alarms are raised. 'soonest' is lowered to
+// the channel's projected time to a range limit.
+static int addAlarmStatus(JsonObject sensor, const AlarmEngine& alarms, const TrendEstimator& trends,
+                          int type, int channel, unsigned long now, long& soonest) {
+  int raised = 0;
+  int rule = alarms.findRule(type, channel);
+  if (rule == NO_ALARM_RULE) {
+    sensor["in_range"] = true;
+    sensor["status"] = "normal";
+  } else {
+    const AlarmRule& range = alarms.getRule(rule);
+    const AlarmStatus& status = alarms.getStatus(rule);
+    sensor["min_range"] = range.low;
+    sensor["max_range"] = range.high;
+    sensor["in_range"] = status.inRange;
+    sensor["status"] = AlarmEngine::stateName(status.state);
+    if (status.state != ALARM_NORMAL) {
+      sensor["side"] = AlarmEngine::sideName(status.side);
+      sensor["since_s"] = (now - status.since) / 1000;
+    }
+    if (status.state == ALARM_ACTIVE || status.state == ALARM_CLEARING) raised++;
+  }
+  
+  float perMinute;
+  if (!trends.getSlope(type, channel, perMinute)) {
+    return raised;
+  }
+  sensor["trend_per_min"] = perMinute;
+  if (rule != NO_ALARM_RULE) {
+    const AlarmRule& range = alarms.getRule(rule);
+    long seconds = TrendEstimator::secondsToThreshold(alarms.getStatus(rule).value, perMinute, range.low, range.high);
+    if (seconds >= 0) {
+      sensor["time_to_limit_s"] = seconds;
+      if (soonest < 0 || seconds < soonest) soonest = seconds;
+    }
+  }
+  int rateRule = alarms.findRule(type, channel, ALARM_RATE);
+  if (rateRule != NO_ALARM_RULE) {
+    const AlarmStatus& rate = alarms.getStatus(rateRule);
+    sensor["rate_limit_per_min"] = alarms.getRule(rateRule).high;
+    sensor["rate_status"] = AlarmEngine::stateName(rate.state);
+    if (rate.state == ALARM_ACTIVE || rate.state == ALARM_CLEARING) raised++;
+  }
+  return raised;
+}
+
 void AquaWebServer::handleApiAquariums(AsyncWebServerRequest *request) {
   JsonDocument doc;
   
@@ -355,11 +474,17 @@ void AquaWebServer::handleApiAquariums(AsyncWebServerRequest *request) {
   }
   
   // Get sensor data
-  TemperatureData tempData = sensorController->getTemperatureSensors().getData();
-  PHData phData = sensorController->getPHSensors().getData();
-  TDSData tdsData = sensorController->getTDSSensors().getData();
-  
-  doc["timestamp"] = millis();
+  TemperatureSensor& tempBank = sensorController->getTemperatureSensors();
+  PHSensor& phBank = sensorController->getPHSensors();
+  TDSSensor& tdsBank = sensorController->getTDSSensors();
+  TemperatureData& tempData = tempBank.getData();
+  PHData& phData = phBank.getData();
+  TDSData& tdsData = tdsBank.getData();
+  const AlarmEngine& alarms = sensorController->getAlarms();
+  const TrendEstimator& trends = sensorController->getTrends();
+  unsigned long now = millis();
+  
+  doc["timestamp"] = now;
   doc["aquarium_count"] = configManager->getAquariumCount();
   
   JsonArray aquariums = doc["aquariums"].to<JsonArray>();
@@ -378,80 +503,59 @@ void AquaWebServer::handleApiAquariums(AsyncWebServerRequest *request) {
       continue; // Skip disabled aquariums
     }
     
+    // Sensors for this aquarium come from the channel map built at boot;
+    // range state comes from the alarm rules evaluated in the scan loop
+    int activeAlarms = 0;
+    long soonest = -1;
+    
+    // Temperature this aquarium's pH and TDS readings are compensated at
+    aquarium["compensation_temperature"] = sensorController->getCompensationTemperature(aqIndex);
+    aquarium["compensation_source"] = sensorController->hasAquariumTemperature(aqIndex) ? "probe" : "reference";
+    
     // Temperature sensors for this aquarium
     JsonArray tempSensors = aquarium["sensors"]["temperature"].to<JsonArray>();
-    for (int i = 0; i < configManager->getTemperatureSensorCount(aqIndex); i++) {
-      int sensorId = configManager->getTemperatureSensorID(aqIndex, i);
-      if (sensorId >= 0 && sensorId < NUM_TEMP_SENSORS) {
+    for (int sensorId = 0; sensorId < tempBank.getSensorCount(); sensorId++) {
+      if (tempBank.getAquarium(sensorId) == aqIndex) {
         JsonObject tempSensor = tempSensors.add<JsonObject>();
         tempSensor["id"] = sensorId;
         tempSensor["value"] = tempData.readings[sensorId];
-        tempSensor["min_range"] = configManager->getTemperatureMin(aqIndex);
-        tempSensor["max_range"] = configManager->getTemperatureMax(aqIndex);
-        tempSensor["in_range"] = configManager->isTemperatureInRange(aqIndex, tempData.readings[sensorId]);
-        tempSensor["status"] = tempSensor["in_range"].as<bool>() ? "normal" : "alarm";
+        tempSensor["raw"] = tempData.rawReadings[sensorId];
+        tempSensor["variance"] = tempData.variances[sensorId];
+        activeAlarms += addAlarmStatus(tempSensor, alarms, trends, SENSOR_TEMPERATURE, sensorId, now, soonest);
       }
     }
     
     // pH sensors for this aquarium
     JsonArray phSensors = aquarium["sensors"]["ph"].to<JsonArray>();
-    for (int i = 0; i < configManager->getPHSensorCount(aqIndex); i++) {
-      int sensorId = configManager->getPHSensorID(aqIndex, i);
-      if (sensorId >= 0 && sensorId < NUM_PH_SENSORS) {
+    for (int sensorId = 0; sensorId < phBank.getSensorCount(); sensorId++) {
+      if (phBank.getAquarium(sensorId) == aqIndex) {
         JsonObject phSensor = phSensors.add<JsonObject>();
         phSensor["id"] = sensorId;
         phSensor["value"] = phData.readings[sensorId];
-        phSensor["min_range"] = configManager->getPHMin(aqIndex);
-        phSensor["max_range"] = configManager->getPHMax(aqIndex);
-        phSensor["in_range"] = configManager->isPHInRange(aqIndex, phData.readings[sensorId]);
-        phSensor["status"] = phSensor["in_range"].as<bool>() ? "normal" : "alarm";
+        phSensor["raw"] = phData.rawReadings[sensorId];
+        phSensor["variance"] = phData.variances[sensorId];
+        activeAlarms += addAlarmStatus(phSensor, alarms, trends, SENSOR_PH, sensorId, now, soonest);
       }
     }
     
     // TDS sensors for this aquarium
     JsonArray tdsSensors = aquarium["sensors"]["tds"].to<JsonArray>();
-    for (int i = 0; i < configManager->getTDSSensorCount(aqIndex); i++) {
-      int sensorId = configManager->getTDSSensorID(aqIndex, i);
-      if (sensorId >= 0 && sensorId < NUM_TDS_SENSORS) {
+    for (int sensorId = 0; sensorId < tdsBank.getSensorCount(); sensorId++) {
+      if (tdsBank.getAquarium(sensorId) == aqIndex) {
         JsonObject tdsSensor = tdsSensors.add<JsonObject>();
         tdsSensor["id"] = sensorId;
         tdsSensor["value"] = tdsData.readings[sensorId];
-        tdsSensor["min_range"] = configManager->getTDSMin(aqIndex);
-        tdsSensor["max_range"] = configManager->getTDSMax(aqIndex);
-        tdsSensor["in_range"] = configManager->isTDSInRange(aqIndex, tdsData.readings[sensorId]);
-        tdsSensor["status"] = tdsSensor["in_range"].as<bool>() ? "normal" : "alarm";
+        tdsSensor["raw"] = tdsData.rawReadings[sensorId];
+        tdsSensor["variance"] = tdsData.variances[sensorId];
+        activeAlarms += addAlarmStatus(tdsSensor, alarms, trends, SENSOR_TDS, sensorId, now, soonest);
       }
     }
     
-    // Calculate overall aquarium health
-    bool allInRange = true;
-    for (int i = 0; i < configManager->getTemperatureSensorCount(aqIndex); i++) {
-      int sensorId = configManager->getTemperatureSensorID(aqIndex, i);
-      if (sensorId >= 0 && !configManager->isTemperatureInRange(aqIndex, tempData.readings[sensorId])) {
-        allInRange = false;
-        break;
-      }
-    }
-    if (allInRange) {
-      for (int i = 0; i < configManager->getPHSensorCount(aqIndex); i++) {
-        int sensorId = configManager->getPHSensorID(aqIndex, i);
-        if (sensorId >= 0 && !configManager->isPHInRange(aqIndex, phData.readings[sensorId])) {
-          allInRange = false;
-          break;
-        }
-      }
-    }
-    if (allInRange) {
-      for (int i = 0; i < configManager->getTDSSensorCount(aqIndex); i++) {
-        int sensorId = configManager->getTDSSensorID(aqIndex, i);
-        if (sensorId >= 0 && !configManager->isTDSInRange(aqIndex, tdsData.readings[sensorId])) {
-          allInRange = false;
-          break;
-        }
-      }
+    aquarium["active_alarms"] = activeAlarms;
+    if (soonest >= 0) {
+      aquarium["time_to_limit_s"] = soonest;   // Nearest projected range crossing
     }
-    
-    aquarium["overall_status"] = allInRange ? "healthy" : "alarm";
+    aquarium["overall_status"] = activeAlarms == 0 ? "healthy" : "alarm";
   }
   
   String response;
@@ -460,6 +564,60 @@ void AquaWebServer::handleApiAquariums(AsyncWebServerRequest *request) {
   request->send(200, "application/json", response);
 }
 
+void AquaWebServer::handleApiAlarms(AsyncWebServerRequest *request) {
+  if (!sensorController) {
+    request->send(500, "application/json", "{\"error\":\"Sensor controller not initialized\"}");
+    return;
+  }
+  
+  const AlarmEngine& alarms = sensorController->getAlarms();
+  unsigned long now = millis();
+  JsonDocument doc;
+  doc["timestamp"] = now;
+  doc["rules"] = alarms.getRuleCount();
+  doc["active"] = alarms.getActiveCount();
+  doc["evaluations"] = alarms.getEvaluations();
+  
+  // Every rule that is not quietly normal
+  JsonArray open = doc["alarms"].to<JsonArray>();
+  for (int i = 0; i < alarms.getRuleCount(); i++) {
+    const AlarmStatus& status = alarms.getStatus(i);
+    if (status.state == ALARM_NORMAL) continue;
+    const AlarmRule& rule = alarms.getRule(i);
+    JsonObject alarm = open.add<JsonObject>();
+    alarm["aquarium"] = rule.aquarium;
+    alarm["type"] = sensorTypeName(rule.sensorType);
+    alarm["id"] = rule.channel;
+    alarm["kind"] = AlarmEngine::kindName(rule.kind);
+    alarm["state"] = AlarmEngine::stateName(status.state);
+    alarm["side"] = AlarmEngine::sideName(status.side);
+    alarm["value"] = status.value;
+    alarm["since_s"] = (now - status.since) / 1000;
+    alarm["raises"] = status.raiseCount;
+  }
+  
+  AlarmEvent events[ALARM_EVENT_LOG];
+  int eventCount = alarms.getEventsSince(0, events, ALARM_EVENT_LOG);
+  JsonArray recent = doc["events"].to<JsonArray>();
+  for (int i = 0; i < eventCount; i++) {
+    const AlarmRule& rule = alarms.getRule(events[i].rule);
+    JsonObject event = recent.add<JsonObject>();
+    event["sequence"] = events[i].sequence;
+    event["aquarium"] = rule.aquarium;
+    event["type"] = sensorTypeName(rule.sensorType);
+    event["id"] = rule.channel;
+    event["kind"] = AlarmEngine::kindName(rule.kind);
+    event["event"] = events[i].state == ALARM_ACTIVE ? "raised" : "cleared";
+    event["side"] = AlarmEngine::sideName(events[i].side);
+    event["value"] = events[i].value;
+    event["age_s"] = (now - events[i].at) / 1000;
+  }
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(200, "application/json", response);
+}
+
 void AquaWebServer::handleCalibrationPage(AsyncWebServerRequest *request) {
   // TODO: Convert to template-based rendering
   String html = generateCalibrationHTML();
@@ -490,14 +648,16 @@ void AquaWebServer::handleStartCalibration(AsyncWebServerRequest *request) {
   String sensorType = request->getParam("sensor_type", true)->value();
   int sensorId = request->getParam("sensor_id", true)->value().toInt() - 1; // Convert to 0-based
   String notes = request->hasParam("notes", true) ? request->getParam("notes", true)->value() : "";
+  uint8_t curve = CalibrationFit::parseType(request->hasParam("curve", true) ?
+                                            request->getParam("curve", true)->value() : "linear");
   
   bool success = false;
   if (sensorType == "temperature") {
     success = calibrationManager->startTemperatureCalibration(sensorId, notes);
   } else if (sensorType == "ph") {
-    success = calibrationManager->startPHCalibration(sensorId, notes);
+    success = calibrationManager->startPHCalibration(sensorId, notes, curve);
   } else if (sensorType == "tds") {
-    success = calibrationManager->startTDSCalibration(sensorId, notes);
+    success = calibrationManager->startTDSCalibration(sensorId, notes, curve);
   }
   
   JsonDocument doc;
@@ -528,14 +688,14 @@ void AquaWebServer::handleAddCalibrationPoint(AsyncWebServerRequest *request) {
   float temperature = request->hasParam("temperature", true) ? 
                      request->getParam("temperature", true)->value().toFloat() : 25.0;
   
-  // Get current raw reading from sensor
+  // Get current raw (uncalibrated) reading from sensor
   float rawValue = 0;
   if (sensorType == "temperature") {
-    rawValue = sensorController->getTemperatureSensors().getData().readings[sensorId];
+    rawValue = sensorController->getTemperatureSensors().getRawReading(sensorId);
   } else if (sensorType == "ph") {
-    rawValue = sensorController->getPHSensors().getData().readings[sensorId];
+    rawValue = sensorController->getPHSensors().getRawReading(sensorId);
   } else if (sensorType == "tds") {
-    rawValue = sensorController->getTDSSensors().getData().readings[sensorId];
+    rawValue = sensorController->getTDSSensors().getRawReading(sensorId);
   }
   
   bool success = false;
@@ -590,6 +750,308 @@ void AquaWebServer::handleFinalizeCalibration(AsyncWebServerRequest *request) {
   request->send(success ? 200 : 400, "application/json", response);
 }
 
+void AquaWebServer::fillCaptureStatus(JsonDocument& doc) {
+  StabilityCapture& capture = sensorController->getCapture();
+  const CaptureCriteria& criteria = capture.getCriteria();
+  unsigned long now = millis();
+  
+  doc["state"] = StabilityCapture::stateName(capture.getState());
+  if (capture.getState() == CAPTURE_IDLE) return;
+  
+  doc["sensor_type"] = sensorTypeName(capture.getSensorType());
+  doc["sensor_id"] = capture.getChannel() + 1;
+  doc["actual_value"] = captureActualValue;
+  doc["samples"] = capture.getTotalSamples();
+  doc["windows"] = capture.getWindows();
+  doc["window_progress"] = capture.getWindowProgress();
+  doc["window_samples"] = criteria.windowSamples;
+  doc["mean"] = capture.getCurrentMean();
+  doc["stdev"] = capture.getCurrentStdev();
+  if (capture.hasCompletedWindow()) {
+    doc["window_mean"] = capture.getWindowMean();
+    doc["window_stdev"] = capture.getWindowStdev();
+    doc["drift"] = capture.getDrift();
+  }
+  doc["max_stdev"] = criteria.maxStdev;
+  doc["max_drift"] = criteria.maxDrift;
+  doc["elapsed_ms"] = capture.getElapsedMs(now);
+  doc["timeout_ms"] = criteria.timeoutMs;
+}
+
+void AquaWebServer::update() {
+  if (!sensorController) return;
+  sensorController->lockCapture();
+  updateCapture();
+  sensorController->unlockCapture();
+}
+
+// Called with the capture locked
+void AquaWebServer::updateCapture() {
+  StabilityCapture& capture = sensorController->getCapture();
+  if (capture.getState() == CAPTURE_IDLE) return;
+  unsigned long now = millis();
+  
+  if (capture.isActive()) {
+    if (capture.getRevision() != captureEventRevision && now - lastCaptureEvent >= CAPTURE_EVENT_INTERVAL_MS) {
+      JsonDocument doc;
+      fillCaptureStatus(doc);
+      String progress;
+      serializeJson(doc, progress);
+      captureEvents.send(progress.c_str(), "progress", now);
+      captureEventRevision = capture.getRevision();
+      lastCaptureEvent = now;
+    }
+    return;
+  }
+  
+  // Finished: a stable window becomes the calibration point, once
+  bool accepted = false;
+  if (capture.getState() == CAPTURE_STABLE && calibrationManager) {
+    accepted = calibrationManager->addCalibrationPoint(capture.getSensorType(), capture.getChannel(),
+                                                       capture.getWindowMean(), captureActualValue,
+                                                       captureTemperature);
+  }
+  
+  JsonDocument doc;
+  fillCaptureStatus(doc);
+  doc["accepted"] = accepted;
+  if (accepted) {
+    doc["raw_value"] = capture.getWindowMean();
+  }
+  lastCaptureResult = "";
+  serializeJson(doc, lastCaptureResult);
+  captureEvents.send(lastCaptureResult.c_str(), "result", now);
+  capture.reset();
+}
+
+void AquaWebServer::handleStartCapture(AsyncWebServerRequest *request) {
+  if (!calibrationManager || !sensorController) {
+    request->send(500, "application/json", "{\"error\":\"Calibration manager or sensor controller not initialized\"}");
+    return;
+  }
+  
+  if (!request->hasParam("sensor_type", true) || !request->hasParam("sensor_id", true) || 
+      !request->hasParam("actual_value", true)) {
+    request->send(400, "application/json", "{\"error\":\"Missing required parameters\"}");
+    return;
+  }
+  
+  int sensorType = CalibrationManager::parseSensorType(request->getParam("sensor_type", true)->value());
+  int sensorId = request->getParam("sensor_id", true)->value().toInt() - 1;
+  
+  // Configured criteria, optionally tightened or relaxed for this capture
+  CaptureCriteria criteria = sensorController->getCaptureCriteria(sensorType);
+  if (request->hasParam("max_stdev", true)) {
+    criteria.maxStdev = request->getParam("max_stdev", true)->value().toFloat();
+  }
+  if (request->hasParam("max_drift", true)) {
+    criteria.maxDrift = request->getParam("max_drift", true)->value().toFloat();
+  }
+  if (request->hasParam("window", true)) {
+    criteria.windowSamples = request->getParam("window", true)->value().toInt();
+  }
+  if (request->hasParam("timeout_s", true)) {
+    criteria.timeoutMs = request->getParam("timeout_s", true)->value().toInt() * 1000UL;
+  }
+  
+  float actualValue = request->getParam("actual_value", true)->value().toFloat();
+  float temperature = request->hasParam("temperature", true) ?
+                      request->getParam("temperature", true)->value().toFloat() : 25.0;
+  
+  // The reference goes in before the capture starts, so the loop task never
+  // sees a running capture with the previous point's value
+  bool success = false;
+  JsonDocument doc;
+  sensorController->lockCapture();
+  if (sensorType >= 0 && sensorController->getCapture().getState() == CAPTURE_IDLE) {
+    captureActualValue = actualValue;
+    captureTemperature = temperature;
+    captureEventRevision = 0;
+    lastCaptureEvent = 0;
+    success = sensorController->startCapture(sensorType, sensorId, criteria);
+  }
+  doc["success"] = success;
+  doc["message"] = success ? "Capture started, waiting for a stable reading" :
+                             "Failed to start capture (invalid sensor, or a capture is running or its result is pending)";
+  if (success) {
+    fillCaptureStatus(doc);
+  }
+  sensorController->unlockCapture();
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(success ? 200 : 400, "application/json", response);
+}
+
+void AquaWebServer::handleCaptureStatus(AsyncWebServerRequest *request) {
+  if (!sensorController) {
+    request->send(500, "application/json", "{\"error\":\"Sensor controller not initialized\"}");
+    return;
+  }
+  
+  String response;
+  sensorController->lockCapture();
+  if (sensorController->getCapture().getState() == CAPTURE_IDLE && lastCaptureResult.length() > 0) {
+    response = lastCaptureResult;
+  } else {
+    JsonDocument doc;
+    fillCaptureStatus(doc);
+    serializeJson(doc, response);
+  }
+  sensorController->unlockCapture();
+  request->send(200, "application/json", response);
+}
+
+void AquaWebServer::handleCancelCapture(AsyncWebServerRequest *request) {
+  if (!sensorController) {
+    request->send(500, "application/json", "{\"error\":\"Sensor controller not initialized\"}");
+    return;
+  }
+  
+  sensorController->cancelCapture();
+  request->send(200, "application/json", "{\"success\":true,\"message\":\"Capture cancelled\"}");
+}
+
+// "1,2,5" -> 0-based channel list; returns the number parsed
+static int parseSensorIds(const String& list, int* channels, int maxCount) {
+  int count = 0;
+  int start = 0;
+  while (start < (int)list.length() && count < maxCount) {
+    int comma = list.indexOf(',', start);
+    if (comma < 0) comma = list.length();
+    String id = list.substring(start, comma);
+    id.trim();
+    if (id.length() > 0) {
+      channels[count++] = id.toInt() - 1;
+    }
+    start = comma + 1;
+  }
+  return count;
+}
+
+void AquaWebServer::handleSessionStatus(AsyncWebServerRequest *request) {
+  if (!calibrationManager) {
+    request->send(500, "application/json", "{\"error\":\"Calibration manager not initialized\"}");
+    return;
+  }
+  
+  request->send(200, "application/json", calibrationManager->getSessionStatus());
+}
+
+void AquaWebServer::handleSessionStart(AsyncWebServerRequest *request) {
+  if (!calibrationManager) {
+    request->send(500, "application/json", "{\"error\":\"Calibration manager not initialized\"}");
+    return;
+  }
+  
+  if (!request->hasParam("sensor_type", true) || !request->hasParam("sensor_ids", true)) {
+    request->send(400, "application/json", "{\"error\":\"Missing sensor_type or sensor_ids parameter\"}");
+    return;
+  }
+  
+  int sensorType = CalibrationManager::parseSensorType(request->getParam("sensor_type", true)->value());
+  int channels[MAX_CHANNELS_PER_TYPE];
+  int count = parseSensorIds(request->getParam("sensor_ids", true)->value(), channels, MAX_CHANNELS_PER_TYPE);
+  String notes = request->hasParam("notes", true) ? request->getParam("notes", true)->value() : "";
+  uint8_t curve = CalibrationFit::parseType(request->hasParam("curve", true) ?
+                                            request->getParam("curve", true)->value() : "linear");
+  
+  bool success = sensorType >= 0 && calibrationManager->startSession(sensorType, channels, count, notes, curve);
+  
+  JsonDocument doc;
+  doc["success"] = success;
+  doc["message"] = success ? "Calibration session started" : "Failed to start calibration session";
+  doc["sensors"] = success ? count : 0;
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(success ? 200 : 400, "application/json", response);
+}
+
+void AquaWebServer::handleSessionPoint(AsyncWebServerRequest *request) {
+  if (!calibrationManager || !sensorController) {
+    request->send(500, "application/json", "{\"error\":\"Calibration manager or sensor controller not initialized\"}");
+    return;
+  }
+  
+  if (!request->hasParam("actual_value", true)) {
+    request->send(400, "application/json", "{\"error\":\"Missing actual_value parameter\"}");
+    return;
+  }
+  
+  const CalibrationSession& session = calibrationManager->getSession();
+  if (!session.active) {
+    request->send(400, "application/json", "{\"error\":\"No calibration session active\"}");
+    return;
+  }
+  
+  float actualValue = request->getParam("actual_value", true)->value().toFloat();
+  float temperature = request->hasParam("temperature", true) ? 
+                     request->getParam("temperature", true)->value().toFloat() : 25.0;
+  
+  // Every sensor's raw reading from the same completed scan cycle
+  float rawValues[MAX_CHANNELS_PER_TYPE];
+  uint32_t cycle = 0;
+  RawSnapshotStatus status = sensorController->getRawSnapshot(session.sensorType, session.channels,
+                                                              session.channelCount, rawValues, cycle);
+  if (status == SNAPSHOT_EMPTY) {
+    request->send(503, "application/json", "{\"error\":\"No completed scan cycle yet\"}");
+    return;
+  }
+  if (status == SNAPSHOT_STALE) {
+    // Some probes were skipped by adaptive sampling; read them all next scan
+    sensorController->requestRead(session.sensorType, session.channels, session.channelCount);
+    request->send(409, "application/json",
+                  "{\"error\":\"Not every sensor was read in the last scan cycle, retry after the next scan\"}");
+    return;
+  }
+  
+  int captured = calibrationManager->addSessionPoint(rawValues, cycle, actualValue, temperature);
+  
+  JsonDocument doc;
+  doc["success"] = captured > 0;
+  doc["message"] = captured > 0 ? "Calibration point captured" : "Failed to capture calibration point";
+  doc["captured"] = captured;
+  doc["cycle"] = cycle;
+  doc["actual_value"] = actualValue;
+  JsonArray raw = doc["raw_values"].to<JsonArray>();
+  for (int i = 0; i < session.channelCount; i++) {
+    JsonObject value = raw.add<JsonObject>();
+    value["id"] = session.channels[i] + 1;
+    value["raw"] = rawValues[i];
+  }
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(captured > 0 ? 200 : 400, "application/json", response);
+}
+
+void AquaWebServer::handleSessionFinalize(AsyncWebServerRequest *request) {
+  if (!calibrationManager) {
+    request->send(500, "application/json", "{\"error\":\"Calibration manager not initialized\"}");
+    return;
+  }
+  
+  if (!calibrationManager->getSession().active) {
+    request->send(400, "application/json", "{\"error\":\"No calibration session active\"}");
+    return;
+  }
+  
+  int calibrated = calibrationManager->finalizeSession();
+  int status = calibrated > 0 ? 200 : (calibrated < 0 ? 500 : 400);
+  request->send(status, "application/json", calibrationManager->getSessionStatus());
+}
+
+void AquaWebServer::handleSessionCancel(AsyncWebServerRequest *request) {
+  if (!calibrationManager) {
+    request->send(500, "application/json", "{\"error\":\"Calibration manager not initialized\"}");
+    return;
+  }
+  
+  calibrationManager->cancelSession();
+  request->send(200, "application/json", "{\"success\":true,\"message\":\"Calibration session cancelled\"}");
+}
+
 void AquaWebServer::handleCalibrationReading(AsyncWebServerRequest *request) {
   if (!sensorController) {
     request->send(500, "application/json", "{\"error\":\"Sensor controller not initialized\"}");
@@ -604,8 +1066,8 @@ void AquaWebServer::handleCalibrationReading(AsyncWebServerRequest *request) {
   String sensorType = request->getParam("sensor_type")->value();
   int sensorId = request->getParam("sensor_id")->value().toInt() - 1;
   
-  if (sensorId < 0 || sensorId >= 8) {
-    request->send(400, "application/json", "{\"error\":\"Invalid sensor_id (1-8)\"}");
+  if (sensorId < 0 || sensorId >= MAX_CHANNELS_PER_TYPE) {
+    request->send(400, "application/json", "{\"error\":\"Invalid sensor_id\"}");
     return;
   }
   
@@ -615,17 +1077,18 @@ void AquaWebServer::handleCalibrationReading(AsyncWebServerRequest *request) {
   doc["sensor_id"] = sensorId + 1;
   
   if (sensorType == "temperature") {
-    TemperatureData& tempData = sensorController->getTemperatureSensors().getData();
-    doc["value"] = tempData.readings[sensorId];
+    doc["value"] = sensorController->getTemperatureSensors().getReading(sensorId);
+    doc["raw"] = sensorController->getTemperatureSensors().getRawReading(sensorId);
     doc["unit"] = "C";
   } else if (sensorType == "ph") {
-    PHData& phData = sensorController->getPHSensors().getData();
-    doc["value"] = phData.readings[sensorId];
+    doc["value"] = sensorController->getPHSensors().getReading(sensorId);
+    doc["raw"] = sensorController->getPHSensors().getRawReading(sensorId);
     doc["unit"] = "pH";
   } else if (sensorType == "tds") {
     TDSSensor& tdsSensors = sensorController->getTDSSensors();
-    doc["value"] = tdsSensors.getTDSReading(sensorId);
-    doc["ec"] = tdsSensors.getECReading(sensorId);
+    doc["value"] = tdsSensors.getReading(sensorId);
+    doc["raw"] = tdsSensors.getRawReading(sensorId);
+    doc["ec"] = tdsSensors.getSecondaryReading(sensorId);
     doc["unit"] = "ppm";
   } else {
     request->send(400, "application/json", "{\"error\":\"Invalid sensor_type (temperature, ph, tds)\"}");
@@ -1074,12 +1537,17 @@ String AquaWebServer::generateCalibrationHTML() {
         }
         
         function updateCalibrationDisplay(data) {
+            // One row per configured channel, as reported by the calibration status
+            var tempCount = data.temperature ? data.temperature.length : 0;
+            var phCount = data.ph ? data.ph.length : 0;
+            var tdsCount = data.tds ? data.tds.length : 0;
+            
             // Update temperature sensors
             var tempContainer = document.getElementById('temperature-calibration');
             if (!tempContainer.querySelector('.sensor-item')) {
                 // Only rebuild if sensor items don't exist (first load or after loading state)
                 tempContainer.innerHTML = '';
-                for (var i = 0; i < 8; i++) {
+                for (var i = 0; i < tempCount; i++) {
                     var div = document.createElement('div');
                     div.className = 'sensor-item';
                     div.innerHTML = '<span class="sensor-status" id="temp-status-' + i + '">Temp' + (i + 1) + ':</span>' +
@@ -1090,7 +1558,7 @@ String AquaWebServer::generateCalibrationHTML() {
             }
             
             // Update calibration status for temperature sensors
-            for (var i = 0; i < 8; i++) {
+            for (var i = 0; i < tempCount; i++) {
                 var isCalibrated = data.temperature && data.temperature[i] && data.temperature[i].isCalibrated;
                 var statusElem = document.getElementById('temp-status-' + i);
                 if (statusElem) {
@@ -1103,7 +1571,7 @@ String AquaWebServer::generateCalibrationHTML() {
             if (!phContainer.querySelector('.sensor-item')) {
                 // Only rebuild if sensor items don't exist (first load or after loading state)
                 phContainer.innerHTML = '';
-                for (var i = 0; i < 8; i++) {
+                for (var i = 0; i < phCount; i++) {
                     var div = document.createElement('div');
                     div.className = 'sensor-item';
                     div.innerHTML = '<span class="sensor-status" id="ph-status-' + i + '">pH' + (i + 1) + ':</span>' +
@@ -1114,7 +1582,7 @@ String AquaWebServer::generateCalibrationHTML() {
             }
             
             // Update calibration status for pH sensors
-            for (var i = 0; i < 8; i++) {
+            for (var i = 0; i < phCount; i++) {
                 var isCalibrated = data.ph && data.ph[i] && data.ph[i].isCalibrated;
                 var statusElem = document.getElementById('ph-status-' + i);
                 if (statusElem) {
@@ -1127,7 +1595,7 @@ String AquaWebServer::generateCalibrationHTML() {
             if (!tdsContainer.querySelector('.sensor-item')) {
                 // Only rebuild if sensor items don't exist (first load or after loading state)
                 tdsContainer.innerHTML = '';
-                for (var i = 0; i < 8; i++) {
+                for (var i = 0; i < tdsCount; i++) {
                     var div = document.createElement('div');
                     div.className = 'sensor-item';
                     div.innerHTML = '<span class="sensor-status" id="tds-status-' + i + '">TDS' + (i + 1) + ':</span>' +
@@ -1138,7 +1606,7 @@ String AquaWebServer::generateCalibrationHTML() {
             }
             
             // Update calibration status for TDS sensors
-            for (var i = 0; i < 8; i++) {
+            for (var i = 0; i < tdsCount; i++) {
                 var isCalibrated = data.tds && data.tds[i] && data.tds[i].isCalibrated;
                 var statusElem = document.getElementById('tds-status-' + i);
                 if (statusElem) {
@@ -1185,145 +1653,88 @@ String AquaWebServer::generateCalibrationHTML() {
             step: 0,
             totalSteps: 0,
             isActive: false,
-            readings: [],
-            stabilityTimer: null,
-            updateTimer: null
+            eventSource: null
         };
         
-        // Statistical analysis for stability detection
-        function calculateStats(readings) {
-            if (readings.length < 10) return null;
-            
-            var sum = readings.reduce(function(a, b) { return a + b; }, 0);
-            var avg = sum / readings.length;
+        // Stability is judged on the device: it samples the probe at a high
+        // rate and accepts the point once the reading is stable, streaming
+        // progress on /api/calibration/events
+        function startLiveReadings() {
+            stopLiveReadings();
+            currentCalibration.isActive = true;
             
-            var variance = readings.reduce(function(sum, val) {
-                return sum + Math.pow(val - avg, 2);
-            }, 0) / readings.length;
+            var source = new EventSource('/api/calibration/events');
+            currentCalibration.eventSource = source;
+            source.addEventListener('progress', function(e) {
+                updateCaptureProgress(JSON.parse(e.data));
+            });
+            source.addEventListener('result', function(e) {
+                handleCaptureResult(JSON.parse(e.data));
+            });
             
-            var stdev = Math.sqrt(variance);
+            var formData = new FormData();
+            formData.append('sensor_type', currentCalibration.sensorType);
+            formData.append('sensor_id', currentCalibration.sensorId);
+            formData.append('actual_value', currentCalibration.currentReferenceValue);
             
-            return {
-                average: avg,
-                stdev: stdev,
-                count: readings.length,
-                isStable: readings.length >= 20 && stdev < getStabilityThreshold(currentCalibration.sensorType)
+            var xhr = new XMLHttpRequest();
+            xhr.onreadystatechange = function() {
+                if (xhr.readyState == 4 && xhr.status != 200) {
+                    stopLiveReadings();
+                    alert('[ERROR] Failed to start capture - Server error');
+                }
             };
+            xhr.open('POST', '/api/calibration/capture', true);
+            xhr.send(formData);
         }
         
-        function getStabilityThreshold(sensorType) {
-            // Stability thresholds for different sensor types
-            switch(sensorType) {
-                case 'temperature': return 0.1; // +/-0.1C
-                case 'ph': return 0.05; // +/-0.05 pH
-                case 'tds': return 2.0; // +/-2 ppm
-                default: return 0.1;
-            }
-        }
-        
-        function startLiveReadings() {
-            if (currentCalibration.updateTimer) {
-                clearInterval(currentCalibration.updateTimer);
-            }
-            
-            currentCalibration.readings = [];
-            currentCalibration.isActive = true;
-            
-            currentCalibration.updateTimer = setInterval(function() {
-                if (!currentCalibration.isActive) return;
-                
+        function stopLiveReadings() {
+            if (currentCalibration.isActive) {
                 var xhr = new XMLHttpRequest();
-                xhr.onreadystatechange = function() {
-                    if (xhr.readyState == 4 && xhr.status == 200) {
-                        var data = JSON.parse(xhr.responseText);
-                        updateLiveReading(data);
-                    }
-                };
-                xhr.open('GET', '/api/calibration/reading?sensor_type=' + currentCalibration.sensorType + '&sensor_id=' + currentCalibration.sensorId, true);
+                xhr.open('POST', '/api/calibration/capture/cancel', true);
                 xhr.send();
-            }, 500); // Update every 500ms
-        }
-        
-        function stopLiveReadings() {
-            currentCalibration.isActive = false;
-            if (currentCalibration.updateTimer) {
-                clearInterval(currentCalibration.updateTimer);
-                currentCalibration.updateTimer = null;
             }
-            if (currentCalibration.stabilityTimer) {
-                clearTimeout(currentCalibration.stabilityTimer);
-                currentCalibration.stabilityTimer = null;
+            currentCalibration.isActive = false;
+            if (currentCalibration.eventSource) {
+                currentCalibration.eventSource.close();
+                currentCalibration.eventSource = null;
             }
         }
         
-        function updateLiveReading(data) {
-            // Add reading to rolling buffer (keep last 30 readings = 15 seconds)
-            currentCalibration.readings.push(data.value);
-            if (currentCalibration.readings.length > 30) {
-                currentCalibration.readings.shift();
-            }
-            
-            // Update display
+        function updateCaptureProgress(data) {
             var readingDiv = document.getElementById('currentReading');
-            if (readingDiv) {
-                var stats = calculateStats(currentCalibration.readings);
-                var stabilityText = '';
-                
-                if (stats) {
-                    var stabilityIndicator = stats.isStable ? '[STABLE]' : '[STABILIZING]';
-                    stabilityText = ' - ' + stabilityIndicator + ' (stdev=' + stats.stdev.toFixed(3) + ')';
-                    
-                    // Auto-advance when stable
-                    if (stats.isStable && !currentCalibration.stabilityTimer) {
-                        currentCalibration.stabilityTimer = setTimeout(function() {
-                            autoAddCalibrationPoint(stats.average);
-                        }, 3000); // Wait 3 seconds after stability detected
-                    }
-                }
-                
-                readingDiv.innerHTML = '<strong>Current Reading:</strong> ' + data.value.toFixed(2) + ' ' + (data.unit || '') + stabilityText +
-                    '<br><small>Readings: ' + currentCalibration.readings.length + '/30</small>';
+            if (!readingDiv) return;
+            
+            var stabilityText = '[STABILIZING]';
+            if (typeof data.window_stdev === 'number') {
+                stabilityText += ' stdev=' + data.window_stdev.toFixed(4) + ' (max ' + data.max_stdev.toFixed(4) + ')' +
+                    ', drift=' + data.drift.toFixed(4) + ' (max ' + data.max_drift.toFixed(4) + ')';
             }
+            readingDiv.innerHTML = '<strong>Current Reading:</strong> ' + data.mean.toFixed(3) + ' - ' + stabilityText +
+                '<br><small>Window ' + (data.windows + 1) + ': ' + data.window_progress + '/' + data.window_samples +
+                ' reads, ' + data.samples + ' total, ' + Math.round(data.elapsed_ms / 1000) + 's of ' +
+                Math.round(data.timeout_ms / 1000) + 's</small>';
         }
         
-        function autoAddCalibrationPoint(stableValue) {
-            // Use the reference value already entered in the modal
-            var referenceValue = currentCalibration.currentReferenceValue;
-            if (!referenceValue) {
-                alert('[ERROR] No reference value set. Please restart calibration.');
-                return;
-            }
-            
-            // Add calibration point with pre-entered reference value
-            var formData = new FormData();
-            formData.append('sensor_type', currentCalibration.sensorType);
-            formData.append('sensor_id', currentCalibration.sensorId);
-            formData.append('actual_value', referenceValue);
+        function handleCaptureResult(data) {
+            currentCalibration.isActive = false;  // Capture already finished on the device
+            stopLiveReadings();
             
-            var xhr = new XMLHttpRequest();
-            xhr.onreadystatechange = function() {
-                if (xhr.readyState == 4) {
-                    if (xhr.status == 200) {
-                        var data = JSON.parse(xhr.responseText);
-                        if (data.success) {
-                            currentCalibration.readings = []; // Reset for next point
-                            if (currentCalibration.stabilityTimer) {
-                                clearTimeout(currentCalibration.stabilityTimer);
-                                currentCalibration.stabilityTimer = null;
-                            }
-                            
-                            // Ask if user wants to add another calibration point
-                            askForNextCalibrationPoint();
-                        } else {
-                            alert('[ERROR] Failed to add calibration point: ' + (data.message || 'Unknown error'));
-                        }
-                    } else {
-                        alert('[ERROR] Server error while adding calibration point');
-                    }
+            if (data.accepted) {
+                var readingDiv = document.getElementById('currentReading');
+                if (readingDiv) {
+                    readingDiv.innerHTML = '<strong>[STABLE]</strong> ' + data.raw_value.toFixed(3) + ' (stdev=' +
+                        data.window_stdev.toFixed(4) + ') after ' + data.samples + ' reads';
                 }
-            };
-            xhr.open('POST', '/api/calibration/point', true);
-            xhr.send(formData);
+                askForNextCalibrationPoint();
+            } else if (data.state === 'timed_out') {
+                if (confirm('[TIMEOUT] The reading did not stabilize within ' + Math.round(data.timeout_ms / 1000) +
+                            ' seconds.\n\nOK = Keep waiting\nCancel = Stop')) {
+                    startLiveReadings();
+                }
+            } else if (data.state === 'stable') {
+                alert('[ERROR] Reading was stable but the calibration point could not be added');
+            }
         }
         
         function askForNextCalibrationPoint() {
@@ -0,0 +1,108 @@
+#include "BootProfiler.h"
+
+BootProfiler::BootProfiler()
+  : phaseCount(0), openPhase(-1), fastBoot(false),
+    bootCompleteMicros(0), firstSampleMicros(0), firstResponseMicros(0), wifiConnectedMicros(0) {}
+
+void BootProfiler::setFastBoot(bool enabled) {
+  fastBoot = enabled;
+}
+
+bool BootProfiler::isFastBoot() const {
+  return fastBoot;
+}
+
+void BootProfiler::beginPhase(const char* name) {
+  endPhase();
+
+  if (phaseCount >= BOOT_PROFILER_MAX_PHASES) {
+    return; // Table full - later phases are not recorded
+  }
+
+  BootPhase& phase = phases[phaseCount];
+  phase.name = name;
+  phase.startMicros = micros();
+  phase.durationMicros = 0;
+  openPhase = phaseCount;
+  phaseCount++;
+}
+
+void BootProfiler::endPhase() {
+  if (openPhase < 0) return;
+
+  BootPhase& phase = phases[openPhase];
+  phase.durationMicros = micros() - phase.startMicros;
+  openPhase = -1;
+}
+
+void BootProfiler::markBootComplete() {
+  endPhase();
+  if (bootCompleteMicros == 0) {
+    bootCompleteMicros = micros();
+  }
+}
+
+void BootProfiler::markFirstSample() {
+  if (firstSampleMicros != 0) return;
+  firstSampleMicros = micros();
+  Serial.printf("[BOOT] Time to first sample: %lu ms\n", getTimeToFirstSampleMs());
+}
+
+void BootProfiler::markFirstHttpResponse() {
+  if (firstResponseMicros != 0) return;
+  firstResponseMicros = micros();
+  Serial.printf("[BOOT] Time to first HTTP response: %lu ms\n", getTimeToFirstResponseMs());
+}
+
+void BootProfiler::markWifiConnected() {
+  if (wifiConnectedMicros != 0) return;
+  wifiConnectedMicros = micros();
+  Serial.printf("[BOOT] Time to WiFi connected: %lu ms\n", getTimeToWifiMs());
+}
+
+unsigned long BootProfiler::getBootTimeMs() const {
+  return bootCompleteMicros / 1000;
+}
+
+unsigned long BootProfiler::getTimeToFirstSampleMs() const {
+  return firstSampleMicros / 1000;
+}
+
+unsigned long BootProfiler::getTimeToFirstResponseMs() const {
+  return firstResponseMicros / 1000;
+}
+
+unsigned long BootProfiler::getTimeToWifiMs() const {
+  return wifiConnectedMicros / 1000;
+}
+
+void BootProfiler::printReport() {
+  Serial.println("Boot Phase Timing:");
+  Serial.println("----------------------------");
+  Serial.printf("  Mode: %s\n", fastBoot ? "FAST BOOT" : "NORMAL");
+  for (int i = 0; i < phaseCount; i++) {
+    Serial.printf("  %-24s %8.1f ms\n", phases[i].name, phases[i].durationMicros / 1000.0);
+  }
+  Serial.printf("  %-24s %8lu ms\n", "Total (since reset)", getBootTimeMs());
+  Serial.println("----------------------------");
+}
+
+void BootProfiler::addToJson(JsonObject obj) {
+  obj["fastBoot"] = fastBoot;
+  obj["bootTimeMs"] = getBootTimeMs();
+
+  // Milestones not reached yet are reported as null
+  if (firstSampleMicros) obj["firstSampleMs"] = getTimeToFirstSampleMs();
+  else obj["firstSampleMs"] = nullptr;
+  if (firstResponseMicros) obj["firstResponseMs"] = getTimeToFirstResponseMs();
+  else obj["firstResponseMs"] = nullptr;
+  if (wifiConnectedMicros) obj["wifiConnectedMs"] = getTimeToWifiMs();
+  else obj["wifiConnectedMs"] = nullptr;
+
+  JsonArray phaseArray = obj["phases"].to<JsonArray>();
+  for (int i = 0; i < phaseCount; i++) {
+    JsonObject phase = phaseArray.add<JsonObject>();
+    phase["name"] = phases[i].name;
+    phase["ms"] = phases[i].durationMicros / 1000.0;
+  }
+}
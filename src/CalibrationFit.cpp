@@ -0,0 +1,213 @@
+#include "CalibrationFit.h"
+#include <math.h>
+
+void CalibrationCurve::setLinear(float slope, float offset) {
+  type = CURVE_LINEAR;
+  order = 1;
+  segments = 1;
+  for (int i = 0; i <= CAL_MAX_POLY_ORDER; i++) poly[i] = 0.0;
+  for (int i = 0; i < CAL_MAX_SEGMENTS - 1; i++) knots[i] = 0.0;
+  for (int i = 0; i < CAL_MAX_SEGMENTS; i++) {
+    segSlope[i] = 0.0;
+    segOffset[i] = 0.0;
+  }
+  poly[0] = offset;
+  poly[1] = slope;
+  segSlope[0] = slope;
+  segOffset[0] = offset;
+}
+
+void CalibrationCurve::scale(float factor) {
+  for (int i = 0; i <= CAL_MAX_POLY_ORDER; i++) poly[i] *= factor;
+  for (int i = 0; i < CAL_MAX_SEGMENTS; i++) {
+    segSlope[i] *= factor;
+    segOffset[i] *= factor;
+  }
+}
+
+float CalibrationCurve::getSlope() const {
+  return type == CURVE_PIECEWISE ? segSlope[0] : poly[1];
+}
+
+float CalibrationCurve::getOffset() const {
+  return type == CURVE_PIECEWISE ? segOffset[0] : poly[0];
+}
+
+// Valid points sorted by raw value, points with the same raw value merged
+static int collectPoints(const CalibrationPoint* points, int count, double* xs, double* ys) {
+  int n = 0;
+  for (int i = 0; i < count && i < CAL_MAX_POINTS; i++) {
+    if (!points[i].valid) continue;
+    double x = points[i].rawValue;
+    double y = points[i].actualValue;
+    int pos = n;
+    while (pos > 0 && xs[pos - 1] > x) {
+      xs[pos] = xs[pos - 1];
+      ys[pos] = ys[pos - 1];
+      pos--;
+    }
+    xs[pos] = x;
+    ys[pos] = y;
+    n++;
+  }
+
+  int distinct = 0;
+  for (int i = 0; i < n; i++) {
+    int weight = 1;
+    double sumY = ys[i];
+    while (i + 1 < n && xs[i + 1] == xs[i]) {
+      sumY += ys[++i];
+      weight++;
+    }
+    xs[distinct] = xs[i];
+    ys[distinct] = sumY / weight;
+    distinct++;
+  }
+  return distinct;
+}
+
+static bool fitPiecewise(const double* xs, const double* ys, int n, CalibrationCurve& curve) {
+  curve.setLinear(1.0, 0.0);
+  curve.type = CURVE_PIECEWISE;
+  curve.segments = n - 1;
+  for (int k = 0; k < n - 1; k++) {
+    double slope = (ys[k + 1] - ys[k]) / (xs[k + 1] - xs[k]);
+    curve.segSlope[k] = slope;
+    curve.segOffset[k] = ys[k] - slope * xs[k];
+    if (k > 0) curve.knots[k - 1] = xs[k];
+  }
+  // Keep the Horner form on the first segment so getSlope()/getOffset() agree
+  curve.poly[0] = curve.segOffset[0];
+  curve.poly[1] = curve.segSlope[0];
+  return true;
+}
+
+// Least squares in t = (x - mean) / spread, which keeps the normal
+// equations well conditioned for raw values in the hundreds, then expanded
+// back to coefficients in x
+static bool fitLeastSquares(const double* xs, const double* ys, int n, int order, CalibrationCurve& curve) {
+  double mean = 0.0;
+  for (int i = 0; i < n; i++) mean += xs[i];
+  mean /= n;
+  double spread = 0.0;
+  for (int i = 0; i < n; i++) {
+    if (fabs(xs[i] - mean) > spread) spread = fabs(xs[i] - mean);
+  }
+  if (spread == 0.0) return false;
+
+  const int size = order + 1;
+  double a[CAL_MAX_POLY_ORDER + 1][CAL_MAX_POLY_ORDER + 2];
+  for (int j = 0; j < size; j++) {
+    for (int k = 0; k <= size; k++) a[j][k] = 0.0;
+  }
+  for (int i = 0; i < n; i++) {
+    double t = (xs[i] - mean) / spread;
+    double powers[2 * CAL_MAX_POLY_ORDER + 1];
+    powers[0] = 1.0;
+    for (int p = 1; p <= 2 * order; p++) powers[p] = powers[p - 1] * t;
+    for (int j = 0; j < size; j++) {
+      for (int k = 0; k < size; k++) a[j][k] += powers[j + k];
+      a[j][size] += ys[i] * powers[j];
+    }
+  }
+
+  // Gaussian elimination with partial pivoting
+  for (int col = 0; col < size; col++) {
+    int pivot = col;
+    for (int row = col + 1; row < size; row++) {
+      if (fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+    }
+    if (fabs(a[pivot][col]) < 1e-12) return false;
+    if (pivot != col) {
+      for (int k = 0; k <= size; k++) {
+        double tmp = a[col][k];
+        a[col][k] = a[pivot][k];
+        a[pivot][k] = tmp;
+      }
+    }
+    for (int row = col + 1; row < size; row++) {
+      double factor = a[row][col] / a[col][col];
+      for (int k = col; k <= size; k++) a[row][k] -= factor * a[col][k];
+    }
+  }
+  double coeffs[CAL_MAX_POLY_ORDER + 1];
+  for (int row = size - 1; row >= 0; row--) {
+    double sum = a[row][size];
+    for (int k = row + 1; k < size; k++) sum -= a[row][k] * coeffs[k];
+    coeffs[row] = sum / a[row][row];
+  }
+
+  // p(x) = sum coeffs[k] * (x/spread - mean/spread)^k, expanded by Horner
+  double alpha = 1.0 / spread;
+  double beta = -mean / spread;
+  double result[CAL_MAX_POLY_ORDER + 1] = { 0.0 };
+  for (int k = order; k >= 0; k--) {
+    for (int i = order; i >= 0; i--) {
+      result[i] = beta * result[i] + (i > 0 ? alpha * result[i - 1] : 0.0);
+    }
+    result[0] += coeffs[k];
+  }
+
+  curve.setLinear(result[1], result[0]);
+  curve.type = order == 1 ? CURVE_LINEAR : CURVE_POLYNOMIAL;
+  curve.order = order;
+  for (int i = 0; i <= order; i++) curve.poly[i] = result[i];
+  return true;
+}
+
+bool CalibrationFit::fit(uint8_t type, const CalibrationPoint* points, int count, CalibrationCurve& curve) {
+  double xs[CAL_MAX_POINTS];
+  double ys[CAL_MAX_POINTS];
+  int n = collectPoints(points, count, xs, ys);
+  if (n < 2) return false;
+
+  if (type == CURVE_PIECEWISE) {
+    return fitPiecewise(xs, ys, n, curve);
+  }
+  // A polynomial through n distinct points has at most order n - 1
+  int order = 1;
+  if (type == CURVE_POLYNOMIAL) {
+    order = n - 1 < CAL_MAX_POLY_ORDER ? n - 1 : CAL_MAX_POLY_ORDER;
+  }
+  return fitLeastSquares(xs, ys, n, order, curve);
+}
+
+CalibrationFitQuality CalibrationFit::quality(const CalibrationCurve& curve, const CalibrationPoint* points, int count) {
+  CalibrationFitQuality result = { 1.0, 0.0, 0.0 };
+  int n = 0;
+  double mean = 0.0;
+  for (int i = 0; i < count; i++) {
+    if (!points[i].valid) continue;
+    mean += points[i].actualValue;
+    n++;
+  }
+  if (n == 0) return result;
+  mean /= n;
+
+  double ssRes = 0.0;
+  double ssTot = 0.0;
+  for (int i = 0; i < count; i++) {
+    if (!points[i].valid) continue;
+    double residual = points[i].actualValue - curve.evaluate(points[i].rawValue);
+    ssRes += residual * residual;
+    ssTot += (points[i].actualValue - mean) * (points[i].actualValue - mean);
+    if (fabs(residual) > result.maxResidual) result.maxResidual = fabs(residual);
+  }
+  result.rmsResidual = sqrt(ssRes / n);
+  result.r2 = ssTot > 0.0 ? 1.0 - ssRes / ssTot : 1.0;
+  return result;
+}
+
+uint8_t CalibrationFit::parseType(const String& name) {
+  if (name == "piecewise") return CURVE_PIECEWISE;
+  if (name == "polynomial") return CURVE_POLYNOMIAL;
+  return CURVE_LINEAR;
+}
+
+const char* CalibrationFit::typeName(uint8_t type) {
+  switch (type) {
+    case CURVE_PIECEWISE: return "piecewise";
+    case CURVE_POLYNOMIAL: return "polynomial";
+    default: return "linear";
+  }
+}
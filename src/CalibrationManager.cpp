@@ -2,9 +2,89 @@
 #include "SPIFFS.h"
 #include <time.h>
 
-CalibrationManager::CalibrationManager() : dataLoaded(false) {
+CalibrationManager::CalibrationManager()
+  : dataLoaded(false), lastLoadMicros(0), importedJsonBytes(0), tempSensorCount(DEFAULT_NUM_TEMP_SENSORS),
+    phSensorCount(DEFAULT_NUM_PH_SENSORS), tdsSensorCount(DEFAULT_NUM_TDS_SENSORS) {
   // Initialize all calibration data as invalid
-  memset(&calibrationData, 0, sizeof(calibrationData));
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    calibrationData.temperature[i] = TemperatureCalibration();
+    calibrationData.ph[i] = PHCalibration();
+    calibrationData.tds[i] = TDSCalibration();
+  }
+  memset(&session, 0, sizeof(session));
+}
+
+void CalibrationManager::compileTemperatureTable() {
+  CalibrationTable& table = temperatureTable.back();
+  table.calibratedCount = 0;
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    const TemperatureCalibration& cal = calibrationData.temperature[i];
+    table.setIdentity(i);
+    if (cal.isCalibrated) {
+      table.channels[i].curve.setLinear(cal.slope, cal.offset);
+      table.channels[i].calibrated = true;
+      table.calibratedCount++;
+    }
+  }
+  temperatureTable.publish();
+}
+
+void CalibrationManager::compilePHTable() {
+  CalibrationTable& table = phTable.back();
+  table.calibratedCount = 0;
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    const PHCalibration& cal = calibrationData.ph[i];
+    table.setIdentity(i);
+    if (cal.isCalibrated) {
+      table.channels[i].curve = cal.curve;
+      table.channels[i].offsetTempCoeff = cal.tempCoeff;
+      table.channels[i].calibrated = true;
+      table.calibratedCount++;
+    }
+  }
+  phTable.publish();
+}
+
+void CalibrationManager::compileTDSTable() {
+  CalibrationTable& table = tdsTable.back();
+  table.calibratedCount = 0;
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    const TDSCalibration& cal = calibrationData.tds[i];
+    table.setIdentity(i);
+    if (cal.isCalibrated) {
+      // Calibrated EC, halved to TDS (see getCalibratedTDS)
+      table.channels[i].curve = cal.curve;
+      table.channels[i].curve.scale(0.5);
+      table.channels[i].scaleTempCoeff = cal.tempCoeff;
+      table.channels[i].calibrated = true;
+      table.calibratedCount++;
+    }
+  }
+  tdsTable.publish();
+}
+
+void CalibrationManager::compileTables() {
+  compileTemperatureTable();
+  compilePHTable();
+  compileTDSTable();
+}
+
+const CalibrationTable& CalibrationManager::getTemperatureTable() {
+  return temperatureTable.acquire();
+}
+
+const CalibrationTable& CalibrationManager::getPHTable() {
+  return phTable.acquire();
+}
+
+const CalibrationTable& CalibrationManager::getTDSTable() {
+  return tdsTable.acquire();
+}
+
+void CalibrationManager::setSensorCounts(int temperature, int ph, int tds) {
+  tempSensorCount = constrain(temperature, 0, MAX_CHANNELS_PER_TYPE);
+  phSensorCount = constrain(ph, 0, MAX_CHANNELS_PER_TYPE);
+  tdsSensorCount = constrain(tds, 0, MAX_CHANNELS_PER_TYPE);
 }
 
 bool CalibrationManager::begin() {
@@ -13,20 +93,55 @@ bool CalibrationManager::begin() {
     return false;
   }
   
-  if (!loadCalibrationData()) {
+  if (store.exists()) {
+    loadCalibrationData();
+  } else if (SPIFFS.exists(CAL_LEGACY_JSON_FILE)) {
+    importJsonCalibration();
+  } else {
     Serial.println("[CAL] No existing calibration data found, starting fresh");
+    store.create();
   }
   
   return true;
 }
 
 bool CalibrationManager::loadCalibrationData() {
-  File file = SPIFFS.open("/calibration.json", "r");
+  unsigned long start = micros();
+  if (!store.beginLoad()) {
+    Serial.printf("[CAL] Failed to open %s\n", CAL_STORE_FILE);
+    return false;
+  }
+  
+  int loaded = 0;
+  CalibrationRecord record;
+  for (int type = 0; type < CAL_SENSOR_TYPES; type++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      if (store.loadRecord(type, i, record)) {
+        unpackRecord(record);
+        loaded++;
+      }
+    }
+  }
+  store.endLoad();
+  
+  dataLoaded = true;
+  compileTables();
+  lastLoadMicros = micros() - start;
+  Serial.printf("[CAL] Loaded %d calibration records in %.1f ms\n", loaded, lastLoadMicros / 1000.0);
+  return true;
+}
+
+// One-time migration from the JSON file earlier firmware wrote; the file is
+// kept as a backup under CAL_IMPORTED_JSON_FILE
+bool CalibrationManager::importJsonCalibration() {
+  unsigned long start = micros();
+  File file = SPIFFS.open(CAL_LEGACY_JSON_FILE, "r");
   if (!file) {
     Serial.println("[CAL] Calibration file not found");
     return false;
   }
   
+  importedJsonBytes = file.size();
   JsonDocument doc;
   DeserializationError error = deserializeJson(doc, file);
   file.close();
@@ -39,7 +154,7 @@ bool CalibrationManager::loadCalibrationData() {
   // Load temperature calibrations
   if (doc.containsKey("temperature")) {
     JsonArray tempArray = doc["temperature"];
-    for (int i = 0; i < 8 && i < tempArray.size(); i++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE && i < tempArray.size(); i++) {
       JsonObject tempCal = tempArray[i];
       TemperatureCalibration& cal = calibrationData.temperature[i];
       
@@ -73,42 +188,18 @@ bool CalibrationManager::loadCalibrationData() {
   // Load pH calibrations
   if (doc.containsKey("ph")) {
     JsonArray phArray = doc["ph"];
-    for (int i = 0; i < 8 && i < phArray.size(); i++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE && i < phArray.size(); i++) {
       JsonObject phCal = phArray[i];
       PHCalibration& cal = calibrationData.ph[i];
       
       if (phCal.containsKey("isCalibrated")) {
         cal.isCalibrated = phCal["isCalibrated"];
-        cal.slope = phCal["slope"] | 1.0;
-        cal.offset = phCal["offset"] | 0.0;
         cal.tempCoeff = phCal["tempCoeff"] | CalibrationStandards::TEMP_COEFF_PH;
         cal.calibrationDate = phCal["date"] | "";
         cal.notes = phCal["notes"] | "";
-        
-        // Load calibration points
-        if (phCal.containsKey("point1")) {
-          JsonObject p1 = phCal["point1"];
-          cal.point1.rawValue = p1["raw"];
-          cal.point1.actualValue = p1["actual"];
-          cal.point1.temperature = p1["temp"];
-          cal.point1.valid = p1["valid"];
-        }
-        
-        if (phCal.containsKey("point2")) {
-          JsonObject p2 = phCal["point2"];
-          cal.point2.rawValue = p2["raw"];
-          cal.point2.actualValue = p2["actual"];
-          cal.point2.temperature = p2["temp"];
-          cal.point2.valid = p2["valid"];
-        }
-        
-        if (phCal.containsKey("point3")) {
-          JsonObject p3 = phCal["point3"];
-          cal.point3.rawValue = p3["raw"];
-          cal.point3.actualValue = p3["actual"];
-          cal.point3.temperature = p3["temp"];
-          cal.point3.valid = p3["valid"];
-        }
+        loadPoints(phCal, cal.points, cal.pointCount);
+        restoreCurve(CalibrationFit::parseType(phCal["curve"] | "linear"), phCal["slope"] | 1.0,
+                     phCal["offset"] | 0.0, cal.points, cal.pointCount, cal.curve, cal.fit);
       }
     }
   }
@@ -116,149 +207,170 @@ bool CalibrationManager::loadCalibrationData() {
   // Load TDS calibrations
   if (doc.containsKey("tds")) {
     JsonArray tdsArray = doc["tds"];
-    for (int i = 0; i < 8 && i < tdsArray.size(); i++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE && i < tdsArray.size(); i++) {
       JsonObject tdsCal = tdsArray[i];
       TDSCalibration& cal = calibrationData.tds[i];
       
       if (tdsCal.containsKey("isCalibrated")) {
         cal.isCalibrated = tdsCal["isCalibrated"];
         cal.kFactor = tdsCal["kFactor"] | 1.0;
-        cal.slope = tdsCal["slope"] | 1.0;
-        cal.offset = tdsCal["offset"] | 0.0;
         cal.tempCoeff = tdsCal["tempCoeff"] | CalibrationStandards::TEMP_COEFF_EC;
         cal.calibrationDate = tdsCal["date"] | "";
         cal.notes = tdsCal["notes"] | "";
-        
-        // Load calibration points
-        if (tdsCal.containsKey("point1")) {
-          JsonObject p1 = tdsCal["point1"];
-          cal.point1.rawValue = p1["raw"];
-          cal.point1.actualValue = p1["actual"];
-          cal.point1.temperature = p1["temp"];
-          cal.point1.valid = p1["valid"];
-        }
-        
-        if (tdsCal.containsKey("point2")) {
-          JsonObject p2 = tdsCal["point2"];
-          cal.point2.rawValue = p2["raw"];
-          cal.point2.actualValue = p2["actual"];
-          cal.point2.temperature = p2["temp"];
-          cal.point2.valid = p2["valid"];
-        }
+        loadPoints(tdsCal, cal.points, cal.pointCount);
+        restoreCurve(CalibrationFit::parseType(tdsCal["curve"] | "linear"), tdsCal["slope"] | 1.0,
+                     tdsCal["offset"] | 0.0, cal.points, cal.pointCount, cal.curve, cal.fit);
       }
     }
   }
   
   dataLoaded = true;
-  Serial.println("[CAL] Calibration data loaded successfully");
+  compileTables();
+  lastLoadMicros = micros() - start;
+  
+  if (!store.create() || !saveCalibrationData()) {
+    Serial.println("[CAL] Import failed, keeping the JSON file");
+    return false;
+  }
+  SPIFFS.rename(CAL_LEGACY_JSON_FILE, CAL_IMPORTED_JSON_FILE);
+  Serial.printf("[CAL] Imported %s (%u bytes, parsed in %.1f ms) into %s (%u bytes)\n",
+                CAL_LEGACY_JSON_FILE, (unsigned)importedJsonBytes, lastLoadMicros / 1000.0,
+                CAL_STORE_FILE, (unsigned)CalibrationStore::fileSize());
   return true;
 }
 
+// Every sensor's record; used by the importer, finalize commits one record
 bool CalibrationManager::saveCalibrationData() {
-  JsonDocument doc;
-  
-  // Save temperature calibrations
-  JsonArray tempArray = doc["temperature"].to<JsonArray>();
-  for (int i = 0; i < 8; i++) {
-    JsonObject tempCal = tempArray.add<JsonObject>();
-    const TemperatureCalibration& cal = calibrationData.temperature[i];
-    
-    tempCal["isCalibrated"] = cal.isCalibrated;
-    tempCal["slope"] = cal.slope;
-    tempCal["offset"] = cal.offset;
-    tempCal["date"] = cal.calibrationDate;
-    tempCal["notes"] = cal.notes;
-    
-    JsonObject p1 = tempCal["point1"].to<JsonObject>();
-    p1["raw"] = cal.point1.rawValue;
-    p1["actual"] = cal.point1.actualValue;
-    p1["temp"] = cal.point1.temperature;
-    p1["valid"] = cal.point1.valid;
-    
-    JsonObject p2 = tempCal["point2"].to<JsonObject>();
-    p2["raw"] = cal.point2.rawValue;
-    p2["actual"] = cal.point2.actualValue;
-    p2["temp"] = cal.point2.temperature;
-    p2["valid"] = cal.point2.valid;
-  }
-  
-  // Save pH calibrations
-  JsonArray phArray = doc["ph"].to<JsonArray>();
-  for (int i = 0; i < 8; i++) {
-    JsonObject phCal = phArray.add<JsonObject>();
-    const PHCalibration& cal = calibrationData.ph[i];
-    
-    phCal["isCalibrated"] = cal.isCalibrated;
-    phCal["slope"] = cal.slope;
-    phCal["offset"] = cal.offset;
-    phCal["tempCoeff"] = cal.tempCoeff;
-    phCal["date"] = cal.calibrationDate;
-    phCal["notes"] = cal.notes;
-    
-    JsonObject p1 = phCal["point1"].to<JsonObject>();
-    p1["raw"] = cal.point1.rawValue;
-    p1["actual"] = cal.point1.actualValue;
-    p1["temp"] = cal.point1.temperature;
-    p1["valid"] = cal.point1.valid;
-    
-    JsonObject p2 = phCal["point2"].to<JsonObject>();
-    p2["raw"] = cal.point2.rawValue;
-    p2["actual"] = cal.point2.actualValue;
-    p2["temp"] = cal.point2.temperature;
-    p2["valid"] = cal.point2.valid;
-    
-    JsonObject p3 = phCal["point3"].to<JsonObject>();
-    p3["raw"] = cal.point3.rawValue;
-    p3["actual"] = cal.point3.actualValue;
-    p3["temp"] = cal.point3.temperature;
-    p3["valid"] = cal.point3.valid;
-  }
-  
-  // Save TDS calibrations
-  JsonArray tdsArray = doc["tds"].to<JsonArray>();
-  for (int i = 0; i < 8; i++) {
-    JsonObject tdsCal = tdsArray.add<JsonObject>();
-    const TDSCalibration& cal = calibrationData.tds[i];
-    
-    tdsCal["isCalibrated"] = cal.isCalibrated;
-    tdsCal["kFactor"] = cal.kFactor;
-    tdsCal["slope"] = cal.slope;
-    tdsCal["offset"] = cal.offset;
-    tdsCal["tempCoeff"] = cal.tempCoeff;
-    tdsCal["date"] = cal.calibrationDate;
-    tdsCal["notes"] = cal.notes;
-    
-    JsonObject p1 = tdsCal["point1"].to<JsonObject>();
-    p1["raw"] = cal.point1.rawValue;
-    p1["actual"] = cal.point1.actualValue;
-    p1["temp"] = cal.point1.temperature;
-    p1["valid"] = cal.point1.valid;
-    
-    JsonObject p2 = tdsCal["point2"].to<JsonObject>();
-    p2["raw"] = cal.point2.rawValue;
-    p2["actual"] = cal.point2.actualValue;
-    p2["temp"] = cal.point2.temperature;
-    p2["valid"] = cal.point2.valid;
-  }
-  
-  // Save to file
-  File file = SPIFFS.open("/calibration.json", "w");
-  if (!file) {
-    Serial.println("[CAL] Failed to open calibration file for writing");
-    return false;
+  CalibrationRecord records[MAX_CHANNELS_PER_TYPE];
+  int written = 0;
+  for (int type = 0; type < CAL_SENSOR_TYPES; type++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      packRecord(type, i, records[i]);
+    }
+    written += store.write(records, MAX_CHANNELS_PER_TYPE);
   }
   
-  if (serializeJson(doc, file) == 0) {
+  if (written != CAL_SENSOR_TYPES * MAX_CHANNELS_PER_TYPE) {
     Serial.println("[CAL] Failed to write calibration data");
-    file.close();
     return false;
   }
-  
-  file.close();
   Serial.println("[CAL] Calibration data saved successfully");
   return true;
 }
 
+bool CalibrationManager::commitRecord(uint8_t sensorType, int sensorIndex) {
+  CalibrationRecord record;
+  packRecord(sensorType, sensorIndex, record);
+  if (store.write(&record, 1) != 1) {
+    Serial.println("[CAL] Failed to write calibration data");
+    return false;
+  }
+  Serial.printf("[CAL] Record committed: %lu bytes in %.1f ms\n", store.getLastWriteBytes(),
+                store.getLastWriteMicros() / 1000.0);
+  return true;
+}
+
+static void copyText(char* target, size_t size, const String& text) {
+  strncpy(target, text.c_str(), size - 1);
+  target[size - 1] = '\0';
+}
+
+static void packPoints(CalibrationRecord& record, const CalibrationPoint* points, int pointCount) {
+  record.pointCount = 0;
+  for (int i = 0; i < pointCount && i < CAL_MAX_POINTS; i++) {
+    if (!points[i].valid) continue;
+    CalibrationRecordPoint& point = record.points[record.pointCount++];
+    point.raw = points[i].rawValue;
+    point.actual = points[i].actualValue;
+    point.temperature = points[i].temperature;
+  }
+}
+
+static int unpackPoints(const CalibrationRecord& record, CalibrationPoint* points) {
+  int count = record.pointCount < CAL_MAX_POINTS ? record.pointCount : CAL_MAX_POINTS;
+  for (int i = 0; i < count; i++) {
+    points[i].rawValue = record.points[i].raw;
+    points[i].actualValue = record.points[i].actual;
+    points[i].temperature = record.points[i].temperature;
+    points[i].valid = true;
+  }
+  return count;
+}
+
+void CalibrationManager::packRecord(uint8_t sensorType, int sensorIndex, CalibrationRecord& record) {
+  memset(&record, 0, sizeof(record));
+  record.sensorType = sensorType;
+  record.channel = sensorIndex;
+  
+  if (sensorType == CAL_TYPE_TEMPERATURE) {
+    const TemperatureCalibration& cal = calibrationData.temperature[sensorIndex];
+    CalibrationPoint points[2] = { cal.point1, cal.point2 };
+    record.calibrated = cal.isCalibrated;
+    record.curveType = CURVE_LINEAR;
+    record.slope = cal.slope;
+    record.offset = cal.offset;
+    packPoints(record, points, 2);
+    copyText(record.date, CAL_DATE_LENGTH, cal.calibrationDate);
+    copyText(record.notes, CAL_NOTES_LENGTH, cal.notes);
+  } else if (sensorType == CAL_TYPE_PH) {
+    const PHCalibration& cal = calibrationData.ph[sensorIndex];
+    record.calibrated = cal.isCalibrated;
+    record.curveType = cal.curve.type;
+    record.slope = cal.curve.getSlope();
+    record.offset = cal.curve.getOffset();
+    record.tempCoeff = cal.tempCoeff;
+    packPoints(record, cal.points, cal.pointCount);
+    copyText(record.date, CAL_DATE_LENGTH, cal.calibrationDate);
+    copyText(record.notes, CAL_NOTES_LENGTH, cal.notes);
+  } else {
+    const TDSCalibration& cal = calibrationData.tds[sensorIndex];
+    record.calibrated = cal.isCalibrated;
+    record.curveType = cal.curve.type;
+    record.slope = cal.curve.getSlope();
+    record.offset = cal.curve.getOffset();
+    record.tempCoeff = cal.tempCoeff;
+    record.kFactor = cal.kFactor;
+    packPoints(record, cal.points, cal.pointCount);
+    copyText(record.date, CAL_DATE_LENGTH, cal.calibrationDate);
+    copyText(record.notes, CAL_NOTES_LENGTH, cal.notes);
+  }
+}
+
+void CalibrationManager::unpackRecord(const CalibrationRecord& record) {
+  int i = record.channel;
+  
+  if (record.sensorType == CAL_TYPE_TEMPERATURE) {
+    TemperatureCalibration& cal = calibrationData.temperature[i];
+    CalibrationPoint points[2];
+    memset(points, 0, sizeof(points));
+    unpackPoints(record, points);
+    cal.point1 = points[0];
+    cal.point2 = points[1];
+    cal.slope = record.slope;
+    cal.offset = record.offset;
+    cal.isCalibrated = record.calibrated;
+    cal.calibrationDate = record.date;
+    cal.notes = record.notes;
+  } else if (record.sensorType == CAL_TYPE_PH) {
+    PHCalibration& cal = calibrationData.ph[i];
+    cal.pointCount = unpackPoints(record, cal.points);
+    restoreCurve(record.curveType, record.slope, record.offset, cal.points, cal.pointCount, cal.curve, cal.fit);
+    cal.tempCoeff = record.tempCoeff;
+    cal.isCalibrated = record.calibrated;
+    cal.calibrationDate = record.date;
+    cal.notes = record.notes;
+  } else if (record.sensorType == CAL_TYPE_TDS) {
+    TDSCalibration& cal = calibrationData.tds[i];
+    cal.pointCount = unpackPoints(record, cal.points);
+    restoreCurve(record.curveType, record.slope, record.offset, cal.points, cal.pointCount, cal.curve, cal.fit);
+    cal.tempCoeff = record.tempCoeff;
+    cal.kFactor = record.kFactor;
+    cal.isCalibrated = record.calibrated;
+    cal.calibrationDate = record.date;
+    cal.notes = record.notes;
+  }
+}
+
 float CalibrationManager::calculateSlope(const CalibrationPoint& p1, const CalibrationPoint& p2) {
   if (p1.rawValue == p2.rawValue) {
     return 1.0; // Avoid division by zero
@@ -278,20 +390,103 @@ String CalibrationManager::getCurrentDateTime() {
   return String(buffer);
 }
 
+bool CalibrationManager::addPoint(CalibrationPoint* points, int& pointCount, float rawValue,
+                                  float actualValue, float temperature) {
+  if (pointCount >= CAL_MAX_POINTS) return false;
+  CalibrationPoint& point = points[pointCount++];
+  point.rawValue = rawValue;
+  point.actualValue = actualValue;
+  point.temperature = temperature;
+  point.valid = true;
+  return true;
+}
+
+bool CalibrationManager::fitCurve(CalibrationPoint* points, int pointCount, CalibrationCurve& curve,
+                                  CalibrationFitQuality& fit) {
+  CalibrationCurve fitted;
+  if (!CalibrationFit::fit(curve.type, points, pointCount, fitted)) {
+    return false;
+  }
+  curve = fitted;
+  fit = CalibrationFit::quality(curve, points, pointCount);
+  return true;
+}
+
+void CalibrationManager::loadPoints(JsonObject source, CalibrationPoint* points, int& pointCount) {
+  pointCount = 0;
+  if (source.containsKey("points")) {
+    for (JsonObject p : source["points"].as<JsonArray>()) {
+      if (!addPoint(points, pointCount, p["raw"], p["actual"], p["temp"] | 25.0)) break;
+    }
+    return;
+  }
+  
+  // Files written before N-point calibration have point1..point3
+  const char* legacyKeys[] = { "point1", "point2", "point3" };
+  for (int i = 0; i < 3; i++) {
+    JsonObject p = source[legacyKeys[i]];
+    if (p && (p["valid"] | false)) {
+      addPoint(points, pointCount, p["raw"], p["actual"], p["temp"] | 25.0);
+    }
+  }
+}
+
+void CalibrationManager::restoreCurve(uint8_t type, float slope, float offset, CalibrationPoint* points,
+                                      int pointCount, CalibrationCurve& curve, CalibrationFitQuality& fit) {
+  // Lines are kept as saved (files from before N-point calibration hold a
+  // 2-point line); other curves are refitted from the points, the fit is
+  // deterministic
+  curve.setLinear(slope, offset);
+  if (type != CURVE_LINEAR) {
+    curve.type = type;
+    if (!fitCurve(points, pointCount, curve, fit)) {
+      curve.setLinear(slope, offset);
+    }
+  }
+  fit = CalibrationFit::quality(curve, points, pointCount);
+}
+
+void CalibrationManager::addFitStatus(JsonObject target, const CalibrationPoint* points, int pointCount,
+                                      const CalibrationCurve& curve, const CalibrationFitQuality& fit) {
+  target["curve"] = CalibrationFit::typeName(curve.type);
+  target["points"] = pointCount;
+  if (!target["isCalibrated"].as<bool>()) return;
+  
+  if (curve.type == CURVE_POLYNOMIAL) {
+    JsonArray coefficients = target["coefficients"].to<JsonArray>();
+    for (int i = 0; i <= curve.order; i++) {
+      coefficients.add(curve.poly[i]);
+    }
+  }
+  target["r2"] = fit.r2;
+  target["rms_residual"] = fit.rmsResidual;
+  target["max_residual"] = fit.maxResidual;
+  JsonArray residuals = target["residuals"].to<JsonArray>();
+  for (int i = 0; i < pointCount; i++) {
+    residuals.add(points[i].actualValue - curve.evaluate(points[i].rawValue));
+  }
+}
+
 // Temperature sensor calibration methods
-bool CalibrationManager::startTemperatureCalibration(int sensorIndex, const String& notes) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+bool CalibrationManager::resetTemperatureCalibration(int sensorIndex, const String& notes) {
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   TemperatureCalibration& cal = calibrationData.temperature[sensorIndex];
-  memset(&cal, 0, sizeof(cal));
+  cal = TemperatureCalibration();
   cal.notes = notes;
   
   Serial.printf("[CAL] Started temperature calibration for sensor %d\n", sensorIndex + 1);
   return true;
 }
 
+bool CalibrationManager::startTemperatureCalibration(int sensorIndex, const String& notes) {
+  if (!resetTemperatureCalibration(sensorIndex, notes)) return false;
+  compileTemperatureTable();
+  return true;
+}
+
 bool CalibrationManager::addTemperatureCalibrationPoint(int sensorIndex, float rawValue, float actualTemp, float ambientTemp) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   TemperatureCalibration& cal = calibrationData.temperature[sensorIndex];
   
@@ -315,8 +510,8 @@ bool CalibrationManager::addTemperatureCalibrationPoint(int sensorIndex, float r
   return false;
 }
 
-bool CalibrationManager::finalizeTemperatureCalibration(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+bool CalibrationManager::fitTemperatureCalibration(int sensorIndex) {
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   TemperatureCalibration& cal = calibrationData.temperature[sensorIndex];
   
@@ -333,12 +528,18 @@ bool CalibrationManager::finalizeTemperatureCalibration(int sensorIndex) {
   Serial.printf("[CAL] Temperature sensor %d calibrated: slope=%.6f, offset=%.6f\n", 
                 sensorIndex + 1, cal.slope, cal.offset);
   
-  saveCalibrationData();
+  return true;
+}
+
+bool CalibrationManager::finalizeTemperatureCalibration(int sensorIndex) {
+  if (!fitTemperatureCalibration(sensorIndex)) return false;
+  commitRecord(CAL_TYPE_TEMPERATURE, sensorIndex);
+  compileTemperatureTable();
   return true;
 }
 
 float CalibrationManager::getCalibratedTemperature(int sensorIndex, float rawValue) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return rawValue;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return rawValue;
   
   const TemperatureCalibration& cal = calibrationData.temperature[sensorIndex];
   
@@ -351,80 +552,75 @@ float CalibrationManager::getCalibratedTemperature(int sensorIndex, float rawVal
 }
 
 bool CalibrationManager::isTemperatureCalibrated(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   return calibrationData.temperature[sensorIndex].isCalibrated;
 }
 
 // pH sensor calibration methods
-bool CalibrationManager::startPHCalibration(int sensorIndex, const String& notes) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+bool CalibrationManager::resetPHCalibration(int sensorIndex, const String& notes, uint8_t curveType) {
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   PHCalibration& cal = calibrationData.ph[sensorIndex];
-  memset(&cal, 0, sizeof(cal));
+  cal = PHCalibration();
   cal.notes = notes;
   cal.tempCoeff = CalibrationStandards::TEMP_COEFF_PH;
+  cal.curve.setLinear(1.0, 0.0);
+  cal.curve.type = curveType;
   
-  Serial.printf("[CAL] Started pH calibration for sensor %d\n", sensorIndex + 1);
+  Serial.printf("[CAL] Started pH calibration for sensor %d (%s fit)\n", sensorIndex + 1,
+                CalibrationFit::typeName(curveType));
+  return true;
+}
+
+bool CalibrationManager::startPHCalibration(int sensorIndex, const String& notes, uint8_t curveType) {
+  if (!resetPHCalibration(sensorIndex, notes, curveType)) return false;
+  compilePHTable();
   return true;
 }
 
 bool CalibrationManager::addPHCalibrationPoint(int sensorIndex, float rawValue, float actualPH, float temperature) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   PHCalibration& cal = calibrationData.ph[sensorIndex];
   
-  if (!cal.point1.valid) {
-    cal.point1.rawValue = rawValue;
-    cal.point1.actualValue = actualPH;
-    cal.point1.temperature = temperature;
-    cal.point1.valid = true;
-    Serial.printf("[CAL] pH%d Point 1: Raw=%.3f, Actual=%.2f pH\n", sensorIndex + 1, rawValue, actualPH);
-    return true;
-  } else if (!cal.point2.valid) {
-    cal.point2.rawValue = rawValue;
-    cal.point2.actualValue = actualPH;
-    cal.point2.temperature = temperature;
-    cal.point2.valid = true;
-    Serial.printf("[CAL] pH%d Point 2: Raw=%.3f, Actual=%.2f pH\n", sensorIndex + 1, rawValue, actualPH);
-    return true;
-  } else if (!cal.point3.valid) {
-    cal.point3.rawValue = rawValue;
-    cal.point3.actualValue = actualPH;
-    cal.point3.temperature = temperature;
-    cal.point3.valid = true;
-    Serial.printf("[CAL] pH%d Point 3: Raw=%.3f, Actual=%.2f pH\n", sensorIndex + 1, rawValue, actualPH);
-    return true;
+  if (!addPoint(cal.points, cal.pointCount, rawValue, actualPH, temperature)) {
+    Serial.printf("[CAL] pH sensor %d already has %d calibration points\n", sensorIndex + 1, CAL_MAX_POINTS);
+    return false;
   }
   
-  Serial.printf("[CAL] pH sensor %d already has 3 calibration points\n", sensorIndex + 1);
-  return false;
+  Serial.printf("[CAL] pH%d Point %d: Raw=%.3f, Actual=%.2f pH\n", sensorIndex + 1, cal.pointCount, rawValue, actualPH);
+  return true;
 }
 
-bool CalibrationManager::finalizePHCalibration(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+bool CalibrationManager::fitPHCalibration(int sensorIndex) {
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   PHCalibration& cal = calibrationData.ph[sensorIndex];
   
-  if (!cal.point1.valid || !cal.point2.valid) {
-    Serial.printf("[CAL] pH sensor %d needs at least 2 calibration points\n", sensorIndex + 1);
+  if (!fitCurve(cal.points, cal.pointCount, cal.curve, cal.fit)) {
+    Serial.printf("[CAL] pH sensor %d needs at least 2 calibration points with different readings\n", sensorIndex + 1);
     return false;
   }
   
-  // Use 2-point calibration (can be extended to 3-point later)
-  cal.slope = calculateSlope(cal.point1, cal.point2);
-  cal.offset = calculateOffset(cal.point1, cal.slope);
   cal.isCalibrated = true;
   cal.calibrationDate = getCurrentDateTime();
   
-  Serial.printf("[CAL] pH sensor %d calibrated: slope=%.6f, offset=%.6f\n", 
-                sensorIndex + 1, cal.slope, cal.offset);
+  Serial.printf("[CAL] pH sensor %d calibrated: %s fit over %d points, R2=%.5f, max residual=%.4f\n",
+                sensorIndex + 1, CalibrationFit::typeName(cal.curve.type), cal.pointCount,
+                cal.fit.r2, cal.fit.maxResidual);
   
-  saveCalibrationData();
+  return true;
+}
+
+bool CalibrationManager::finalizePHCalibration(int sensorIndex) {
+  if (!fitPHCalibration(sensorIndex)) return false;
+  commitRecord(CAL_TYPE_PH, sensorIndex);
+  compilePHTable();
   return true;
 }
 
 float CalibrationManager::getCalibratedPH(int sensorIndex, float rawValue, float temperature) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return rawValue;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return rawValue;
   
   const PHCalibration& cal = calibrationData.ph[sensorIndex];
   
@@ -432,83 +628,86 @@ float CalibrationManager::getCalibratedPH(int sensorIndex, float rawValue, float
     return rawValue;
   }
   
-  float phValue = (cal.slope * rawValue) + cal.offset;
+  float phValue = cal.curve.evaluate(rawValue);
   
   // Apply temperature compensation
-  float tempDelta = temperature - 25.0; // Reference temperature
+  float tempDelta = temperature - CAL_REFERENCE_TEMP;
   phValue = phValue - (cal.tempCoeff * tempDelta);
   
   return phValue;
 }
 
 bool CalibrationManager::isPHCalibrated(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   return calibrationData.ph[sensorIndex].isCalibrated;
 }
 
 // TDS sensor calibration methods
-bool CalibrationManager::startTDSCalibration(int sensorIndex, const String& notes) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+bool CalibrationManager::resetTDSCalibration(int sensorIndex, const String& notes, uint8_t curveType) {
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   TDSCalibration& cal = calibrationData.tds[sensorIndex];
-  memset(&cal, 0, sizeof(cal));
+  cal = TDSCalibration();
   cal.notes = notes;
   cal.kFactor = 1.0;
   cal.tempCoeff = CalibrationStandards::TEMP_COEFF_EC;
+  cal.curve.setLinear(1.0, 0.0);
+  cal.curve.type = curveType;
   
-  Serial.printf("[CAL] Started TDS calibration for sensor %d\n", sensorIndex + 1);
+  Serial.printf("[CAL] Started TDS calibration for sensor %d (%s fit)\n", sensorIndex + 1,
+                CalibrationFit::typeName(curveType));
+  return true;
+}
+
+bool CalibrationManager::startTDSCalibration(int sensorIndex, const String& notes, uint8_t curveType) {
+  if (!resetTDSCalibration(sensorIndex, notes, curveType)) return false;
+  compileTDSTable();
   return true;
 }
 
 bool CalibrationManager::addTDSCalibrationPoint(int sensorIndex, float rawValue, float actualEC, float temperature) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   TDSCalibration& cal = calibrationData.tds[sensorIndex];
   
-  if (!cal.point1.valid) {
-    cal.point1.rawValue = rawValue;
-    cal.point1.actualValue = actualEC;
-    cal.point1.temperature = temperature;
-    cal.point1.valid = true;
-    Serial.printf("[CAL] TDS%d Point 1: Raw=%.3f, Actual=%.0f uS/cm\n", sensorIndex + 1, rawValue, actualEC);
-    return true;
-  } else if (!cal.point2.valid) {
-    cal.point2.rawValue = rawValue;
-    cal.point2.actualValue = actualEC;
-    cal.point2.temperature = temperature;
-    cal.point2.valid = true;
-    Serial.printf("[CAL] TDS%d Point 2: Raw=%.3f, Actual=%.0f uS/cm\n", sensorIndex + 1, rawValue, actualEC);
-    return true;
+  if (!addPoint(cal.points, cal.pointCount, rawValue, actualEC, temperature)) {
+    Serial.printf("[CAL] TDS sensor %d already has %d calibration points\n", sensorIndex + 1, CAL_MAX_POINTS);
+    return false;
   }
   
-  Serial.printf("[CAL] TDS sensor %d already has 2 calibration points\n", sensorIndex + 1);
-  return false;
+  Serial.printf("[CAL] TDS%d Point %d: Raw=%.3f, Actual=%.0f uS/cm\n", sensorIndex + 1, cal.pointCount, rawValue, actualEC);
+  return true;
 }
 
-bool CalibrationManager::finalizeTDSCalibration(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+bool CalibrationManager::fitTDSCalibration(int sensorIndex) {
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   
   TDSCalibration& cal = calibrationData.tds[sensorIndex];
   
-  if (!cal.point1.valid || !cal.point2.valid) {
-    Serial.printf("[CAL] TDS sensor %d needs 2 calibration points\n", sensorIndex + 1);
+  if (!fitCurve(cal.points, cal.pointCount, cal.curve, cal.fit)) {
+    Serial.printf("[CAL] TDS sensor %d needs at least 2 calibration points with different readings\n", sensorIndex + 1);
     return false;
   }
   
-  cal.slope = calculateSlope(cal.point1, cal.point2);
-  cal.offset = calculateOffset(cal.point1, cal.slope);
   cal.isCalibrated = true;
   cal.calibrationDate = getCurrentDateTime();
   
-  Serial.printf("[CAL] TDS sensor %d calibrated: slope=%.6f, offset=%.6f, kFactor=%.3f\n", 
-                sensorIndex + 1, cal.slope, cal.offset, cal.kFactor);
+  Serial.printf("[CAL] TDS sensor %d calibrated: %s fit over %d points, R2=%.5f, max residual=%.1f, kFactor=%.3f\n",
+                sensorIndex + 1, CalibrationFit::typeName(cal.curve.type), cal.pointCount,
+                cal.fit.r2, cal.fit.maxResidual, cal.kFactor);
   
-  saveCalibrationData();
+  return true;
+}
+
+bool CalibrationManager::finalizeTDSCalibration(int sensorIndex) {
+  if (!fitTDSCalibration(sensorIndex)) return false;
+  commitRecord(CAL_TYPE_TDS, sensorIndex);
+  compileTDSTable();
   return true;
 }
 
 float CalibrationManager::getCalibratedTDS(int sensorIndex, float rawValue, float temperature) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return rawValue;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return rawValue;
   
   const TDSCalibration& cal = calibrationData.tds[sensorIndex];
   
@@ -524,7 +723,7 @@ float CalibrationManager::getCalibratedTDS(int sensorIndex, float rawValue, floa
 }
 
 float CalibrationManager::getCalibratedEC(int sensorIndex, float rawValue, float temperature) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return rawValue;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return rawValue;
   
   const TDSCalibration& cal = calibrationData.tds[sensorIndex];
   
@@ -532,27 +731,221 @@ float CalibrationManager::getCalibratedEC(int sensorIndex, float rawValue, float
     return rawValue;
   }
   
-  float ecValue = (cal.slope * rawValue) + cal.offset;
+  float ecValue = cal.curve.evaluate(rawValue);
   
-  // Apply temperature compensation
-  float tempDelta = temperature - 25.0; // Reference temperature
-  ecValue = ecValue * (1.0 + (cal.tempCoeff * tempDelta));
+  // Refer the conductivity back to the reference temperature
+  float tempDelta = temperature - CAL_REFERENCE_TEMP;
+  ecValue = ecValue / (1.0 + (cal.tempCoeff * tempDelta));
   
   return ecValue;
 }
 
 bool CalibrationManager::isTDSCalibrated(int sensorIndex) {
-  if (sensorIndex < 0 || sensorIndex >= 8) return false;
+  if (sensorIndex < 0 || sensorIndex >= MAX_CHANNELS_PER_TYPE) return false;
   return calibrationData.tds[sensorIndex].isCalibrated;
 }
 
+int CalibrationManager::parseSensorType(const String& sensorType) {
+  return parseSensorTypeName(sensorType);
+}
+
+bool CalibrationManager::resetCalibration(uint8_t sensorType, int sensorIndex, const String& notes, uint8_t curveType) {
+  switch (sensorType) {
+    case CAL_TYPE_TEMPERATURE: return resetTemperatureCalibration(sensorIndex, notes);
+    case CAL_TYPE_PH: return resetPHCalibration(sensorIndex, notes, curveType);
+    case CAL_TYPE_TDS: return resetTDSCalibration(sensorIndex, notes, curveType);
+  }
+  return false;
+}
+
+bool CalibrationManager::addCalibrationPoint(uint8_t sensorType, int sensorIndex, float rawValue,
+                                             float actualValue, float temperature) {
+  switch (sensorType) {
+    case CAL_TYPE_TEMPERATURE: return addTemperatureCalibrationPoint(sensorIndex, rawValue, actualValue, temperature);
+    case CAL_TYPE_PH: return addPHCalibrationPoint(sensorIndex, rawValue, actualValue, temperature);
+    case CAL_TYPE_TDS: return addTDSCalibrationPoint(sensorIndex, rawValue, actualValue, temperature);
+  }
+  return false;
+}
+
+bool CalibrationManager::fitCalibration(uint8_t sensorType, int sensorIndex) {
+  switch (sensorType) {
+    case CAL_TYPE_TEMPERATURE: return fitTemperatureCalibration(sensorIndex);
+    case CAL_TYPE_PH: return fitPHCalibration(sensorIndex);
+    case CAL_TYPE_TDS: return fitTDSCalibration(sensorIndex);
+  }
+  return false;
+}
+
+void CalibrationManager::compileTable(uint8_t sensorType) {
+  switch (sensorType) {
+    case CAL_TYPE_TEMPERATURE: compileTemperatureTable(); break;
+    case CAL_TYPE_PH: compilePHTable(); break;
+    case CAL_TYPE_TDS: compileTDSTable(); break;
+  }
+}
+
+bool CalibrationManager::startSession(uint8_t sensorType, const int* channels, int count, const String& notes,
+                                      uint8_t curveType) {
+  if (sensorType >= CAL_SENSOR_TYPES || count <= 0 || count > MAX_CHANNELS_PER_TYPE) return false;
+  for (int i = 0; i < count; i++) {
+    if (channels[i] < 0 || channels[i] >= MAX_CHANNELS_PER_TYPE) return false;
+    for (int j = 0; j < i; j++) {
+      if (channels[j] == channels[i]) return false;
+    }
+  }
+  
+  if (session.active) {
+    Serial.println("[CAL] Previous calibration session discarded");
+  }
+  memset(&session, 0, sizeof(session));
+  session.sensorType = sensorType;
+  session.channelCount = count;
+  for (int i = 0; i < count; i++) {
+    session.channels[i] = channels[i];
+    resetCalibration(sensorType, channels[i], notes, curveType);
+  }
+  compileTable(sensorType);  // One publish for the whole batch
+  session.active = true;
+  
+  Serial.printf("[CAL] Session started: %d sensors\n", count);
+  return true;
+}
+
+int CalibrationManager::addSessionPoint(const float* rawValues, uint32_t cycle, float actualValue, float temperature) {
+  if (!session.active) return 0;
+  // Two reference values from the same readings cannot both be right
+  if (session.pointCount > 0 && cycle == session.lastCycle) {
+    Serial.println("[CAL] Session point rejected: no new scan cycle since the last point");
+    return 0;
+  }
+  
+  int captured = 0;
+  for (int i = 0; i < session.channelCount; i++) {
+    if (addCalibrationPoint(session.sensorType, session.channels[i], rawValues[i], actualValue, temperature)) {
+      captured++;
+    }
+  }
+  if (captured > 0) {
+    session.pointCount++;
+    session.lastCycle = cycle;
+  }
+  
+  Serial.printf("[CAL] Session point %d captured for %d/%d sensors (cycle %u)\n", session.pointCount,
+                captured, session.channelCount, (unsigned)cycle);
+  return captured;
+}
+
+int CalibrationManager::finalizeSession() {
+  if (!session.active) return 0;
+  
+  CalibrationRecord records[MAX_CHANNELS_PER_TYPE];
+  int recordChannel[MAX_CHANNELS_PER_TYPE];   // Session index of each record
+  int fitted = 0;
+  for (int i = 0; i < session.channelCount; i++) {
+    session.fitted[i] = fitCalibration(session.sensorType, session.channels[i]);
+    if (session.fitted[i]) {
+      recordChannel[fitted] = i;
+      packRecord(session.sensorType, session.channels[i], records[fitted++]);
+    }
+  }
+  
+  // One store write and one table publish for the whole batch
+  bool committed[MAX_CHANNELS_PER_TYPE];
+  int written = 0;
+  if (fitted > 0) {
+    written = store.write(records, fitted, committed);
+    Serial.printf("[CAL] Session committed: %d records, %lu bytes in %.1f ms\n", written,
+                  store.getLastWriteBytes(), store.getLastWriteMicros() / 1000.0);
+  }
+  session.active = false;
+  
+  // Report what reached flash: records flushed before a failure stay
+  // committed, and a channel whose record did not keeps its stored one
+  for (int r = 0; r < fitted; r++) {
+    session.fitted[recordChannel[r]] = committed[r];
+  }
+  if (written < session.channelCount) {
+    // Channels not committed go back to their stored calibration, and the
+    // committed ones reload as stored
+    restoreSessionChannels();
+  } else {
+    compileTable(session.sensorType);
+  }
+  if (written < fitted) {
+    Serial.printf("[CAL] Session store write failed (%d of %d records), the rest keep their stored calibration\n",
+                  written, fitted);
+    return -1;
+  }
+  return written;
+}
+
+void CalibrationManager::restoreSessionChannels() {
+  for (int i = 0; i < session.channelCount; i++) {
+    int channel = session.channels[i];
+    switch (session.sensorType) {
+      case CAL_TYPE_TEMPERATURE: calibrationData.temperature[channel] = TemperatureCalibration(); break;
+      case CAL_TYPE_PH: calibrationData.ph[channel] = PHCalibration(); break;
+      case CAL_TYPE_TDS: calibrationData.tds[channel] = TDSCalibration(); break;
+    }
+  }
+  loadCalibrationData();
+}
+
+void CalibrationManager::cancelSession() {
+  if (!session.active) return;
+  // Channels go back to their stored calibration
+  restoreSessionChannels();
+  session.active = false;
+  Serial.println("[CAL] Session cancelled");
+}
+
+const CalibrationSession& CalibrationManager::getSession() const {
+  return session;
+}
+
+String CalibrationManager::getSessionStatus() {
+  JsonDocument doc;
+  doc["active"] = session.active;
+  if (session.channelCount > 0) {
+    doc["sensor_type"] = sensorTypeName(session.sensorType);
+    doc["points"] = session.pointCount;
+    doc["cycle"] = session.lastCycle;
+  }
+  
+  JsonArray sensors = doc["sensors"].to<JsonArray>();
+  for (int i = 0; i < session.channelCount; i++) {
+    int channel = session.channels[i];
+    JsonObject sensor = sensors.add<JsonObject>();
+    sensor["id"] = channel + 1;
+    if (session.sensorType == CAL_TYPE_PH) {
+      const PHCalibration& cal = calibrationData.ph[channel];
+      sensor["isCalibrated"] = cal.isCalibrated;
+      addFitStatus(sensor, cal.points, cal.pointCount, cal.curve, cal.fit);
+    } else if (session.sensorType == CAL_TYPE_TDS) {
+      const TDSCalibration& cal = calibrationData.tds[channel];
+      sensor["isCalibrated"] = cal.isCalibrated;
+      addFitStatus(sensor, cal.points, cal.pointCount, cal.curve, cal.fit);
+    } else {
+      sensor["isCalibrated"] = calibrationData.temperature[channel].isCalibrated;
+    }
+    if (!session.active) {
+      sensor["fitted"] = session.fitted[i];
+    }
+  }
+  
+  String jsonString;
+  serializeJson(doc, jsonString);
+  return jsonString;
+}
+
 void CalibrationManager::printCalibrationStatus() {
   Serial.println("Calibration Status Summary:");
   Serial.println("===========================");
   
   // Temperature sensors
   Serial.println("Temperature Sensors:");
-  for (int i = 0; i < 8; i++) {
+  for (int i = 0; i < tempSensorCount; i++) {
     const TemperatureCalibration& cal = calibrationData.temperature[i];
     Serial.printf("  Temp%d: %s", i + 1, cal.isCalibrated ? "[CALIBRATED]" : "[NOT CALIBRATED]");
     if (cal.isCalibrated) {
@@ -563,22 +956,24 @@ void CalibrationManager::printCalibrationStatus() {
   
   // pH sensors
   Serial.println("pH Sensors:");
-  for (int i = 0; i < 8; i++) {
+  for (int i = 0; i < phSensorCount; i++) {
     const PHCalibration& cal = calibrationData.ph[i];
     Serial.printf("  pH%d: %s", i + 1, cal.isCalibrated ? "[CALIBRATED]" : "[NOT CALIBRATED]");
     if (cal.isCalibrated) {
-      Serial.printf(" Date: %s", cal.calibrationDate.c_str());
+      Serial.printf(" Date: %s, %s fit, %d points, R2=%.5f", cal.calibrationDate.c_str(),
+                    CalibrationFit::typeName(cal.curve.type), cal.pointCount, cal.fit.r2);
     }
     Serial.println();
   }
   
   // TDS sensors
   Serial.println("TDS Sensors:");
-  for (int i = 0; i < 8; i++) {
+  for (int i = 0; i < tdsSensorCount; i++) {
     const TDSCalibration& cal = calibrationData.tds[i];
     Serial.printf("  TDS%d: %s", i + 1, cal.isCalibrated ? "[CALIBRATED]" : "[NOT CALIBRATED]");
     if (cal.isCalibrated) {
-      Serial.printf(" Date: %s", cal.calibrationDate.c_str());
+      Serial.printf(" Date: %s, %s fit, %d points, R2=%.5f", cal.calibrationDate.c_str(),
+                    CalibrationFit::typeName(cal.curve.type), cal.pointCount, cal.fit.r2);
     }
     Serial.println();
   }
@@ -625,7 +1020,7 @@ String CalibrationManager::getFullCalibrationStatus() {
   
   // Temperature calibration status
   JsonArray tempArray = doc["temperature"].to<JsonArray>();
-  for (int i = 0; i < 8; i++) {
+  for (int i = 0; i < tempSensorCount; i++) {
     JsonObject tempStatus = tempArray.add<JsonObject>();
     const TemperatureCalibration& cal = calibrationData.temperature[i];
     tempStatus["isCalibrated"] = cal.isCalibrated;
@@ -635,22 +1030,37 @@ String CalibrationManager::getFullCalibrationStatus() {
   
   // pH calibration status
   JsonArray phArray = doc["ph"].to<JsonArray>();
-  for (int i = 0; i < 8; i++) {
+  for (int i = 0; i < phSensorCount; i++) {
     JsonObject phStatus = phArray.add<JsonObject>();
     const PHCalibration& cal = calibrationData.ph[i];
     phStatus["isCalibrated"] = cal.isCalibrated;
     phStatus["date"] = cal.calibrationDate;
     phStatus["notes"] = cal.notes;
+    addFitStatus(phStatus, cal.points, cal.pointCount, cal.curve, cal.fit);
   }
   
   // TDS calibration status
   JsonArray tdsArray = doc["tds"].to<JsonArray>();
-  for (int i = 0; i < 8; i++) {
+  for (int i = 0; i < tdsSensorCount; i++) {
     JsonObject tdsStatus = tdsArray.add<JsonObject>();
     const TDSCalibration& cal = calibrationData.tds[i];
     tdsStatus["isCalibrated"] = cal.isCalibrated;
     tdsStatus["date"] = cal.calibrationDate;
     tdsStatus["notes"] = cal.notes;
+    addFitStatus(tdsStatus, cal.points, cal.pointCount, cal.curve, cal.fit);
+  }
+  
+  // Flash store figures, to compare against the JSON file it replaced
+  JsonObject storeStatus = doc["store"].to<JsonObject>();
+  storeStatus["format"] = "binary";
+  storeStatus["record_bytes"] = sizeof(CalibrationRecord);
+  storeStatus["file_bytes"] = CalibrationStore::fileSize();
+  storeStatus["bytes_written"] = store.getBytesWritten();
+  storeStatus["last_commit_bytes"] = store.getLastWriteBytes();
+  storeStatus["last_commit_ms"] = store.getLastWriteMicros() / 1000.0;
+  storeStatus["load_ms"] = lastLoadMicros / 1000.0;
+  if (importedJsonBytes > 0) {
+    storeStatus["imported_json_bytes"] = importedJsonBytes;
   }
   
   String jsonString;
@@ -0,0 +1,173 @@
+#include "CalibrationStore.h"
+#include "SPIFFS.h"
+#include <stddef.h>
+
+CalibrationStore::CalibrationStore()
+  : bytesWritten(0), lastWriteBytes(0), lastWriteMicros(0) {
+  for (int t = 0; t < CAL_SENSOR_TYPES; t++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      sequences[t][i] = 0;
+      activeSlots[t][i] = CAL_NO_SLOT;
+    }
+  }
+}
+
+uint32_t CalibrationStore::crc32(const uint8_t* data, size_t length) {
+  // Bitwise CRC-32 (IEEE, reflected) - records are small, no table needed
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+size_t CalibrationStore::fileSize() {
+  return (size_t)CAL_SENSOR_TYPES * MAX_CHANNELS_PER_TYPE * 2 * sizeof(CalibrationRecord);
+}
+
+size_t CalibrationStore::slotOffset(int sensorType, int channel, int slot) {
+  return ((size_t)(sensorType * MAX_CHANNELS_PER_TYPE + channel) * 2 + slot) * sizeof(CalibrationRecord);
+}
+
+bool CalibrationStore::isValid(const CalibrationRecord& record, int sensorType, int channel) {
+  return record.magic == CAL_RECORD_MAGIC && record.version == CAL_STORE_VERSION &&
+         record.sensorType == sensorType && record.channel == channel &&
+         record.crc == crc32((const uint8_t*)&record, offsetof(CalibrationRecord, crc));
+}
+
+bool CalibrationStore::exists() {
+  if (!SPIFFS.exists(CAL_STORE_FILE)) return false;
+  File file = SPIFFS.open(CAL_STORE_FILE, "r");
+  if (!file) return false;
+  size_t size = file.size();
+  file.close();
+  return size == fileSize();
+}
+
+bool CalibrationStore::create() {
+  File file = SPIFFS.open(CAL_STORE_FILE, "w");
+  if (!file) {
+    Serial.printf("[CAL] Failed to create %s\n", CAL_STORE_FILE);
+    return false;
+  }
+
+  // Zeroed slots fail the magic check, so every sensor starts uncalibrated
+  uint8_t empty[sizeof(CalibrationRecord)];
+  memset(empty, 0, sizeof(empty));
+  size_t written = 0;
+  for (int slot = 0; slot < CAL_SENSOR_TYPES * MAX_CHANNELS_PER_TYPE * 2; slot++) {
+    written += file.write(empty, sizeof(empty));
+  }
+  file.close();
+
+  for (int t = 0; t < CAL_SENSOR_TYPES; t++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      sequences[t][i] = 0;
+      activeSlots[t][i] = CAL_NO_SLOT;
+    }
+  }
+  bytesWritten += written;
+  return written == fileSize();
+}
+
+bool CalibrationStore::beginLoad() {
+  loadFile = SPIFFS.open(CAL_STORE_FILE, "r");
+  return (bool)loadFile;
+}
+
+bool CalibrationStore::loadRecord(int sensorType, int channel, CalibrationRecord& record) {
+  if (sensorType < 0 || sensorType >= CAL_SENSOR_TYPES || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return false;
+  }
+
+  CalibrationRecord slots[2];
+  bool valid[2];
+  for (int slot = 0; slot < 2; slot++) {
+    valid[slot] = loadFile.seek(slotOffset(sensorType, channel, slot)) &&
+                  loadFile.read((uint8_t*)&slots[slot], sizeof(CalibrationRecord)) == sizeof(CalibrationRecord) &&
+                  isValid(slots[slot], sensorType, channel);
+  }
+
+  int newest = -1;
+  if (valid[0] && valid[1]) {
+    newest = (int32_t)(slots[1].sequence - slots[0].sequence) > 0 ? 1 : 0;
+  } else if (valid[0] || valid[1]) {
+    newest = valid[0] ? 0 : 1;
+  }
+
+  if (newest < 0) {
+    activeSlots[sensorType][channel] = CAL_NO_SLOT;
+    sequences[sensorType][channel] = 0;
+    return false;
+  }
+  activeSlots[sensorType][channel] = newest;
+  sequences[sensorType][channel] = slots[newest].sequence;
+  record = slots[newest];
+  return true;
+}
+
+void CalibrationStore::endLoad() {
+  loadFile.close();
+}
+
+int CalibrationStore::write(CalibrationRecord* records, int count, bool* committed) {
+  unsigned long start = micros();
+  if (committed) {
+    for (int r = 0; r < count; r++) committed[r] = false;
+  }
+  File file = SPIFFS.open(CAL_STORE_FILE, "r+");
+  if (!file) {
+    Serial.printf("[CAL] Failed to open %s for writing\n", CAL_STORE_FILE);
+    return 0;
+  }
+
+  int written = 0;
+  unsigned long bytes = 0;
+  for (int r = 0; r < count; r++) {
+    CalibrationRecord& record = records[r];
+    int type = record.sensorType;
+    int channel = record.channel;
+    if (type >= CAL_SENSOR_TYPES || channel >= MAX_CHANNELS_PER_TYPE) continue;
+
+    uint8_t active = activeSlots[type][channel];
+    int slot = (active == 0) ? 1 : 0;
+    record.magic = CAL_RECORD_MAGIC;
+    record.version = CAL_STORE_VERSION;
+    record.sequence = sequences[type][channel] + 1;
+    record.crc = crc32((const uint8_t*)&record, offsetof(CalibrationRecord, crc));
+
+    if (!file.seek(slotOffset(type, channel, slot)) ||
+        file.write((const uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+      Serial.printf("[CAL] Failed to write record %d/%d\n", type, channel);
+      continue;
+    }
+    // The old slot stays the current record until this one is on flash
+    file.flush();
+    activeSlots[type][channel] = slot;
+    sequences[type][channel] = record.sequence;
+    bytes += sizeof(record);
+    written++;
+    if (committed) committed[r] = true;
+  }
+  file.close();
+
+  bytesWritten += bytes;
+  lastWriteBytes = bytes;
+  lastWriteMicros = micros() - start;
+  return written;
+}
+
+unsigned long CalibrationStore::getBytesWritten() const {
+  return bytesWritten;
+}
+
+unsigned long CalibrationStore::getLastWriteBytes() const {
+  return lastWriteBytes;
+}
+
+unsigned long CalibrationStore::getLastWriteMicros() const {
+  return lastWriteMicros;
+}
@@ -0,0 +1,79 @@
+#include "ChannelEstimator.h"
+
+ChannelEstimator::ChannelEstimator() {
+  config.mode = ESTIMATOR_NONE;
+  config.processNoise = DEFAULT_ESTIMATOR_PROCESS_NOISE;
+  config.measurementNoise = DEFAULT_ESTIMATOR_MEASUREMENT_NOISE;
+  config.alpha = DEFAULT_ESTIMATOR_ALPHA;
+  config.adaptive = DEFAULT_ESTIMATOR_ADAPTIVE;
+}
+
+void ChannelEstimator::configure(const EstimatorConfig& estimatorConfig) {
+  config = estimatorConfig;
+  if (config.processNoise < 0) config.processNoise = 0;
+  if (config.measurementNoise <= 0) config.measurementNoise = DEFAULT_ESTIMATOR_MEASUREMENT_NOISE;
+  config.alpha = constrain(config.alpha, 0.01f, 1.0f);
+}
+
+void ChannelEstimator::reset(ChannelEstimate& state) {
+  state.value = 0.0;
+  state.variance = 0.0;
+  state.innovation = 0.0;
+  state.initialized = false;
+}
+
+float ChannelEstimator::update(ChannelEstimate& state, float measurement) const {
+  if (config.mode == ESTIMATOR_NONE) {
+    state.value = measurement;
+    state.variance = 0.0;
+    return measurement;
+  }
+
+  // First reading seeds the estimate with the measurement's own uncertainty
+  if (!state.initialized) {
+    state.value = measurement;
+    state.variance = config.measurementNoise;
+    state.innovation = config.measurementNoise;
+    state.initialized = true;
+    return measurement;
+  }
+
+  float innovation = measurement - state.value;
+
+  if (config.mode == ESTIMATOR_KALMAN) {
+    float predicted = state.variance + config.processNoise;
+    float gain = predicted / (predicted + config.measurementNoise);
+    state.value += gain * innovation;
+    state.variance = (1.0 - gain) * predicted;
+    return state.value;
+  }
+
+  // EWMA
+  float gain = config.alpha;
+  float squared = innovation * innovation;
+  if (config.adaptive) {
+    float ratio = squared / (4.0 * config.measurementNoise);  // >1 beyond 2 sigma
+    if (ratio > 1.0) {
+      gain = config.alpha * ratio < 1.0 ? config.alpha * ratio : 1.0;
+    }
+  }
+  state.value += gain * innovation;
+  state.innovation += gain * (squared - state.innovation);
+  // Variance of an EWMA of independent readings: a / (2 - a) of theirs
+  state.variance = state.innovation * gain / (2.0 - gain);
+  return state.value;
+}
+
+EstimatorMode ChannelEstimator::parseMode(const String& name) {
+  if (name == "kalman") return ESTIMATOR_KALMAN;
+  if (name == "ewma") return ESTIMATOR_EWMA;
+  return ESTIMATOR_NONE;
+}
+
+const char* ChannelEstimator::modeName(EstimatorMode mode) {
+  switch (mode) {
+    case ESTIMATOR_KALMAN: return "kalman";
+    case ESTIMATOR_EWMA:   return "ewma";
+    default:               return "none";
+  }
+}
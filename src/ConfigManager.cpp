@@ -1,4 +1,5 @@
 #include "ConfigManager.h"
+#include "SampleFilter.h"
 #include "Config.h"
 
 ConfigManager::ConfigManager() : configLoaded(false) {
@@ -117,6 +118,18 @@ String ConfigManager::getWifiPassword() {
   }
 }
 
+unsigned long ConfigManager::getWifiBackoffMin() {
+  return configLoaded ? (config["wifi"]["backoff_min_ms"] | DEFAULT_WIFI_BACKOFF_MIN_MS) : DEFAULT_WIFI_BACKOFF_MIN_MS;
+}
+
+unsigned long ConfigManager::getWifiBackoffMax() {
+  return configLoaded ? (config["wifi"]["backoff_max_ms"] | DEFAULT_WIFI_BACKOFF_MAX_MS) : DEFAULT_WIFI_BACKOFF_MAX_MS;
+}
+
+unsigned long ConfigManager::getWifiConnectTimeout() {
+  return configLoaded ? (config["wifi"]["connect_timeout_ms"] | DEFAULT_WIFI_CONNECT_TIMEOUT_MS) : DEFAULT_WIFI_CONNECT_TIMEOUT_MS;
+}
+
 // System configuration  
 String ConfigManager::getDeviceName() {
   return configLoaded ? config["system"]["device_name"].as<String>() : "ESP32 Device";
@@ -134,6 +147,10 @@ int ConfigManager::getPrintInterval() {
   return configLoaded ? config["system"]["print_interval"].as<int>() : 5000;
 }
 
+bool ConfigManager::getFastBoot() {
+  return configLoaded ? (config["system"]["fast_boot"] | DEFAULT_FAST_BOOT) : DEFAULT_FAST_BOOT;
+}
+
 // NO ICONS policy configuration
 bool ConfigManager::getUseIcons() {
   return configLoaded ? config["system"]["use_icons"].as<bool>() : false;  // Always false
@@ -153,15 +170,195 @@ String ConfigManager::getOutputPolicy() {
 
 // Sensor configuration
 int ConfigManager::getTemperatureCount() {
-  return configLoaded ? config["sensors"]["temperature_count"].as<int>() : 8;
+  return configLoaded ? (config["sensors"]["temperature_count"] | DEFAULT_NUM_TEMP_SENSORS) : DEFAULT_NUM_TEMP_SENSORS;
 }
 
 int ConfigManager::getPHCount() {
-  return configLoaded ? config["sensors"]["ph_count"].as<int>() : 8;
+  return configLoaded ? (config["sensors"]["ph_count"] | DEFAULT_NUM_PH_SENSORS) : DEFAULT_NUM_PH_SENSORS;
 }
 
 int ConfigManager::getTDSCount() {
-  return configLoaded ? config["sensors"]["tds_count"].as<int>() : 8;
+  return configLoaded ? (config["sensors"]["tds_count"] | DEFAULT_NUM_TDS_SENSORS) : DEFAULT_NUM_TDS_SENSORS;
+}
+
+String ConfigManager::getFilterMode(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["filters"][sensorType]["mode"] | DEFAULT_FILTER_MODE) : DEFAULT_FILTER_MODE;
+}
+
+int ConfigManager::getFilterSamples(const String& sensorType, int defaultSamples) {
+  return configLoaded ? (config["sensors"]["filters"][sensorType]["samples"] | defaultSamples) : defaultSamples;
+}
+
+int ConfigManager::getFilterWindow(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["filters"][sensorType]["window"] | DEFAULT_FILTER_WINDOW) : DEFAULT_FILTER_WINDOW;
+}
+
+int ConfigManager::getFilterTrimPercent(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["filters"][sensorType]["trim_percent"] | DEFAULT_FILTER_TRIM_PERCENT) : DEFAULT_FILTER_TRIM_PERCENT;
+}
+
+String ConfigManager::getEstimatorMode(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["estimators"][sensorType]["mode"] | DEFAULT_ESTIMATOR_MODE) : DEFAULT_ESTIMATOR_MODE;
+}
+
+float ConfigManager::getEstimatorProcessNoise(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["estimators"][sensorType]["process_noise"] | DEFAULT_ESTIMATOR_PROCESS_NOISE) : DEFAULT_ESTIMATOR_PROCESS_NOISE;
+}
+
+float ConfigManager::getEstimatorMeasurementNoise(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["estimators"][sensorType]["measurement_noise"] | DEFAULT_ESTIMATOR_MEASUREMENT_NOISE) : DEFAULT_ESTIMATOR_MEASUREMENT_NOISE;
+}
+
+float ConfigManager::getEstimatorAlpha(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["estimators"][sensorType]["alpha"] | DEFAULT_ESTIMATOR_ALPHA) : DEFAULT_ESTIMATOR_ALPHA;
+}
+
+bool ConfigManager::getEstimatorAdaptive(const String& sensorType) {
+  return configLoaded ? (config["sensors"]["estimators"][sensorType]["adaptive"] | DEFAULT_ESTIMATOR_ADAPTIVE) : DEFAULT_ESTIMATOR_ADAPTIVE;
+}
+
+bool ConfigManager::getSettleAutoTune() {
+  return configLoaded ? (config["sensors"]["settle_tuning"]["enabled"] | DEFAULT_SETTLE_AUTO_TUNE) : DEFAULT_SETTLE_AUTO_TUNE;
+}
+
+int ConfigManager::getSettleToleranceLsb() {
+  return configLoaded ? (config["sensors"]["settle_tuning"]["tolerance_lsb"] | DEFAULT_SETTLE_TOLERANCE_LSB) : DEFAULT_SETTLE_TOLERANCE_LSB;
+}
+
+unsigned long ConfigManager::getSettleMaxUs() {
+  return configLoaded ? (config["sensors"]["settle_tuning"]["max_us"] | DEFAULT_SETTLE_MAX_US) : DEFAULT_SETTLE_MAX_US;
+}
+
+unsigned long ConfigManager::getSettleRecheckMinutes() {
+  return configLoaded ? (config["sensors"]["settle_tuning"]["recheck_min"] | DEFAULT_SETTLE_RECHECK_MIN) : DEFAULT_SETTLE_RECHECK_MIN;
+}
+
+bool ConfigManager::getSamplingAdaptive() {
+  return configLoaded ? (config["sensors"]["sampling"]["adaptive"] | DEFAULT_SAMPLING_ADAPTIVE) : DEFAULT_SAMPLING_ADAPTIVE;
+}
+
+float ConfigManager::getSamplingAlarmMargin() {
+  return configLoaded ? (config["sensors"]["sampling"]["alarm_margin"] | DEFAULT_SAMPLING_ALARM_MARGIN) : DEFAULT_SAMPLING_ALARM_MARGIN;
+}
+
+unsigned long ConfigManager::getSamplingBaseMs(const String& sensorType, unsigned long defaultMs) {
+  return configLoaded ? (config["sensors"]["sampling"][sensorType]["base_ms"] | defaultMs) : defaultMs;
+}
+
+unsigned long ConfigManager::getSamplingMinMs(const String& sensorType, unsigned long defaultMs) {
+  return configLoaded ? (config["sensors"]["sampling"][sensorType]["min_ms"] | defaultMs) : defaultMs;
+}
+
+unsigned long ConfigManager::getSamplingMaxMs(const String& sensorType, unsigned long defaultMs) {
+  return configLoaded ? (config["sensors"]["sampling"][sensorType]["max_ms"] | defaultMs) : defaultMs;
+}
+
+float ConfigManager::getSamplingChangeThreshold(const String& sensorType, float defaultThreshold) {
+  return configLoaded ? (config["sensors"]["sampling"][sensorType]["change"] | defaultThreshold) : defaultThreshold;
+}
+
+unsigned long ConfigManager::getCaptureIntervalMs() {
+  return configLoaded ? (config["calibration"]["capture"]["interval_ms"] | DEFAULT_CAPTURE_INTERVAL_MS) : DEFAULT_CAPTURE_INTERVAL_MS;
+}
+
+int ConfigManager::getCaptureWindow() {
+  return configLoaded ? (config["calibration"]["capture"]["window"] | DEFAULT_CAPTURE_WINDOW) : DEFAULT_CAPTURE_WINDOW;
+}
+
+unsigned long ConfigManager::getCaptureTimeoutSeconds() {
+  return configLoaded ? (config["calibration"]["capture"]["timeout_s"] | DEFAULT_CAPTURE_TIMEOUT_S) : DEFAULT_CAPTURE_TIMEOUT_S;
+}
+
+float ConfigManager::getCaptureMaxStdev(const String& sensorType, float defaultStdev) {
+  return configLoaded ? (config["calibration"]["capture"][sensorType]["max_stdev"] | defaultStdev) : defaultStdev;
+}
+
+float ConfigManager::getCaptureMaxDrift(const String& sensorType, float defaultDrift) {
+  return configLoaded ? (config["calibration"]["capture"][sensorType]["max_drift"] | defaultDrift) : defaultDrift;
+}
+
+float ConfigManager::getAlarmHysteresisPercent() {
+  return configLoaded ? (config["alarms"]["hysteresis_percent"] | DEFAULT_ALARM_HYSTERESIS_PERCENT) : DEFAULT_ALARM_HYSTERESIS_PERCENT;
+}
+
+unsigned long ConfigManager::getAlarmRaiseSeconds(int aquariumIndex, const String& sensorType) {
+  if (!configLoaded) return DEFAULT_ALARM_RAISE_S;
+  unsigned long global = config["alarms"]["raise_s"] | DEFAULT_ALARM_RAISE_S;
+  if (aquariumIndex < 0 || aquariumIndex >= getAquariumCount()) return global;
+  return config["aquariums"][aquariumIndex]["sensors"][sensorType]["alarm"]["raise_s"] | global;
+}
+
+unsigned long ConfigManager::getAlarmClearSeconds(int aquariumIndex, const String& sensorType) {
+  if (!configLoaded) return DEFAULT_ALARM_CLEAR_S;
+  unsigned long global = config["alarms"]["clear_s"] | DEFAULT_ALARM_CLEAR_S;
+  if (aquariumIndex < 0 || aquariumIndex >= getAquariumCount()) return global;
+  return config["aquariums"][aquariumIndex]["sensors"][sensorType]["alarm"]["clear_s"] | global;
+}
+
+float ConfigManager::getAlarmHysteresis(int aquariumIndex, const String& sensorType, float defaultHysteresis) {
+  if (!configLoaded || aquariumIndex < 0 || aquariumIndex >= getAquariumCount()) {
+    return defaultHysteresis;
+  }
+  return config["aquariums"][aquariumIndex]["sensors"][sensorType]["alarm"]["hysteresis"] | defaultHysteresis;
+}
+
+unsigned long ConfigManager::getTrendWindowSeconds() {
+  return configLoaded ? (config["alarms"]["rate"]["window_s"] | DEFAULT_TREND_WINDOW_S) : DEFAULT_TREND_WINDOW_S;
+}
+
+float ConfigManager::getAlarmMaxRate(int aquariumIndex, const String& sensorType, float defaultPerMinute) {
+  if (!configLoaded) return defaultPerMinute;
+  float global = config["alarms"]["rate"][sensorType]["max_per_min"] | defaultPerMinute;
+  if (aquariumIndex < 0 || aquariumIndex >= getAquariumCount()) return global;
+  return config["aquariums"][aquariumIndex]["sensors"][sensorType]["alarm"]["max_rate_per_min"] | global;
+}
+
+bool ConfigManager::getMqttEnabled() {
+  return configLoaded ? (config["mqtt"]["enabled"] | DEFAULT_MQTT_ENABLED) : DEFAULT_MQTT_ENABLED;
+}
+
+String ConfigManager::getMqttHost() {
+  return configLoaded ? (config["mqtt"]["host"] | "") : "";
+}
+
+int ConfigManager::getMqttPort() {
+  return configLoaded ? (config["mqtt"]["port"] | DEFAULT_MQTT_PORT) : DEFAULT_MQTT_PORT;
+}
+
+String ConfigManager::getMqttClientId() {
+  return configLoaded ? (config["mqtt"]["client_id"] | DEFAULT_MQTT_CLIENT_ID) : DEFAULT_MQTT_CLIENT_ID;
+}
+
+String ConfigManager::getMqttUsername() {
+  return configLoaded ? (config["mqtt"]["username"] | "") : "";
+}
+
+String ConfigManager::getMqttPassword() {
+  return configLoaded ? (config["mqtt"]["password"] | "") : "";
+}
+
+String ConfigManager::getMqttBaseTopic() {
+  return configLoaded ? (config["mqtt"]["base_topic"] | DEFAULT_MQTT_BASE_TOPIC) : DEFAULT_MQTT_BASE_TOPIC;
+}
+
+String ConfigManager::getMqttBatch() {
+  return configLoaded ? (config["mqtt"]["batch"] | DEFAULT_MQTT_BATCH) : DEFAULT_MQTT_BATCH;
+}
+
+int ConfigManager::getMqttTelemetryQos() {
+  return configLoaded ? (config["mqtt"]["telemetry_qos"] | DEFAULT_MQTT_TELEMETRY_QOS) : DEFAULT_MQTT_TELEMETRY_QOS;
+}
+
+int ConfigManager::getMqttAlarmQos() {
+  return configLoaded ? (config["mqtt"]["alarm_qos"] | DEFAULT_MQTT_ALARM_QOS) : DEFAULT_MQTT_ALARM_QOS;
+}
+
+unsigned long ConfigManager::getMqttMinIntervalSeconds() {
+  return configLoaded ? (config["mqtt"]["min_interval_s"] | DEFAULT_MQTT_MIN_INTERVAL_S) : DEFAULT_MQTT_MIN_INTERVAL_S;
+}
+
+int ConfigManager::getMqttKeepAliveSeconds() {
+  return configLoaded ? (config["mqtt"]["keepalive_s"] | DEFAULT_MQTT_KEEPALIVE_S) : DEFAULT_MQTT_KEEPALIVE_S;
 }
 
 // Hardware configuration
@@ -201,6 +398,61 @@ int ConfigManager::getMuxEnable() {
   return configLoaded ? config["hardware"]["mux_enable"].as<int>() : 21;
 }
 
+String ConfigManager::getAdcMode() {
+  return configLoaded ? (config["hardware"]["adc_mode"] | DEFAULT_ADC_MODE) : DEFAULT_ADC_MODE;
+}
+
+// Multiplexer banks
+int ConfigManager::getMuxBankCount() {
+  if (!configLoaded || !config["hardware"]["mux_banks"].is<JsonArray>()) {
+    return 0;
+  }
+  return config["hardware"]["mux_banks"].size();
+}
+
+String ConfigManager::getMuxBankType(int index) {
+  if (index < 0 || index >= getMuxBankCount()) {
+    return "";
+  }
+  return config["hardware"]["mux_banks"][index]["type"].as<String>();
+}
+
+int ConfigManager::getMuxBankEnable(int index) {
+  if (index < 0 || index >= getMuxBankCount()) {
+    return getMuxEnable();
+  }
+  return config["hardware"]["mux_banks"][index]["enable"] | getMuxEnable();
+}
+
+int ConfigManager::getMuxBankAdcPin(int index) {
+  if (index < 0 || index >= getMuxBankCount()) {
+    return -1;
+  }
+  return config["hardware"]["mux_banks"][index]["adc"] | -1;
+}
+
+bool ConfigManager::hasMuxBankAddress(int index) {
+  if (index < 0 || index >= getMuxBankCount()) {
+    return false;
+  }
+  return config["hardware"]["mux_banks"][index]["address"].is<JsonArray>() &&
+         config["hardware"]["mux_banks"][index]["address"].size() == 4;
+}
+
+int ConfigManager::getMuxBankAddressPin(int index, int line) {
+  if (!hasMuxBankAddress(index) || line < 0 || line >= 4) {
+    return -1;
+  }
+  return config["hardware"]["mux_banks"][index]["address"][line].as<int>();
+}
+
+int ConfigManager::getMuxBankSettleUs(int index) {
+  if (index < 0 || index >= getMuxBankCount()) {
+    return 0;
+  }
+  return config["hardware"]["mux_banks"][index]["settle_us"] | 0;
+}
+
 // Utility methods
 bool ConfigManager::isLoaded() {
   return configLoaded;
@@ -224,6 +476,7 @@ void ConfigManager::printConfig() {
   Serial.printf("  Serial Baud: %d\n", getSerialBaud());
   Serial.printf("  Sensor Read Interval: %dms\n", getSensorReadInterval());
   Serial.printf("  Print Interval: %dms\n", getPrintInterval());
+  Serial.printf("  Fast Boot: %s\n", getFastBoot() ? "true" : "false");
   Serial.println();
   
   Serial.println("Output Policy:");
@@ -237,6 +490,17 @@ void ConfigManager::printConfig() {
   Serial.printf("  Temperature Sensors: %d\n", getTemperatureCount());
   Serial.printf("  pH Sensors: %d\n", getPHCount());
   Serial.printf("  TDS Sensors: %d\n", getTDSCount());
+  Serial.printf("  Settle Auto-Tune: %s\n", getSettleAutoTune() ? "true" : "false");
+  Serial.printf("  Adaptive Sampling: %s\n", getSamplingAdaptive() ? "true" : "false");
+  Serial.println();
+  
+  Serial.println("MQTT:");
+  Serial.printf("  Enabled: %s\n", getMqttEnabled() ? "true" : "false");
+  if (getMqttEnabled()) {
+    Serial.printf("  Broker: %s:%d\n", getMqttHost().c_str(), getMqttPort());
+    Serial.printf("  Topic: %s/%s (batch: %s)\n", getMqttBaseTopic().c_str(), getMqttClientId().c_str(),
+                  getMqttBatch().c_str());
+  }
   Serial.println();
   
   Serial.println("Hardware Pins:");
@@ -247,6 +511,12 @@ void ConfigManager::printConfig() {
   Serial.printf("  Multiplexer Control: S0=%d, S1=%d, S2=%d, S3=%d\n", 
                 getMuxS0(), getMuxS1(), getMuxS2(), getMuxS3());
   Serial.printf("  Multiplexer Enable: %d\n", getMuxEnable());
+  Serial.printf("  ADC Mode: %s\n", getAdcMode().c_str());
+  for (int i = 0; i < getMuxBankCount(); i++) {
+    Serial.printf("  Mux Bank %d: %s, ADC %d, EN %d, settle %dus%s\n", i, getMuxBankType(i).c_str(),
+                  getMuxBankAdcPin(i), getMuxBankEnable(i), getMuxBankSettleUs(i),
+                  hasMuxBankAddress(i) ? ", own address bus" : "");
+  }
   
   Serial.println();
   Serial.println("Security Configuration:");
@@ -0,0 +1,299 @@
+#include "HttpConnectionTable.h"
+
+HttpConnectionTable::HttpConnectionTable() : handler(nullptr) {
+  memset(&stats, 0, sizeof(stats));
+
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    connections[i].slot = i;
+    connections[i].state = ConnectionState::FREE;
+  }
+}
+
+void HttpConnectionTable::setHandler(HttpConnectionHandler* connectionHandler) {
+  handler = connectionHandler;
+}
+
+void HttpConnectionTable::handleClients(WiFiServer& plain, WiFiServer* secure, unsigned long now) {
+  acceptClients(plain, secure, now);
+
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    if (connections[i].state != ConnectionState::FREE) {
+      serviceConnection(connections[i], now);
+    }
+  }
+}
+
+const HttpServerStats& HttpConnectionTable::getStats() const {
+  return stats;
+}
+
+HttpConnection* HttpConnectionTable::findFreeSlot() {
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    if (connections[i].state == ConnectionState::FREE) {
+      return &connections[i];
+    }
+  }
+  return nullptr;
+}
+
+void HttpConnectionTable::acceptClients(WiFiServer& plain, WiFiServer* secure, unsigned long now) {
+  // New clients wait in the listen backlog while the table is full
+  HttpConnection* slot = findFreeSlot();
+  if (slot) {
+    WiFiClient httpClient = plain.available();
+    if (httpClient) {
+      slot->client = httpClient;
+      openConnection(*slot, false, now);
+      slot = findFreeSlot();
+    }
+  }
+
+  if (slot && secure) {
+    WiFiClient httpsClient = secure->available();
+    if (httpsClient) {
+      slot->client = httpsClient;
+      openConnection(*slot, true, now);
+    }
+  }
+}
+
+void HttpConnectionTable::openConnection(HttpConnection& conn, bool isSecure, unsigned long now) {
+  conn.isSecure = isSecure;
+  conn.state = isSecure ? ConnectionState::HANDSHAKE : ConnectionState::READING;
+  conn.parser.reset();
+  conn.response = "";
+  conn.responseSent = 0;
+  conn.keepAlive = false;
+  conn.lastActivity = now;
+  conn.requestStarted = 0;
+  conn.requestsServed = 0;
+  conn.client.setNoDelay(true);
+
+  stats.accepted++;
+  stats.activeConnections++;
+  if (stats.activeConnections > stats.peakConnections) {
+    stats.peakConnections = stats.activeConnections;
+  }
+
+  if (isSecure && !handler->beginSecure(conn)) {
+    conn.state = ConnectionState::CLOSING;
+  }
+}
+
+void HttpConnectionTable::closeConnection(HttpConnection& conn) {
+  if (conn.isSecure) {
+    handler->endSecure(conn);
+  }
+  conn.client.stop();
+  conn.response = "";
+  conn.state = ConnectionState::FREE;
+  stats.activeConnections--;
+}
+
+void HttpConnectionTable::serviceConnection(HttpConnection& conn, unsigned long now) {
+  // A gone client only matters while we wait for its input. One that half-
+  // closes after sending its request still gets the response (a dead socket
+  // fails the write), and a pipelined request already buffered is served.
+  bool waitingForInput = conn.state == ConnectionState::HANDSHAKE ||
+                         (conn.state == ConnectionState::READING && !conn.parser.isComplete());
+  if (waitingForInput && !conn.client.connected() && conn.client.available() == 0) {
+    closeConnection(conn);
+    return;
+  }
+
+  switch (conn.state) {
+    case ConnectionState::HANDSHAKE:
+      continueHandshake(conn, now);
+      break;
+    case ConnectionState::READING:
+      readRequest(conn, now);
+      break;
+    case ConnectionState::WRITING:
+      writeResponse(conn, now);
+      break;
+    case ConnectionState::CLOSING:
+      closeConnection(conn);
+      break;
+    case ConnectionState::FREE:
+      break;
+  }
+}
+
+void HttpConnectionTable::continueHandshake(HttpConnection& conn, unsigned long now) {
+  // One handshake step per pass; the key exchange itself still runs to
+  // completion inside the step that receives the client's key share
+  int result = handler->continueHandshake(conn, now);
+  if (result > 0) {
+    conn.lastActivity = now;
+    conn.state = ConnectionState::READING;
+  } else if (result < 0) {
+    closeConnection(conn);
+  } else if (now - conn.lastActivity > HTTP_REQUEST_TIMEOUT_MS) {
+    // Connected but never finished the handshake
+    stats.timeouts++;
+    closeConnection(conn);
+  }
+}
+
+int HttpConnectionTable::connectionRead(HttpConnection& conn, uint8_t* buf, size_t len) {
+  if (conn.isSecure) {
+    return handler->secureRead(conn, buf, len);
+  }
+
+  int available = conn.client.available();
+  if (available <= 0) return 0;
+  size_t toRead = (size_t)available < len ? available : len;
+  return conn.client.read(buf, toRead);
+}
+
+int HttpConnectionTable::connectionWrite(HttpConnection& conn, const uint8_t* buf, size_t len) {
+  if (conn.isSecure) {
+    return handler->secureWrite(conn, buf, len);
+  }
+  size_t written = conn.client.write(buf, len);
+  if (written == 0 && !conn.client.connected()) {
+    return -1;  // Reset by the client, not just a full send buffer
+  }
+  return written;
+}
+
+void HttpConnectionTable::readRequest(HttpConnection& conn, unsigned long now) {
+  HttpRequestParser& parser = conn.parser;
+
+  // One bulk read per pass, straight into the parser's buffer
+  if (!parser.isComplete() && !parser.hasError()) {
+    bool wasIdle = parser.isIdle();
+    int bytesRead = connectionRead(conn, (uint8_t*)parser.writePtr(), parser.writeSpace());
+    if (bytesRead < 0) {
+      closeConnection(conn);
+      return;
+    }
+    if (bytesRead > 0) {
+      if (wasIdle) {
+        conn.requestStarted = now;
+      }
+      parser.commit(bytesRead);
+      conn.lastActivity = now;
+    }
+  }
+
+  if (parser.hasError()) {
+    stats.parseErrors++;
+    conn.keepAlive = false;
+    sendResponse(conn, parser.getErrorStatus(), "text/plain", statusText(parser.getErrorStatus()));
+    return;
+  }
+
+  if (parser.isComplete()) {
+    stats.requests++;
+    if (conn.requestsServed > 0) stats.keepAliveReuses++;
+    conn.requestsServed++;
+    conn.keepAlive = parser.keepAlive() && conn.requestsServed < HTTP_MAX_KEEPALIVE_REQUESTS;
+    handler->handleRequest(conn);
+    return;
+  }
+
+  // Timeouts: stalled mid-request, or idle between keep-alive requests
+  if (!parser.isIdle()) {
+    if (now - conn.requestStarted > HTTP_REQUEST_TIMEOUT_MS) {
+      stats.timeouts++;
+      conn.keepAlive = false;
+      sendResponse(conn, 408, "text/plain", "Request Timeout");
+    }
+  } else if (now - conn.lastActivity > HTTP_IDLE_TIMEOUT_MS) {
+    closeConnection(conn);
+  }
+}
+
+void HttpConnectionTable::writeResponse(HttpConnection& conn, unsigned long now) {
+  size_t remaining = conn.response.length() - conn.responseSent;
+  size_t chunk = remaining < HTTP_WRITE_CHUNK ? remaining : HTTP_WRITE_CHUNK;
+
+  if (chunk > 0) {
+    int written = connectionWrite(conn, (const uint8_t*)conn.response.c_str() + conn.responseSent, chunk);
+    if (written < 0) {
+      closeConnection(conn);
+      return;
+    }
+    if (written > 0) {
+      conn.responseSent += written;
+      conn.lastActivity = now;
+    } else if (now - conn.lastActivity > HTTP_REQUEST_TIMEOUT_MS) {
+      // Client stopped reading
+      stats.timeouts++;
+      closeConnection(conn);
+      return;
+    }
+  }
+
+  if (conn.responseSent >= conn.response.length()) {
+    finishResponse(conn);
+  }
+}
+
+void HttpConnectionTable::finishResponse(HttpConnection& conn) {
+  conn.response = "";
+  conn.responseSent = 0;
+
+  if (!conn.keepAlive) {
+    conn.state = ConnectionState::CLOSING;
+    return;
+  }
+
+  // Keep the connection and start on any pipelined request already buffered
+  conn.parser.consumeRequest();
+  conn.requestStarted = conn.lastActivity;
+  conn.state = ConnectionState::READING;
+}
+
+const char* HttpConnectionTable::statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 505: return "HTTP Version Not Supported";
+    default:  return "Unknown";
+  }
+}
+
+void HttpConnectionTable::sendResponse(HttpConnection& conn, int code, const String& contentType, const String& content) {
+  String headers = "HTTP/1.1 " + String(code) + " " + statusText(code) + "\r\n";
+  headers += "Content-Type: " + contentType + "\r\n";
+  headers += "Content-Length: " + String(content.length()) + "\r\n";
+  if (conn.keepAlive) {
+    headers += "Connection: keep-alive\r\n";
+    headers += "Keep-Alive: timeout=" + String(HTTP_IDLE_TIMEOUT_MS / 1000) + ", max=" + String(HTTP_MAX_KEEPALIVE_REQUESTS) + "\r\n";
+  } else {
+    headers += "Connection: close\r\n";
+  }
+
+  // Add security headers
+  addSecurityHeaders(headers);
+  headers += "\r\n"; // End headers
+
+  // Queue the response - writeResponse() sends it in chunks
+  conn.response.reserve(headers.length() + content.length());
+  conn.response = headers;
+  conn.response += content;
+  conn.responseSent = 0;
+  conn.state = ConnectionState::WRITING;
+}
+
+void HttpConnectionTable::addSecurityHeaders(String& headers) {
+  headers += "X-Content-Type-Options: nosniff\r\n";
+  headers += "X-Frame-Options: SAMEORIGIN\r\n";
+  headers += "X-XSS-Protection: 1; mode=block\r\n";
+  headers += "Referrer-Policy: strict-origin-when-cross-origin\r\n";
+  headers += "Content-Security-Policy: default-src 'self'; script-src 'self' 'unsafe-inline'; style-src 'self' 'unsafe-inline'\r\n";
+  headers += "Access-Control-Allow-Origin: *\r\n";
+  headers += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
+  headers += "Access-Control-Allow-Headers: Content-Type\r\n";
+}
@@ -0,0 +1,296 @@
+#include "HttpRequestParser.h"
+
+static const char EMPTY_STRING[] = "";
+
+HttpRequestParser::HttpRequestParser() {
+  reset();
+}
+
+void HttpRequestParser::reset() {
+  received = 0;
+  clearRequest();
+}
+
+void HttpRequestParser::clearRequest() {
+  scanPos = 0;
+  bodyStart = 0;
+  requestEnd = 0;
+  state = HttpParseState::REQUEST_LINE;
+  errorStatus = 0;
+  method = HttpMethod::UNKNOWN;
+  methodText = EMPTY_STRING;
+  path = EMPTY_STRING;
+  query = EMPTY_STRING;
+  http11 = false;
+  keepAliveRequested = false;
+  closeRequested = false;
+  contentLength = 0;
+  headerCount = 0;
+}
+
+char* HttpRequestParser::writePtr() {
+  return buffer + received;
+}
+
+size_t HttpRequestParser::writeSpace() const {
+  return HTTP_MAX_REQUEST_SIZE - received;
+}
+
+void HttpRequestParser::commit(size_t bytes) {
+  if (bytes > writeSpace()) bytes = writeSpace();
+  received += bytes;
+  parse();
+}
+
+size_t HttpRequestParser::feed(const uint8_t* data, size_t len) {
+  size_t count = len < writeSpace() ? len : writeSpace();
+  memcpy(buffer + received, data, count);
+  commit(count);
+  return count;
+}
+
+void HttpRequestParser::consumeRequest() {
+  if (state != HttpParseState::COMPLETE) {
+    reset();
+    return;
+  }
+  
+  // Move pipelined bytes that followed this request to the front
+  size_t leftover = received - requestEnd;
+  if (leftover > 0) {
+    memmove(buffer, buffer + requestEnd, leftover);
+  }
+  received = leftover;
+  clearRequest();
+  
+  if (received > 0) {
+    parse();
+  }
+}
+
+void HttpRequestParser::fail(int status) {
+  state = HttpParseState::ERROR;
+  errorStatus = status;
+}
+
+char* HttpRequestParser::nextLine() {
+  if (scanPos >= received) return nullptr;
+  
+  char* start = buffer + scanPos;
+  char* newline = (char*)memchr(start, '\n', received - scanPos);
+  if (!newline) return nullptr;
+  
+  // Accept both CRLF and bare LF line endings
+  *newline = '\0';
+  if (newline > start && *(newline - 1) == '\r') {
+    *(newline - 1) = '\0';
+  }
+  scanPos = (newline - buffer) + 1;
+  return start;
+}
+
+void HttpRequestParser::parse() {
+  while (state == HttpParseState::REQUEST_LINE || state == HttpParseState::HEADERS) {
+    char* line = nextLine();
+    if (!line) {
+      if (received >= HTTP_MAX_REQUEST_SIZE) {
+        fail(state == HttpParseState::REQUEST_LINE ? 414 : 431);
+      }
+      return;
+    }
+    
+    if (state == HttpParseState::REQUEST_LINE) {
+      if (line[0] == '\0') continue;  // Tolerate stray CRLF between requests
+      if (!parseRequestLine(line)) return;
+      state = HttpParseState::HEADERS;
+      continue;
+    }
+    
+    // Blank line ends the header block
+    if (line[0] == '\0') {
+      bodyStart = scanPos;
+      if (contentLength > HTTP_MAX_REQUEST_SIZE - bodyStart) {
+        fail(413);
+        return;
+      }
+      state = contentLength > 0 ? HttpParseState::BODY : HttpParseState::COMPLETE;
+      requestEnd = bodyStart;
+      break;
+    }
+    
+    if (!parseHeaderLine(line)) return;
+  }
+  
+  if (state == HttpParseState::BODY && received - bodyStart >= contentLength) {
+    requestEnd = bodyStart + contentLength;
+    state = HttpParseState::COMPLETE;
+  }
+}
+
+bool HttpRequestParser::parseRequestLine(char* line) {
+  // METHOD SP request-target SP HTTP-version
+  char* target = strchr(line, ' ');
+  if (!target) { fail(400); return false; }
+  *target++ = '\0';
+  
+  char* version = strchr(target, ' ');
+  if (!version) { fail(400); return false; }
+  *version++ = '\0';
+  
+  if (strncmp(version, "HTTP/1.", 7) != 0 || version[7] < '0' || version[7] > '9') {
+    fail(505);
+    return false;
+  }
+  http11 = version[7] >= '1';
+  
+  methodText = line;
+  method = methodFromText(line);
+  if (method == HttpMethod::UNKNOWN) {
+    fail(501);
+    return false;
+  }
+  
+  if (target[0] != '/' && !(method == HttpMethod::OPTIONS && strcmp(target, "*") == 0)) {
+    fail(400);
+    return false;
+  }
+  
+  char* queryStart = strchr(target, '?');
+  if (queryStart) {
+    *queryStart++ = '\0';
+    query = queryStart;
+  }
+  path = target;
+  return true;
+}
+
+bool HttpRequestParser::parseHeaderLine(char* line) {
+  char* colon = strchr(line, ':');
+  if (!colon || colon == line) {
+    fail(400);
+    return false;
+  }
+  *colon = '\0';
+  
+  // Trim optional whitespace around the value
+  char* value = colon + 1;
+  while (*value == ' ' || *value == '\t') value++;
+  char* end = value + strlen(value);
+  while (end > value && (*(end - 1) == ' ' || *(end - 1) == '\t')) *--end = '\0';
+  
+  if (equalsIgnoreCase(line, "Content-Length")) {
+    if (*value == '\0') { fail(400); return false; }
+    size_t length = 0;
+    for (const char* p = value; *p; p++) {
+      if (*p < '0' || *p > '9' || length > HTTP_MAX_REQUEST_SIZE) {
+        fail(*p < '0' || *p > '9' ? 400 : 413);
+        return false;
+      }
+      length = length * 10 + (*p - '0');
+    }
+    contentLength = length;
+  } else if (equalsIgnoreCase(line, "Transfer-Encoding")) {
+    if (!equalsIgnoreCase(value, "identity")) {
+      fail(501);  // Chunked request bodies are not supported
+      return false;
+    }
+  } else if (equalsIgnoreCase(line, "Connection")) {
+    if (equalsIgnoreCase(value, "close")) closeRequested = true;
+    else if (equalsIgnoreCase(value, "keep-alive")) keepAliveRequested = true;
+  }
+  
+  if (headerCount < HTTP_MAX_HEADERS) {
+    headers[headerCount].name = line;
+    headers[headerCount].value = value;
+    headerCount++;
+  }
+  return true;
+}
+
+HttpMethod HttpRequestParser::methodFromText(const char* text) {
+  if (strcmp(text, "GET") == 0) return HttpMethod::GET;
+  if (strcmp(text, "POST") == 0) return HttpMethod::POST;
+  if (strcmp(text, "HEAD") == 0) return HttpMethod::HEAD;
+  if (strcmp(text, "OPTIONS") == 0) return HttpMethod::OPTIONS;
+  if (strcmp(text, "PUT") == 0) return HttpMethod::PUT;
+  if (strcmp(text, "DELETE") == 0) return HttpMethod::DELETE;
+  return HttpMethod::UNKNOWN;
+}
+
+bool HttpRequestParser::equalsIgnoreCase(const char* a, const char* b) {
+  return strcasecmp(a, b) == 0;
+}
+
+bool HttpRequestParser::keepAlive() const {
+  if (closeRequested) return false;
+  return http11 || keepAliveRequested;
+}
+
+const char* HttpRequestParser::getHeader(const char* name) const {
+  for (int i = 0; i < headerCount; i++) {
+    if (equalsIgnoreCase(headers[i].name, name)) {
+      return headers[i].value;
+    }
+  }
+  return nullptr;
+}
+
+const char* HttpRequestParser::getBody() const {
+  return buffer + bodyStart;
+}
+
+size_t HttpRequestParser::getBodyLength() const {
+  return state == HttpParseState::COMPLETE ? contentLength : 0;
+}
+
+bool HttpRequestParser::getQueryParam(const char* name, char* out, size_t outLen) const {
+  return findParam(query, strlen(query), name, out, outLen);
+}
+
+bool HttpRequestParser::getFormParam(const char* name, char* out, size_t outLen) const {
+  return findParam(getBody(), getBodyLength(), name, out, outLen);
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool HttpRequestParser::findParam(const char* src, size_t srcLen, const char* name, char* out, size_t outLen) {
+  if (!src || !out || outLen == 0) return false;
+  size_t nameLen = strlen(name);
+  const char* end = src + srcLen;
+  const char* pair = src;
+  
+  while (pair < end) {
+    const char* pairEnd = (const char*)memchr(pair, '&', end - pair);
+    if (!pairEnd) pairEnd = end;
+    
+    const char* eq = (const char*)memchr(pair, '=', pairEnd - pair);
+    const char* keyEnd = eq ? eq : pairEnd;
+    
+    if ((size_t)(keyEnd - pair) == nameLen && strncmp(pair, name, nameLen) == 0) {
+      // Decode '+' and %XX escapes into the caller's buffer
+      size_t n = 0;
+      const char* p = eq ? eq + 1 : pairEnd;
+      while (p < pairEnd && n < outLen - 1) {
+        if (*p == '+') {
+          out[n++] = ' ';
+          p++;
+        } else if (*p == '%' && pairEnd - p >= 3 && hexValue(p[1]) >= 0 && hexValue(p[2]) >= 0) {
+          out[n++] = (char)((hexValue(p[1]) << 4) | hexValue(p[2]));
+          p += 3;
+        } else {
+          out[n++] = *p++;
+        }
+      }
+      out[n] = '\0';
+      return true;
+    }
+    
+    pair = pairEnd + 1;
+  }
+  return false;
+}
@@ -0,0 +1,326 @@
+#include "MqttPublisher.h"
+
+MqttPublisher::MqttPublisher()
+  : config(nullptr), sensors(nullptr),
+#ifdef ESP32
+    transport(&arduinoTransport),
+#else
+    transport(&posixTransport),
+#endif
+    enabled(false), port(DEFAULT_MQTT_PORT), perAquarium(false),
+    telemetryQos(DEFAULT_MQTT_TELEMETRY_QOS), alarmQos(DEFAULT_MQTT_ALARM_QOS),
+    minIntervalMs(DEFAULT_MQTT_MIN_INTERVAL_S * 1000UL),
+    linkUp(false), online(false), nextConnectAt(0), reconnectDelayMs(MQTT_RECONNECT_MIN_MS),
+    lastCycle(0), lastTelemetryAt(0), lastAlarmSequence(0), lastDrainAt(0),
+    published(0), queuedCount(0), failedCount(0), connects(0), oversized(0), outboxFull(0)
+#ifdef ESP32
+    , outbox(nullptr)
+#endif
+{
+  memset(&building, 0, sizeof(building));
+  memset(&message, 0, sizeof(message));
+}
+
+void MqttPublisher::setTransport(MqttTransport* replacement) {
+  transport = replacement;
+}
+
+void MqttPublisher::begin(ConfigManager* configManager, SensorController* sensorController) {
+  config = configManager;
+  sensors = sensorController;
+  enabled = config && sensors && transport && config->getMqttEnabled();
+  if (!enabled) {
+    return;
+  }
+
+  host = config->getMqttHost();
+  if (host.length() == 0) {
+    Serial.println("[MQTT] Enabled but no broker host set, publisher off");
+    enabled = false;
+    return;
+  }
+  port = config->getMqttPort();
+  clientId = config->getMqttClientId();
+  username = config->getMqttUsername();
+  password = config->getMqttPassword();
+  topicPrefix = config->getMqttBaseTopic() + "/" + clientId;
+  statusTopic = topicPrefix + "/status";
+  perAquarium = config->getMqttBatch() == "aquarium";
+  telemetryQos = constrain(config->getMqttTelemetryQos(), 0, 1);
+  alarmQos = constrain(config->getMqttAlarmQos(), 0, 1);
+  minIntervalMs = config->getMqttMinIntervalSeconds() * 1000UL;
+
+  if (!queue.begin()) {
+    Serial.println("[MQTT] Queue unavailable, messages are dropped while offline");
+  }
+  transport->begin(host.c_str(), port, config->getMqttKeepAliveSeconds());
+  lastAlarmSequence = sensors->getAlarms().getLastSequence();
+#ifdef ESP32
+  outbox = xQueueCreate(MQTT_OUTBOX_LENGTH, sizeof(MqttMessage));
+  if (!outbox || xTaskCreate(taskEntry, "mqtt", MQTT_TASK_STACK, this, MQTT_TASK_PRIORITY, nullptr) != pdPASS) {
+    Serial.println("[MQTT] Failed to start the publisher task, publisher off");
+    enabled = false;
+    return;
+  }
+#endif
+  Serial.printf("[MQTT] Publishing to %s:%d under %s (%s)\n", host.c_str(), port, topicPrefix.c_str(),
+                transport->name());
+}
+
+void MqttPublisher::update(bool wifiUp, unsigned long now) {
+  if (!enabled) return;
+  linkUp = wifiUp;
+  publishAlarms();
+  publishTelemetry(now);
+#ifndef ESP32
+  service(now);                               // No task off-target
+#endif
+}
+
+#ifdef ESP32
+void MqttPublisher::taskEntry(void* publisher) {
+  MqttPublisher* self = (MqttPublisher*)publisher;
+  for (;;) {
+    // Wake when a message is handed over, or every MQTT_TASK_PERIOD_MS for
+    // keepalive, reconnects and the drain
+    xQueuePeek(self->outbox, &self->message, pdMS_TO_TICKS(MQTT_TASK_PERIOD_MS));
+    self->service(millis());
+  }
+}
+#endif
+
+void MqttPublisher::service(unsigned long now) {
+  maintainConnection(linkUp, now);
+#ifdef ESP32
+  while (xQueueReceive(outbox, &message, 0) == pdTRUE) {
+    send();
+  }
+#endif
+  drain(now);
+}
+
+bool MqttPublisher::handOver() {
+#ifdef ESP32
+  return xQueueSend(outbox, &building, 0) == pdTRUE;
+#else
+  message = building;
+  send();
+  return true;
+#endif
+}
+
+void MqttPublisher::maintainConnection(bool linkUp, unsigned long now) {
+  if (online) {
+    transport->loop();
+    if (!linkUp || !transport->connected()) {
+      Serial.println("[MQTT] Connection lost");
+      markOffline(now);
+    }
+    return;
+  }
+  if (!linkUp || (long)(now - nextConnectAt) < 0) return;
+
+  if (transport->connect(clientId.c_str(), username.c_str(), password.c_str(), statusTopic.c_str(), "offline")) {
+    online = true;
+    connects++;
+    reconnectDelayMs = MQTT_RECONNECT_MIN_MS;
+    transport->publish(statusTopic.c_str(), "online", 6, true, 1);
+    Serial.printf("[MQTT] Connected to %s:%d, %d queued messages to send\n", host.c_str(), port, queue.size());
+  } else {
+    nextConnectAt = now + reconnectDelayMs;
+    Serial.printf("[MQTT] Connect to %s:%d failed, retrying in %lu s\n", host.c_str(), port, reconnectDelayMs / 1000);
+    reconnectDelayMs = reconnectDelayMs * 2 < MQTT_RECONNECT_MAX_MS ? reconnectDelayMs * 2 : MQTT_RECONNECT_MAX_MS;
+  }
+}
+
+void MqttPublisher::markOffline(unsigned long now) {
+  online = false;
+  transport->disconnect();
+  nextConnectAt = now + reconnectDelayMs;
+}
+
+bool MqttPublisher::send() {
+  // Telemetry keeps its place behind any queued message, an alarm behind
+  // queued alarms only
+  bool waiting = message.urgent ? queue.urgentCount() > 0 : !queue.isEmpty();
+  if (online && !waiting) {
+    if (transport->publish(message.topic, message.payload, message.length, message.retained, message.qos)) {
+      published++;
+      return true;
+    }
+    failedCount++;
+    markOffline(millis());
+  }
+  if (queue.push(message)) {
+    queuedCount++;
+    return true;
+  }
+  return false;
+}
+
+bool MqttPublisher::buildMessage(const String& topic, JsonDocument& doc, uint8_t qos, bool retained, bool urgent) {
+  size_t length = measureJson(doc);
+  if (topic.length() >= MQTT_TOPIC_LENGTH || length >= MQTT_PAYLOAD_LENGTH) {
+    Serial.printf("[MQTT] %s: %u byte message over the %d byte limit, dropped\n",
+                  topic.c_str(), (unsigned)length, MQTT_PAYLOAD_LENGTH - 1);
+    oversized++;
+    return false;
+  }
+  strcpy(building.topic, topic.c_str());
+  building.length = serializeJson(doc, building.payload, MQTT_PAYLOAD_LENGTH);
+  building.qos = qos;
+  building.retained = retained;
+  building.urgent = urgent;
+  return true;
+}
+
+void MqttPublisher::publishAlarms() {
+  const AlarmEngine& alarms = sensors->getAlarms();
+  if (alarms.getLastSequence() == lastAlarmSequence) return;
+
+  AlarmEvent events[ALARM_EVENT_LOG];
+  int count = alarms.getEventsSince(lastAlarmSequence, events, ALARM_EVENT_LOG);
+  for (int i = 0; i < count; i++) {
+    const AlarmRule& rule = alarms.getRule(events[i].rule);
+    JsonDocument doc;
+    doc["sequence"] = events[i].sequence;
+    doc["aquarium"] = config->getAquariumID(rule.aquarium);
+    doc["type"] = sensorTypeName(rule.sensorType);
+    doc["id"] = rule.channel;
+    doc["kind"] = AlarmEngine::kindName(rule.kind);
+    doc["event"] = events[i].state == ALARM_ACTIVE ? "raised" : "cleared";
+    doc["side"] = AlarmEngine::sideName(events[i].side);
+    doc["value"] = events[i].value;
+    doc["uptime_ms"] = events[i].at;
+    // With the outbox full the rest wait for the next loop(), still in the alarm log
+    if (buildMessage(topicPrefix + "/alarm", doc, alarmQos, false, true) && !handOver()) {
+      return;
+    }
+    lastAlarmSequence = events[i].sequence;
+  }
+}
+
+// One bank's channels in an aquarium: value, range state and trend
+template <typename Bank>
+static int addChannels(JsonArray target, Bank& bank, const AlarmEngine& alarms, const TrendEstimator& trends,
+                       int type, int aquarium) {
+  int raised = 0;
+  for (int i = 0; i < bank.getSensorCount(); i++) {
+    if (bank.getAquarium(i) != aquarium) continue;
+    JsonObject channel = target.add<JsonObject>();
+    channel["id"] = i;
+    channel["value"] = bank.getData().readings[i];
+    int rule = alarms.findRule(type, i);
+    if (rule != NO_ALARM_RULE) {
+      uint8_t state = alarms.getStatus(rule).state;
+      channel["status"] = AlarmEngine::stateName(state);
+      if (state == ALARM_ACTIVE || state == ALARM_CLEARING) raised++;
+    }
+    float perMinute;
+    if (trends.getSlope(type, i, perMinute)) {
+      channel["trend_per_min"] = perMinute;
+    }
+  }
+  return raised;
+}
+
+void MqttPublisher::addAquarium(JsonObject target, int aquarium) {
+  const AlarmEngine& alarms = sensors->getAlarms();
+  const TrendEstimator& trends = sensors->getTrends();
+  int raised = 0;
+  raised += addChannels(target[sensorTypeName(SENSOR_TEMPERATURE)].to<JsonArray>(), sensors->getTemperatureSensors(),
+                        alarms, trends, SENSOR_TEMPERATURE, aquarium);
+  raised += addChannels(target[sensorTypeName(SENSOR_PH)].to<JsonArray>(), sensors->getPHSensors(),
+                        alarms, trends, SENSOR_PH, aquarium);
+  raised += addChannels(target[sensorTypeName(SENSOR_TDS)].to<JsonArray>(), sensors->getTDSSensors(),
+                        alarms, trends, SENSOR_TDS, aquarium);
+  target["active_alarms"] = raised;
+}
+
+void MqttPublisher::publishTelemetry(unsigned long now) {
+  uint32_t cycle = sensors->getCycleCount();
+  if (cycle == lastCycle) return;
+  // Epochs inside min_interval_s are skipped; the next message has the latest readings
+  if (lastCycle != 0 && now - lastTelemetryAt < minIntervalMs) return;
+  lastCycle = cycle;
+  lastTelemetryAt = now;
+
+  if (perAquarium) {
+    for (int aq = 0; aq < config->getAquariumCount(); aq++) {
+      if (!config->isAquariumEnabled(aq)) continue;
+      String id = config->getAquariumID(aq);
+      JsonDocument doc;
+      doc["epoch"] = cycle;
+      doc["uptime_ms"] = now;
+      doc["aquarium"] = id;
+      addAquarium(doc.as<JsonObject>(), aq);
+      if (buildMessage(topicPrefix + "/aquarium/" + id + "/telemetry", doc, telemetryQos, false, false) && !handOver()) {
+        outboxFull++;
+      }
+    }
+    return;
+  }
+
+  JsonDocument doc;
+  doc["epoch"] = cycle;
+  doc["uptime_ms"] = now;
+  JsonArray aquariums = doc["aquariums"].to<JsonArray>();
+  for (int aq = 0; aq < config->getAquariumCount(); aq++) {
+    if (!config->isAquariumEnabled(aq)) continue;
+    JsonObject aquarium = aquariums.add<JsonObject>();
+    aquarium["id"] = config->getAquariumID(aq);
+    addAquarium(aquarium, aq);
+  }
+  if (buildMessage(topicPrefix + "/telemetry", doc, telemetryQos, false, false) && !handOver()) {
+    outboxFull++;                             // The next epoch has the latest readings
+  }
+}
+
+void MqttPublisher::drain(unsigned long now) {
+  if (!online || queue.isEmpty() || now - lastDrainAt < MQTT_DRAIN_INTERVAL_MS) return;
+  lastDrainAt = now;
+
+  // One message in flight: each publish returns once written (QoS 0) or acked (QoS 1)
+  for (int i = 0; i < MQTT_DRAIN_BURST && queue.peek(message); i++) {
+    if (!transport->publish(message.topic, message.payload, message.length, message.retained, message.qos)) {
+      failedCount++;
+      Serial.printf("[MQTT] Drain stopped, %d messages still queued\n", queue.size());
+      markOffline(now);
+      return;
+    }
+    queue.pop();
+    published++;
+  }
+  if (queue.isEmpty()) {
+    Serial.println("[MQTT] Queue drained");
+  }
+}
+
+bool MqttPublisher::isEnabled() const {
+  return enabled;
+}
+
+bool MqttPublisher::isOnline() const {
+  return online;
+}
+
+int MqttPublisher::getQueued() const {
+  return queue.size();
+}
+
+void MqttPublisher::addToJson(JsonObject target) const {
+  target["enabled"] = enabled;
+  if (!enabled) return;
+  target["online"] = online;
+  target["broker"] = host + ":" + String(port);
+  target["topic"] = topicPrefix;
+  target["queued"] = queue.size();
+  target["queue_capacity"] = queue.capacity();
+  target["dropped"] = queue.getDropped();
+  target["published"] = published;
+  target["queued_total"] = queuedCount;
+  target["failed"] = failedCount;
+  target["oversized"] = oversized;
+  target["outbox_full"] = outboxFull;
+  target["connects"] = connects;
+}
@@ -0,0 +1,203 @@
+#include "MqttQueue.h"
+#include <stddef.h>
+
+MqttQueue::MqttQueue()
+  :
+#ifdef ESP32
+    spiffsStorage(MQTT_QUEUE_FILE), storage(&spiffsStorage),
+#else
+    storage(nullptr),
+#endif
+    nextSequence(1), used(0), urgentUsed(0), ready(false), dropped(0) {
+  memset(sequences, 0, sizeof(sequences));
+  memset(qosLevels, 0, sizeof(qosLevels));
+  memset(urgentSlots, 0, sizeof(urgentSlots));
+}
+
+void MqttQueue::setStorage(MqttStorage* replacement) {
+  storage = replacement;
+}
+
+// CRC-32 (as CalibrationStore::crc32) fed in pieces, so the record never
+// needs to be copied into one buffer
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return crc;
+}
+
+// CRC-32 of the header up to the crc field, then the topic and payload
+static uint32_t recordCrc(const MqttRecordHeader& header, const char* topic, const char* payload) {
+  uint32_t crc = crc32Update(0xFFFFFFFF, (const uint8_t*)&header, offsetof(MqttRecordHeader, crc));
+  crc = crc32Update(crc, (const uint8_t*)topic, header.topicLength);
+  crc = crc32Update(crc, (const uint8_t*)payload, header.payloadLength);
+  return ~crc;
+}
+
+bool MqttQueue::begin() {
+  ready = false;
+  used = 0;
+  urgentUsed = 0;
+  nextSequence = 1;
+  memset(sequences, 0, sizeof(sequences));
+  memset(urgentSlots, 0, sizeof(urgentSlots));
+
+  bool created = false;
+  if (!storage || !storage->begin(MQTT_QUEUE_SLOTS * MQTT_SLOT_BYTES, created)) {
+    return false;
+  }
+  ready = true;
+  if (created) return true;
+
+  // Only the headers are read here; bodies are checked when sent
+  for (int slot = 0; slot < MQTT_QUEUE_SLOTS; slot++) {
+    MqttRecordHeader header;
+    if (!storage->read(slot * MQTT_SLOT_BYTES, &header, sizeof(header))) {
+      break;
+    }
+    if (header.magic != MQTT_RECORD_MAGIC || header.sequence == 0 ||
+        header.topicLength >= MQTT_TOPIC_LENGTH || header.payloadLength > MQTT_PAYLOAD_LENGTH) {
+      continue;
+    }
+    sequences[slot] = header.sequence;
+    qosLevels[slot] = header.qos;
+    urgentSlots[slot] = (header.flags & MQTT_FLAG_URGENT) != 0;
+    used++;
+    if (urgentSlots[slot]) urgentUsed++;
+    if (header.sequence >= nextSequence) nextSequence = header.sequence + 1;
+  }
+  if (used > 0) {
+    Serial.printf("[MQTT] %d queued messages restored from %s\n", used, storage->name());
+  }
+  return true;
+}
+
+int MqttQueue::findOldest(bool qos0Only, bool urgentOnly) const {
+  int oldest = -1;
+  for (int slot = 0; slot < MQTT_QUEUE_SLOTS; slot++) {
+    if (sequences[slot] == 0 || (qos0Only && qosLevels[slot] != 0) || (urgentOnly && !urgentSlots[slot])) continue;
+    if (oldest < 0 || sequences[slot] < sequences[oldest]) oldest = slot;
+  }
+  return oldest;
+}
+
+int MqttQueue::findFront() const {
+  return findOldest(false, urgentUsed > 0);
+}
+
+int MqttQueue::findFree() const {
+  for (int slot = 0; slot < MQTT_QUEUE_SLOTS; slot++) {
+    if (sequences[slot] == 0) return slot;
+  }
+  return -1;
+}
+
+bool MqttQueue::freeSlot(int slot) {
+  sequences[slot] = 0;
+  used--;
+  if (urgentSlots[slot]) {
+    urgentSlots[slot] = false;
+    urgentUsed--;
+  }
+  uint16_t magic = 0;
+  return storage->write(slot * MQTT_SLOT_BYTES, &magic, sizeof(magic)) && storage->flush();
+}
+
+bool MqttQueue::push(const MqttMessage& message) {
+  if (!ready) return false;
+  size_t topicLength = strlen(message.topic);
+  if (topicLength >= MQTT_TOPIC_LENGTH || message.length > MQTT_PAYLOAD_LENGTH) return false;
+
+  int slot = findFree();
+  if (slot < 0) {
+    slot = findOldest(true, false);
+    if (slot < 0) slot = findOldest(false, false);
+    Serial.printf("[MQTT] Queue full, dropping message %lu\n", (unsigned long)sequences[slot]);
+    freeSlot(slot);
+    dropped++;
+  }
+
+  MqttRecordHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = MQTT_RECORD_MAGIC;
+  header.qos = message.qos;
+  header.flags = (message.retained ? MQTT_FLAG_RETAINED : 0) | (message.urgent ? MQTT_FLAG_URGENT : 0);
+  header.topicLength = topicLength;
+  header.payloadLength = message.length;
+  header.sequence = nextSequence;
+  header.crc = recordCrc(header, message.topic, message.payload);
+
+  size_t offset = slot * MQTT_SLOT_BYTES;
+  bool ok = storage->write(offset + sizeof(header), message.topic, topicLength) &&
+            storage->write(offset + sizeof(header) + topicLength, message.payload, message.length) &&
+            // Header last: until it is on flash the slot still reads as free
+            storage->flush() &&
+            storage->write(offset, &header, sizeof(header)) &&
+            storage->flush();
+  if (!ok) {
+    Serial.printf("[MQTT] Failed to write queue slot %d\n", slot);
+    return false;
+  }
+
+  sequences[slot] = nextSequence++;
+  qosLevels[slot] = message.qos;
+  urgentSlots[slot] = message.urgent;
+  used++;
+  if (message.urgent) urgentUsed++;
+  return true;
+}
+
+bool MqttQueue::peek(MqttMessage& message) {
+  while (ready && used > 0) {
+    int slot = findFront();
+    size_t offset = slot * MQTT_SLOT_BYTES;
+    MqttRecordHeader header;
+    if (!storage->read(offset, &header, sizeof(header))) return false;
+    bool ok = header.magic == MQTT_RECORD_MAGIC && header.sequence == sequences[slot] &&
+              header.topicLength < MQTT_TOPIC_LENGTH && header.payloadLength <= MQTT_PAYLOAD_LENGTH &&
+              storage->read(offset + sizeof(header), message.topic, header.topicLength) &&
+              storage->read(offset + sizeof(header) + header.topicLength, message.payload, header.payloadLength);
+
+    if (ok && header.crc == recordCrc(header, message.topic, message.payload)) {
+      message.topic[header.topicLength] = '\0';
+      message.length = header.payloadLength;
+      message.qos = header.qos;
+      message.retained = (header.flags & MQTT_FLAG_RETAINED) != 0;
+      message.urgent = (header.flags & MQTT_FLAG_URGENT) != 0;
+      return true;
+    }
+    Serial.printf("[MQTT] Queued message %lu is corrupt, dropped\n", (unsigned long)sequences[slot]);
+    freeSlot(slot);
+    dropped++;
+  }
+  return false;
+}
+
+bool MqttQueue::pop() {
+  if (!ready || used == 0) return false;
+  return freeSlot(findFront());
+}
+
+int MqttQueue::size() const {
+  return used;
+}
+
+int MqttQueue::urgentCount() const {
+  return urgentUsed;
+}
+
+int MqttQueue::capacity() const {
+  return MQTT_QUEUE_SLOTS;
+}
+
+bool MqttQueue::isEmpty() const {
+  return used == 0;
+}
+
+uint32_t MqttQueue::getDropped() const {
+  return dropped;
+}
@@ -0,0 +1,91 @@
+#include "MqttStorage.h"
+
+#ifdef ESP32
+#include "SPIFFS.h"
+
+SpiffsMqttStorage::SpiffsMqttStorage(const char* filePath) : path(filePath) {
+}
+
+bool SpiffsMqttStorage::create(size_t size) {
+  File created = SPIFFS.open(path, "w");
+  if (!created) {
+    Serial.printf("[MQTT] Failed to create %s\n", path);
+    return false;
+  }
+  uint8_t zeros[64];
+  memset(zeros, 0, sizeof(zeros));
+  for (size_t written = 0; written < size; written += sizeof(zeros)) {
+    size_t chunk = size - written < sizeof(zeros) ? size - written : sizeof(zeros);
+    created.write(zeros, chunk);
+  }
+  created.close();
+  return true;
+}
+
+bool SpiffsMqttStorage::begin(size_t size, bool& created) {
+  if (file) file.close();
+  created = false;
+  if (SPIFFS.exists(path)) {
+    File existing = SPIFFS.open(path, "r");
+    bool usable = existing && existing.size() >= size;
+    if (existing) existing.close();
+    if (!usable) {
+      Serial.printf("[MQTT] %s unreadable or truncated, recreating\n", path);
+      SPIFFS.remove(path);
+    }
+  }
+  if (!SPIFFS.exists(path)) {
+    if (!create(size)) return false;
+    created = true;
+  }
+  file = SPIFFS.open(path, "r+");
+  if (!file) {
+    Serial.printf("[MQTT] Failed to open %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+bool SpiffsMqttStorage::read(size_t offset, void* data, size_t length) {
+  return file && file.seek(offset) && file.read((uint8_t*)data, length) == length;
+}
+
+bool SpiffsMqttStorage::write(size_t offset, const void* data, size_t length) {
+  return file && file.seek(offset) && file.write((const uint8_t*)data, length) == length;
+}
+
+bool SpiffsMqttStorage::flush() {
+  if (!file) return false;
+  file.flush();
+  return true;
+}
+#endif
+
+MemoryMqttStorage::MemoryMqttStorage() : bytes(nullptr), capacity(0) {
+}
+
+MemoryMqttStorage::~MemoryMqttStorage() {
+  free(bytes);
+}
+
+bool MemoryMqttStorage::begin(size_t size, bool& created) {
+  created = false;
+  if (bytes && capacity >= size) return true;
+  free(bytes);
+  bytes = (uint8_t*)calloc(size, 1);
+  capacity = bytes ? size : 0;
+  created = bytes != nullptr;
+  return bytes != nullptr;
+}
+
+bool MemoryMqttStorage::read(size_t offset, void* data, size_t length) {
+  if (!bytes || offset + length > capacity) return false;
+  memcpy(data, bytes + offset, length);
+  return true;
+}
+
+bool MemoryMqttStorage::write(size_t offset, const void* data, size_t length) {
+  if (!bytes || offset + length > capacity) return false;
+  memcpy(bytes + offset, data, length);
+  return true;
+}
@@ -0,0 +1,264 @@
+#include "MqttTransport.h"
+
+#ifdef ESP32
+ArduinoMqttTransport::ArduinoMqttTransport() : client(MQTT_PACKET_BUFFER) {
+}
+
+void ArduinoMqttTransport::begin(const char* host, int port, int keepAliveSeconds) {
+  // The host string must outlive the client; the publisher keeps it
+  client.begin(host, port, net);
+  client.setOptions(keepAliveSeconds, true, MQTT_TIMEOUT_MS);
+}
+
+bool ArduinoMqttTransport::connect(const char* clientId, const char* username, const char* password,
+                                   const char* willTopic, const char* willPayload) {
+  client.setWill(willTopic, willPayload, true, 1);
+  if (username && username[0]) {
+    return client.connect(clientId, username, password);
+  }
+  return client.connect(clientId);
+}
+
+bool ArduinoMqttTransport::connected() {
+  return client.connected();
+}
+
+bool ArduinoMqttTransport::publish(const char* topic, const char* payload, int length, bool retained, int qos) {
+  return client.publish(topic, payload, length, retained, qos);
+}
+
+void ArduinoMqttTransport::loop() {
+  client.loop();
+}
+
+void ArduinoMqttTransport::disconnect() {
+  client.disconnect();
+}
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#define MQTT_BODY  5                          // Body offset in packet[]
+
+// Packet types (high nibble of the fixed header)
+#define MQTT_CONNECT     0x10
+#define MQTT_CONNACK     0x20
+#define MQTT_PUBLISH     0x30
+#define MQTT_PUBACK      0x40
+#define MQTT_PINGREQ     0xC0
+#define MQTT_DISCONNECT  0xE0
+
+// Length-prefixed string into the body, false if it does not fit
+static bool putString(uint8_t* body, size_t& at, size_t limit, const char* text) {
+  size_t length = strlen(text);
+  if (at + 2 + length > limit) return false;
+  body[at++] = length >> 8;
+  body[at++] = length & 0xFF;
+  memcpy(body + at, text, length);
+  at += length;
+  return true;
+}
+
+PosixMqttTransport::PosixMqttTransport()
+  : host(nullptr), port(0), keepAliveSeconds(0), fd(-1), packetId(0), lastSent(0) {
+}
+
+PosixMqttTransport::~PosixMqttTransport() {
+  closeSocket();
+}
+
+void PosixMqttTransport::begin(const char* brokerHost, int brokerPort, int keepAlive) {
+  // The host string must outlive the transport; the publisher keeps it
+  host = brokerHost;
+  port = brokerPort;
+  keepAliveSeconds = keepAlive;
+}
+
+void PosixMqttTransport::closeSocket() {
+  if (fd >= 0) close(fd);
+  fd = -1;
+}
+
+// Writes the fixed header in front of the body already in packet[MQTT_BODY..]
+bool PosixMqttTransport::sendPacket(uint8_t type, size_t bodyLength) {
+  uint8_t lengthBytes[4];
+  int count = 0;
+  size_t remaining = bodyLength;
+  do {
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    if (remaining > 0) digit |= 0x80;
+    lengthBytes[count++] = digit;
+  } while (remaining > 0 && count < 4);
+
+  size_t start = MQTT_BODY - 1 - count;
+  packet[start] = type;
+  memcpy(packet + start + 1, lengthBytes, count);
+  size_t total = 1 + count + bodyLength;
+  if (send(fd, packet + start, total, MSG_NOSIGNAL) != (ssize_t)total) {
+    closeSocket();
+    return false;
+  }
+  lastSent = millis();
+  return true;
+}
+
+bool PosixMqttTransport::readExact(uint8_t* data, size_t length) {
+  size_t received = 0;
+  while (received < length) {
+    ssize_t got = recv(fd, data + received, length - received, 0);
+    if (got <= 0) return false;
+    received += got;
+  }
+  return true;
+}
+
+// Next packet's body into packet[MQTT_BODY..]; a body too big for the
+// buffer is read and dropped
+bool PosixMqttTransport::readPacket(uint8_t& type, size_t& bodyLength) {
+  if (!readExact(&type, 1)) return false;
+  bodyLength = 0;
+  size_t multiplier = 1;
+  uint8_t digit;
+  do {
+    if (!readExact(&digit, 1)) return false;
+    bodyLength += (digit & 0x7F) * multiplier;
+    multiplier *= 128;
+  } while ((digit & 0x80) && multiplier <= 128 * 128 * 128);
+
+  size_t limit = sizeof(packet) - MQTT_BODY;
+  if (bodyLength <= limit) {
+    return readExact(packet + MQTT_BODY, bodyLength);
+  }
+  for (size_t left = bodyLength; left > 0;) {
+    size_t chunk = left < limit ? left : limit;
+    if (!readExact(packet + MQTT_BODY, chunk)) return false;
+    left -= chunk;
+  }
+  bodyLength = 0;
+  type = 0;
+  return true;
+}
+
+bool PosixMqttTransport::connect(const char* clientId, const char* username, const char* password,
+                                 const char* willTopic, const char* willPayload) {
+  closeSocket();
+  if (!host) return false;
+
+  char service[8];
+  snprintf(service, sizeof(service), "%d", port);
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* addresses = nullptr;
+  if (getaddrinfo(host, service, &hints, &addresses) != 0) return false;
+  for (struct addrinfo* address = addresses; address && fd < 0; address = address->ai_next) {
+    fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) continue;
+    struct timeval timeout = { MQTT_TIMEOUT_MS / 1000, (MQTT_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (::connect(fd, address->ai_addr, address->ai_addrlen) != 0) closeSocket();
+  }
+  freeaddrinfo(addresses);
+  if (fd < 0) return false;
+
+  // Clean session, will retained at QoS 1
+  bool credentials = username && username[0];
+  uint8_t flags = 0x02 | 0x04 | 0x08 | 0x20;
+  if (credentials) flags |= 0x80 | 0x40;
+  uint8_t* body = packet + MQTT_BODY;
+  size_t limit = sizeof(packet) - MQTT_BODY;
+  size_t at = 0;
+  bool ok = putString(body, at, limit, "MQTT");
+  body[at++] = 4;                             // Protocol level 3.1.1
+  body[at++] = flags;
+  body[at++] = keepAliveSeconds >> 8;
+  body[at++] = keepAliveSeconds & 0xFF;
+  ok = ok && putString(body, at, limit, clientId) &&
+       putString(body, at, limit, willTopic) && putString(body, at, limit, willPayload);
+  if (credentials) {
+    ok = ok && putString(body, at, limit, username) && putString(body, at, limit, password ? password : "");
+  }
+  if (!ok || !sendPacket(MQTT_CONNECT, at)) {
+    closeSocket();
+    return false;
+  }
+
+  uint8_t type;
+  size_t length;
+  if (!readPacket(type, length) || (type & 0xF0) != MQTT_CONNACK || length < 2 || body[1] != 0) {
+    closeSocket();
+    return false;
+  }
+  return true;
+}
+
+bool PosixMqttTransport::connected() {
+  return fd >= 0;
+}
+
+bool PosixMqttTransport::publish(const char* topic, const char* payload, int length, bool retained, int qos) {
+  if (fd < 0) return false;
+  uint8_t* body = packet + MQTT_BODY;
+  size_t limit = sizeof(packet) - MQTT_BODY;
+  size_t at = 0;
+  if (!putString(body, at, limit, topic)) return false;
+  uint16_t id = 0;
+  if (qos > 0) {
+    if (++packetId == 0) packetId = 1;
+    id = packetId;
+    body[at++] = id >> 8;
+    body[at++] = id & 0xFF;
+  }
+  if (at + length > limit) return false;
+  memcpy(body + at, payload, length);
+  at += length;
+  if (!sendPacket(MQTT_PUBLISH | (qos > 0 ? 0x02 : 0) | (retained ? 0x01 : 0), at)) return false;
+  if (qos == 0) return true;
+
+  // Other packets (PINGRESP) may arrive before the PUBACK
+  for (;;) {
+    uint8_t type;
+    size_t bodyLength;
+    if (!readPacket(type, bodyLength)) {
+      closeSocket();
+      return false;
+    }
+    if ((type & 0xF0) == MQTT_PUBACK && bodyLength >= 2 && ((body[0] << 8) | body[1]) == id) {
+      return true;
+    }
+  }
+}
+
+void PosixMqttTransport::loop() {
+  if (fd < 0) return;
+  uint8_t next;
+  ssize_t waiting = recv(fd, &next, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (waiting == 0) {
+    closeSocket();
+    return;
+  }
+  if (waiting > 0) {
+    uint8_t type;
+    size_t length;
+    if (!readPacket(type, length)) {
+      closeSocket();
+      return;
+    }
+  }
+  if (keepAliveSeconds > 0 && millis() - lastSent >= (unsigned long)keepAliveSeconds * 500) {
+    sendPacket(MQTT_PINGREQ, 0);
+  }
+}
+
+void PosixMqttTransport::disconnect() {
+  if (fd >= 0) {
+    sendPacket(MQTT_DISCONNECT, 0);           // The broker drops the will
+  }
+  closeSocket();
+}
+#endif
@@ -1,46 +1,252 @@
 #include "MultiplexerController.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
 
-MultiplexerController::MultiplexerController() : initialized(false) {}
+MultiplexerController::MultiplexerController()
+  : initialized(false), bankCount(0), sharedChannel(-1), selectCount(0), edgeCount(0) {
+  setSharedAddressPins(MUX_S0, MUX_S1, MUX_S2, MUX_S3);
+}
+
+void MultiplexerController::setSharedAddressPins(int s0, int s1, int s2, int s3) {
+  int pins[MUX_ADDRESS_LINES] = { s0, s1, s2, s3 };
+  buildMasks(sharedBus, pins);
+}
+
+void MultiplexerController::buildMasks(MuxAddressBus& bus, const int* pins) {
+  bus.registerWrite = true;
+  for (int i = 0; i < MUX_ADDRESS_LINES; i++) {
+    bus.pins[i] = pins[i];
+    // GPIO32+ live in the second output register; keep those on digitalWrite
+    if (pins[i] < 0 || pins[i] > 31) {
+      bus.registerWrite = false;
+    }
+  }
+
+  for (int channel = 0; channel < MUX_CHANNEL_CAPACITY; channel++) {
+    bus.setMask[channel] = 0;
+    bus.clearMask[channel] = 0;
+    if (!bus.registerWrite) continue;
+    for (int i = 0; i < MUX_ADDRESS_LINES; i++) {
+      if ((channel >> i) & 0x01) {
+        bus.setMask[channel] |= (1UL << pins[i]);
+      } else {
+        bus.clearMask[channel] |= (1UL << pins[i]);
+      }
+    }
+  }
+}
+
+int MultiplexerController::addBank(int enablePin, int adcPin, const int* addressPins) {
+  if (bankCount >= MAX_MUX_BANKS) {
+    Serial.printf("  [MUX] Bank limit (%d) reached, bank on GPIO%d ignored\n", MAX_MUX_BANKS, adcPin);
+    return -1;
+  }
 
-void MultiplexerController::begin() {
+  MuxBank& bank = banks[bankCount];
+  bank.enablePin = enablePin;
+  bank.adcPin = adcPin;
+  bank.sharedAddress = (addressPins == nullptr);
+  buildMasks(bank.ownBus, addressPins ? addressPins : sharedBus.pins);
+  bank.channel = -1;
+  bank.enabled = false;
+  bank.selectedAt = 0;
+  bank.settleUs = 0;
+
+  // Banks on one ADC pin are told apart by their enable lines only
+  for (int i = 0; i < bankCount; i++) {
+    if (banks[i].adcPin == adcPin && banks[i].enablePin == enablePin) {
+      Serial.printf("  [MUX] Warning: banks %d and %d share GPIO%d and enable GPIO%d\n",
+                    i, bankCount, adcPin, enablePin);
+    }
+  }
+
+  return bankCount++;
+}
+
+void MultiplexerController::setSettleTime(int bank, unsigned long settleUs) {
+  if (bank < 0 || bank >= bankCount) return;
+  banks[bank].settleUs = settleUs;
+}
+
+void MultiplexerController::begin(bool runSelfTest) {
   if (initialized) return;
-  
+
+  // Without an explicit layout, drive the classic single shared bus + enable
+  if (bankCount == 0) {
+    addBank(MUX_EN, TEMP_ADC_PIN);
+    addBank(MUX_EN, PH_ADC_PIN);
+    addBank(MUX_EN, TDS_ADC_PIN);
+  }
+
   // Initialize multiplexer control pins
-  pinMode(MUX_S0, OUTPUT);
-  pinMode(MUX_S1, OUTPUT);
-  pinMode(MUX_S2, OUTPUT);
-  pinMode(MUX_S3, OUTPUT);
-  pinMode(MUX_EN, OUTPUT);
-  
-  // Enable multiplexer (active LOW)
-  digitalWrite(MUX_EN, LOW);
-  
+  for (int i = 0; i < MUX_ADDRESS_LINES; i++) {
+    pinMode(sharedBus.pins[i], OUTPUT);
+  }
+  for (int b = 0; b < bankCount; b++) {
+    if (!banks[b].sharedAddress) {
+      for (int i = 0; i < MUX_ADDRESS_LINES; i++) {
+        pinMode(banks[b].ownBus.pins[i], OUTPUT);
+      }
+    }
+    pinMode(banks[b].enablePin, OUTPUT);
+
+    // Start disabled (active LOW); select() enables a bank when it is read
+    digitalWrite(banks[b].enablePin, HIGH);
+  }
+
   Serial.println("Multiplexer Controller Initialized");
-  Serial.println("  Testing channel selection...");
-  
-  for (int i = 0; i < 8; i++) {
-    selectChannel(i);
-    delay(50);
+  printBanks();
+
+  if (runSelfTest) {
+    Serial.println("  Testing channel selection...");
+    for (int i = 0; i < 8; i++) {
+      selectChannel(i);
+      delay(50);
+    }
+  } else {
+    Serial.println("  Channel self-test skipped (fast boot)");
   }
-  
+
   initialized = true;
   Serial.println("  Multiplexer ready");
 }
 
+int MultiplexerController::writeAddress(const MuxAddressBus& bus, int from, int to) {
+  if (bus.registerWrite && from >= 0) {
+    // Touch only the lines that differ - one write per step in Gray-code order
+    uint32_t rising = bus.setMask[to] & bus.clearMask[from];
+    uint32_t falling = bus.clearMask[to] & bus.setMask[from];
+    if (rising) REG_WRITE(GPIO_OUT_W1TS_REG, rising);
+    if (falling) REG_WRITE(GPIO_OUT_W1TC_REG, falling);
+  } else if (bus.registerWrite) {
+    REG_WRITE(GPIO_OUT_W1TC_REG, bus.clearMask[to]);
+    REG_WRITE(GPIO_OUT_W1TS_REG, bus.setMask[to]);
+  } else {
+    for (int i = 0; i < MUX_ADDRESS_LINES; i++) {
+      digitalWrite(bus.pins[i], (to >> i) & 0x01);
+    }
+  }
+
+  // Lines in an unknown state count as changed
+  int changed = (from < 0) ? 0x0F : ((from ^ to) & 0x0F);
+  return __builtin_popcount(changed);
+}
+
+void MultiplexerController::setEnabled(int bank, bool enabled) {
+  MuxBank& target = banks[bank];
+  if (target.enabled == enabled) return;
+
+  digitalWrite(target.enablePin, enabled ? LOW : HIGH);
+  edgeCount++;
+
+  // Every bank wired to the same enable pin follows it
+  unsigned long now = micros();
+  for (int b = 0; b < bankCount; b++) {
+    if (banks[b].enablePin == target.enablePin) {
+      banks[b].enabled = enabled;
+      banks[b].selectedAt = now;
+    }
+  }
+}
+
+bool MultiplexerController::sharesAddress(int a, int b) const {
+  return a == b || (banks[a].sharedAddress && banks[b].sharedAddress);
+}
+
+bool MultiplexerController::select(int bank, int channel) {
+  if (bank < 0 || bank >= bankCount) return false;
+  MuxBank& target = banks[bank];
+  bool changed = false;
+
+  // Banks sharing this ADC pin must be off while this one drives it
+  for (int b = 0; b < bankCount; b++) {
+    if (b != bank && banks[b].adcPin == target.adcPin &&
+        banks[b].enablePin != target.enablePin && banks[b].enabled) {
+      setEnabled(b, false);
+    }
+  }
+
+  if (target.channel != channel) {
+    selectCount++;
+    if (target.sharedAddress) {
+      edgeCount += writeAddress(sharedBus, sharedChannel, channel);
+      sharedChannel = channel;
+      unsigned long now = micros();
+      for (int b = 0; b < bankCount; b++) {
+        if (banks[b].sharedAddress) {
+          banks[b].channel = channel;
+          banks[b].selectedAt = now;
+        }
+      }
+    } else {
+      edgeCount += writeAddress(target.ownBus, target.channel, channel);
+      target.channel = channel;
+      target.selectedAt = micros();
+    }
+    changed = true;
+  }
+
+  if (!target.enabled) {
+    setEnabled(bank, true);
+    changed = true;
+  }
+
+  return changed;
+}
+
+void MultiplexerController::waitSettled(int bank, unsigned long defaultSettleUs) {
+  if (bank < 0 || bank >= bankCount) return;
+  waitSettledFor(bank, banks[bank].settleUs > 0 ? banks[bank].settleUs : defaultSettleUs);
+}
+
+void MultiplexerController::waitSettledFor(int bank, unsigned long settleUs) {
+  if (bank < 0 || bank >= bankCount) return;
+  unsigned long elapsed = micros() - banks[bank].selectedAt;
+  if (elapsed < settleUs) {
+    delayMicroseconds(settleUs - elapsed);
+  }
+}
+
+bool MultiplexerController::canPreselect(int currentBank, int nextBank, int nextChannel) const {
+  if (nextBank < 0 || nextBank >= bankCount || currentBank < 0 || currentBank >= bankCount) {
+    return false;
+  }
+  const MuxBank& current = banks[currentBank];
+  const MuxBank& next = banks[nextBank];
+
+  // Moving a shared address bus would change the channel being read
+  if (sharesAddress(currentBank, nextBank) && current.channel != nextChannel) {
+    return false;
+  }
+  // Enabling a bank on the same ADC pin would disconnect the current one
+  if (next.adcPin == current.adcPin && next.enablePin != current.enablePin) {
+    return false;
+  }
+  return true;
+}
+
+int MultiplexerController::getBankCount() const {
+  return bankCount;
+}
+
+int MultiplexerController::getAdcPin(int bank) const {
+  if (bank < 0 || bank >= bankCount) return -1;
+  return banks[bank].adcPin;
+}
+
+unsigned long MultiplexerController::getSelectCount() const {
+  return selectCount;
+}
+
+unsigned long MultiplexerController::getEdgeCount() const {
+  return edgeCount;
+}
+
 void MultiplexerController::selectChannel(int channel) {
-  // Set control pins for multiplexer channel selection
-  bool s0 = channel & 0x01;
-  bool s1 = (channel >> 1) & 0x01;
-  bool s2 = (channel >> 2) & 0x01;
-  bool s3 = (channel >> 3) & 0x01;
-  
-  digitalWrite(MUX_S0, s0);
-  digitalWrite(MUX_S1, s1);
-  digitalWrite(MUX_S2, s2);
-  digitalWrite(MUX_S3, s3);
-  
-  // Small delay for switching stability
-  delayMicroseconds(10);
+  // Set control pins for multiplexer channel selection on every bank
+  for (int b = 0; b < bankCount; b++) {
+    select(b, channel);
+  }
 }
 
 void MultiplexerController::printChannelInfo(int channel) {
@@ -48,7 +254,27 @@ void MultiplexerController::printChannelInfo(int channel) {
   bool s1 = (channel >> 1) & 0x01;
   bool s2 = (channel >> 2) & 0x01;
   bool s3 = (channel >> 3) & 0x01;
-  
-  Serial.printf("  [MUX] Channel %d -> S3=%d S2=%d S1=%d S0=%d\n", 
+
+  Serial.printf("  [MUX] Channel %d -> S3=%d S2=%d S1=%d S0=%d\n",
                 channel, s3, s2, s1, s0);
-}
\ No newline at end of file
+}
+
+void MultiplexerController::printBanks() {
+  Serial.printf("  Banks: %d (shared bus S0=%d S1=%d S2=%d S3=%d, %s)\n", bankCount,
+                sharedBus.pins[0], sharedBus.pins[1], sharedBus.pins[2], sharedBus.pins[3],
+                sharedBus.registerWrite ? "register writes" : "digitalWrite");
+  for (int b = 0; b < bankCount; b++) {
+    const MuxBank& bank = banks[b];
+    if (bank.sharedAddress) {
+      Serial.printf("    Bank %d: ADC GPIO%d, EN GPIO%d, shared bus", b, bank.adcPin, bank.enablePin);
+    } else {
+      Serial.printf("    Bank %d: ADC GPIO%d, EN GPIO%d, S0-S3 GPIO%d/%d/%d/%d", b, bank.adcPin,
+                    bank.enablePin, bank.ownBus.pins[0], bank.ownBus.pins[1],
+                    bank.ownBus.pins[2], bank.ownBus.pins[3]);
+    }
+    if (bank.settleUs > 0) {
+      Serial.printf(", settle %luus", bank.settleUs);
+    }
+    Serial.println();
+  }
+}
@@ -1,73 +1,253 @@
 #include "NetworkManager.h"
 
-NetworkManager::NetworkManager() : isConnected(false), configMgr(nullptr) {}
+NetworkManager::NetworkManager()
+  : isConnected(false), configured(false),
+    state(NetworkState::IDLE), stateSince(0), nextAttemptAt(0), disconnectedAt(0),
+    failureStreak(0), justConnected(false),
+    cachedChannel(0), hasCachedAP(false), attemptUsedCache(false),
+    lastRssiSample(0), eventHead(0), eventTail(0) {
+  memset(cachedBSSID, 0, sizeof(cachedBSSID));
+  memset(&stats, 0, sizeof(stats));
+  eventLock = portMUX_INITIALIZER_UNLOCKED;
+}
 
-void NetworkManager::begin(ConfigManager* config) {
-  configMgr = config;
+void NetworkManager::begin(const WiFiSettings& wifi) {
+  settings = wifi;
+  configured = true;
   Serial.println("Initializing Network Manager...");
   Serial.printf("MAC Address: %s\n", WiFi.macAddress().c_str());
+  
+  // The state machine owns reconnection - disable the driver's own retries
+  WiFi.mode(WIFI_STA);
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+    onWiFiEvent(event, info);
+  });
 }
 
-bool NetworkManager::connect() {
-  if (!configMgr) {
-    Serial.println("Error: NetworkManager: No configuration manager available");
+// Runs on the WiFi event task - only queue the event here
+void NetworkManager::onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+      queueEvent(NetworkEvent::STA_CONNECTED, 0);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      queueEvent(NetworkEvent::GOT_IP, 0);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      queueEvent(NetworkEvent::DISCONNECTED, info.wifi_sta_disconnected.reason);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+      queueEvent(NetworkEvent::LOST_IP, 0);
+      break;
+    default:
+      break;
+  }
+}
+
+void NetworkManager::queueEvent(NetworkEvent event, uint8_t reason) {
+  portENTER_CRITICAL(&eventLock);
+  uint8_t next = (eventHead + 1) % NETWORK_EVENT_QUEUE_SIZE;
+  if (next != eventTail) {
+    eventQueue[eventHead].event = event;
+    eventQueue[eventHead].reason = reason;
+    eventHead = next;
+  }
+  portEXIT_CRITICAL(&eventLock);
+}
+
+bool NetworkManager::popEvent(PendingEvent& out) {
+  bool available = false;
+  portENTER_CRITICAL(&eventLock);
+  if (eventTail != eventHead) {
+    out = eventQueue[eventTail];
+    eventTail = (eventTail + 1) % NETWORK_EVENT_QUEUE_SIZE;
+    available = true;
+  }
+  portEXIT_CRITICAL(&eventLock);
+  return available;
+}
+
+bool NetworkManager::startConnect() {
+  if (!configured) {
+    Serial.println("Error: NetworkManager: begin() has not been called");
     return false;
   }
   
-  String ssid = configMgr->getWifiSSID();
-  String password = configMgr->getWifiPassword();
-  
-  Serial.println("DEBUG: WiFi Configuration from ConfigManager:");
-  Serial.printf("DEBUG: SSID: '%s'\n", ssid.c_str());
-  Serial.printf("DEBUG: Password: '%s'\n", password.c_str());
   Serial.println("Connecting to WiFi...");
-  Serial.printf("SSID: %s\n", ssid.c_str());
-  Serial.print("Status: ");
-  
-  WiFi.begin(ssid.c_str(), password.c_str());
+  Serial.printf("SSID: %s\n", settings.ssid.c_str());
   
-  int attempts = 0;
-  IPAddress lastIP = IPAddress(0, 0, 0, 0);
+  failureStreak = 0;
+  startAttempt(millis());
+  return true;
+}
+
+bool NetworkManager::connect() {
+  if (!startConnect()) {
+    return false;
+  }
   
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    
-    // Check if we got an IP address during connection process
-    IPAddress currentIP = WiFi.localIP();
-    if (currentIP != lastIP && currentIP != IPAddress(0, 0, 0, 0)) {
-      Serial.println();
-      Serial.printf("DHCP Lease Obtained: %s\n", currentIP.toString().c_str());
-      lastIP = currentIP;
-    }
-    
-    // Show detailed connection status every 5 attempts
-    if (attempts % 5 == 4) {
-      Serial.println();
-      Serial.printf("   Connection attempt %d/20\n", attempts + 1);
-      Serial.printf("   WiFi Status: %d\n", WiFi.status());
-      if (WiFi.localIP() != IPAddress(0, 0, 0, 0)) {
-        Serial.printf("   Current IP: %s\n", WiFi.localIP().toString().c_str());
-      }
-      Serial.print("   Continuing: ");
+  // Drive the state machine until the first attempt resolves
+  Serial.print("Status: ");
+  unsigned long start = millis();
+  unsigned long lastDot = start;
+  while (state != NetworkState::CONNECTED && millis() - start < settings.connectTimeoutMs) {
+    delay(50);
+    update(millis());
+    if (millis() - lastDot >= 500) {
+      Serial.print(".");
+      lastDot = millis();
     }
-    
-    attempts++;
   }
   
   Serial.println();
-  isConnected = (WiFi.status() == WL_CONNECTED);
-  
-  if (isConnected) {
-    printConnectionDetails();
-  } else {
+  if (!isConnected) {
     Serial.println("WiFi Connection Failed!");
-    Serial.println("Continuing in offline mode...");
+    Serial.println("Continuing in offline mode - retrying in background...");
   }
   
   return isConnected;
 }
 
+void NetworkManager::startAttempt(unsigned long now) {
+  // Reuse the last access point for the first retries - skips the channel scan
+  attemptUsedCache = hasCachedAP && failureStreak < 2;
+  
+  if (attemptUsedCache) {
+    Serial.printf("[WiFi] Fast reconnect to cached AP (channel %d)\n", cachedChannel);
+    WiFi.begin(settings.ssid.c_str(), settings.password.c_str(), cachedChannel, cachedBSSID);
+  } else {
+    WiFi.begin(settings.ssid.c_str(), settings.password.c_str());
+  }
+  
+  enterState(NetworkState::CONNECTING, now);
+}
+
+void NetworkManager::scheduleRetry(unsigned long now) {
+  unsigned long delayMs = retryBackoffMs(failureStreak, settings.backoffMinMs, settings.backoffMaxMs, esp_random());
+  nextAttemptAt = now + delayMs;
+  enterState(NetworkState::BACKOFF, now);
+  Serial.printf("[WiFi] Retry in %lu ms (failures: %d)\n", delayMs, failureStreak);
+}
+
+void NetworkManager::enterState(NetworkState newState, unsigned long now) {
+  if (state == NetworkState::CONNECTED && newState != NetworkState::CONNECTED) {
+    stats.totalConnectedMs += now - stats.connectedSince;
+  }
+  state = newState;
+  stateSince = now;
+  isConnected = (state == NetworkState::CONNECTED);
+}
+
+void NetworkManager::handleEvent(NetworkEvent event, uint8_t reason, unsigned long now) {
+  switch (event) {
+    case NetworkEvent::STA_CONNECTED:
+      // Associated - still waiting for DHCP
+      break;
+      
+    case NetworkEvent::GOT_IP:
+      if (state == NetworkState::CONNECTED) break;
+      
+      stats.connects++;
+      if (attemptUsedCache) stats.fastReconnects++;
+      stats.lastConnectMs = (disconnectedAt != 0) ? now - disconnectedAt : now - stateSince;
+      stats.connectedSince = now;
+      failureStreak = 0;
+      
+      // Remember the access point for the next reconnect
+      if (uint8_t* bssid = WiFi.BSSID()) {
+        memcpy(cachedBSSID, bssid, sizeof(cachedBSSID));
+        cachedChannel = WiFi.channel();
+        hasCachedAP = true;
+      }
+      
+      enterState(NetworkState::CONNECTED, now);
+      justConnected = true;
+      Serial.printf("[WiFi] Connected in %lu ms (%s)\n", stats.lastConnectMs,
+                    attemptUsedCache ? "fast reconnect" : "full scan");
+      break;
+      
+    case NetworkEvent::DISCONNECTED:
+    case NetworkEvent::LOST_IP:
+      if (state == NetworkState::CONNECTED) {
+        // Link dropped - retry right away against the cached AP
+        stats.disconnects++;
+        stats.lastDisconnectReason = reason;
+        disconnectedAt = now;
+        failureStreak = 0;
+        Serial.printf("[WiFi] Link lost (reason %d)\n", reason);
+        scheduleRetry(now);
+      } else if (state == NetworkState::CONNECTING) {
+        // Attempt rejected (wrong channel, auth failure, AP gone)
+        stats.failedAttempts++;
+        stats.lastDisconnectReason = reason;
+        if (attemptUsedCache) hasCachedAP = false;
+        failureStreak++;
+        scheduleRetry(now);
+      }
+      // Disconnects while in BACKOFF are the echo of our own WiFi.disconnect()
+      break;
+  }
+}
+
+bool NetworkManager::update(unsigned long now) {
+  PendingEvent pending;
+  while (popEvent(pending)) {
+    handleEvent(pending.event, pending.reason, now);
+  }
+  
+  switch (state) {
+    case NetworkState::CONNECTING:
+      if (now - stateSince >= settings.connectTimeoutMs) {
+        stats.failedAttempts++;
+        if (attemptUsedCache) hasCachedAP = false;
+        failureStreak++;
+        WiFi.disconnect();
+        scheduleRetry(now);
+      }
+      break;
+      
+    case NetworkState::BACKOFF:
+      if ((long)(now - nextAttemptAt) >= 0) {
+        startAttempt(now);
+      }
+      break;
+      
+    case NetworkState::CONNECTED:
+      sampleLinkQuality(now);
+      break;
+      
+    case NetworkState::IDLE:
+      break;
+  }
+  
+  bool connectedNow = justConnected;
+  justConnected = false;
+  return connectedNow;
+}
+
+void NetworkManager::sampleLinkQuality(unsigned long now) {
+  if (lastRssiSample != 0 && now - lastRssiSample < WIFI_RSSI_SAMPLE_INTERVAL) {
+    return;
+  }
+  lastRssiSample = now;
+  
+  int rssi = WiFi.RSSI();
+  if (rssi == 0) return; // Not associated
+  
+  if (stats.rssiAvg == 0) {
+    stats.rssiMin = rssi;
+    stats.rssiMax = rssi;
+    stats.rssiAvg = rssi;
+  } else {
+    if (rssi < stats.rssiMin) stats.rssiMin = rssi;
+    if (rssi > stats.rssiMax) stats.rssiMax = rssi;
+    stats.rssiAvg = stats.rssiAvg * 0.9 + rssi * 0.1;
+  }
+  stats.rssi = rssi;
+}
+
 void NetworkManager::printConnectionDetails() {
   Serial.println("WiFi Connected Successfully!");
   Serial.println("+--- DHCP Network Configuration ----+");
@@ -87,11 +267,59 @@ void NetworkManager::printConnectionDetails() {
   Serial.println("+------------------------------------+");
 }
 
+void NetworkManager::printLinkStats() {
+  Serial.println("WiFi Link Statistics:");
+  Serial.printf("    State: %s\n", getStateName());
+  Serial.printf("    RSSI: %d dBm (min %d, max %d, avg %.1f)\n",
+                stats.rssi, stats.rssiMin, stats.rssiMax, stats.rssiAvg);
+  Serial.printf("    Connects: %lu (fast: %lu), Disconnects: %lu, Failed attempts: %lu\n",
+                stats.connects, stats.fastReconnects, stats.disconnects, stats.failedAttempts);
+  Serial.printf("    Last connect: %lu ms, Last disconnect reason: %d\n",
+                stats.lastConnectMs, stats.lastDisconnectReason);
+}
+
 bool NetworkManager::checkConnection() {
-  isConnected = (WiFi.status() == WL_CONNECTED);
   return isConnected;
 }
 
+NetworkState NetworkManager::getState() const {
+  return state;
+}
+
+const char* NetworkManager::getStateName() const {
+  switch (state) {
+    case NetworkState::IDLE:       return "IDLE";
+    case NetworkState::CONNECTING: return "CONNECTING";
+    case NetworkState::CONNECTED:  return "CONNECTED";
+    case NetworkState::BACKOFF:    return "BACKOFF";
+  }
+  return "UNKNOWN";
+}
+
+const LinkStats& NetworkManager::getLinkStats() const {
+  return stats;
+}
+
+void NetworkManager::addToJson(JsonObject obj) {
+  unsigned long now = millis();
+  obj["state"] = getStateName();
+  obj["rssi"] = stats.rssi;
+  obj["rssiMin"] = stats.rssiMin;
+  obj["rssiMax"] = stats.rssiMax;
+  obj["rssiAvg"] = stats.rssiAvg;
+  obj["connects"] = stats.connects;
+  obj["fastReconnects"] = stats.fastReconnects;
+  obj["disconnects"] = stats.disconnects;
+  obj["failedAttempts"] = stats.failedAttempts;
+  obj["lastConnectMs"] = stats.lastConnectMs;
+  obj["lastDisconnectReason"] = stats.lastDisconnectReason;
+  obj["linkUptimeMs"] = isConnected ? now - stats.connectedSince : 0;
+  obj["totalConnectedMs"] = stats.totalConnectedMs + (isConnected ? now - stats.connectedSince : 0);
+  if (state == NetworkState::BACKOFF) {
+    obj["retryInMs"] = (long)(nextAttemptAt - now) > 0 ? nextAttemptAt - now : 0;
+  }
+}
+
 String NetworkManager::getIP() {
   return WiFi.localIP().toString();
 }
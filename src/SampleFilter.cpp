@@ -0,0 +1,136 @@
+#include "SampleFilter.h"
+
+float selectKth(float* values, int count, int k) {
+  int left = 0;
+  int right = count - 1;
+
+  while (left < right) {
+    // Hoare partition around the middle element
+    float pivot = values[(left + right) / 2];
+    int i = left;
+    int j = right;
+    while (i <= j) {
+      while (values[i] < pivot) i++;
+      while (values[j] > pivot) j--;
+      if (i <= j) {
+        float tmp = values[i];
+        values[i] = values[j];
+        values[j] = tmp;
+        i++;
+        j--;
+      }
+    }
+
+    if (k <= j) {
+      right = j;
+    } else if (k >= i) {
+      left = i;
+    } else {
+      break;  // values[j+1..i-1] all equal the pivot
+    }
+  }
+  return values[k];
+}
+
+SampleFilter::SampleFilter()
+  : mode(FILTER_MEAN), trimPercent(DEFAULT_FILTER_TRIM_PERCENT), count(0), sum(0.0) {}
+
+void SampleFilter::configure(SampleFilterMode filterMode, int trim) {
+  mode = filterMode;
+  trimPercent = constrain(trim, 0, 45);
+  reset();
+}
+
+void SampleFilter::reset() {
+  count = 0;
+  sum = 0.0;
+}
+
+void SampleFilter::add(float value) {
+  sum += value;
+  if (count < SAMPLE_FILTER_MAX_SAMPLES) {
+    samples[count] = value;
+  }
+  count++;
+}
+
+float SampleFilter::result() {
+  if (count == 0) return 0.0;
+  int n = count < SAMPLE_FILTER_MAX_SAMPLES ? count : SAMPLE_FILTER_MAX_SAMPLES;
+
+  switch (mode) {
+    case FILTER_MEDIAN: {
+      float upper = selectKth(samples, n, n / 2);
+      if (n % 2 == 1) {
+        return upper;
+      }
+      // Even count: the lower middle is the largest value left of n/2
+      float lower = samples[0];
+      for (int i = 1; i < n / 2; i++) {
+        if (samples[i] > lower) lower = samples[i];
+      }
+      return (lower + upper) / 2.0;
+    }
+
+    case FILTER_TRIMMED_MEAN: {
+      int trim = n * trimPercent / 100;
+      if (trim == 0) {
+        return sum / count;
+      }
+      // Push the `trim` smallest to the front, then the `trim` largest to the back
+      selectKth(samples, n, trim);
+      selectKth(samples + trim, n - trim, n - 2 * trim - 1);
+      float kept = 0.0;
+      for (int i = trim; i < n - trim; i++) {
+        kept += samples[i];
+      }
+      return kept / (n - 2 * trim);
+    }
+
+    case FILTER_MEAN:
+    case FILTER_RUNNING_MEDIAN:
+    default:
+      return sum / count;
+  }
+}
+
+SampleFilterMode SampleFilter::parseMode(const String& name) {
+  if (name == "median") return FILTER_MEDIAN;
+  if (name == "trimmed_mean") return FILTER_TRIMMED_MEAN;
+  if (name == "running_median") return FILTER_RUNNING_MEDIAN;
+  return FILTER_MEAN;
+}
+
+const char* SampleFilter::modeName(SampleFilterMode filterMode) {
+  switch (filterMode) {
+    case FILTER_MEDIAN:         return "median";
+    case FILTER_TRIMMED_MEAN:   return "trimmed_mean";
+    case FILTER_RUNNING_MEDIAN: return "running_median";
+    default:                    return "mean";
+  }
+}
+
+RunningMedian::RunningMedian() : window(DEFAULT_FILTER_WINDOW), count(0), next(0) {}
+
+void RunningMedian::setWindow(int size) {
+  window = constrain(size, 1, SAMPLE_FILTER_MAX_WINDOW);
+  reset();
+}
+
+void RunningMedian::reset() {
+  count = 0;
+  next = 0;
+}
+
+float RunningMedian::push(float value) {
+  values[next] = value;
+  next = (next + 1) % window;
+  if (count < window) count++;
+
+  // Select on a copy so the ring keeps its arrival order
+  float scratch[SAMPLE_FILTER_MAX_WINDOW];
+  for (int i = 0; i < count; i++) {
+    scratch[i] = values[i];
+  }
+  return selectKth(scratch, count, count / 2);
+}
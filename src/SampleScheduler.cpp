@@ -0,0 +1,234 @@
+#include "SampleScheduler.h"
+#include <math.h>
+
+SampleScheduler::SampleScheduler()
+  : enabled(DEFAULT_SAMPLING_ADAPTIVE), alarmMargin(DEFAULT_SAMPLING_ALARM_MARGIN),
+    readIntervalMs(DEFAULT_SENSOR_READ_DELAY) {
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    types[t].baseMs = DEFAULT_SENSOR_READ_DELAY;
+    types[t].minMs = DEFAULT_SENSOR_READ_DELAY;
+    types[t].maxMs = DEFAULT_SENSOR_READ_DELAY;
+    types[t].changeThreshold = 0.0;
+    channelCounts[t] = 0;
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      hasAlarm[t][i] = false;
+      alarmMin[t][i] = 0.0;
+      alarmMax[t][i] = 0.0;
+    }
+  }
+  reset();
+}
+
+void SampleScheduler::configure(bool adaptive, float margin, unsigned long intervalMs) {
+  enabled = adaptive;
+  alarmMargin = margin >= 0.0 ? margin : DEFAULT_SAMPLING_ALARM_MARGIN;
+  readIntervalMs = intervalMs;
+}
+
+void SampleScheduler::configureType(int type, const SamplingConfig& config) {
+  if (type < 0 || type >= SENSOR_TYPE_COUNT) return;
+  SamplingConfig& target = types[type];
+  target = config;
+  if (target.baseMs == 0) target.baseMs = DEFAULT_SENSOR_READ_DELAY;
+  if (target.minMs == 0 || target.minMs > target.baseMs) target.minMs = target.baseMs;
+  if (target.maxMs < target.baseMs) target.maxMs = target.baseMs;
+}
+
+void SampleScheduler::setChannelCount(int type, int count) {
+  if (type < 0 || type >= SENSOR_TYPE_COUNT) return;
+  channelCounts[type] = constrain(count, 0, MAX_CHANNELS_PER_TYPE);
+}
+
+float SampleScheduler::getBudgetPerSecond() const {
+  if (readIntervalMs == 0) return 0.0;
+  int total = 0;
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) total += channelCounts[t];
+  return total * 1000.0 / readIntervalMs;
+}
+
+void SampleScheduler::setAlarmRange(int type, int channel, float minValue, float maxValue) {
+  if (type < 0 || type >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) return;
+  hasAlarm[type][channel] = maxValue > minValue;
+  alarmMin[type][channel] = minValue;
+  alarmMax[type][channel] = maxValue;
+}
+
+void SampleScheduler::reset() {
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+      periodMs[t][i] = types[t].baseMs;
+      effectiveMs[t][i] = types[t].baseMs;
+      lastSampled[t][i] = 0;
+      lastValue[t][i] = 0.0;
+      hasValue[t][i] = false;
+      flatReads[t][i] = 0;
+      reasons[t][i] = RATE_BASE;
+      reads[t][i] = 0;
+    }
+  }
+}
+
+bool SampleScheduler::isEnabled() const {
+  return enabled;
+}
+
+bool SampleScheduler::isDue(int type, int channel, unsigned long now) const {
+  if (!enabled || reads[type][channel] == 0) return true;
+  return now - lastSampled[type][channel] >= effectiveMs[type][channel];
+}
+
+void SampleScheduler::markSampled(int type, int channel, unsigned long now) {
+  lastSampled[type][channel] = now;
+  reads[type][channel]++;
+}
+
+bool SampleScheduler::nearAlarm(int type, int channel, float value) const {
+  if (!hasAlarm[type][channel]) return false;
+  float margin = (alarmMax[type][channel] - alarmMin[type][channel]) * alarmMargin;
+  return value <= alarmMin[type][channel] + margin || value >= alarmMax[type][channel] - margin;
+}
+
+void SampleScheduler::update(int type, int channel, float value) {
+  if (!enabled) return;
+  const SamplingConfig& config = types[type];
+  unsigned long& period = periodMs[type][channel];
+  bool alarm = nearAlarm(type, channel, value);
+
+  if (alarm) {
+    period = config.minMs;
+    flatReads[type][channel] = 0;
+  } else if (hasValue[type][channel]) {
+    float change = fabs(value - lastValue[type][channel]);
+    if (change >= config.changeThreshold) {
+      period = period / 2 > config.minMs ? period / 2 : config.minMs;
+      flatReads[type][channel] = 0;
+    } else if (change < config.changeThreshold * SAMPLING_FLAT_FRACTION) {
+      if (++flatReads[type][channel] >= SAMPLING_FLAT_READS) {
+        period = period * 2 < config.maxMs ? period * 2 : config.maxMs;
+        flatReads[type][channel] = 0;
+      }
+    } else {
+      // Moving, but not fast: head back to the base period
+      if (period < config.baseMs) {
+        period = period * 2 < config.baseMs ? period * 2 : config.baseMs;
+      } else if (period > config.baseMs) {
+        period = period / 2 > config.baseMs ? period / 2 : config.baseMs;
+      }
+      flatReads[type][channel] = 0;
+    }
+  }
+  lastValue[type][channel] = value;
+  hasValue[type][channel] = true;
+
+  if (alarm) {
+    reasons[type][channel] = RATE_ALARM;
+  } else if (period < config.baseMs) {
+    reasons[type][channel] = RATE_FAST;
+  } else if (period > config.baseMs) {
+    reasons[type][channel] = RATE_FLAT;
+  } else {
+    reasons[type][channel] = RATE_BASE;
+  }
+}
+
+void SampleScheduler::rebalance() {
+  if (enabled) balance();
+}
+
+void SampleScheduler::balance() {
+  // Reads per second wanted by urgent channels and by the rest
+  float urgentLoad = 0.0;
+  float otherLoad = 0.0;
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    for (int i = 0; i < channelCounts[t]; i++) {
+      float load = 1000.0 / periodMs[t][i];
+      if (reasons[t][i] == RATE_ALARM || reasons[t][i] == RATE_FAST) {
+        urgentLoad += load;
+      } else {
+        otherLoad += load;
+      }
+    }
+  }
+
+  // Stretch the rest so the total fits the budget, as far as max_ms allows
+  float budgetPerSecond = getBudgetPerSecond();
+  float stretch = 1.0;
+  if (budgetPerSecond > 0.0 && urgentLoad + otherLoad > budgetPerSecond && otherLoad > 0.0) {
+    float room = budgetPerSecond - urgentLoad;
+    stretch = room > 0.0 ? otherLoad / room : 1e6;
+  }
+
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    for (int i = 0; i < channelCounts[t]; i++) {
+      bool urgent = reasons[t][i] == RATE_ALARM || reasons[t][i] == RATE_FAST;
+      if (urgent || stretch <= 1.0) {
+        effectiveMs[t][i] = periodMs[t][i];
+        continue;
+      }
+      float stretched = periodMs[t][i] * stretch;
+      effectiveMs[t][i] = stretched < types[t].maxMs ? (unsigned long)stretched : types[t].maxMs;
+      if (effectiveMs[t][i] > periodMs[t][i]) {
+        reasons[t][i] = RATE_BUDGET;
+      }
+    }
+  }
+}
+
+unsigned long SampleScheduler::getTickMs() const {
+  unsigned long tick = 0;
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    if (channelCounts[t] == 0) continue;
+    if (tick == 0 || types[t].minMs < tick) tick = types[t].minMs;
+  }
+  return tick > SAMPLING_MIN_TICK_MS ? tick : SAMPLING_MIN_TICK_MS;
+}
+
+unsigned long SampleScheduler::getPeriod(int type, int channel) const {
+  return effectiveMs[type][channel];
+}
+
+uint8_t SampleScheduler::getReason(int type, int channel) const {
+  return reasons[type][channel];
+}
+
+uint32_t SampleScheduler::getReads(int type, int channel) const {
+  return reads[type][channel];
+}
+
+uint32_t SampleScheduler::getTotalReads() const {
+  uint32_t total = 0;
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    for (int i = 0; i < channelCounts[t]; i++) {
+      total += reads[t][i];
+    }
+  }
+  return total;
+}
+
+const char* SampleScheduler::reasonName(uint8_t reason) {
+  switch (reason) {
+    case RATE_ALARM: return "alarm";
+    case RATE_FAST: return "fast";
+    case RATE_FLAT: return "flat";
+    case RATE_BUDGET: return "budget";
+    default: return "base";
+  }
+}
+
+void SampleScheduler::addToJson(JsonObject target) const {
+  target["adaptive"] = enabled;
+  target["total_reads"] = getTotalReads();
+  if (!enabled) return;
+
+  target["tick_ms"] = getTickMs();
+  target["budget_per_s"] = getBudgetPerSecond();
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    JsonArray channels = target[sensorTypeName(t)].to<JsonArray>();
+    for (int i = 0; i < channelCounts[t]; i++) {
+      JsonObject channel = channels.add<JsonObject>();
+      channel["period_ms"] = effectiveMs[t][i];
+      channel["reason"] = reasonName(reasons[t][i]);
+      channel["reads"] = reads[t][i];
+    }
+  }
+}
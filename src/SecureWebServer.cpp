@@ -3,10 +3,11 @@
 
 SecureWebServer::SecureWebServer(int httpPort, int httpsPort) {
   server = new WiFiServer(httpPort);
-  secureServer = new WiFiServerSecure(httpsPort);
+  secureServer = new WiFiServer(httpsPort);
   sensorController = nullptr;
   templateManager = nullptr;
   sslEnabled = false;
+  connections.setHandler(this);
 }
 
 SecureWebServer::~SecureWebServer() {
@@ -38,8 +39,10 @@ bool SecureWebServer::loadSSLCertificates() {
   keyFile.close();
   
   // Set SSL certificates
-  secureServer->loadCertChain(certificatePEM.c_str(), certificatePEM.length());
-  secureServer->loadPrivateKey(privateKeyPEM.c_str(), privateKeyPEM.length());
+  if (!tlsServer.begin(certificatePEM, privateKeyPEM)) {
+    Serial.println("Failed to set up TLS with the loaded certificates");
+    return false;
+  }
   
   Serial.println("SSL certificates loaded successfully");
   sslEnabled = true;
@@ -76,95 +79,75 @@ bool SecureWebServer::begin(SensorController* sensors) {
 }
 
 void SecureWebServer::handleClients() {
-  // Handle HTTP clients
-  WiFiClient httpClient = server->available();
-  if (httpClient) {
-    handleClient(httpClient, false);
-  }
-  
-  // Handle HTTPS clients (if SSL is enabled)
-  if (sslEnabled) {
-    WiFiClientSecure httpsClient = secureServer->available();
-    if (httpsClient) {
-      handleClient(httpsClient, true);
-    }
-  }
+  connections.handleClients(*server, sslEnabled ? secureServer : nullptr, millis());
 }
 
-void SecureWebServer::handleClient(WiFiClient client, bool isSecure) {
-  if (!client) return;
-  
-  String currentLine = "";
-  String method = "";
-  String path = "";
-  
-  while (client.connected()) {
-    if (client.available()) {
-      char c = client.read();
-      if (c == '\n') {
-        if (currentLine.length() == 0) {
-          // End of headers - process request
-          if (path == "/" || path == "") {
-            handleRoot(client, isSecure);
-          } else if (path.startsWith("/api/")) {
-            handleAPI(client, path, isSecure);
-          } else {
-            sendResponse(client, 404, "text/plain", "Not Found", isSecure);
-          }
-          break;
-        } else {
-          // Parse first line for method and path
-          if (method == "" && currentLine.startsWith("GET ")) {
-            method = "GET";
-            int spaceIndex = currentLine.indexOf(' ');
-            int secondSpaceIndex = currentLine.indexOf(' ', spaceIndex + 1);
-            if (spaceIndex != -1 && secondSpaceIndex != -1) {
-              path = currentLine.substring(spaceIndex + 1, secondSpaceIndex);
-            }
-          }
-          currentLine = "";
-        }
-      } else if (c != '\r') {
-        currentLine += c;
-      }
-    }
-  }
-  
-  client.stop();
+const HttpServerStats& SecureWebServer::getStats() const {
+  return connections.getStats();
+}
+
+const TlsStats& SecureWebServer::getTlsStats() const {
+  return tlsServer.getStats();
+}
+
+bool SecureWebServer::beginSecure(HttpConnection& conn) {
+  return tls[conn.slot].begin(tlsServer, conn.client);
+}
+
+int SecureWebServer::continueHandshake(HttpConnection& conn, unsigned long now) {
+  return tls[conn.slot].handshake(now);
+}
+
+int SecureWebServer::secureRead(HttpConnection& conn, uint8_t* buf, size_t len) {
+  return tls[conn.slot].read(buf, len);
+}
+
+int SecureWebServer::secureWrite(HttpConnection& conn, const uint8_t* buf, size_t len) {
+  return tls[conn.slot].write(buf, len);
+}
+
+void SecureWebServer::endSecure(HttpConnection& conn) {
+  tls[conn.slot].stop();
 }
 
-void SecureWebServer::sendResponse(WiFiClient& client, int code, const String& contentType, const String& content, bool isSecure) {
-  client.println("HTTP/1.1 " + String(code) + " OK");
-  client.println("Content-Type: " + contentType);
-  client.println("Content-Length: " + String(content.length()));
+void SecureWebServer::handleRequest(HttpConnection& conn) {
+  const HttpRequestParser& request = conn.parser;
+  String path = request.getPath();
+  HttpMethod method = request.getMethod();
+  
+  if (method == HttpMethod::OPTIONS) {
+    // CORS preflight - headers are added by sendResponse
+    sendResponse(conn, 204, "text/plain", "");
+    return;
+  }
   
-  // Add security headers
-  addSecurityHeaders(client);
+  if (method != HttpMethod::GET && method != HttpMethod::POST) {
+    sendResponse(conn, 405, "text/plain", "Method Not Allowed");
+    return;
+  }
   
-  client.println(); // End headers
-  client.print(content);
+  if (path == "/" || path == "") {
+    handleRoot(conn);
+  } else if (path.startsWith("/api/")) {
+    handleAPI(conn, path);
+  } else {
+    sendResponse(conn, 404, "text/plain", "Not Found");
+  }
 }
 
-void SecureWebServer::addSecurityHeaders(WiFiClient& client) {
-  client.println("X-Content-Type-Options: nosniff");
-  client.println("X-Frame-Options: SAMEORIGIN");
-  client.println("X-XSS-Protection: 1; mode=block");
-  client.println("Referrer-Policy: strict-origin-when-cross-origin");
-  client.println("Content-Security-Policy: default-src 'self'; script-src 'self' 'unsafe-inline'; style-src 'self' 'unsafe-inline'");
-  client.println("Access-Control-Allow-Origin: *");
-  client.println("Access-Control-Allow-Methods: GET, POST, OPTIONS");
-  client.println("Access-Control-Allow-Headers: Content-Type");
+void SecureWebServer::sendResponse(HttpConnection& conn, int code, const String& contentType, const String& content) {
+  connections.sendResponse(conn, code, contentType, content);
 }
 
-void SecureWebServer::handleRoot(WiFiClient& client, bool isSecure) {
+void SecureWebServer::handleRoot(HttpConnection& conn) {
   if (!templateManager) {
-    sendResponse(client, 500, "text/plain", "Template manager not initialized", isSecure);
+    sendResponse(conn, 500, "text/plain", "Template manager not initialized");
     return;
   }
   
   String html = templateManager->loadTemplate("dashboard.html");
   if (html.length() == 0) {
-    sendResponse(client, 500, "text/plain", "Failed to load dashboard template", isSecure);
+    sendResponse(conn, 500, "text/plain", "Failed to load dashboard template");
     return;
   }
   
@@ -172,12 +155,12 @@ void SecureWebServer::handleRoot(WiFiClient& client, bool isSecure) {
   html.replace("{{DEVICE_NAME}}", "Aquarium Monitor");
   html.replace("{{VERSION}}", "2.0.0");
   
-  sendResponse(client, 200, "text/html", html, isSecure);
+  sendResponse(conn, 200, "text/html", html);
 }
 
-void SecureWebServer::handleAPI(WiFiClient& client, const String& path, bool isSecure) {
+void SecureWebServer::handleAPI(HttpConnection& conn, const String& path) {
   if (!sensorController) {
-    sendResponse(client, 500, "application/json", "{\"error\":\"Sensor controller not initialized\"}", isSecure);
+    sendResponse(conn, 500, "application/json", "{\"error\":\"Sensor controller not initialized\"}");
     return;
   }
   
@@ -189,34 +172,47 @@ void SecureWebServer::handleAPI(WiFiClient& client, const String& path, bool isS
     
     // Add temperature data
     JsonArray tempArray = sensors["temperature"].to<JsonArray>();
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < sensorController->getTemperatureSensors().getSensorCount(); i++) {
       tempArray.add(sensorController->getTemperature(i));
     }
     
     // Add pH data  
     JsonArray phArray = sensors["ph"].to<JsonArray>();
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < sensorController->getPHSensors().getSensorCount(); i++) {
       phArray.add(sensorController->getPH(i));
     }
     
     // Add TDS data
     JsonArray tdsArray = sensors["tds"].to<JsonArray>();
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < sensorController->getTDSSensors().getSensorCount(); i++) {
       tdsArray.add(sensorController->getTDS(i));
     }
     
   } else if (path == "/api/status") {
     doc["status"] = "online";
     doc["uptime"] = millis();
-    doc["secure"] = isSecure;
+    doc["secure"] = conn.isSecure;
     doc["ssl_enabled"] = sslEnabled;
     
+    JsonObject connStats = doc["connections"].to<JsonObject>();
+    const HttpServerStats& stats = connections.getStats();
+    connStats["active"] = stats.activeConnections;
+    connStats["peak"] = stats.peakConnections;
+    connStats["max"] = MAX_HTTP_CONNECTIONS;
+    connStats["accepted"] = stats.accepted;
+    connStats["requests"] = stats.requests;
+    connStats["keepAliveReuses"] = stats.keepAliveReuses;
+    connStats["timeouts"] = stats.timeouts;
+    connStats["parseErrors"] = stats.parseErrors;
+    
+    tlsServer.addToJson(doc["tls"].to<JsonObject>());
+    
   } else {
-    sendResponse(client, 404, "application/json", "{\"error\":\"API endpoint not found\"}", isSecure);
+    sendResponse(conn, 404, "application/json", "{\"error\":\"API endpoint not found\"}");
     return;
   }
   
   String response;
   serializeJson(doc, response);
-  sendResponse(client, 200, "application/json", response, isSecure);
+  sendResponse(conn, 200, "application/json", response);
 }
\ No newline at end of file
@@ -1,59 +1,741 @@
 #include "SensorController.h"
 
+// Bank operations for withBank() and forEachBank()
+struct BankSensorCount {
+  int count = 0;
+  template <typename Bank> void operator()(Bank& bank) { count = bank.getSensorCount(); }
+};
+
+struct BankMuxPosition {
+  int channel;
+  int bank = -1;
+  int muxChannel = -1;
+  explicit BankMuxPosition(int ch) : channel(ch) {}
+  template <typename Bank> void operator()(Bank& b) {
+    bank = b.getMuxBank(channel);
+    muxChannel = b.getMuxChannel(channel);
+  }
+};
+
+struct BankReading {
+  int channel;
+  bool capture;   // captureSample() instead of the latest reading
+  float value = 0.0;
+  BankReading(int ch, bool captureRead) : channel(ch), capture(captureRead) {}
+  template <typename Bank> void operator()(Bank& bank) {
+    value = capture ? bank.captureSample(channel) : bank.getReading(channel);
+  }
+};
+
+struct BankSampleChannel {
+  int channel;
+  template <typename Bank> void operator()(Bank& bank) { bank.sampleChannel(channel); }
+};
+
+struct BankMuxAttach {
+  int muxBank;   // -1 only asks whether there is room
+  bool hasRoom = false;
+  explicit BankMuxAttach(int bank) : muxBank(bank) {}
+  template <typename Bank> void operator()(Bank& bank) {
+    hasRoom = bank.canAttachMuxBank();
+    if (muxBank >= 0) bank.attachMuxBank(muxBank);
+  }
+};
+
+struct BankSetAdcBackend {
+  AdcBackend* backend;
+  template <typename Bank> void operator()(Bank& bank) { bank.setAdcBackend(backend); }
+};
+
+struct BankBegin {
+  template <typename Bank> void operator()(Bank& bank) { bank.begin(); }
+};
+
+struct BankSetSettleTable {
+  const uint16_t* table;
+  template <typename Bank> void operator()(Bank& bank) { bank.setSettleTable(table); }
+};
+
+template <int I, typename F>
+bool SensorController::withBankFrom(int sensorType, F& f, std::integral_constant<int, I>) {
+  if (sensorType == I) {
+    f(std::get<I>(banks));
+    return true;
+  }
+  return withBankFrom(sensorType, f, std::integral_constant<int, I + 1>());
+}
+
+template <typename F>
+bool SensorController::withBankFrom(int sensorType, F& f, std::integral_constant<int, SENSOR_TYPE_COUNT>) {
+  return false;
+}
+
+template <typename F>
+bool SensorController::withBank(int sensorType, F&& f) {
+  return withBankFrom(sensorType, f, std::integral_constant<int, 0>());
+}
+
+template <typename F>
+void SensorController::forEachBank(F&& f) {
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    withBank(type, f);
+  }
+}
+
+int SensorController::getBankSensorCount(int sensorType) {
+  BankSensorCount count;
+  withBank(sensorType, count);
+  return count.count;
+}
+
 SensorController::SensorController() 
-  : tempSensors(&mux, TEMP_ADC_PIN), phSensors(&mux, PH_ADC_PIN), tdsSensors(&mux, TDS_ADC_PIN) {}
+  : adc(&esp32Adc),
+    banks(TemperatureSensor(&mux, &esp32Adc, 0), PHSensor(&mux, &esp32Adc, 1), TDSSensor(&mux, &esp32Adc, 2)),
+    scanStepCount(0), lastCycleMicros(0), lastCycleEdges(0), readIntervalMs(DEFAULT_SENSOR_READ_DELAY),
+    calibration(nullptr),
+    cycleCount(0), captureIntervalMs(DEFAULT_CAPTURE_INTERVAL_MS), lastCaptureRead(0) {
+  memset(&snapshot, 0, sizeof(snapshot));
+  memset(sampleCycles, 0, sizeof(sampleCycles));
+  memset(forcedReads, 0, sizeof(forcedReads));
+  snapshotLock = portMUX_INITIALIZER_UNLOCKED;
+  captureMutex = xSemaphoreCreateRecursiveMutex();
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    captureDefaults[type].windowSamples = DEFAULT_CAPTURE_WINDOW;
+    captureDefaults[type].timeoutMs = DEFAULT_CAPTURE_TIMEOUT_S * 1000UL;
+  }
+  captureDefaults[TEMP_BANK].maxStdev = TemperatureTraits::captureMaxStdev();
+  captureDefaults[PH_BANK].maxStdev = PHTraits::captureMaxStdev();
+  captureDefaults[TDS_BANK].maxStdev = TDSTraits::captureMaxStdev();
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    captureDefaults[type].maxDrift = captureDefaults[type].maxStdev;
+  }
+  for (int aq = 0; aq < MAX_AQUARIUMS; aq++) {
+    aquariumTemperatures[aq] = CAL_REFERENCE_TEMP;
+    aquariumProbeCounts[aq] = 0;
+  }
+}
 
-void SensorController::begin() {
+void SensorController::setAdcBackend(AdcBackend* backend) {
+  adc = backend;
+  forEachBank(BankSetAdcBackend{ backend });
+}
+
+static EstimatorConfig loadEstimatorConfig(ConfigManager& config, const String& sensorType) {
+  EstimatorConfig estimator;
+  estimator.mode = ChannelEstimator::parseMode(config.getEstimatorMode(sensorType));
+  estimator.processNoise = config.getEstimatorProcessNoise(sensorType);
+  estimator.measurementNoise = config.getEstimatorMeasurementNoise(sensorType);
+  estimator.alpha = config.getEstimatorAlpha(sensorType);
+  estimator.adaptive = config.getEstimatorAdaptive(sensorType);
+  return estimator;
+}
+
+static SamplingConfig loadSamplingConfig(ConfigManager& config, const String& sensorType,
+                                         unsigned long defaultBaseMs, float defaultChange) {
+  SamplingConfig sampling;
+  sampling.baseMs = config.getSamplingBaseMs(sensorType, defaultBaseMs);
+  sampling.minMs = config.getSamplingMinMs(sensorType, sampling.baseMs / SAMPLING_MIN_DIVISOR);
+  sampling.maxMs = config.getSamplingMaxMs(sensorType, sampling.baseMs * SAMPLING_MAX_MULTIPLIER);
+  sampling.changeThreshold = config.getSamplingChangeThreshold(sensorType, defaultChange);
+  return sampling;
+}
+
+// One channel's range and rate alarms from its aquarium's normal_range and
+// alarm settings
+static void addAlarmRules(AlarmEngine& alarms, ConfigManager& config, int aq, const String& sensorType,
+                          int type, int channel, float low, float high, float defaultMaxRate) {
+  float percent = config.getAlarmHysteresisPercent() / 100.0;
+  unsigned long raiseMs = config.getAlarmRaiseSeconds(aq, sensorType) * 1000UL;
+  unsigned long clearMs = config.getAlarmClearSeconds(aq, sensorType) * 1000UL;
+  float hysteresis = config.getAlarmHysteresis(aq, sensorType, (high - low) * percent);
+  alarms.addRule(type, channel, aq, low, high, hysteresis, raiseMs, clearMs);
+  
+  float maxRate = config.getAlarmMaxRate(aq, sensorType, defaultMaxRate);
+  alarms.addRateRule(type, channel, aq, maxRate, 2 * maxRate * percent, raiseMs, clearMs);
+}
+
+void SensorController::setCalibration(CalibrationManager* manager) {
+  calibration = manager;
+}
+
+void SensorController::configure(ConfigManager& config) {
+  TemperatureSensor& tempBank = std::get<TEMP_BANK>(banks);
+  PHSensor& phBank = std::get<PH_BANK>(banks);
+  TDSSensor& tdsBank = std::get<TDS_BANK>(banks);
+  
+  esp32Adc.setContinuous(config.getAdcMode() == "dma");
+  
+  mux.setSharedAddressPins(config.getMuxS0(), config.getMuxS1(), config.getMuxS2(), config.getMuxS3());
+  
+  if (config.getMuxBankCount() == 0) {
+    // Classic layout: one multiplexer per type on the shared bus and enable
+    mux.addBank(config.getMuxEnable(), config.getTempAdcPin());
+    mux.addBank(config.getMuxEnable(), config.getPHAdcPin());
+    mux.addBank(config.getMuxEnable(), config.getTDSAdcPin());
+  } else {
+    tempBank.clearMuxBanks();
+    phBank.clearMuxBanks();
+    tdsBank.clearMuxBanks();
+    
+    for (int i = 0; i < config.getMuxBankCount(); i++) {
+      // Everything is checked before the bank is added, so a rejected bank
+      // is never driven by the scan
+      String type = config.getMuxBankType(i);
+      int adcPin = config.getMuxBankAdcPin(i);
+      int sensorType = parseSensorTypeName(type);
+      BankMuxAttach room(-1);
+      if (!withBank(sensorType, room)) {
+        Serial.printf("  [MUX] Bank %d not used: unknown type \"%s\"\n", i, type.c_str());
+        continue;
+      }
+      if (adcPin < 0) {
+        Serial.printf("  [MUX] Bank %d (%s) not used: no adc pin\n", i, type.c_str());
+        continue;
+      }
+      if (!room.hasRoom) {
+        Serial.printf("  [MUX] Bank %d (%s) not used: more than %d banks for the type\n",
+                      i, type.c_str(), MAX_MUX_BANKS_PER_TYPE);
+        continue;
+      }
+      
+      int addressPins[MUX_ADDRESS_LINES];
+      bool ownAddress = config.hasMuxBankAddress(i);
+      for (int line = 0; line < MUX_ADDRESS_LINES; line++) {
+        addressPins[line] = config.getMuxBankAddressPin(i, line);
+      }
+      
+      int bank = mux.addBank(config.getMuxBankEnable(i), adcPin, ownAddress ? addressPins : nullptr);
+      if (bank < 0) {
+        continue;
+      }
+      mux.setSettleTime(bank, config.getMuxBankSettleUs(i));
+      withBank(sensorType, BankMuxAttach(bank));
+    }
+  }
+  
+  tempBank.configureFilter(SampleFilter::parseMode(config.getFilterMode("temperature")),
+                           config.getFilterSamples("temperature", TemperatureTraits::SAMPLES),
+                           config.getFilterWindow("temperature"), config.getFilterTrimPercent("temperature"));
+  phBank.configureFilter(SampleFilter::parseMode(config.getFilterMode("ph")),
+                         config.getFilterSamples("ph", PHTraits::SAMPLES),
+                         config.getFilterWindow("ph"), config.getFilterTrimPercent("ph"));
+  tdsBank.configureFilter(SampleFilter::parseMode(config.getFilterMode("tds")),
+                          config.getFilterSamples("tds", TDSTraits::SAMPLES),
+                          config.getFilterWindow("tds"), config.getFilterTrimPercent("tds"));
+  
+  tempBank.configureEstimator(loadEstimatorConfig(config, "temperature"));
+  phBank.configureEstimator(loadEstimatorConfig(config, "ph"));
+  tdsBank.configureEstimator(loadEstimatorConfig(config, "tds"));
+  
+  settleTuner.configure(config.getSettleAutoTune(), config.getSettleToleranceLsb(),
+                        config.getSettleMaxUs(), config.getSettleRecheckMinutes());
+  
+  readIntervalMs = config.getSensorReadInterval();
+  scheduler.configure(config.getSamplingAdaptive(), config.getSamplingAlarmMargin(), readIntervalMs);
+  scheduler.configureType(TEMP_BANK, loadSamplingConfig(config, "temperature", TemperatureTraits::SAMPLE_PERIOD_MS,
+                                                        TemperatureTraits::rateChangeThreshold()));
+  scheduler.configureType(PH_BANK, loadSamplingConfig(config, "ph", PHTraits::SAMPLE_PERIOD_MS,
+                                                      PHTraits::rateChangeThreshold()));
+  scheduler.configureType(TDS_BANK, loadSamplingConfig(config, "tds", TDSTraits::SAMPLE_PERIOD_MS,
+                                                       TDSTraits::rateChangeThreshold()));
+  
+  captureIntervalMs = config.getCaptureIntervalMs();
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    CaptureCriteria& criteria = captureDefaults[type];
+    criteria.windowSamples = config.getCaptureWindow();
+    criteria.timeoutMs = config.getCaptureTimeoutSeconds() * 1000UL;
+    criteria.maxStdev = config.getCaptureMaxStdev(sensorTypeName(type), criteria.maxStdev);
+    criteria.maxDrift = config.getCaptureMaxDrift(sensorTypeName(type), criteria.maxStdev);
+  }
+  
+  tempBank.setChannelCount(config.getTemperatureCount());
+  phBank.setChannelCount(config.getPHCount());
+  tdsBank.setChannelCount(config.getTDSCount());
+  
+  // Resolve aquarium sensor_ids once so request handlers never walk the config
+  tempBank.clearAquariumMap();
+  phBank.clearAquariumMap();
+  tdsBank.clearAquariumMap();
+  alarms.clear();
+  trends.configure(config.getTrendWindowSeconds());
+  trends.reset();
+  for (int aq = 0; aq < config.getAquariumCount(); aq++) {
+    for (int i = 0; i < config.getTemperatureSensorCount(aq); i++) {
+      int channel = config.getTemperatureSensorID(aq, i);
+      if (!tempBank.assignAquarium(channel, aq)) {
+        Serial.printf("  [TEMP] Aquarium %d: channel %d not configured, ignored\n", aq, channel);
+      } else {
+        scheduler.setAlarmRange(TEMP_BANK, channel, config.getTemperatureMin(aq), config.getTemperatureMax(aq));
+        if (config.isAquariumEnabled(aq)) {
+          addAlarmRules(alarms, config, aq, "temperature", TEMP_BANK, channel,
+                        config.getTemperatureMin(aq), config.getTemperatureMax(aq), TemperatureTraits::maxRatePerMinute());
+        }
+      }
+    }
+    for (int i = 0; i < config.getPHSensorCount(aq); i++) {
+      int channel = config.getPHSensorID(aq, i);
+      if (!phBank.assignAquarium(channel, aq)) {
+        Serial.printf("  [pH] Aquarium %d: channel %d not configured, ignored\n", aq, channel);
+      } else {
+        scheduler.setAlarmRange(PH_BANK, channel, config.getPHMin(aq), config.getPHMax(aq));
+        if (config.isAquariumEnabled(aq)) {
+          addAlarmRules(alarms, config, aq, "ph", PH_BANK, channel,
+                        config.getPHMin(aq), config.getPHMax(aq), PHTraits::maxRatePerMinute());
+        }
+      }
+    }
+    for (int i = 0; i < config.getTDSSensorCount(aq); i++) {
+      int channel = config.getTDSSensorID(aq, i);
+      if (!tdsBank.assignAquarium(channel, aq)) {
+        Serial.printf("  [TDS] Aquarium %d: channel %d not configured, ignored\n", aq, channel);
+      } else {
+        scheduler.setAlarmRange(TDS_BANK, channel, config.getTDSMin(aq), config.getTDSMax(aq));
+        if (config.isAquariumEnabled(aq)) {
+          addAlarmRules(alarms, config, aq, "tds", TDS_BANK, channel,
+                        config.getTDSMin(aq), config.getTDSMax(aq), TDSTraits::maxRatePerMinute());
+        }
+      }
+    }
+  }
+  
+  Serial.printf("Sensor channels: %d temperature, %d pH, %d TDS on %d mux banks\n",
+                tempBank.getSensorCount(), phBank.getSensorCount(), tdsBank.getSensorCount(),
+                mux.getBankCount());
+  Serial.printf("Alarm rules: %d\n", alarms.getRuleCount());
+}
+
+void SensorController::begin(bool runSelfTest) {
   Serial.println("Sensor Controller Initializing...");
   
-  // Initialize multiplexer first
-  mux.begin();
+  // Initialize multiplexer and the ADC conversion table first
+  mux.begin(runSelfTest);
+  adc->begin();
   
-  // Initialize sensor classes
-  tempSensors.begin();
-  phSensors.begin();
-  tdsSensors.begin();
+  // Initialize sensor banks
+  forEachBank(BankBegin());
+  
+  buildScanPlan();
+  
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    settleTuner.setChannelCount(type, getBankSensorCount(type));
+  }
+  if (settleTuner.isEnabled() && adc == &esp32Adc && esp32Adc.getDmaSampler().isRunning()) {
+    // Probes need single conversions at exact delays, which the DMA stream can't give
+    Serial.println("[SETTLE] Auto-tuning needs adc_mode \"oneshot\", disabled");
+    settleTuner.setEnabled(false);
+  }
+  if (settleTuner.isEnabled()) {
+    // Channels without a learned time use the sensor default until measured
+    settleTuner.load();
+    for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+      withBank(type, BankSetSettleTable{ settleTuner.getTable(type) });
+    }
+  }
+  settleTuner.printTable();
+  
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    scheduler.setChannelCount(type, getBankSensorCount(type));
+  }
+  scheduler.reset();
+  if (scheduler.isEnabled()) {
+    Serial.printf("Adaptive sampling: scan tick %lums, read budget of %lums per channel\n",
+                  scheduler.getTickMs(), readIntervalMs);
+  }
+  
+  Serial.printf("Scan plan: %d steps across %d mux banks\n", scanStepCount, mux.getBankCount());
   
   Serial.println("All sensor systems ready");
   Serial.println();
 }
 
+void SensorController::addScanSteps(int sensorType, int muxBank, int muxChannel) {
+  // Every channel of this type wired to (muxBank, muxChannel) - at most one
+  int count = getBankSensorCount(sensorType);
+  
+  for (int ch = 0; ch < count && scanStepCount < MAX_SCAN_STEPS; ch++) {
+    BankMuxPosition position(ch);
+    withBank(sensorType, position);
+    if (position.bank == muxBank && position.muxChannel == muxChannel) {
+      ScanStep& step = scanPlan[scanStepCount++];
+      step.sensorType = sensorType;
+      step.channel = ch;
+      step.muxBank = muxBank;
+      step.muxChannel = muxChannel;
+    }
+  }
+}
+
+void SensorController::buildScanPlan() {
+  scanStepCount = 0;
+  for (int i = 0; i < MUX_CHANNEL_CAPACITY; i++) {
+    int muxChannel = MultiplexerController::scanChannel(i);
+    for (int muxBank = 0; muxBank < mux.getBankCount(); muxBank++) {
+      addScanSteps(TEMP_BANK, muxBank, muxChannel);
+      addScanSteps(PH_BANK, muxBank, muxChannel);
+      addScanSteps(TDS_BANK, muxBank, muxChannel);
+    }
+  }
+}
+
+void SensorController::sampleStep(const ScanStep& step) {
+  sampleCycles[step.sensorType][step.channel] = cycleCount + 1;
+  withBank(step.sensorType, BankSampleChannel{ step.channel });
+}
+
 void SensorController::updateAllReadings() {
-  tempSensors.updateAllReadings();
-  Serial.println();
-  phSensors.updateAllReadings();
-  Serial.println();
-  tdsSensors.updateAllReadings();
+  // Steps the scheduler has due or a handler asked for, still in scan plan order
+  unsigned long now = millis();
+  uint32_t forced[SENSOR_TYPE_COUNT];
+  portENTER_CRITICAL(&snapshotLock);
+  for (int type = 0; type < SENSOR_TYPE_COUNT; type++) {
+    forced[type] = forcedReads[type];
+    forcedReads[type] = 0;
+  }
+  portEXIT_CRITICAL(&snapshotLock);
+  
+  int dueSteps[MAX_SCAN_STEPS];
+  int dueCount = 0;
+  for (int i = 0; i < scanStepCount; i++) {
+    const ScanStep& step = scanPlan[i];
+    if ((forced[step.sensorType] & (1UL << step.channel)) ||
+        scheduler.isDue(step.sensorType, step.channel, now)) {
+      dueSteps[dueCount++] = i;
+    }
+  }
+  if (dueCount == 0) {
+    return;
+  }
+  
+  Serial.printf("  Reading %d of %d sensors on %d mux banks...\n", dueCount, scanStepCount, mux.getBankCount());
+  unsigned long start = micros();
+  unsigned long startEdges = mux.getEdgeCount();
+  
+  for (int i = 0; i < dueCount; i++) {
+    const ScanStep& step = scanPlan[dueSteps[i]];
+    mux.select(step.muxBank, step.muxChannel);
+    
+    // Start the next bank settling while this one is converted
+    if (i + 1 < dueCount) {
+      const ScanStep& next = scanPlan[dueSteps[i + 1]];
+      if (next.muxBank != step.muxBank &&
+          mux.canPreselect(step.muxBank, next.muxBank, next.muxChannel)) {
+        mux.select(next.muxBank, next.muxChannel);
+      }
+    }
+    
+    sampleStep(step);
+    scheduler.markSampled(step.sensorType, step.channel, now);
+    
+    // A channel under calibration capture keeps its rate during the scan
+    if (capture.isActive()) {
+      serviceCapture();
+    }
+  }
+  
+  // Calibrate the whole cycle against the current tables in one pass per
+  // type. Temperature goes first so each aquarium's pH and TDS channels are
+  // compensated at that aquarium's temperature from the same cycle.
+  TemperatureSensor& tempBank = std::get<TEMP_BANK>(banks);
+  PHSensor& phBank = std::get<PH_BANK>(banks);
+  TDSSensor& tdsBank = std::get<TDS_BANK>(banks);
+  float channelTemperatures[MAX_CHANNELS_PER_TYPE];
+  
+  tempBank.finishCycle(calibration ? &calibration->getTemperatureTable() : nullptr);
+  updateAquariumTemperatures();
+  
+  // Unassigned channels and aquariums without a probe stay at the reference
+  phBank.mapFromAquariums(aquariumTemperatures, CAL_REFERENCE_TEMP, channelTemperatures);
+  phBank.finishCycle(calibration ? &calibration->getPHTable() : nullptr, channelTemperatures);
+  tdsBank.mapFromAquariums(aquariumTemperatures, CAL_REFERENCE_TEMP, channelTemperatures);
+  tdsBank.finishCycle(calibration ? &calibration->getTDSTable() : nullptr, channelTemperatures);
+  publishSnapshot();
+  
+  // Alarms, trends and next periods from the readings just taken;
+  // channels not read this cycle keep their alarm state
+  unsigned long finished = millis();
+  for (int i = 0; i < dueCount; i++) {
+    const ScanStep& step = scanPlan[dueSteps[i]];
+    float reading = getBankReading(step.sensorType, step.channel);
+    alarms.evaluate(step.sensorType, step.channel, reading, finished);
+    float perMinute;
+    if (trends.add(step.sensorType, step.channel, reading, finished) &&
+        trends.getSlope(step.sensorType, step.channel, perMinute)) {
+      alarms.evaluateRate(step.sensorType, step.channel, perMinute, finished);
+    }
+    scheduler.update(step.sensorType, step.channel, reading);
+  }
+  scheduler.rebalance();
+  
+  lastCycleMicros = micros() - start;
+  lastCycleEdges = mux.getEdgeCount() - startEdges;
+  Serial.printf("  Scan cycle: %.1f ms, %lu mux line edges\n", lastCycleMicros / 1000.0, lastCycleEdges);
+  
+  if (settleTuner.isEnabled()) {
+    tuneNextDue();
+  }
+}
+
+void SensorController::updateAquariumTemperatures() {
+  std::get<TEMP_BANK>(banks).averageByAquarium(aquariumTemperatures, aquariumProbeCounts, CAL_REFERENCE_TEMP);
+}
+
+void SensorController::publishSnapshot() {
+  TemperatureSensor& tempBank = std::get<TEMP_BANK>(banks);
+  PHSensor& phBank = std::get<PH_BANK>(banks);
+  TDSSensor& tdsBank = std::get<TDS_BANK>(banks);
+  float readings[SENSOR_TYPE_COUNT][MAX_CHANNELS_PER_TYPE];
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    readings[TEMP_BANK][i] = tempBank.getRawReading(i);
+    readings[PH_BANK][i] = phBank.getRawReading(i);
+    readings[TDS_BANK][i] = tdsBank.getRawReading(i);
+  }
+  
+  cycleCount++;
+  portENTER_CRITICAL(&snapshotLock);
+  memcpy(snapshot.readings, readings, sizeof(readings));
+  memcpy(snapshot.sampledCycles, sampleCycles, sizeof(sampleCycles));
+  snapshot.cycle = cycleCount;
+  snapshot.takenAt = millis();
+  portEXIT_CRITICAL(&snapshotLock);
+}
+
+RawSnapshotStatus SensorController::getRawSnapshot(int sensorType, const int* channels, int count,
+                                                   float* values, uint32_t& cycle) {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT) return SNAPSHOT_EMPTY;
+  for (int i = 0; i < count; i++) {
+    if (channels[i] < 0 || channels[i] >= MAX_CHANNELS_PER_TYPE) return SNAPSHOT_EMPTY;
+  }
+  
+  RawSnapshotStatus status = SNAPSHOT_OK;
+  portENTER_CRITICAL(&snapshotLock);
+  if (snapshot.cycle == 0) {
+    status = SNAPSHOT_EMPTY;
+  } else {
+    for (int i = 0; i < count; i++) {
+      values[i] = snapshot.readings[sensorType][channels[i]];
+      if (snapshot.sampledCycles[sensorType][channels[i]] != snapshot.cycle) {
+        status = SNAPSHOT_STALE;
+      }
+    }
+    cycle = snapshot.cycle;
+  }
+  portEXIT_CRITICAL(&snapshotLock);
+  return status;
+}
+
+void SensorController::requestRead(int sensorType, const int* channels, int count) {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT) return;
+  uint32_t mask = 0;
+  for (int i = 0; i < count; i++) {
+    if (channels[i] >= 0 && channels[i] < MAX_CHANNELS_PER_TYPE) {
+      mask |= 1UL << channels[i];
+    }
+  }
+  portENTER_CRITICAL(&snapshotLock);
+  forcedReads[sensorType] |= mask;
+  portEXIT_CRITICAL(&snapshotLock);
+}
+
+float SensorController::getBankReading(int sensorType, int channel) {
+  BankReading reading(channel, false);
+  withBank(sensorType, reading);
+  return reading.value;
+}
+
+uint32_t SensorController::getCycleCount() const {
+  return cycleCount;
+}
+
+float SensorController::captureSample(int sensorType, int channel) {
+  BankReading reading(channel, true);
+  withBank(sensorType, reading);
+  return reading.value;
+}
+
+CaptureCriteria SensorController::getCaptureCriteria(int sensorType) const {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT) return captureDefaults[TEMP_BANK];
+  return captureDefaults[sensorType];
+}
+
+bool SensorController::startCapture(int sensorType, int channel, const CaptureCriteria& criteria) {
+  if (channel < 0 || channel >= getBankSensorCount(sensorType)) {
+    return false;
+  }
+  
+  lockCapture();
+  // A finished capture stays until its result is taken, so a stable
+  // window is never replaced before it became a calibration point
+  if (capture.getState() != CAPTURE_IDLE) {
+    unlockCapture();
+    return false;
+  }
+  capture.start(sensorType, channel, criteria, millis());
+  lastCaptureRead = 0;
+  Serial.printf("[CAPTURE] %s channel %d: every %lums, windows of %d, stdev <= %.4f, drift <= %.4f\n",
+                sensorTypeName(sensorType), channel + 1, captureIntervalMs,
+                capture.getCriteria().windowSamples, criteria.maxStdev, criteria.maxDrift);
+  unlockCapture();
+  return true;
+}
+
+void SensorController::cancelCapture() {
+  lockCapture();
+  capture.cancel(millis());
+  unlockCapture();
+}
+
+void SensorController::lockCapture() {
+  xSemaphoreTakeRecursive(captureMutex, portMAX_DELAY);
+}
+
+void SensorController::unlockCapture() {
+  xSemaphoreGiveRecursive(captureMutex);
+}
+
+void SensorController::serviceCapture() {
+  lockCapture();
+  if (!capture.isActive()) {
+    unlockCapture();
+    return;
+  }
+  
+  unsigned long now = millis();
+  bool finished;
+  if (lastCaptureRead != 0 && now - lastCaptureRead < captureIntervalMs) {
+    finished = capture.checkTimeout(now);
+  } else {
+    lastCaptureRead = now;
+    float value = captureSample(capture.getSensorType(), capture.getChannel());
+    finished = capture.add(value, millis());
+  }
+  
+  if (finished) {
+    Serial.printf("[CAPTURE] %s channel %d %s after %lu reads: mean %.4f, stdev %.4f\n",
+                  sensorTypeName(capture.getSensorType()), capture.getChannel() + 1,
+                  StabilityCapture::stateName(capture.getState()), (unsigned long)capture.getTotalSamples(),
+                  capture.getWindowMean(), capture.getWindowStdev());
+  }
+  unlockCapture();
+}
+
+StabilityCapture& SensorController::getCapture() {
+  return capture;
+}
+
+void SensorController::tuneChannel(int sensorType, int channel) {
+  BankMuxPosition position(channel);
+  withBank(sensorType, position);
+  int bank = position.bank;
+  int muxChannel = position.muxChannel;
+  
+  unsigned long previous = settleTuner.getSettleTime(sensorType, channel);
+  unsigned long measured = settleTuner.measure(mux, *adc, bank, muxChannel);
+  settleTuner.setSettleTime(sensorType, channel, measured);
+  Serial.printf("  [SETTLE] %s channel %d (bank %d ch %d): %luus (was %luus)\n",
+                sensorTypeName(sensorType), channel, bank, muxChannel, measured, previous);
+}
+
+void SensorController::tuneNextDue() {
+  // One channel per cycle at most, and none while the tuner holds off so
+  // measurements stay a small share of loop time
+  unsigned long now = millis();
+  if (!settleTuner.canMeasure(now)) return;
+  
+  int type;
+  int channel;
+  if (settleTuner.nextDue(now, type, channel)) {
+    tuneChannel(type, channel);
+  } else {
+    settleTuner.save();  // Only writes after a pass changed something
+  }
 }
 
 void SensorController::printAllReadings() {
-  tempSensors.printReadings();
+  std::get<TEMP_BANK>(banks).printReadings();
   Serial.println();
-  phSensors.printReadings();
+  std::get<PH_BANK>(banks).printReadings();
   Serial.println();
-  tdsSensors.printReadings();
+  std::get<TDS_BANK>(banks).printReadings();
 }
 
 void SensorController::printDetailedReadings() {
-  tempSensors.printDetailedReadings();
+  std::get<TEMP_BANK>(banks).printDetailedReadings();
   Serial.println();
-  phSensors.printDetailedReadings();
+  std::get<PH_BANK>(banks).printDetailedReadings();
   Serial.println();
-  tdsSensors.printDetailedReadings();
+  std::get<TDS_BANK>(banks).printDetailedReadings();
 }
 
 TemperatureSensor& SensorController::getTemperatureSensors() {
-  return tempSensors;
+  return std::get<TEMP_BANK>(banks);
 }
 
 PHSensor& SensorController::getPHSensors() {
-  return phSensors;
+  return std::get<PH_BANK>(banks);
 }
 
 TDSSensor& SensorController::getTDSSensors() {
-  return tdsSensors;
+  return std::get<TDS_BANK>(banks);
 }
 
 MultiplexerController& SensorController::getMultiplexer() {
   return mux;
-}
\ No newline at end of file
+}
+
+int SensorController::getScanStepCount() const {
+  return scanStepCount;
+}
+
+AdcBackend& SensorController::getAdcBackend() {
+  return *adc;
+}
+
+SettleTuner& SensorController::getSettleTuner() {
+  return settleTuner;
+}
+
+SampleScheduler& SensorController::getScheduler() {
+  return scheduler;
+}
+
+const AlarmEngine& SensorController::getAlarms() const {
+  return alarms;
+}
+
+const TrendEstimator& SensorController::getTrends() const {
+  return trends;
+}
+
+unsigned long SensorController::getScanInterval() const {
+  return scheduler.isEnabled() ? scheduler.getTickMs() : readIntervalMs;
+}
+
+unsigned long SensorController::getLastCycleMicros() const {
+  return lastCycleMicros;
+}
+
+unsigned long SensorController::getLastCycleEdges() const {
+  return lastCycleEdges;
+}
+
+float SensorController::getTemperature(int sensorIndex) {
+  return std::get<TEMP_BANK>(banks).getReading(sensorIndex);
+}
+
+float SensorController::getPH(int sensorIndex) {
+  return std::get<PH_BANK>(banks).getReading(sensorIndex);
+}
+
+float SensorController::getTDS(int sensorIndex) {
+  return std::get<TDS_BANK>(banks).getReading(sensorIndex);
+}
+
+float SensorController::getCompensationTemperature(int aquariumIndex) const {
+  if (aquariumIndex < 0 || aquariumIndex >= MAX_AQUARIUMS) return CAL_REFERENCE_TEMP;
+  return aquariumTemperatures[aquariumIndex];
+}
+
+bool SensorController::hasAquariumTemperature(int aquariumIndex) const {
+  if (aquariumIndex < 0 || aquariumIndex >= MAX_AQUARIUMS) return false;
+  return aquariumProbeCounts[aquariumIndex] > 0;
+}
@@ -0,0 +1,233 @@
+#include "SettleTuner.h"
+#include <ArduinoJson.h>
+#include "SPIFFS.h"
+
+SettleTuner::SettleTuner()
+  : enabled(DEFAULT_SETTLE_AUTO_TUNE), toleranceLsb(DEFAULT_SETTLE_TOLERANCE_LSB),
+    maxUs(DEFAULT_SETTLE_MAX_US), recheckMs(DEFAULT_SETTLE_RECHECK_MIN * 60000UL),
+    cursorType(0), cursorChannel(0), dirty(false), nextMeasureAt(0) {
+  memset(settleUs, 0, sizeof(settleUs));
+  memset(tunedAt, 0, sizeof(tunedAt));
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    channelCounts[t] = 0;
+  }
+}
+
+void SettleTuner::configure(bool autoTune, int tolerance, unsigned long maxSettleUs, unsigned long recheckMinutes) {
+  enabled = autoTune;
+  toleranceLsb = tolerance > 0 ? tolerance : DEFAULT_SETTLE_TOLERANCE_LSB;
+  maxUs = constrain(maxSettleUs, (unsigned long)SETTLE_MIN_US * 2, (unsigned long)SETTLE_MAX_STORED_US);
+  if (recheckMinutes < SETTLE_MIN_RECHECK_MIN) {
+    Serial.printf("[SETTLE] recheck_min %lu too short, using %d\n", recheckMinutes, SETTLE_MIN_RECHECK_MIN);
+    recheckMinutes = SETTLE_MIN_RECHECK_MIN;
+  }
+  recheckMs = recheckMinutes * 60000UL;
+}
+
+void SettleTuner::setChannelCount(int type, int count) {
+  if (type < 0 || type >= SENSOR_TYPE_COUNT) return;
+  channelCounts[type] = constrain(count, 0, MAX_CHANNELS_PER_TYPE);
+}
+
+void SettleTuner::setEnabled(bool autoTune) {
+  enabled = autoTune;
+}
+
+bool SettleTuner::isEnabled() const {
+  return enabled;
+}
+
+bool SettleTuner::load() {
+  File file = SPIFFS.open(SETTLE_FILE, "r");
+  if (!file) {
+    Serial.println("[SETTLE] No learned settle times, channels will be measured");
+    return false;
+  }
+
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+
+  if (error) {
+    Serial.printf("[SETTLE] Failed to parse %s: %s\n", SETTLE_FILE, error.c_str());
+    return false;
+  }
+
+  // Loaded values count as fresh; they are re-checked after the normal interval
+  unsigned long now = millis();
+  int loaded = 0;
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    JsonArray values = doc[sensorTypeName(t)];
+    for (int i = 0; i < MAX_CHANNELS_PER_TYPE && i < (int)values.size(); i++) {
+      unsigned long us = values[i] | 0;
+      settleUs[t][i] = (us > maxUs) ? maxUs : us;
+      tunedAt[t][i] = now;
+      if (us > 0) loaded++;
+    }
+  }
+
+  dirty = false;
+  Serial.printf("[SETTLE] Loaded %d learned settle times\n", loaded);
+  return true;
+}
+
+bool SettleTuner::save() {
+  if (!dirty) return true;
+
+  JsonDocument doc;
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    JsonArray values = doc[sensorTypeName(t)].to<JsonArray>();
+    for (int i = 0; i < channelCounts[t]; i++) {
+      values.add(settleUs[t][i]);
+    }
+  }
+
+  File file = SPIFFS.open(SETTLE_FILE, "w");
+  if (!file) {
+    Serial.printf("[SETTLE] Failed to open %s for writing\n", SETTLE_FILE);
+    return false;
+  }
+
+  if (serializeJson(doc, file) == 0) {
+    Serial.println("[SETTLE] Failed to write settle times");
+    file.close();
+    return false;
+  }
+
+  file.close();
+  dirty = false;
+  Serial.println("[SETTLE] Settle times saved");
+  return true;
+}
+
+int SettleTuner::readAverage(AdcBackend& adc, int adcPin) {
+  int sum = 0;
+  for (int i = 0; i < SETTLE_PROBE_READS; i++) {
+    sum += adc.readRaw(adcPin);
+  }
+  return sum / SETTLE_PROBE_READS;
+}
+
+unsigned long SettleTuner::measure(MultiplexerController& mux, AdcBackend& adc, int bank, int muxChannel) {
+  int adcPin = mux.getAdcPin(bank);
+  if (adcPin < 0) return 0;
+
+  unsigned long start = micros();
+  unsigned long result = probe(mux, adc, adcPin, bank, muxChannel);
+
+  // Spread measurements out so they take a bounded share of loop time
+  unsigned long spentMs = (micros() - start + 999) / 1000;
+  nextMeasureAt = millis() + spentMs * (100 - SETTLE_MAX_DUTY_PERCENT) / SETTLE_MAX_DUTY_PERCENT;
+  return result;
+}
+
+unsigned long SettleTuner::probe(MultiplexerController& mux, AdcBackend& adc, int adcPin, int bank,
+                                 int muxChannel) {
+  // Settle on the neighbouring channel first so the switch is a real step
+  mux.select(bank, muxChannel ^ 0x01);
+  delayMicroseconds(maxUs);
+
+  mux.select(bank, muxChannel);
+  unsigned long start = micros();
+  unsigned long probeUs = SETTLE_MIN_US;
+  delayMicroseconds(probeUs);
+  int previous = readAverage(adc, adcPin);
+
+  while (probeUs * 2 <= maxUs) {
+    unsigned long nextUs = probeUs * 2;
+    unsigned long elapsed = micros() - start;
+    if (elapsed < nextUs) {
+      delayMicroseconds(nextUs - elapsed);
+    }
+    int value = readAverage(adc, adcPin);
+
+    if (abs(value - previous) <= toleranceLsb) {
+      unsigned long result = probeUs + probeUs * SETTLE_MARGIN_PERCENT / 100;
+      return result < maxUs ? result : maxUs;
+    }
+
+    previous = value;
+    probeUs = nextUs;
+  }
+
+  // Never converged (noisy or floating input) - wait the full bound
+  return maxUs;
+}
+
+void SettleTuner::setSettleTime(int type, int channel, unsigned long us) {
+  if (type < 0 || type >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return;
+  }
+  if (us > SETTLE_MAX_STORED_US) {
+    us = SETTLE_MAX_STORED_US;
+  }
+  if (settleUs[type][channel] != us) {
+    settleUs[type][channel] = us;
+    dirty = true;
+  }
+  tunedAt[type][channel] = millis();
+}
+
+void SettleTuner::advanceCursor() {
+  cursorChannel++;
+  if (cursorChannel >= channelCounts[cursorType]) {
+    cursorChannel = 0;
+    cursorType = (cursorType + 1) % SENSOR_TYPE_COUNT;
+  }
+}
+
+bool SettleTuner::canMeasure(unsigned long now) const {
+  return (long)(now - nextMeasureAt) >= 0;
+}
+
+bool SettleTuner::nextDue(unsigned long now, int& type, int& channel) {
+  int total = 0;
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    total += channelCounts[t];
+  }
+
+  // One full lap from the cursor at most (empty types are skipped in passing)
+  for (int visited = 0; visited < total + SENSOR_TYPE_COUNT; visited++) {
+    if (cursorChannel < channelCounts[cursorType]) {
+      int t = cursorType;
+      int i = cursorChannel;
+      if (settleUs[t][i] == 0 || now - tunedAt[t][i] >= recheckMs) {
+        type = t;
+        channel = i;
+        advanceCursor();
+        return true;
+      }
+    }
+    advanceCursor();
+  }
+  return false;
+}
+
+const uint16_t* SettleTuner::getTable(int type) const {
+  if (type < 0 || type >= SENSOR_TYPE_COUNT) return nullptr;
+  return settleUs[type];
+}
+
+unsigned long SettleTuner::getSettleTime(int type, int channel) const {
+  if (type < 0 || type >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return 0;
+  }
+  return settleUs[type][channel];
+}
+
+void SettleTuner::printTable() {
+  Serial.printf("Settle Tuning: %s (tolerance %d LSB, max %luus, re-check every %lu min)\n",
+                enabled ? "auto" : "off", toleranceLsb, maxUs, recheckMs / 60000UL);
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    if (channelCounts[t] == 0) continue;
+    Serial.printf("  %s:", sensorTypeName(t));
+    for (int i = 0; i < channelCounts[t]; i++) {
+      if (settleUs[t][i] > 0) {
+        Serial.printf(" %u", settleUs[t][i]);
+      } else {
+        Serial.print(" -");
+      }
+    }
+    Serial.println(" us");
+  }
+}
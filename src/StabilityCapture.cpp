@@ -0,0 +1,165 @@
+#include "StabilityCapture.h"
+#include <math.h>
+
+StabilityCapture::StabilityCapture() {
+  criteria.windowSamples = 1;
+  criteria.maxStdev = 0.0;
+  criteria.maxDrift = 0.0;
+  criteria.timeoutMs = 0;
+  sensorType = -1;
+  channel = -1;
+  startedAt = 0;
+  revision = 0;
+  reset();
+}
+
+void StabilityCapture::reset() {
+  state = CAPTURE_IDLE;
+  finishedAt = 0;
+  totalSamples = 0;
+  windows = 0;
+  count = 0;
+  mean = 0.0;
+  m2 = 0.0;
+  windowMean = 0.0;
+  windowStdev = 0.0;
+  drift = 0.0;
+  hasWindow = false;
+}
+
+void StabilityCapture::start(int type, int channelIndex, const CaptureCriteria& captureCriteria, unsigned long now) {
+  reset();
+  sensorType = type;
+  channel = channelIndex;
+  criteria = captureCriteria;
+  if (criteria.windowSamples < 2) criteria.windowSamples = 2;
+  startedAt = now;
+  state = CAPTURE_SAMPLING;
+  revision++;
+}
+
+void StabilityCapture::finish(uint8_t finalState, unsigned long now) {
+  state = finalState;
+  finishedAt = now;
+  revision++;
+}
+
+bool StabilityCapture::add(float value, unsigned long now) {
+  if (state != CAPTURE_SAMPLING) return false;
+
+  // Welford's update of the current window
+  count++;
+  double delta = value - mean;
+  mean += delta / count;
+  m2 += delta * (value - mean);
+  totalSamples++;
+  revision++;
+
+  if (count >= criteria.windowSamples) {
+    float stdev = sqrt(m2 / (count - 1));
+    drift = hasWindow ? fabs(mean - windowMean) : 0.0;
+    bool stable = hasWindow && stdev <= criteria.maxStdev && drift <= criteria.maxDrift;
+
+    windowMean = mean;
+    windowStdev = stdev;
+    hasWindow = true;
+    windows++;
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+
+    if (stable) {
+      finish(CAPTURE_STABLE, now);
+      return true;
+    }
+  }
+  return checkTimeout(now);
+}
+
+bool StabilityCapture::checkTimeout(unsigned long now) {
+  if (state != CAPTURE_SAMPLING || criteria.timeoutMs == 0) return false;
+  if (now - startedAt < criteria.timeoutMs) return false;
+  finish(CAPTURE_TIMED_OUT, now);
+  return true;
+}
+
+void StabilityCapture::cancel(unsigned long now) {
+  if (state == CAPTURE_SAMPLING) {
+    finish(CAPTURE_CANCELLED, now);
+  }
+}
+
+bool StabilityCapture::isActive() const {
+  return state == CAPTURE_SAMPLING;
+}
+
+uint8_t StabilityCapture::getState() const {
+  return state;
+}
+
+int StabilityCapture::getSensorType() const {
+  return sensorType;
+}
+
+int StabilityCapture::getChannel() const {
+  return channel;
+}
+
+const CaptureCriteria& StabilityCapture::getCriteria() const {
+  return criteria;
+}
+
+uint32_t StabilityCapture::getTotalSamples() const {
+  return totalSamples;
+}
+
+uint32_t StabilityCapture::getRevision() const {
+  return revision;
+}
+
+int StabilityCapture::getWindows() const {
+  return windows;
+}
+
+int StabilityCapture::getWindowProgress() const {
+  return count;
+}
+
+float StabilityCapture::getCurrentMean() const {
+  return count > 0 ? mean : windowMean;
+}
+
+float StabilityCapture::getCurrentStdev() const {
+  return count > 1 ? sqrt(m2 / (count - 1)) : windowStdev;
+}
+
+float StabilityCapture::getWindowMean() const {
+  return windowMean;
+}
+
+float StabilityCapture::getWindowStdev() const {
+  return windowStdev;
+}
+
+float StabilityCapture::getDrift() const {
+  return drift;
+}
+
+bool StabilityCapture::hasCompletedWindow() const {
+  return hasWindow;
+}
+
+unsigned long StabilityCapture::getElapsedMs(unsigned long now) const {
+  if (state == CAPTURE_IDLE) return 0;
+  return (state == CAPTURE_SAMPLING ? now : finishedAt) - startedAt;
+}
+
+const char* StabilityCapture::stateName(uint8_t captureState) {
+  switch (captureState) {
+    case CAPTURE_SAMPLING: return "sampling";
+    case CAPTURE_STABLE: return "stable";
+    case CAPTURE_TIMED_OUT: return "timed_out";
+    case CAPTURE_CANCELLED: return "cancelled";
+    default: return "idle";
+  }
+}
@@ -0,0 +1,321 @@
+#include "TlsServer.h"
+#include "mbedtls/error.h"
+#include "mbedtls/net_sockets.h"
+
+// Written against the mbedtls 2.x API bundled with arduino-esp32 2.x
+
+// ECDHE with the P-256 curve for both key types (plus the certificate's own
+// curve for a P-384 or P-521 key); AES-GCM is hardware assisted
+static const int ECDSA_CIPHERSUITES[] = {
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+  0
+};
+
+static const int RSA_CIPHERSUITES[] = {
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+  MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,  // Fallback for clients without ECDHE
+  0
+};
+
+TlsServer::TlsServer() : ready(false), ecdsaKey(false), handshaking(nullptr) {
+  memset(&stats, 0, sizeof(stats));
+  curves[0] = MBEDTLS_ECP_DP_SECP256R1;
+  curves[1] = MBEDTLS_ECP_DP_NONE;
+  curves[2] = MBEDTLS_ECP_DP_NONE;
+  mbedtls_ssl_config_init(&conf);
+  mbedtls_x509_crt_init(&cert);
+  mbedtls_pk_init(&key);
+  mbedtls_entropy_init(&entropy);
+  mbedtls_ctr_drbg_init(&ctrDrbg);
+  mbedtls_ssl_cache_init(&cache);
+  mbedtls_ssl_ticket_init(&ticket);
+}
+
+TlsServer::~TlsServer() {
+  mbedtls_ssl_ticket_free(&ticket);
+  mbedtls_ssl_cache_free(&cache);
+  mbedtls_ctr_drbg_free(&ctrDrbg);
+  mbedtls_entropy_free(&entropy);
+  mbedtls_pk_free(&key);
+  mbedtls_x509_crt_free(&cert);
+  mbedtls_ssl_config_free(&conf);
+}
+
+void TlsServer::logError(const char* what, int ret) {
+  char message[96];
+  mbedtls_strerror(ret, message, sizeof(message));
+  Serial.printf("[TLS] %s failed: -0x%04X %s\n", what, -ret, message);
+}
+
+bool TlsServer::begin(const String& certPEM, const String& keyPEM) {
+  int ret = mbedtls_ctr_drbg_seed(&ctrDrbg, mbedtls_entropy_func, &entropy,
+                                  (const unsigned char*)"aqua_tls", 8);
+  if (ret != 0) {
+    logError("RNG seed", ret);
+    return false;
+  }
+
+  // PEM parsing needs the terminating NUL in the length
+  ret = mbedtls_x509_crt_parse(&cert, (const unsigned char*)certPEM.c_str(), certPEM.length() + 1);
+  if (ret != 0) {
+    logError("Certificate parse", ret);
+    return false;
+  }
+
+  ret = mbedtls_pk_parse_key(&key, (const unsigned char*)keyPEM.c_str(), keyPEM.length() + 1, nullptr, 0);
+  if (ret != 0) {
+    logError("Private key parse", ret);
+    return false;
+  }
+
+  ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_SERVER,
+                                    MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+  if (ret != 0) {
+    logError("SSL config", ret);
+    return false;
+  }
+
+  mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctrDrbg);
+  mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+
+  ret = mbedtls_ssl_conf_own_cert(&conf, &cert, &key);
+  if (ret != 0) {
+    logError("Own certificate", ret);
+    return false;
+  }
+
+  if (!configureCipherSuites()) {
+    return false;
+  }
+
+  // Bounded session-ID cache: oldest entries are evicted once it is full
+  mbedtls_ssl_cache_set_max_entries(&cache, TLS_SESSION_CACHE_SIZE);
+  mbedtls_ssl_cache_set_timeout(&cache, TLS_SESSION_TIMEOUT_S);
+  mbedtls_ssl_conf_session_cache(&conf, this, cacheGet, cacheSet);
+
+  // Session tickets keep the state on the client, so resumption still works
+  // for browsers that have fallen out of the cache
+  ret = mbedtls_ssl_ticket_setup(&ticket, mbedtls_ctr_drbg_random, &ctrDrbg,
+                                 MBEDTLS_CIPHER_AES_256_GCM, TLS_TICKET_LIFETIME_S);
+  if (ret != 0) {
+    logError("Session ticket setup", ret);
+    return false;
+  }
+  mbedtls_ssl_conf_session_tickets_cb(&conf, ticketWrite, ticketParse, this);
+
+  Serial.printf("[TLS] Ready: session cache %d entries, tickets %lu s\n",
+                TLS_SESSION_CACHE_SIZE, (unsigned long)TLS_TICKET_LIFETIME_S);
+  ready = true;
+  return true;
+}
+
+bool TlsServer::configureCipherSuites() {
+  curves[0] = MBEDTLS_ECP_DP_SECP256R1;
+  curves[1] = MBEDTLS_ECP_DP_NONE;
+  if (mbedtls_pk_can_do(&key, MBEDTLS_PK_ECDSA)) {
+    // The certificate's curve must be on the list or every handshake fails
+    mbedtls_ecp_group_id keyCurve = mbedtls_pk_ec(key)->grp.id;
+    if (keyCurve == MBEDTLS_ECP_DP_SECP384R1 || keyCurve == MBEDTLS_ECP_DP_SECP521R1) {
+      curves[1] = keyCurve;
+    } else if (keyCurve != MBEDTLS_ECP_DP_SECP256R1) {
+      const mbedtls_ecp_curve_info* info = mbedtls_ecp_curve_info_from_grp_id(keyCurve);
+      Serial.printf("[TLS] ECDSA key on curve %s not supported, use P-256, P-384 or P-521\n",
+                    info ? info->name : "unknown");
+      return false;
+    }
+    ecdsaKey = true;
+    mbedtls_ssl_conf_ciphersuites(&conf, ECDSA_CIPHERSUITES);
+  } else if (mbedtls_pk_can_do(&key, MBEDTLS_PK_RSA)) {
+    ecdsaKey = false;
+    mbedtls_ssl_conf_ciphersuites(&conf, RSA_CIPHERSUITES);
+  } else {
+    Serial.printf("[TLS] Unsupported key type: %s\n", mbedtls_pk_get_name(&key));
+    return false;
+  }
+  mbedtls_ssl_conf_curves(&conf, curves);
+
+  Serial.printf("[TLS] %s-%u key, %s cipher suites\n", mbedtls_pk_get_name(&key),
+                (unsigned)mbedtls_pk_get_bitlen(&key), ecdsaKey ? "ECDHE-ECDSA" : "ECDHE-RSA");
+  if (!ecdsaKey || curves[1] != MBEDTLS_ECP_DP_NONE) {
+    Serial.println("[TLS] A P-256 ECDSA certificate makes full handshakes much cheaper");
+  }
+  return true;
+}
+
+int TlsServer::cacheGet(void* ctx, mbedtls_ssl_session* session) {
+  TlsServer* self = static_cast<TlsServer*>(ctx);
+  int ret = mbedtls_ssl_cache_get(&self->cache, session);
+  if (ret == 0 && self->handshaking) {
+    self->handshaking->resumed = true;
+  }
+  return ret;
+}
+
+int TlsServer::cacheSet(void* ctx, const mbedtls_ssl_session* session) {
+  TlsServer* self = static_cast<TlsServer*>(ctx);
+  return mbedtls_ssl_cache_set(&self->cache, session);
+}
+
+int TlsServer::ticketWrite(void* ctx, const mbedtls_ssl_session* session, unsigned char* start,
+                           const unsigned char* end, size_t* len, uint32_t* lifetime) {
+  // Both ticket callbacks get the same context, so write needs a wrapper too
+  TlsServer* self = static_cast<TlsServer*>(ctx);
+  return mbedtls_ssl_ticket_write(&self->ticket, session, start, end, len, lifetime);
+}
+
+int TlsServer::ticketParse(void* ctx, mbedtls_ssl_session* session, unsigned char* buf, size_t len) {
+  TlsServer* self = static_cast<TlsServer*>(ctx);
+  int ret = mbedtls_ssl_ticket_parse(&self->ticket, session, buf, len);
+  if (ret == 0 && self->handshaking) {
+    self->handshaking->resumed = true;
+    self->handshaking->ticketUsed = true;
+  }
+  return ret;
+}
+
+void TlsServer::recordHandshake(bool resumed, bool ticket, unsigned long ms, unsigned long cpuUs) {
+  stats.recordHandshake(resumed, ticket, ms, cpuUs);
+}
+
+void TlsServer::recordFailure() {
+  stats.recordFailure();
+}
+
+void TlsServer::addToJson(JsonObject obj) {
+  obj["ready"] = ready;
+  obj["keyType"] = ready ? mbedtls_pk_get_name(&key) : "none";
+  obj["keyBits"] = ready ? (unsigned)mbedtls_pk_get_bitlen(&key) : 0;
+  obj["handshakes"] = stats.handshakes;
+  obj["full"] = stats.fullHandshakes;
+  obj["resumed"] = stats.resumedHandshakes;
+  obj["ticketResumes"] = stats.ticketResumes;
+  obj["failed"] = stats.failedHandshakes;
+  obj["lastMs"] = stats.lastHandshakeMs;
+  obj["avgFullMs"] = stats.averageFullMs();
+  obj["avgResumedMs"] = stats.averageResumedMs();
+  obj["lastCpuMs"] = stats.lastHandshakeCpuUs / 1000.0;
+  obj["avgFullCpuMs"] = stats.averageFullCpuMs();
+  obj["avgResumedCpuMs"] = stats.averageResumedCpuMs();
+  obj["resumeRate"] = stats.resumeRate();
+  obj["cacheSize"] = TLS_SESSION_CACHE_SIZE;
+}
+
+TlsConnection::TlsConnection()
+  : client(nullptr), server(nullptr), active(false), established(false),
+    resumed(false), ticketUsed(false), handshakeStart(0), handshakeCpuUs(0) {}
+
+TlsConnection::~TlsConnection() {
+  stop();
+}
+
+bool TlsConnection::begin(TlsServer& tlsServer, WiFiClient& socket) {
+  stop();
+
+  server = &tlsServer;
+  client = &socket;
+  established = false;
+  resumed = false;
+  ticketUsed = false;
+  handshakeStart = millis();
+  handshakeCpuUs = 0;
+
+  // Record buffers are allocated here and released in stop()
+  mbedtls_ssl_init(&ssl);
+  active = true;
+  int ret = mbedtls_ssl_setup(&ssl, tlsServer.getConfig());
+  if (ret != 0) {
+    TlsServer::logError("SSL setup", ret);
+    stop();
+    return false;
+  }
+  mbedtls_ssl_set_bio(&ssl, this, bioSend, bioRecv, nullptr);
+  return true;
+}
+
+int TlsConnection::handshake(unsigned long now) {
+  if (!active) return -1;
+  if (established) return 1;
+
+  // Wall time includes network round trips; CPU time is only the crypto work
+  server->handshaking = this;
+  unsigned long stepStart = micros();
+  int ret = mbedtls_ssl_handshake(&ssl);
+  handshakeCpuUs += micros() - stepStart;
+  server->handshaking = nullptr;
+
+  if (ret == 0) {
+    established = true;
+    unsigned long ms = now - handshakeStart;
+    server->recordHandshake(resumed, ticketUsed, ms, handshakeCpuUs);
+    Serial.printf("[TLS] %s handshake in %lu ms, CPU %.1f ms (%s)\n",
+                  resumed ? "Resumed" : "Full", ms, handshakeCpuUs / 1000.0,
+                  mbedtls_ssl_get_ciphersuite(&ssl));
+    return 1;
+  }
+
+  if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+    if (now - handshakeStart > TLS_HANDSHAKE_TIMEOUT_MS) {
+      Serial.println("[TLS] Handshake timed out");
+      server->recordFailure();
+      return -1;
+    }
+    return 0;
+  }
+
+  TlsServer::logError("Handshake", ret);
+  server->recordFailure();
+  return -1;
+}
+
+int TlsConnection::read(uint8_t* buf, size_t len) {
+  if (!established) return -1;
+
+  int ret = mbedtls_ssl_read(&ssl, buf, len);
+  if (ret > 0) return ret;
+  if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) return 0;
+  return -1; // Close notify, reset or record error
+}
+
+int TlsConnection::write(const uint8_t* buf, size_t len) {
+  if (!established) return -1;
+
+  int ret = mbedtls_ssl_write(&ssl, buf, len);
+  if (ret >= 0) return ret;
+  if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) return 0;
+  return -1;
+}
+
+void TlsConnection::stop() {
+  if (!active) return;
+
+  if (established) {
+    mbedtls_ssl_close_notify(&ssl);
+  }
+  mbedtls_ssl_free(&ssl);
+  active = false;
+  established = false;
+  client = nullptr;
+}
+
+int TlsConnection::bioSend(void* ctx, const unsigned char* buf, size_t len) {
+  TlsConnection* self = static_cast<TlsConnection*>(ctx);
+  if (!self->client->connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+
+  size_t written = self->client->write(buf, len);
+  return written > 0 ? (int)written : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int TlsConnection::bioRecv(void* ctx, unsigned char* buf, size_t len) {
+  TlsConnection* self = static_cast<TlsConnection*>(ctx);
+  int available = self->client->available();
+  if (available <= 0) {
+    return self->client->connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+  }
+
+  size_t toRead = (size_t)available < len ? available : len;
+  int bytesRead = self->client->read(buf, toRead);
+  return bytesRead > 0 ? bytesRead : MBEDTLS_ERR_SSL_WANT_READ;
+}
@@ -0,0 +1,124 @@
+#include "TrendEstimator.h"
+
+TrendEstimator::TrendEstimator() {
+  configure(DEFAULT_TREND_WINDOW_S);
+  reset();
+}
+
+void TrendEstimator::configure(unsigned long windowSeconds) {
+  if (windowSeconds == 0) windowSeconds = DEFAULT_TREND_WINDOW_S;
+  windowMs = windowSeconds * 1000UL;
+  spacingMs = windowMs / TREND_WINDOW_SAMPLES;
+}
+
+void TrendEstimator::reset() {
+  memset(windows, 0, sizeof(windows));
+}
+
+void TrendEstimator::drop(TrendWindow& window) {
+  float t = window.times[window.oldest];
+  float v = window.values[window.oldest];
+  window.sumT -= t;
+  window.sumV -= v;
+  window.sumTT -= (double)t * t;
+  window.sumTV -= (double)t * v;
+  window.oldest = (window.oldest + 1) % TREND_WINDOW_SAMPLES;
+  window.count--;
+}
+
+void TrendEstimator::rebase(TrendWindow& window) {
+  // Times from the oldest stored reading, and fresh sums
+  float shift = window.count > 0 ? window.times[window.oldest] : 0.0;
+  window.origin += (unsigned long)(shift * 1000.0);
+  window.sumT = window.sumV = window.sumTT = window.sumTV = 0.0;
+  for (int i = 0; i < window.count; i++) {
+    int slot = (window.oldest + i) % TREND_WINDOW_SAMPLES;
+    float t = window.times[slot] - shift;
+    float v = window.values[slot];
+    window.times[slot] = t;
+    window.sumT += t;
+    window.sumV += v;
+    window.sumTT += (double)t * t;
+    window.sumTV += (double)t * v;
+  }
+}
+
+bool TrendEstimator::add(int sensorType, int channel, float value, unsigned long now) {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return false;
+  }
+  TrendWindow& window = windows[sensorType][channel];
+  if (window.count == 0) {
+    window.origin = now;
+  } else if (now - window.lastAdded < spacingMs) {
+    return false;
+  }
+
+  // Age out readings older than the window, and make room in the ring
+  while (window.count > 0 &&
+         now - (window.origin + (unsigned long)(window.times[window.oldest] * 1000.0)) > windowMs) {
+    drop(window);
+  }
+  if (window.count == TREND_WINDOW_SAMPLES) {
+    drop(window);
+  }
+  if (window.count == 0) {
+    window.origin = now;
+    window.sumT = window.sumV = window.sumTT = window.sumTV = 0.0;
+  }
+
+  int slot = (window.oldest + window.count) % TREND_WINDOW_SAMPLES;
+  float t = (now - window.origin) / 1000.0;
+  window.times[slot] = t;
+  window.values[slot] = value;
+  window.count++;
+  window.lastAdded = now;
+  window.sumT += t;
+  window.sumV += value;
+  window.sumTT += (double)t * t;
+  window.sumTV += (double)t * value;
+
+  if (slot == TREND_WINDOW_SAMPLES - 1) {
+    rebase(window);
+  }
+  return true;
+}
+
+bool TrendEstimator::getSlope(int sensorType, int channel, float& perMinute) const {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return false;
+  }
+  const TrendWindow& window = windows[sensorType][channel];
+  if (window.count < TREND_MIN_SAMPLES) return false;
+
+  int newest = (window.oldest + window.count - 1) % TREND_WINDOW_SAMPLES;
+  float span = window.times[newest] - window.times[window.oldest];
+  if (span * 1000.0 < windowMs / 4) return false;
+
+  double n = window.count;
+  double denominator = n * window.sumTT - window.sumT * window.sumT;
+  if (denominator <= 0.0) return false;
+  double perSecond = (n * window.sumTV - window.sumT * window.sumV) / denominator;
+  perMinute = perSecond * 60.0;
+  return true;
+}
+
+int TrendEstimator::getSampleCount(int sensorType, int channel) const {
+  if (sensorType < 0 || sensorType >= SENSOR_TYPE_COUNT || channel < 0 || channel >= MAX_CHANNELS_PER_TYPE) {
+    return 0;
+  }
+  return windows[sensorType][channel].count;
+}
+
+long TrendEstimator::secondsToThreshold(float value, float perMinute, float low, float high) {
+  if (value < low || value > high) return 0;
+  float seconds;
+  if (perMinute > 0.0) {
+    seconds = (high - value) / perMinute * 60.0;
+  } else if (perMinute < 0.0) {
+    seconds = (value - low) / -perMinute * 60.0;
+  } else {
+    return -1;
+  }
+  return seconds <= TREND_MAX_PROJECTION_S ? (long)seconds : -1;
+}
@@ -6,6 +6,8 @@
 #include "AquaWebServer.h"
 #include "CalibrationManager.h"
 #include "IconPolicy.h"
+#include "BootProfiler.h"
+#include "MqttPublisher.h"
 
 // Create global objects
 ConfigManager configMgr;
@@ -13,6 +15,8 @@ SensorController sensors;
 NetworkManager network;
 AquaWebServer webServer;
 CalibrationManager calibrationMgr;
+BootProfiler bootProfiler;
+MqttPublisher mqtt;
 
 // CPU utilization monitoring variables
 unsigned long lastCpuUpdate = 0;
@@ -27,13 +31,38 @@ float getCpuUtilization() {
   return cpuUtilization;
 }
 
+// Boot profiler (accessible from other files)
+BootProfiler& getBootProfiler() {
+  return bootProfiler;
+}
+
+// Network manager (accessible from other files)
+NetworkManager& getNetworkManager() {
+  return network;
+}
+
+// MQTT publisher (accessible from other files)
+MqttPublisher& getMqttPublisher() {
+  return mqtt;
+}
+
 void setup() {
   // Initialize serial communication (using default first, then config)
+  bootProfiler.beginPhase("Serial");
   Serial.begin(DEFAULT_SERIAL_BAUD_RATE);
   
-  // Wait for serial port to connect (useful for debugging)
-  while (!Serial) {
-    ; // Wait for serial port to connect
+  // Load configuration first so fast boot can skip the Serial wait
+  bootProfiler.beginPhase("Config");
+  bool configLoaded = configMgr.begin();
+  bool fastBoot = configMgr.getFastBoot();
+  bootProfiler.setFastBoot(fastBoot);
+  
+  if (!fastBoot) {
+    // Wait for serial port to connect (useful for debugging)
+    bootProfiler.beginPhase("Serial wait");
+    while (!Serial) {
+      ; // Wait for serial port to connect
+    }
   }
   
   // Display NO ICONS policy
@@ -44,9 +73,8 @@ void setup() {
   Serial.println(SAFE_SEPARATOR);
   Serial.println();
   
-  // Load configuration from JSON file
-  Serial.println("Loading configuration...");
-  if (!configMgr.begin()) {
+  // Report configuration load result
+  if (!configLoaded) {
     Serial.println("Warning: Using default configuration (config.json not found)");
   } else {
     configMgr.printConfig();
@@ -64,28 +92,52 @@ void setup() {
   Serial.println("Chip: " + String(ESP.getChipModel()));
   Serial.println("Flash Size: " + String(ESP.getFlashChipSize() / (1024 * 1024)) + " MB");
   Serial.println("Free Heap: " + String(ESP.getFreeHeap()) + " bytes");
+  if (fastBoot) {
+    Serial.println("Boot Mode: FAST (no mux self-test, WiFi connects in background)");
+  }
   Serial.println();
   
   // Initialize sensor controller
+  bootProfiler.beginPhase("Sensors");
   Serial.println("Initializing Sensor Controller...");
-  sensors.begin();
+  sensors.configure(configMgr);
+  sensors.begin(!fastBoot);
   Serial.println("Sensor Controller initialized successfully");
   Serial.println();
   
   // Initialize and connect to WiFi
-  network.begin(&configMgr);
-  Serial.println("Connecting to WiFi...");
-  if (network.connect()) {
-    Serial.println("WiFi connected successfully");
-    network.printConnectionDetails();
+  bootProfiler.beginPhase("WiFi");
+  WiFiSettings wifi;
+  wifi.ssid = configMgr.getWifiSSID();
+  wifi.password = configMgr.getWifiPassword();
+  wifi.backoffMinMs = configMgr.getWifiBackoffMin();
+  wifi.backoffMaxMs = configMgr.getWifiBackoffMax();
+  wifi.connectTimeoutMs = configMgr.getWifiConnectTimeout();
+  network.begin(wifi);
+  if (fastBoot) {
+    // Connection completes in the background, see loop()
+    network.startConnect();
+    Serial.println("WiFi connection started in background");
   } else {
-    Serial.println("WiFi connection failed");
+    Serial.println("Connecting to WiFi...");
+    if (network.connect()) {
+      Serial.println("WiFi connected successfully");
+      network.printConnectionDetails();
+      bootProfiler.markWifiConnected();
+    } else {
+      Serial.println("WiFi connection failed");
+    }
   }
   Serial.println();
   
   // Initialize calibration manager
+  bootProfiler.beginPhase("Calibration");
   Serial.println("Initializing Calibration Manager...");
+  calibrationMgr.setSensorCounts(sensors.getTemperatureSensors().getSensorCount(),
+                                 sensors.getPHSensors().getSensorCount(),
+                                 sensors.getTDSSensors().getSensorCount());
   if (calibrationMgr.begin()) {
+    sensors.setCalibration(&calibrationMgr);
     Serial.println("Calibration Manager initialized successfully");
   } else {
     Serial.println("Warning: Calibration Manager initialization failed");
@@ -93,6 +145,7 @@ void setup() {
   Serial.println();
 
   // Initialize web server
+  bootProfiler.beginPhase("Web server");
   Serial.println("Initializing Web Server...");
   webServer.begin(&sensors, &calibrationMgr, &configMgr);
   Serial.println("Web Server started");
@@ -101,6 +154,13 @@ void setup() {
   Serial.println("Calibration page: http://" + network.getIP() + "/calibration");
   Serial.println();
   
+  // MQTT telemetry (its task connects once WiFi is up)
+  bootProfiler.beginPhase("MQTT");
+  mqtt.begin(&configMgr, &sensors);
+  
+  bootProfiler.markBootComplete();
+  bootProfiler.printReport();
+  
   Serial.println("System Ready! Starting main loop...");
   Serial.println("=========================================");
 }
@@ -108,19 +168,38 @@ void setup() {
 void loop() {
   static unsigned long lastUpdate = 0;
   static unsigned long lastPrint = 0;
+  static bool firstSampleTaken = false;
   
   // CPU utilization monitoring - start timing
   unsigned long loopStartTime = micros();
   
-  int sensorInterval = configMgr.getSensorReadInterval();
+  unsigned long scanInterval = sensors.getScanInterval();  // sensor_read_interval unless sampling is adaptive
   int printInterval = configMgr.getPrintInterval();
   
-  // Update sensor readings every configured interval
-  if (millis() - lastUpdate >= sensorInterval) {
+  // WiFi state machine: connects and reconnects in the background, never blocks sampling
+  if (network.update(millis())) {
+    bootProfiler.markWifiConnected();
+    Serial.println("Access dashboard at: http://" + network.getIP() + "/");
+  }
+  
+  // Update sensor readings every scan interval (first cycle runs immediately);
+  // with adaptive sampling each scan reads only the channels that are due
+  if (!firstSampleTaken || millis() - lastUpdate >= scanInterval) {
     sensors.updateAllReadings();
     lastUpdate = millis();
+    if (!firstSampleTaken) {
+      bootProfiler.markFirstSample();
+      firstSampleTaken = true;
+    }
   }
   
+  // Extra reads of a channel under calibration capture, and its progress events
+  sensors.serviceCapture();
+  webServer.update();
+  
+  // Telemetry and alarm transitions to the broker, queued while it is unreachable
+  mqtt.update(network.getState() == NetworkState::CONNECTED, millis());
+  
   // Print sensor values every configured interval  
   if (millis() - lastPrint >= printInterval) {
     Serial.println();
@@ -149,7 +228,7 @@ void loop() {
     Serial.println("TDS Sensors:");
     for (int i = 0; i < sensors.getTDSSensors().getSensorCount(); i++) {
       float tds = sensors.getTDSSensors().getData().readings[i];
-      float ec = sensors.getTDSSensors().getECReading(i);
+      float ec = sensors.getTDSSensors().getSecondaryReading(i);
       Serial.printf("    TDS%d: %.2f ppm / %.2f uS/cm\n", i + 1, tds, ec);
     }
     
@@ -167,6 +246,7 @@ void loop() {
       Serial.println("    WiFi Disconnected");
       Serial.printf("    Status Code: %d\n", WiFi.status());
     }
+    network.printLinkStats();
     
     // Enhanced system monitoring
     uint32_t freeHeap = ESP.getFreeHeap();
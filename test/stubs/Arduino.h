@@ -0,0 +1,150 @@
+#pragma once
+// Just enough of the Arduino core for the sources built by [env:native]:
+// String, Serial (to stdout), millis()/micros() from the host clock and a
+// few helpers. Not a general emulation; add to it as sources need more.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+typedef uint8_t byte;
+
+#define PI 3.14159265358979323846
+
+using std::min;
+using std::max;
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+inline long random(long low, long high) {
+  return high > low ? low + rand() % (high - low) : low;
+}
+
+inline long random(long high) {
+  return random(0, high);
+}
+
+// Delays do not sleep, they move the clock on: code that waits runs at
+// full speed and still sees the time it asked for pass
+inline unsigned long nativeSkippedUs = 0;
+
+inline unsigned long micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start).count() + nativeSkippedUs;
+}
+
+inline unsigned long millis() {
+  return micros() / 1000;
+}
+
+inline void delay(unsigned long ms) { nativeSkippedUs += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { nativeSkippedUs += us; }
+inline void yield() {}
+
+// GPIO levels and modes are kept per pin, so tests can read back what a
+// driver put on its lines. Register writes (soc/soc.h) land here as well.
+#define INPUT   0x01
+#define OUTPUT  0x03
+#define LOW     0
+#define HIGH    1
+#define NATIVE_GPIO_COUNT 40
+
+struct NativeGpio {
+  uint8_t level[NATIVE_GPIO_COUNT];
+  uint8_t mode[NATIVE_GPIO_COUNT];
+  unsigned long changedAt[NATIVE_GPIO_COUNT];   // micros() of the pin's last level change
+  unsigned long writes;                 // digitalWrite() calls and register writes
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  void drive(uint8_t pin, uint8_t value) {
+    if (pin >= NATIVE_GPIO_COUNT || level[pin] == value) return;
+    level[pin] = value;
+    changedAt[pin] = micros();
+  }
+};
+
+inline NativeGpio nativeGpio;
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < NATIVE_GPIO_COUNT) nativeGpio.mode[pin] = mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+  nativeGpio.drive(pin, value ? HIGH : LOW);
+  nativeGpio.writes++;
+}
+
+inline int digitalRead(uint8_t pin) {
+  return pin < NATIVE_GPIO_COUNT ? nativeGpio.level[pin] : LOW;
+}
+
+// ADC1 channel of a GPIO as on the ESP32 (36-39 -> 0-3, 32-35 -> 4-7);
+// -1 for everything else, ADC2 pins included
+inline int8_t digitalPinToAnalogChannel(uint8_t pin) {
+  if (pin >= 36 && pin <= 39) return pin - 36;
+  if (pin >= 32 && pin <= 35) return pin - 28;
+  return -1;
+}
+
+class String {
+private:
+  std::string text;
+
+public:
+  String() {}
+  String(const char* value) : text(value ? value : "") {}
+  String(const std::string& value) : text(value) {}
+  String(int value) : text(std::to_string(value)) {}
+  String(unsigned value) : text(std::to_string(value)) {}
+  String(long value) : text(std::to_string(value)) {}
+  String(unsigned long value) : text(std::to_string(value)) {}
+
+  unsigned length() const { return text.size(); }
+  bool reserve(unsigned size) { text.reserve(size); return true; }
+  const char* c_str() const { return text.c_str(); }
+  bool isEmpty() const { return text.empty(); }
+  long toInt() const { return atol(text.c_str()); }
+  float toFloat() const { return atof(text.c_str()); }
+
+  String& operator+=(const String& other) { text += other.text; return *this; }
+  bool operator==(const String& other) const { return text == other.text; }
+  bool operator==(const char* other) const { return text == other; }
+  bool operator!=(const String& other) const { return text != other.text; }
+  friend String operator+(const String& a, const String& b) { return String(a.text + b.text); }
+};
+
+class NativeSerial {
+public:
+  void begin(unsigned long) {}
+  size_t print(const char* text) { return fputs(text, stdout); }
+  size_t print(const String& text) { return print(text.c_str()); }
+  size_t println(const char* text = "") { return printf("%s\n", text); }
+  size_t println(const String& text) { return println(text.c_str()); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    int written = vprintf(format, args);
+    va_end(args);
+    return written;
+  }
+};
+
+inline NativeSerial Serial;
+
+// Single core, no scheduler: critical sections have nothing to guard
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED  0
+#define portENTER_CRITICAL(mux)       ((void)(mux))
+#define portEXIT_CRITICAL(mux)        ((void)(mux))
@@ -0,0 +1,72 @@
+#pragma once
+// File-backed stand-in for the ESP32 FS API, rooted in a fresh temporary
+// directory per test run, so SPIFFS users can be tested on the host
+#include <Arduino.h>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Bytes writes may still store before they fail, as on a full partition;
+// -1 for no limit. A write that crosses it stores only what fits.
+inline long nativeFsWriteBudget = -1;
+
+class File {
+private:
+  std::shared_ptr<FILE> handle;
+
+public:
+  File() {}
+  explicit File(FILE* file) : handle(file, [](FILE* f) { fclose(f); }) {}
+
+  explicit operator bool() const { return (bool)handle; }
+  void close() { handle.reset(); }
+  void flush() { fflush(handle.get()); }
+  bool seek(uint32_t position) { return fseek(handle.get(), position, SEEK_SET) == 0; }
+  size_t position() { return ftell(handle.get()); }
+  size_t size() {
+    long at = ftell(handle.get());
+    fseek(handle.get(), 0, SEEK_END);
+    long end = ftell(handle.get());
+    fseek(handle.get(), at, SEEK_SET);
+    return end;
+  }
+  size_t read(uint8_t* data, size_t length) { return fread(data, 1, length, handle.get()); }
+  int read() { return fgetc(handle.get()); }
+  size_t readBytes(char* data, size_t length) { return read((uint8_t*)data, length); }
+  size_t write(const uint8_t* data, size_t length) {
+    if (nativeFsWriteBudget >= 0 && (long)length > nativeFsWriteBudget) length = nativeFsWriteBudget;
+    size_t written = fwrite(data, 1, length, handle.get());
+    if (nativeFsWriteBudget >= 0) nativeFsWriteBudget -= written;
+    return written;
+  }
+  size_t write(uint8_t value) { return write(&value, 1); }
+};
+
+class FS {
+private:
+  std::string root;
+
+  std::string pathOf(const char* path) const { return root + path; }
+
+public:
+  FS() {
+    char directory[] = "/tmp/aqua_fs_XXXXXX";
+    root = mkdtemp(directory) ? directory : ".";
+  }
+
+  bool begin(bool = false) { return true; }
+  File open(const char* path, const char* mode = "r") {
+    // "r+" on a missing file fails, as on SPIFFS
+    std::string binary = std::string(mode) + "b";
+    FILE* file = fopen(pathOf(path).c_str(), binary.c_str());
+    return file ? File(file) : File();
+  }
+  bool exists(const char* path) {
+    struct stat info;
+    return stat(pathOf(path).c_str(), &info) == 0;
+  }
+  bool remove(const char* path) { return ::remove(pathOf(path).c_str()) == 0; }
+  bool rename(const char* from, const char* to) {
+    return ::rename(pathOf(from).c_str(), pathOf(to).c_str()) == 0;
+  }
+};
@@ -0,0 +1,4 @@
+#pragma once
+#include "FS.h"
+
+inline FS SPIFFS;
@@ -0,0 +1,227 @@
+#pragma once
+// A scripted WiFi driver for the sources built by [env:native]. Nothing is
+// transmitted: begin()/disconnect() are recorded for the test to inspect,
+// the access point (BSSID, channel, RSSI) is whatever the test sets, and
+// driver events are raised by the test with fire(). TCP is in memory: a
+// test connects with nativeConnect() and plays the peer through the
+// returned NativeSocket. Not a general emulation; add to it as sources
+// need more.
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class IPAddress {
+private:
+  uint8_t octets[4];
+
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{ a, b, c, d } {}
+
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(text);
+  }
+};
+
+typedef enum { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+typedef enum {
+  WIFI_AUTH_OPEN, WIFI_AUTH_WEP, WIFI_AUTH_WPA_PSK, WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK, WIFI_AUTH_WPA2_ENTERPRISE, WIFI_AUTH_WPA3_PSK
+} wifi_auth_mode_t;
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_START,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP
+} arduino_event_id_t;
+
+typedef union {
+  struct {
+    uint8_t reason;
+  } wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> WiFiEventFuncCb;
+
+inline uint32_t esp_random() {
+  return (uint32_t)rand();
+}
+
+class WiFiClass {
+private:
+  std::vector<WiFiEventFuncCb> handlers;
+
+public:
+  // Access point the next connection reports (BSSID() is null when unset)
+  uint8_t apBssid[6];
+  bool hasBssid;
+  int apChannel;
+  int rssi;
+
+  // What the code under test asked for
+  wifi_mode_t lastMode;
+  int beginCalls;
+  int disconnectCalls;
+  String lastSsid;
+  int lastChannel;              // 0 when begin() was asked to scan
+  uint8_t lastBssid[6];
+  bool lastUsedBssid;
+
+  WiFiClass() { reset(); }
+
+  void reset() {
+    handlers.clear();
+    memset(apBssid, 0, sizeof(apBssid));
+    hasBssid = false;
+    apChannel = 0;
+    rssi = 0;
+    lastMode = WIFI_OFF;
+    beginCalls = 0;
+    disconnectCalls = 0;
+    lastSsid = String();
+    lastChannel = 0;
+    memset(lastBssid, 0, sizeof(lastBssid));
+    lastUsedBssid = false;
+  }
+
+  // Raises a driver event, as the WiFi task would
+  void fire(arduino_event_id_t event, uint8_t reason = 0) {
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.wifi_sta_disconnected.reason = reason;
+    for (auto& handler : handlers) {
+      handler(event, info);
+    }
+  }
+
+  bool mode(wifi_mode_t newMode) { lastMode = newMode; return true; }
+  bool persistent(bool) { return true; }
+  bool setAutoReconnect(bool) { return true; }
+
+  int onEvent(WiFiEventFuncCb handler) {
+    handlers.push_back(handler);
+    return handlers.size();
+  }
+
+  int begin(const char* ssid, const char* password, int32_t channel = 0, const uint8_t* bssid = nullptr) {
+    beginCalls++;
+    lastSsid = ssid;
+    lastChannel = channel;
+    lastUsedBssid = bssid != nullptr;
+    if (bssid) memcpy(lastBssid, bssid, sizeof(lastBssid));
+    return 0;
+  }
+
+  bool disconnect() { disconnectCalls++; return true; }
+
+  uint8_t* BSSID() { return hasBssid ? apBssid : nullptr; }
+  int channel() { return apChannel; }
+  int RSSI() { return rssi; }
+  String macAddress() { return String("24:0A:C4:00:00:01"); }
+  int encryptionType(uint8_t) { return WIFI_AUTH_WPA2_PSK; }
+
+  IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+  IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+  IPAddress dnsIP() { return IPAddress(192, 168, 1, 1); }
+  IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+};
+
+inline WiFiClass WiFi;
+
+// One TCP connection. The peer side is driven by the test; WiFiClient is
+// the device side. Writes stop once 'sendWindow' bytes wait unread, as
+// with a client that has stopped reading.
+struct NativeSocket {
+  std::string toDevice;         // Sent by the peer, not yet read by the device
+  std::string toPeer;           // Written by the device, not yet read by the peer
+  size_t sendWindow = 5744;     // lwIP's default TCP send buffer
+  bool peerOpen = true;
+  bool deviceOpen = true;
+
+  void send(const std::string& data) { toDevice += data; }
+  void close() { peerOpen = false; }
+
+  // Everything the device has written since the last call
+  std::string receive() {
+    std::string data;
+    data.swap(toPeer);
+    return data;
+  }
+};
+
+inline std::map<uint16_t, std::deque<std::shared_ptr<NativeSocket>>> nativeBacklog;
+
+// Opens a connection to a listening port; WiFiServer::available() hands it over
+inline std::shared_ptr<NativeSocket> nativeConnect(uint16_t port) {
+  std::shared_ptr<NativeSocket> socket = std::make_shared<NativeSocket>();
+  nativeBacklog[port].push_back(socket);
+  return socket;
+}
+
+class WiFiClient {
+private:
+  std::shared_ptr<NativeSocket> socket;
+
+public:
+  WiFiClient() {}
+  explicit WiFiClient(std::shared_ptr<NativeSocket> accepted) : socket(accepted) {}
+
+  operator bool() const { return socket != nullptr; }
+
+  uint8_t connected() {
+    return socket && socket->deviceOpen && socket->peerOpen;
+  }
+
+  int available() {
+    return socket && socket->deviceOpen ? socket->toDevice.size() : 0;
+  }
+
+  int read(uint8_t* buf, size_t len) {
+    if (!socket || !socket->deviceOpen) return -1;
+    size_t count = min(len, socket->toDevice.size());
+    memcpy(buf, socket->toDevice.data(), count);
+    socket->toDevice.erase(0, count);
+    return count;
+  }
+
+  size_t write(const uint8_t* buf, size_t len) {
+    if (!connected() || socket->toPeer.size() >= socket->sendWindow) return 0;
+    size_t count = min(len, socket->sendWindow - socket->toPeer.size());
+    socket->toPeer.append((const char*)buf, count);
+    return count;
+  }
+
+  void stop() {
+    if (socket) socket->deviceOpen = false;
+    socket.reset();
+  }
+
+  int setNoDelay(bool) { return 0; }
+};
+
+class WiFiServer {
+private:
+  uint16_t port;
+  bool listening;
+
+public:
+  WiFiServer(uint16_t listenPort = 80, uint8_t = 4) : port(listenPort), listening(false) {}
+
+  void begin() { listening = true; }
+
+  WiFiClient available() {
+    std::deque<std::shared_ptr<NativeSocket>>& backlog = nativeBacklog[port];
+    if (!listening || backlog.empty()) return WiFiClient();
+    std::shared_ptr<NativeSocket> socket = backlog.front();
+    backlog.pop_front();
+    return WiFiClient(socket);
+  }
+};
@@ -0,0 +1,4 @@
+#pragma once
+// GPIO output set/clear registers for pins 0-31 (ESP32 TRM addresses)
+#define GPIO_OUT_W1TS_REG  0x3FF44008
+#define GPIO_OUT_W1TC_REG  0x3FF4400C
@@ -0,0 +1,17 @@
+#pragma once
+// REG_WRITE on the GPIO set/clear registers drives the pins of nativeGpio
+// (Arduino.h); writes to any other register are ignored
+#include <Arduino.h>
+#include "soc/gpio_reg.h"
+
+inline void nativeRegWrite(uint32_t reg, uint32_t value) {
+  if (reg != GPIO_OUT_W1TS_REG && reg != GPIO_OUT_W1TC_REG) return;
+  for (int pin = 0; pin < 32; pin++) {
+    if (value & (1UL << pin)) {
+      nativeGpio.drive(pin, (reg == GPIO_OUT_W1TS_REG) ? HIGH : LOW);
+    }
+  }
+  nativeGpio.writes++;
+}
+
+#define REG_WRITE(reg, value)  nativeRegWrite((reg), (value))
@@ -0,0 +1,114 @@
+#include <unity.h>
+#include <chrono>
+#include "AdcBackend.h"
+
+static const uint16_t tempTrace[] = { 100, 200, 300 };
+static const uint16_t phTrace[] = { 4095 };
+
+static ReplayAdcBackend* adc;
+
+void setUp() {
+  adc = new ReplayAdcBackend();
+  adc->addTrace(TEMP_ADC_PIN, tempTrace, 3);
+  adc->addTrace(PH_ADC_PIN, phTrace, 1);
+  adc->begin();
+}
+
+void tearDown() {
+  delete adc;
+}
+
+// The table matches the old (raw / 4095.0) * 3.3 formula, rounded to 1 mV
+void test_linear_table_matches_the_old_formula() {
+  for (int raw = 0; raw < ADC_LUT_SIZE; raw++) {
+    float volts = (raw / 4095.0) * 3.3;
+    TEST_ASSERT_FLOAT_WITHIN(0.0005, volts, adc->toMillivolts(raw) * 0.001);
+  }
+  TEST_ASSERT_EQUAL_UINT16(0, adc->toMillivolts(0));
+  TEST_ASSERT_EQUAL_UINT16(1000, adc->toMillivolts(1241));
+  TEST_ASSERT_EQUAL_UINT16(3300, adc->toMillivolts(4095));
+}
+
+void test_codes_outside_12_bits_stay_in_the_table() {
+  TEST_ASSERT_EQUAL_UINT16(adc->toMillivolts(5), adc->toMillivolts(ADC_LUT_SIZE + 5));
+}
+
+void test_traces_replay_in_order_and_wrap() {
+  TEST_ASSERT_EQUAL_INT(100, adc->readRaw(TEMP_ADC_PIN));
+  TEST_ASSERT_EQUAL_INT(200, adc->readRaw(TEMP_ADC_PIN));
+  TEST_ASSERT_EQUAL_INT(4095, adc->readRaw(PH_ADC_PIN));
+  TEST_ASSERT_EQUAL_INT(300, adc->readRaw(TEMP_ADC_PIN));
+  TEST_ASSERT_EQUAL_INT(100, adc->readRaw(TEMP_ADC_PIN));
+  TEST_ASSERT_EQUAL_INT(0, adc->readRaw(TDS_ADC_PIN));   // No trace
+
+  adc->rewind();
+  TEST_ASSERT_EQUAL_INT(100, adc->readRaw(TEMP_ADC_PIN));
+}
+
+void test_trace_limit_and_empty_traces() {
+  TEST_ASSERT_FALSE(adc->addTrace(TDS_ADC_PIN, tempTrace, 0));
+  TEST_ASSERT_FALSE(adc->addTrace(TDS_ADC_PIN, nullptr, 3));
+  for (int i = 2; i < MAX_REPLAY_TRACES; i++) {
+    TEST_ASSERT_TRUE(adc->addTrace(TDS_ADC_PIN, tempTrace, 3));
+  }
+  TEST_ASSERT_FALSE(adc->addTrace(TDS_ADC_PIN, tempTrace, 3));
+}
+
+// The default readSamples() takes blocking reads sampleDelayMs apart
+void test_default_read_samples_spaces_the_reads() {
+  uint16_t raw[5];
+  unsigned long start = micros();
+  TEST_ASSERT_EQUAL_INT(5, adc->readSamples(TEMP_ADC_PIN, raw, 5, 2));
+  TEST_ASSERT_GREATER_OR_EQUAL(5 * 2000, micros() - start);
+  TEST_ASSERT_EQUAL_UINT16(100, raw[0]);
+  TEST_ASSERT_EQUAL_UINT16(300, raw[2]);
+  TEST_ASSERT_EQUAL_UINT16(200, raw[4]);
+}
+
+// Per-sample cost of the table lookup against the old double-precision
+// formula over a pseudo-random stream of codes. Host numbers only: the
+// ESP32's FPU is single precision, so there the formula runs in software
+// and the gap is wider. The two sums must agree to the table's rounding.
+void test_lut_against_formula_benchmark() {
+  const int samples = 1 << 20;
+  static uint16_t codes[samples];
+  uint32_t seed = 12345;
+  for (int i = 0; i < samples; i++) {
+    seed = seed * 1664525 + 1013904223;
+    codes[i] = (seed >> 16) & (ADC_LUT_SIZE - 1);
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint32_t lutSum = 0;
+  for (int i = 0; i < samples; i++) {
+    lutSum += adc->toMillivolts(codes[i]);
+  }
+  std::chrono::nanoseconds lutTime = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  double formulaSum = 0;
+  for (int i = 0; i < samples; i++) {
+    formulaSum += (codes[i] / 4095.0) * 3.3;
+  }
+  std::chrono::nanoseconds formulaTime = std::chrono::steady_clock::now() - start;
+
+  double lutNs = (double)lutTime.count() / samples;
+  double formulaNs = (double)formulaTime.count() / samples;
+  char message[128];
+  snprintf(message, sizeof(message), "Per sample: LUT %.2f ns, (raw/4095.0)*3.3 %.2f ns (%.1fx)",
+           lutNs, formulaNs, formulaNs / lutNs);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.0005 * samples, formulaSum, lutSum * 0.001);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_linear_table_matches_the_old_formula);
+  RUN_TEST(test_codes_outside_12_bits_stay_in_the_table);
+  RUN_TEST(test_traces_replay_in_order_and_wrap);
+  RUN_TEST(test_trace_limit_and_empty_traces);
+  RUN_TEST(test_default_read_samples_spaces_the_reads);
+  RUN_TEST(test_lut_against_formula_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+#include <unity.h>
+#include "AdcDmaSampler.h"
+
+// ADC1 channels of the default sensor pins
+#define TEMP_CHANNEL  4   // GPIO32
+#define PH_CHANNEL    5   // GPIO33
+
+static SimulatedAdcProducer* producer;
+static AdcDmaSampler* sampler;
+
+void setUp() {
+  producer = new SimulatedAdcProducer(1);
+  producer->setLevel(TEMP_CHANNEL, 1000);
+  producer->setLevel(PH_CHANNEL, 2000);
+  sampler = new AdcDmaSampler();
+  TEST_ASSERT_TRUE(sampler->begin(producer));
+}
+
+void tearDown() {
+  delete sampler;
+  delete producer;
+}
+
+static void assertWindow(int pin, uint16_t level, int count) {
+  uint16_t raw[ADC_DMA_MAX_WINDOW];
+  TEST_ASSERT_EQUAL_INT(count, sampler->takeWindow(pin, raw, count));
+  for (int i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT16(level, raw[i]);
+  }
+}
+
+void test_window_comes_from_the_selected_pin() {
+  assertWindow(TEMP_ADC_PIN, 1000, 10);
+  assertWindow(PH_ADC_PIN, 2000, 10);
+  assertWindow(TEMP_ADC_PIN, 1000, ADC_DMA_MAX_WINDOW);
+}
+
+// After a switch the producer still delivers a buffer tagged with the old
+// channel; none of it may reach the window
+void test_stale_buffers_after_a_switch_are_dropped() {
+  delete producer;
+  producer = new SimulatedAdcProducer(3);
+  producer->setLevel(TEMP_CHANNEL, 1000);
+  producer->setLevel(PH_CHANNEL, 2000);
+  delete sampler;
+  sampler = new AdcDmaSampler();
+  sampler->begin(producer);
+
+  assertWindow(TEMP_ADC_PIN, 1000, 10);
+  assertWindow(PH_ADC_PIN, 2000, 10);
+}
+
+// Samples queued before the window was asked for are flushed, not averaged
+void test_queued_samples_are_flushed() {
+  uint16_t old[ADC_DMA_BUFFER_LEN];
+  for (int i = 0; i < ADC_DMA_BUFFER_LEN; i++) {
+    old[i] = (TEMP_CHANNEL << ADC_DMA_TAG_SHIFT) | 4000;
+  }
+  sampler->selectPin(TEMP_ADC_PIN);
+  sampler->feedFrame(old, ADC_DMA_BUFFER_LEN);
+  assertWindow(TEMP_ADC_PIN, 1000, 10);
+}
+
+void test_window_is_capped() {
+  uint16_t raw[ADC_DMA_MAX_WINDOW + 8];
+  TEST_ASSERT_EQUAL_INT(ADC_DMA_MAX_WINDOW, sampler->takeWindow(TEMP_ADC_PIN, raw, ADC_DMA_MAX_WINDOW + 8));
+}
+
+void test_pins_off_adc1_give_nothing() {
+  uint16_t raw[4];
+  TEST_ASSERT_FALSE(sampler->selectPin(MUX_S0));
+  TEST_ASSERT_EQUAL_INT(0, sampler->takeWindow(MUX_S0, raw, 4));
+}
+
+void test_nothing_before_begin() {
+  AdcDmaSampler idle;
+  uint16_t raw[4];
+  TEST_ASSERT_FALSE(idle.isRunning());
+  TEST_ASSERT_EQUAL_INT(0, idle.takeWindow(TEMP_ADC_PIN, raw, 4));
+}
+
+void test_overrun_keeps_the_newest_samples() {
+  uint16_t frame[ADC_DMA_BUFFER_LEN];
+  for (int f = 0; f < ADC_DMA_RING_SIZE / ADC_DMA_BUFFER_LEN + 2; f++) {
+    for (int i = 0; i < ADC_DMA_BUFFER_LEN; i++) {
+      frame[i] = (TEMP_CHANNEL << ADC_DMA_TAG_SHIFT) | f;
+    }
+    sampler->feedFrame(frame, ADC_DMA_BUFFER_LEN);
+  }
+  TEST_ASSERT_EQUAL_INT(ADC_DMA_RING_SIZE, sampler->available());
+}
+
+void test_noise_stays_within_its_span() {
+  delete producer;
+  producer = new SimulatedAdcProducer(0, 3);
+  producer->setLevel(TEMP_CHANNEL, 1000);
+  delete sampler;
+  sampler = new AdcDmaSampler();
+  sampler->begin(producer);
+
+  uint16_t raw[32];
+  TEST_ASSERT_EQUAL_INT(32, sampler->takeWindow(TEMP_ADC_PIN, raw, 32));
+  long sum = 0;
+  for (int i = 0; i < 32; i++) {
+    TEST_ASSERT_UINT16_WITHIN(3, 1000, raw[i]);
+    sum += raw[i];
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1.0, 1000.0, sum / 32.0);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_window_comes_from_the_selected_pin);
+  RUN_TEST(test_stale_buffers_after_a_switch_are_dropped);
+  RUN_TEST(test_queued_samples_are_flushed);
+  RUN_TEST(test_window_is_capped);
+  RUN_TEST(test_pins_off_adc1_give_nothing);
+  RUN_TEST(test_nothing_before_begin);
+  RUN_TEST(test_overrun_keeps_the_newest_samples);
+  RUN_TEST(test_noise_stays_within_its_span);
+  return UNITY_END();
+}
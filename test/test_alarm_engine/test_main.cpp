@@ -0,0 +1,189 @@
+#include <unity.h>
+#include "AlarmEngine.h"
+
+static AlarmEngine* alarms;
+
+static const AlarmStatus& phStatus() {
+  return alarms->getStatus(alarms->findRule(SENSOR_PH, 0));
+}
+
+// pH channel 0 of aquarium 2: 6.5..8.0, cleared 0.1 back inside
+static void addPhRule(unsigned long raiseDelayMs, unsigned long clearDelayMs) {
+  TEST_ASSERT_TRUE(alarms->addRule(SENSOR_PH, 0, 2, 6.5, 8.0, 0.1, raiseDelayMs, clearDelayMs));
+}
+
+void setUp() {
+  alarms = new AlarmEngine();
+}
+
+void tearDown() {
+  delete alarms;
+}
+
+void test_channel_without_a_rule_is_ignored() {
+  TEST_ASSERT_EQUAL_INT(NO_ALARM_RULE, alarms->findRule(SENSOR_PH, 0));
+  alarms->evaluate(SENSOR_PH, 0, 99.0, 0);
+  TEST_ASSERT_EQUAL_UINT32(0, alarms->getEvaluations());
+  TEST_ASSERT_FALSE(alarms->addRule(SENSOR_PH, 0, 0, 8.0, 8.0, 0.1, 0, 0));   // Empty range
+  TEST_ASSERT_FALSE(alarms->addRule(SENSOR_PH, MAX_CHANNELS_PER_TYPE, 0, 6.5, 8.0, 0.1, 0, 0));
+  TEST_ASSERT_EQUAL_INT(0, alarms->getRuleCount());
+}
+
+void test_raises_and_clears_at_once_without_delays() {
+  addPhRule(0, 0);
+  alarms->evaluate(SENSOR_PH, 0, 8.3, 1000);
+  TEST_ASSERT_EQUAL_INT(ALARM_ACTIVE, phStatus().state);
+  TEST_ASSERT_EQUAL_INT(ALARM_SIDE_HIGH, phStatus().side);
+  TEST_ASSERT_EQUAL_INT(1, alarms->getActiveCount());
+  TEST_ASSERT_TRUE(alarms->isAquariumInAlarm(2));
+  TEST_ASSERT_FALSE(alarms->isAquariumInAlarm(0));
+
+  alarms->evaluate(SENSOR_PH, 0, 7.2, 2000);
+  TEST_ASSERT_EQUAL_INT(ALARM_NORMAL, phStatus().state);
+  TEST_ASSERT_EQUAL_UINT32(2000, phStatus().clearedAt);
+  TEST_ASSERT_EQUAL_INT(0, alarms->getActiveCount());
+  TEST_ASSERT_EQUAL_UINT32(2, alarms->getLastSequence());
+}
+
+void test_raise_waits_out_its_delay() {
+  addPhRule(10000, 0);
+  alarms->evaluate(SENSOR_PH, 0, 6.2, 0);
+  TEST_ASSERT_EQUAL_INT(ALARM_PENDING, phStatus().state);
+  TEST_ASSERT_EQUAL_INT(ALARM_SIDE_LOW, phStatus().side);
+  alarms->evaluate(SENSOR_PH, 0, 6.2, 9999);   // Same value, but the delay is running
+  TEST_ASSERT_EQUAL_INT(ALARM_PENDING, phStatus().state);
+  alarms->evaluate(SENSOR_PH, 0, 6.2, 10000);
+  TEST_ASSERT_EQUAL_INT(ALARM_ACTIVE, phStatus().state);
+  TEST_ASSERT_EQUAL_UINT32(10000, phStatus().raisedAt);
+  TEST_ASSERT_EQUAL_UINT32(1, phStatus().raiseCount);
+}
+
+// A blip shorter than the raise delay never becomes an alarm
+void test_short_excursion_is_not_raised() {
+  addPhRule(10000, 0);
+  alarms->evaluate(SENSOR_PH, 0, 8.4, 0);
+  alarms->evaluate(SENSOR_PH, 0, 7.5, 5000);
+  TEST_ASSERT_EQUAL_INT(ALARM_NORMAL, phStatus().state);
+  alarms->evaluate(SENSOR_PH, 0, 8.4, 6000);
+  alarms->evaluate(SENSOR_PH, 0, 8.4, 15000);   // 9 s since this excursion began
+  TEST_ASSERT_EQUAL_INT(ALARM_PENDING, phStatus().state);
+  TEST_ASSERT_EQUAL_UINT32(0, alarms->getLastSequence());
+}
+
+// Back inside the range but not past the hysteresis band: still active
+void test_clear_needs_the_hysteresis_band_and_delay() {
+  addPhRule(0, 30000);
+  alarms->evaluate(SENSOR_PH, 0, 8.2, 0);
+  alarms->evaluate(SENSOR_PH, 0, 7.95, 1000);
+  TEST_ASSERT_EQUAL_INT(ALARM_ACTIVE, phStatus().state);
+  TEST_ASSERT_TRUE(phStatus().inRange);
+
+  alarms->evaluate(SENSOR_PH, 0, 7.85, 2000);
+  TEST_ASSERT_EQUAL_INT(ALARM_CLEARING, phStatus().state);
+  TEST_ASSERT_TRUE(alarms->isAquariumInAlarm(2));
+  alarms->evaluate(SENSOR_PH, 0, 7.85, 31999);
+  TEST_ASSERT_EQUAL_INT(ALARM_CLEARING, phStatus().state);
+  alarms->evaluate(SENSOR_PH, 0, 7.85, 32000);
+  TEST_ASSERT_EQUAL_INT(ALARM_NORMAL, phStatus().state);
+  TEST_ASSERT_EQUAL_INT(ALARM_SIDE_NONE, phStatus().side);
+}
+
+// Leaving the band while clearing resumes the same alarm
+void test_clearing_falls_back_to_the_same_alarm() {
+  addPhRule(0, 30000);
+  alarms->evaluate(SENSOR_PH, 0, 8.2, 0);
+  alarms->evaluate(SENSOR_PH, 0, 7.5, 1000);
+  alarms->evaluate(SENSOR_PH, 0, 6.3, 2000);   // Out the other side
+  TEST_ASSERT_EQUAL_INT(ALARM_ACTIVE, phStatus().state);
+  TEST_ASSERT_EQUAL_INT(ALARM_SIDE_LOW, phStatus().side);
+  TEST_ASSERT_EQUAL_UINT32(0, phStatus().since);
+  TEST_ASSERT_EQUAL_UINT32(1, phStatus().raiseCount);
+  TEST_ASSERT_EQUAL_INT(1, alarms->getActiveCount());
+  TEST_ASSERT_EQUAL_UINT32(1, alarms->getLastSequence());
+}
+
+// The band is capped at 45% of the range width so an alarm can always clear
+void test_hysteresis_is_capped() {
+  TEST_ASSERT_TRUE(alarms->addRule(SENSOR_TDS, 1, 0, 100, 300, 500, 0, 0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 90.0, alarms->getRule(alarms->findRule(SENSOR_TDS, 1)).hysteresis);
+  alarms->evaluate(SENSOR_TDS, 1, 400, 0);
+  alarms->evaluate(SENSOR_TDS, 1, 200, 1000);
+  TEST_ASSERT_EQUAL_INT(ALARM_NORMAL, alarms->getStatus(alarms->findRule(SENSOR_TDS, 1)).state);
+}
+
+// An unchanged value on a settled rule costs no evaluation
+void test_unchanged_values_are_skipped() {
+  addPhRule(0, 0);
+  for (int i = 0; i < 5; i++) {
+    alarms->evaluate(SENSOR_PH, 0, 7.2, i * 1000);
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, alarms->getEvaluations());
+  alarms->evaluate(SENSOR_PH, 0, 7.3, 6000);
+  TEST_ASSERT_EQUAL_UINT32(2, alarms->getEvaluations());
+}
+
+void test_rate_rule_is_separate_from_the_range() {
+  addPhRule(0, 0);
+  TEST_ASSERT_FALSE(alarms->addRateRule(SENSOR_PH, 0, 2, 0.0, 0.0, 0, 0));   // Off
+  TEST_ASSERT_TRUE(alarms->addRateRule(SENSOR_PH, 0, 2, 0.5, 0.1, 0, 0));
+  int rateRule = alarms->findRule(SENSOR_PH, 0, ALARM_RATE);
+  TEST_ASSERT_NOT_EQUAL(alarms->findRule(SENSOR_PH, 0), rateRule);
+  TEST_ASSERT_EQUAL_FLOAT(-0.5, alarms->getRule(rateRule).low);
+
+  alarms->evaluateRate(SENSOR_PH, 0, -0.7, 0);
+  TEST_ASSERT_EQUAL_INT(ALARM_ACTIVE, alarms->getStatus(rateRule).state);
+  TEST_ASSERT_EQUAL_INT(ALARM_SIDE_LOW, alarms->getStatus(rateRule).side);
+  TEST_ASSERT_EQUAL_INT(ALARM_NORMAL, phStatus().state);
+
+  alarms->evaluateRate(SENSOR_PH, 0, -0.45, 1000);   // Inside the 0.1 band
+  TEST_ASSERT_EQUAL_INT(ALARM_ACTIVE, alarms->getStatus(rateRule).state);
+  alarms->evaluateRate(SENSOR_PH, 0, -0.3, 2000);
+  TEST_ASSERT_EQUAL_INT(ALARM_NORMAL, alarms->getStatus(rateRule).state);
+}
+
+// The ring keeps the last ALARM_EVENT_LOG raises and clears
+void test_event_log_keeps_the_newest() {
+  addPhRule(0, 0);
+  int transitions = ALARM_EVENT_LOG + 4;
+  for (int i = 0; i < transitions; i++) {
+    alarms->evaluate(SENSOR_PH, 0, (i % 2 == 0) ? 8.5 + i * 0.01 : 7.2, i * 1000);
+  }
+  TEST_ASSERT_EQUAL_UINT32(transitions, alarms->getLastSequence());
+
+  AlarmEvent events[ALARM_EVENT_LOG + 4];
+  int count = alarms->getEventsSince(0, events, ALARM_EVENT_LOG + 4);
+  TEST_ASSERT_EQUAL_INT(ALARM_EVENT_LOG, count);
+  TEST_ASSERT_EQUAL_UINT32(transitions - ALARM_EVENT_LOG + 1, events[0].sequence);
+  TEST_ASSERT_EQUAL_UINT32(transitions, events[count - 1].sequence);
+  TEST_ASSERT_EQUAL_INT(ALARM_NORMAL, events[count - 1].state);
+
+  count = alarms->getEventsSince(transitions - 2, events, ALARM_EVENT_LOG);
+  TEST_ASSERT_EQUAL_INT(2, count);
+  TEST_ASSERT_EQUAL_INT(ALARM_ACTIVE, events[0].state);
+  TEST_ASSERT_EQUAL_INT(ALARM_SIDE_HIGH, events[0].side);
+  TEST_ASSERT_EQUAL_INT(1, alarms->getEventsSince(0, events, 1));
+  TEST_ASSERT_EQUAL_INT(0, alarms->getEventsSince(transitions, events, ALARM_EVENT_LOG));
+}
+
+void test_names() {
+  TEST_ASSERT_EQUAL_STRING("clearing", AlarmEngine::stateName(ALARM_CLEARING));
+  TEST_ASSERT_EQUAL_STRING("low", AlarmEngine::sideName(ALARM_SIDE_LOW));
+  TEST_ASSERT_EQUAL_STRING("rate", AlarmEngine::kindName(ALARM_RATE));
+  TEST_ASSERT_EQUAL_STRING("range", AlarmEngine::kindName(ALARM_RANGE));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_channel_without_a_rule_is_ignored);
+  RUN_TEST(test_raises_and_clears_at_once_without_delays);
+  RUN_TEST(test_raise_waits_out_its_delay);
+  RUN_TEST(test_short_excursion_is_not_raised);
+  RUN_TEST(test_clear_needs_the_hysteresis_band_and_delay);
+  RUN_TEST(test_clearing_falls_back_to_the_same_alarm);
+  RUN_TEST(test_hysteresis_is_capped);
+  RUN_TEST(test_unchanged_values_are_skipped);
+  RUN_TEST(test_rate_rule_is_separate_from_the_range);
+  RUN_TEST(test_event_log_keeps_the_newest);
+  RUN_TEST(test_names);
+  return UNITY_END();
+}
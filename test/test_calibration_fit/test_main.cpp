@@ -0,0 +1,146 @@
+#include <unity.h>
+#include "CalibrationFit.h"
+
+static CalibrationPoint points[CAL_MAX_POINTS];
+static int pointCount;
+static CalibrationCurve curve;
+
+static void addPoint(float raw, float actual, bool valid = true) {
+  CalibrationPoint& point = points[pointCount++];
+  point.rawValue = raw;
+  point.actualValue = actual;
+  point.temperature = 25.0;
+  point.valid = valid;
+}
+
+void setUp() {
+  memset(points, 0, sizeof(points));
+  pointCount = 0;
+}
+
+void tearDown() {}
+
+void test_two_point_line_is_exact() {
+  addPoint(2.0, 4.01);
+  addPoint(1.5, 6.86);
+  TEST_ASSERT_TRUE(CalibrationFit::fit(CURVE_LINEAR, points, pointCount, curve));
+  TEST_ASSERT_EQUAL_INT(CURVE_LINEAR, curve.type);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, -5.7, curve.getSlope());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 4.01, curve.evaluate(2.0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 6.86, curve.evaluate(1.5));
+}
+
+// Three buffers that do not sit on one line: the least-squares line
+void test_linear_fit_is_least_squares() {
+  addPoint(1.0, 1.0);
+  addPoint(2.0, 2.0);
+  addPoint(3.0, 2.0);
+  TEST_ASSERT_TRUE(CalibrationFit::fit(CURVE_LINEAR, points, pointCount, curve));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.5, curve.getSlope());
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.0 / 3.0, curve.getOffset());
+
+  CalibrationFitQuality fit = CalibrationFit::quality(curve, points, pointCount);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 0.75, fit.r2);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 1.0 / 3.0, fit.maxResidual);
+  TEST_ASSERT_TRUE(fit.rmsResidual > 0.0 && fit.rmsResidual <= fit.maxResidual);
+}
+
+void test_piecewise_goes_through_every_point() {
+  addPoint(3000, 12880);   // Out of order on purpose
+  addPoint(100, 84);
+  addPoint(900, 1413);
+  TEST_ASSERT_TRUE(CalibrationFit::fit(CURVE_PIECEWISE, points, pointCount, curve));
+  TEST_ASSERT_EQUAL_INT(2, curve.segments);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 84, curve.evaluate(100));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 1413, curve.evaluate(900));
+  TEST_ASSERT_FLOAT_WITHIN(0.1, 12880, curve.evaluate(3000));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, (84 + 1413) / 2.0, curve.evaluate(500));
+
+  // Outside the points the end segments carry on
+  float slope = (1413 - 84) / 800.0;
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 84 - 100 * slope, curve.evaluate(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, slope, curve.getSlope());
+
+  CalibrationFitQuality fit = CalibrationFit::quality(curve, points, pointCount);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0, fit.r2);
+}
+
+// Raw values in the hundreds, as the TDS probe gives them, still recover
+// the cubic they were taken from
+void test_polynomial_recovers_a_cubic() {
+  for (int i = 0; i < 4; i++) {
+    double x = 500.0 + 400.0 * i;
+    addPoint(x, 2.0 + 0.5 * x + 1e-4 * x * x + 2e-8 * x * x * x);
+  }
+  TEST_ASSERT_TRUE(CalibrationFit::fit(CURVE_POLYNOMIAL, points, pointCount, curve));
+  TEST_ASSERT_EQUAL_INT(CURVE_POLYNOMIAL, curve.type);
+  TEST_ASSERT_EQUAL_INT(3, curve.order);
+  for (int i = 0; i < pointCount; i++) {
+    TEST_ASSERT_FLOAT_WITHIN(points[i].actualValue * 1e-4, points[i].actualValue, curve.evaluate(points[i].rawValue));
+  }
+}
+
+// Order follows the distinct points, capped at CAL_MAX_POLY_ORDER
+void test_polynomial_order_follows_the_points() {
+  addPoint(1, 1);
+  addPoint(2, 4);
+  addPoint(3, 9);
+  TEST_ASSERT_TRUE(CalibrationFit::fit(CURVE_POLYNOMIAL, points, pointCount, curve));
+  TEST_ASSERT_EQUAL_INT(2, curve.order);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 16.0, curve.evaluate(4));
+
+  addPoint(4, 16);
+  addPoint(5, 25);
+  TEST_ASSERT_TRUE(CalibrationFit::fit(CURVE_POLYNOMIAL, points, pointCount, curve));
+  TEST_ASSERT_EQUAL_INT(CAL_MAX_POLY_ORDER, curve.order);
+}
+
+void test_repeated_and_invalid_points() {
+  addPoint(1.0, 4.0);
+  addPoint(1.0, 6.0);            // Same raw value: averaged to 5
+  addPoint(9.0, 100.0, false);   // Not captured
+  addPoint(2.0, 7.0);
+  TEST_ASSERT_TRUE(CalibrationFit::fit(CURVE_LINEAR, points, pointCount, curve));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 2.0, curve.getSlope());
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 3.0, curve.getOffset());
+}
+
+void test_one_distinct_raw_value_cannot_be_fitted() {
+  addPoint(1.0, 4.0);
+  addPoint(1.0, 7.0);
+  TEST_ASSERT_FALSE(CalibrationFit::fit(CURVE_LINEAR, points, pointCount, curve));
+  TEST_ASSERT_FALSE(CalibrationFit::fit(CURVE_PIECEWISE, points, pointCount, curve));
+  TEST_ASSERT_FALSE(CalibrationFit::fit(CURVE_POLYNOMIAL, points, pointCount, curve));
+}
+
+void test_scale_multiplies_every_output() {
+  addPoint(100, 84);
+  addPoint(900, 1413);
+  addPoint(3000, 12880);
+  CalibrationFit::fit(CURVE_PIECEWISE, points, pointCount, curve);
+  float before = curve.evaluate(2000);
+  curve.scale(0.5);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, before * 0.5, curve.evaluate(2000));
+}
+
+void test_type_names_round_trip() {
+  const uint8_t types[] = { CURVE_LINEAR, CURVE_PIECEWISE, CURVE_POLYNOMIAL };
+  for (uint8_t type : types) {
+    TEST_ASSERT_EQUAL_INT(type, CalibrationFit::parseType(CalibrationFit::typeName(type)));
+  }
+  TEST_ASSERT_EQUAL_INT(CURVE_LINEAR, CalibrationFit::parseType("spline"));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_two_point_line_is_exact);
+  RUN_TEST(test_linear_fit_is_least_squares);
+  RUN_TEST(test_piecewise_goes_through_every_point);
+  RUN_TEST(test_polynomial_recovers_a_cubic);
+  RUN_TEST(test_polynomial_order_follows_the_points);
+  RUN_TEST(test_repeated_and_invalid_points);
+  RUN_TEST(test_one_distinct_raw_value_cannot_be_fitted);
+  RUN_TEST(test_scale_multiplies_every_output);
+  RUN_TEST(test_type_names_round_trip);
+  return UNITY_END();
+}
@@ -0,0 +1,154 @@
+#include <unity.h>
+#include "CalibrationManager.h"
+#include "SPIFFS.h"
+
+static CalibrationManager* manager;
+static const int channels[] = { 0, 1, 2 };
+
+// A new manager over the same store, as after a reboot
+static void restart() {
+  delete manager;
+  manager = new CalibrationManager();
+  TEST_ASSERT_TRUE(manager->begin());
+}
+
+// pH through raw 2.0 -> 4.0 and 'rawAt7' -> 7.0 on every session channel,
+// each point from its own scan cycle
+static void captureTwoPoints(float rawAt7, uint32_t cycle) {
+  const float low[] = { 2.0, 2.0, 2.0 };
+  const float high[] = { rawAt7, rawAt7, rawAt7 };
+  TEST_ASSERT_EQUAL_INT(3, manager->addSessionPoint(low, cycle, 4.0));
+  TEST_ASSERT_EQUAL_INT(3, manager->addSessionPoint(high, cycle + 1, 7.0));
+}
+
+static float phAt(int channel, float raw) {
+  return manager->getCalibratedPH(channel, raw, CAL_REFERENCE_TEMP);
+}
+
+void setUp() {
+  nativeFsWriteBudget = -1;
+  SPIFFS.remove(CAL_STORE_FILE);
+  manager = new CalibrationManager();
+  TEST_ASSERT_TRUE(manager->begin());
+}
+
+void tearDown() {
+  nativeFsWriteBudget = -1;
+  delete manager;
+}
+
+void test_session_calibrates_every_channel_in_one_write() {
+  TEST_ASSERT_TRUE(manager->startSession(CAL_TYPE_PH, channels, 3, "batch"));
+  TEST_ASSERT_TRUE(manager->getSession().active);
+  captureTwoPoints(1.5, 10);
+  TEST_ASSERT_EQUAL_INT(2, manager->getSession().pointCount);
+
+  TEST_ASSERT_EQUAL_INT(3, manager->finalizeSession());
+  TEST_ASSERT_FALSE(manager->getSession().active);
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(manager->getSession().fitted[i]);
+    TEST_ASSERT_TRUE(manager->isPHCalibrated(i));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 7.0, phAt(i, 1.5));
+  }
+  TEST_ASSERT_FALSE(manager->isPHCalibrated(3));
+  TEST_ASSERT_EQUAL_INT(3, manager->getPHTable().calibratedCount);
+
+  restart();
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.0, phAt(2, 1.5));
+}
+
+// Two reference values read from the same scan cycle cannot both be right
+void test_point_from_the_same_cycle_is_rejected() {
+  manager->startSession(CAL_TYPE_PH, channels, 3);
+  const float raw[] = { 2.0, 2.0, 2.0 };
+  TEST_ASSERT_EQUAL_INT(3, manager->addSessionPoint(raw, 10, 4.0));
+  TEST_ASSERT_EQUAL_INT(0, manager->addSessionPoint(raw, 10, 7.0));
+  TEST_ASSERT_EQUAL_INT(1, manager->getSession().pointCount);
+  TEST_ASSERT_EQUAL_UINT32(10, manager->getSession().lastCycle);
+
+  // One point fits nothing: no channel is calibrated
+  TEST_ASSERT_EQUAL_INT(0, manager->finalizeSession());
+  TEST_ASSERT_FALSE(manager->getSession().fitted[0]);
+  TEST_ASSERT_FALSE(manager->isPHCalibrated(0));
+}
+
+void test_bad_channel_lists_are_refused() {
+  const int duplicate[] = { 0, 1, 0 };
+  const int outOfRange[] = { 0, MAX_CHANNELS_PER_TYPE };
+  TEST_ASSERT_FALSE(manager->startSession(CAL_TYPE_PH, duplicate, 3));
+  TEST_ASSERT_FALSE(manager->startSession(CAL_TYPE_PH, outOfRange, 2));
+  TEST_ASSERT_FALSE(manager->startSession(CAL_TYPE_PH, channels, 0));
+  TEST_ASSERT_FALSE(manager->getSession().active);
+  TEST_ASSERT_EQUAL_INT(0, manager->addSessionPoint(nullptr, 1, 4.0));
+}
+
+// Cancelling puts the channels back to their stored calibration
+void test_cancel_restores_the_stored_calibration() {
+  manager->startSession(CAL_TYPE_PH, channels, 3);
+  captureTwoPoints(1.5, 10);
+  TEST_ASSERT_EQUAL_INT(3, manager->finalizeSession());
+
+  manager->startSession(CAL_TYPE_PH, channels, 2);
+  TEST_ASSERT_FALSE(manager->isPHCalibrated(0));   // Cleared for the new calibration
+  const float raw[] = { 2.0, 2.0 };
+  manager->addSessionPoint(raw, 20, 4.0);
+  manager->cancelSession();
+
+  TEST_ASSERT_FALSE(manager->getSession().active);
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(manager->isPHCalibrated(i));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 7.0, phAt(i, 1.5));
+  }
+}
+
+// The store write runs out of space after the first record. That record is
+// on flash and reported as committed; the other two keep their previous
+// calibration, in memory and after a reboot.
+void test_failed_write_reports_what_was_committed() {
+  manager->startSession(CAL_TYPE_PH, channels, 3);
+  captureTwoPoints(1.5, 10);
+  TEST_ASSERT_EQUAL_INT(3, manager->finalizeSession());
+
+  manager->startSession(CAL_TYPE_PH, channels, 3);
+  captureTwoPoints(1.0, 20);   // 5.5 at raw 1.5 once committed
+  nativeFsWriteBudget = sizeof(CalibrationRecord) + 10;
+  TEST_ASSERT_EQUAL_INT(-1, manager->finalizeSession());
+
+  TEST_ASSERT_TRUE(manager->getSession().fitted[0]);
+  TEST_ASSERT_FALSE(manager->getSession().fitted[1]);
+  TEST_ASSERT_FALSE(manager->getSession().fitted[2]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 5.5, phAt(0, 1.5));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.0, phAt(1, 1.5));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.0, phAt(2, 1.5));
+  TEST_ASSERT_EQUAL_INT(3, manager->getPHTable().calibratedCount);
+
+  nativeFsWriteBudget = -1;
+  restart();
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 5.5, phAt(0, 1.5));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.0, phAt(1, 1.5));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 7.0, phAt(2, 1.5));
+}
+
+// Nothing was stored before: channels whose records failed are uncalibrated
+void test_failed_first_write_leaves_channels_uncalibrated() {
+  manager->startSession(CAL_TYPE_PH, channels, 3);
+  captureTwoPoints(1.5, 10);
+  nativeFsWriteBudget = 0;
+  TEST_ASSERT_EQUAL_INT(-1, manager->finalizeSession());
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_FALSE(manager->getSession().fitted[i]);
+    TEST_ASSERT_FALSE(manager->isPHCalibrated(i));
+  }
+  TEST_ASSERT_EQUAL_INT(0, manager->getPHTable().calibratedCount);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_session_calibrates_every_channel_in_one_write);
+  RUN_TEST(test_point_from_the_same_cycle_is_rejected);
+  RUN_TEST(test_bad_channel_lists_are_refused);
+  RUN_TEST(test_cancel_restores_the_stored_calibration);
+  RUN_TEST(test_failed_write_reports_what_was_committed);
+  RUN_TEST(test_failed_first_write_leaves_channels_uncalibrated);
+  return UNITY_END();
+}
@@ -0,0 +1,236 @@
+#include <unity.h>
+#include <stddef.h>
+#include "CalibrationStore.h"
+#include "SPIFFS.h"
+
+static CalibrationStore* store;
+
+static CalibrationRecord makeRecord(int sensorType, int channel, float offset) {
+  CalibrationRecord record;
+  memset(&record, 0, sizeof(record));
+  record.sensorType = sensorType;
+  record.channel = channel;
+  record.calibrated = 1;
+  record.curveType = CURVE_LINEAR;
+  record.pointCount = 2;
+  record.slope = 1.0;
+  record.offset = offset;
+  record.points[0] = { 1.0, 4.0, 25.0 };
+  record.points[1] = { 2.0, 7.0, 25.0 };
+  strcpy(record.date, "2026-10-18 12:00:00");
+  return record;
+}
+
+static size_t slotOffset(int sensorType, int channel, int slot) {
+  return ((size_t)(sensorType * MAX_CHANNELS_PER_TYPE + channel) * 2 + slot) * sizeof(CalibrationRecord);
+}
+
+// Writes a record straight into a slot, as a previous boot would have left it
+static void writeSlot(int slot, CalibrationRecord record, uint32_t sequence) {
+  record.magic = CAL_RECORD_MAGIC;
+  record.version = CAL_STORE_VERSION;
+  record.sequence = sequence;
+  record.crc = CalibrationStore::crc32((const uint8_t*)&record, offsetof(CalibrationRecord, crc));
+  File file = SPIFFS.open(CAL_STORE_FILE, "r+");
+  file.seek(slotOffset(record.sensorType, record.channel, slot));
+  file.write((const uint8_t*)&record, sizeof(record));
+  file.close();
+}
+
+// Flips one byte of a slot, as a write cut short by power loss would
+static void corruptSlot(int sensorType, int channel, int slot) {
+  File file = SPIFFS.open(CAL_STORE_FILE, "r+");
+  size_t at = slotOffset(sensorType, channel, slot) + offsetof(CalibrationRecord, offset);
+  file.seek(at);
+  int value = file.read();
+  file.seek(at);
+  file.write((uint8_t)(value ^ 0xFF));
+  file.close();
+}
+
+static bool load(int sensorType, int channel, CalibrationRecord& record) {
+  TEST_ASSERT_TRUE(store->beginLoad());
+  bool found = store->loadRecord(sensorType, channel, record);
+  store->endLoad();
+  return found;
+}
+
+// A new store over the same file, as after a reboot
+static void restart() {
+  delete store;
+  store = new CalibrationStore();
+}
+
+void setUp() {
+  nativeFsWriteBudget = -1;
+  SPIFFS.remove(CAL_STORE_FILE);
+  store = new CalibrationStore();
+}
+
+void tearDown() {
+  delete store;
+}
+
+void test_crc32_check_value() {
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926, CalibrationStore::crc32((const uint8_t*)"123456789", 9));
+}
+
+void test_new_store_has_no_records() {
+  TEST_ASSERT_FALSE(store->exists());
+  TEST_ASSERT_TRUE(store->create());
+  TEST_ASSERT_TRUE(store->exists());
+  TEST_ASSERT_EQUAL_UINT32(CalibrationStore::fileSize(), store->getBytesWritten());
+
+  CalibrationRecord record;
+  for (int t = 0; t < CAL_SENSOR_TYPES; t++) {
+    TEST_ASSERT_FALSE(load(t, 0, record));
+  }
+}
+
+void test_record_round_trips() {
+  store->create();
+  CalibrationRecord record = makeRecord(CAL_TYPE_PH, 3, 0.25);
+  TEST_ASSERT_EQUAL_INT(1, store->write(&record, 1));
+  TEST_ASSERT_EQUAL_UINT32(sizeof(CalibrationRecord), store->getLastWriteBytes());
+
+  restart();
+  CalibrationRecord loaded;
+  TEST_ASSERT_TRUE(load(CAL_TYPE_PH, 3, loaded));
+  TEST_ASSERT_EQUAL_MEMORY(&record, &loaded, sizeof(record));
+  TEST_ASSERT_EQUAL_UINT32(1, loaded.sequence);
+  TEST_ASSERT_FALSE(load(CAL_TYPE_PH, 2, loaded));
+  TEST_ASSERT_FALSE(load(CAL_TYPE_TDS, 3, loaded));
+}
+
+// Each write goes to the slot the current record is not in, so the
+// previous record survives until the new one is whole
+void test_writes_alternate_slots() {
+  store->create();
+  for (int i = 1; i <= 3; i++) {
+    CalibrationRecord record = makeRecord(CAL_TYPE_TDS, 0, i);
+    store->write(&record, 1);
+  }
+  CalibrationRecord loaded;
+  TEST_ASSERT_TRUE(load(CAL_TYPE_TDS, 0, loaded));
+  TEST_ASSERT_EQUAL_FLOAT(3.0, loaded.offset);
+  TEST_ASSERT_EQUAL_UINT32(3, loaded.sequence);
+
+  // Writes 1 and 3 went to slot 0, write 2 to slot 1
+  corruptSlot(CAL_TYPE_TDS, 0, 0);
+  restart();
+  TEST_ASSERT_TRUE(load(CAL_TYPE_TDS, 0, loaded));
+  TEST_ASSERT_EQUAL_FLOAT(2.0, loaded.offset);
+
+  corruptSlot(CAL_TYPE_TDS, 0, 1);
+  restart();
+  TEST_ASSERT_FALSE(load(CAL_TYPE_TDS, 0, loaded));
+}
+
+// After falling back to the older slot, the next write replaces the corrupt one
+void test_write_after_fallback_keeps_the_good_slot() {
+  store->create();
+  CalibrationRecord first = makeRecord(CAL_TYPE_PH, 1, 1.0);
+  store->write(&first, 1);
+  CalibrationRecord second = makeRecord(CAL_TYPE_PH, 1, 2.0);
+  store->write(&second, 1);
+  corruptSlot(CAL_TYPE_PH, 1, 1);
+
+  restart();
+  CalibrationRecord loaded;
+  TEST_ASSERT_TRUE(load(CAL_TYPE_PH, 1, loaded));
+  TEST_ASSERT_EQUAL_FLOAT(1.0, loaded.offset);
+  CalibrationRecord third = makeRecord(CAL_TYPE_PH, 1, 3.0);
+  store->write(&third, 1);
+  corruptSlot(CAL_TYPE_PH, 1, 1);
+
+  restart();
+  TEST_ASSERT_TRUE(load(CAL_TYPE_PH, 1, loaded));
+  TEST_ASSERT_EQUAL_FLOAT(1.0, loaded.offset);
+}
+
+// Sequence numbers compare across the wrap
+void test_newest_slot_wins_across_sequence_wrap() {
+  store->create();
+  writeSlot(0, makeRecord(CAL_TYPE_TEMPERATURE, 2, 1.0), 0xFFFFFFFF);
+  writeSlot(1, makeRecord(CAL_TYPE_TEMPERATURE, 2, 2.0), 0);
+  CalibrationRecord loaded;
+  TEST_ASSERT_TRUE(load(CAL_TYPE_TEMPERATURE, 2, loaded));
+  TEST_ASSERT_EQUAL_FLOAT(2.0, loaded.offset);
+}
+
+// A valid record in the wrong place is not taken for that sensor
+void test_record_in_the_wrong_slot_is_rejected() {
+  store->create();
+  CalibrationRecord record = makeRecord(CAL_TYPE_PH, 0, 1.0);
+  writeSlot(0, record, 1);
+  File file = SPIFFS.open(CAL_STORE_FILE, "r+");
+  CalibrationRecord copy;
+  file.seek(slotOffset(CAL_TYPE_PH, 0, 0));
+  file.read((uint8_t*)&copy, sizeof(copy));
+  file.seek(slotOffset(CAL_TYPE_PH, 1, 0));
+  file.write((const uint8_t*)&copy, sizeof(copy));
+  file.close();
+
+  CalibrationRecord loaded;
+  TEST_ASSERT_TRUE(load(CAL_TYPE_PH, 0, loaded));
+  TEST_ASSERT_FALSE(load(CAL_TYPE_PH, 1, loaded));
+}
+
+void test_one_write_commits_several_records() {
+  store->create();
+  CalibrationRecord records[] = {
+    makeRecord(CAL_TYPE_PH, 0, 1.0),
+    makeRecord(CAL_TYPE_TDS, MAX_CHANNELS_PER_TYPE, 2.0),   // No such channel: skipped
+    makeRecord(CAL_TYPE_TDS, 5, 3.0)
+  };
+  TEST_ASSERT_EQUAL_INT(2, store->write(records, 3));
+  TEST_ASSERT_EQUAL_UINT32(2 * sizeof(CalibrationRecord), store->getLastWriteBytes());
+  TEST_ASSERT_EQUAL_UINT32(CalibrationStore::fileSize() + 2 * sizeof(CalibrationRecord), store->getBytesWritten());
+
+  CalibrationRecord loaded;
+  TEST_ASSERT_TRUE(load(CAL_TYPE_TDS, 5, loaded));
+  TEST_ASSERT_EQUAL_FLOAT(3.0, loaded.offset);
+}
+
+// Records are flushed one at a time: those before a failure stay committed
+void test_failed_write_reports_each_record() {
+  store->create();
+  CalibrationRecord records[] = {
+    makeRecord(CAL_TYPE_PH, 0, 1.0),
+    makeRecord(CAL_TYPE_PH, 1, 2.0),
+    makeRecord(CAL_TYPE_PH, 2, 3.0)
+  };
+  bool committed[3];
+  nativeFsWriteBudget = sizeof(CalibrationRecord) + 10;
+  TEST_ASSERT_EQUAL_INT(1, store->write(records, 3, committed));
+  nativeFsWriteBudget = -1;
+  TEST_ASSERT_TRUE(committed[0]);
+  TEST_ASSERT_FALSE(committed[1]);
+  TEST_ASSERT_FALSE(committed[2]);
+
+  restart();
+  CalibrationRecord loaded;
+  TEST_ASSERT_TRUE(load(CAL_TYPE_PH, 0, loaded));
+  TEST_ASSERT_FALSE(load(CAL_TYPE_PH, 1, loaded));   // Cut short: fails its CRC
+}
+
+void test_write_without_a_file_fails() {
+  CalibrationRecord record = makeRecord(CAL_TYPE_PH, 0, 1.0);
+  TEST_ASSERT_EQUAL_INT(0, store->write(&record, 1));
+  TEST_ASSERT_FALSE(store->beginLoad());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc32_check_value);
+  RUN_TEST(test_new_store_has_no_records);
+  RUN_TEST(test_record_round_trips);
+  RUN_TEST(test_writes_alternate_slots);
+  RUN_TEST(test_write_after_fallback_keeps_the_good_slot);
+  RUN_TEST(test_newest_slot_wins_across_sequence_wrap);
+  RUN_TEST(test_record_in_the_wrong_slot_is_rejected);
+  RUN_TEST(test_one_write_commits_several_records);
+  RUN_TEST(test_failed_write_reports_each_record);
+  RUN_TEST(test_write_without_a_file_fails);
+  return UNITY_END();
+}
@@ -0,0 +1,118 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "CalibrationTable.h"
+
+static CalibrationTableSet* tables;
+
+// Every channel of the table carries the same offset, so a reader can tell
+// a table that was handed over whole from one mixed with another
+static void fillTable(CalibrationTable& table, float offset) {
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    table.channels[i].curve.setLinear(1.0, offset);
+    table.channels[i].offsetTempCoeff = 0.0;
+    table.channels[i].scaleTempCoeff = 0.0;
+    table.channels[i].calibrated = true;
+  }
+  table.calibratedCount = MAX_CHANNELS_PER_TYPE;
+}
+
+void setUp() {
+  tables = new CalibrationTableSet();
+}
+
+void tearDown() {
+  delete tables;
+}
+
+void test_tables_start_as_identity() {
+  const CalibrationTable& table = tables->acquire();
+  TEST_ASSERT_EQUAL_UINT32(0, table.version);
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    TEST_ASSERT_FALSE(table.isCalibrated(i));
+    TEST_ASSERT_EQUAL_FLOAT(512.0, table.apply(i, 512.0, 31.0));   // No temperature terms either
+  }
+}
+
+void test_apply_uses_the_temperature_coefficients() {
+  CalibrationTable& table = tables->back();
+  table.channels[0].curve.setLinear(2.0, 1.0);
+  table.channels[0].offsetTempCoeff = 0.02;    // pH style
+  table.channels[0].scaleTempCoeff = 0.0;
+  table.channels[1].curve.setLinear(1.0, 0.0);
+  table.channels[1].offsetTempCoeff = 0.0;
+  table.channels[1].scaleTempCoeff = 0.02;     // EC style
+  tables->publish();
+
+  const CalibrationTable& live = tables->acquire();
+  TEST_ASSERT_EQUAL_FLOAT(7.0, live.apply(0, 3.0, CAL_REFERENCE_TEMP));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5, 7.0 - 0.02 * 5.0, live.apply(0, 3.0, CAL_REFERENCE_TEMP + 5.0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 1413.0 / 1.1, live.apply(1, 1413.0, CAL_REFERENCE_TEMP + 5.0));
+}
+
+void test_reader_keeps_its_table_until_acquire() {
+  const CalibrationTable& first = tables->acquire();
+  fillTable(tables->back(), 1.0);
+  tables->publish();
+  TEST_ASSERT_EQUAL_UINT32(0, first.version);
+  TEST_ASSERT_FALSE(first.isCalibrated(0));
+
+  const CalibrationTable& second = tables->acquire();
+  TEST_ASSERT_EQUAL_UINT32(1, second.version);
+  TEST_ASSERT_EQUAL_FLOAT(11.0, second.apply(0, 10.0, CAL_REFERENCE_TEMP));
+  TEST_ASSERT_EQUAL_PTR(&second, &tables->acquire());   // Nothing new: same buffer
+}
+
+// Several publishes in one cycle: the reader gets the newest, and the
+// writer never fills the buffer the reader holds
+void test_newest_of_several_publishes_wins() {
+  const CalibrationTable* held = &tables->acquire();
+  for (int v = 1; v <= 5; v++) {
+    TEST_ASSERT_TRUE(&tables->back() != held);
+    fillTable(tables->back(), v);
+    tables->publish();
+  }
+  const CalibrationTable& latest = tables->acquire();
+  TEST_ASSERT_EQUAL_UINT32(5, latest.version);
+  TEST_ASSERT_EQUAL_FLOAT(5.0, latest.apply(0, 0.0, CAL_REFERENCE_TEMP));
+}
+
+// A writer publishing as fast as it can while the reader applies tables:
+// every table the reader sees is whole, and versions never go back
+void test_concurrent_publish_never_tears_a_table() {
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (int v = 1; v <= 20000; v++) {
+      fillTable(tables->back(), v);
+      tables->publish();
+    }
+    done = true;
+  });
+
+  uint32_t lastVersion = 0;
+  int torn = 0;
+  while (!done) {
+    const CalibrationTable& table = tables->acquire();
+    if (table.version < lastVersion) torn++;
+    lastVersion = table.version;
+    float expected = table.apply(0, 0.0, CAL_REFERENCE_TEMP);
+    for (int i = 1; i < MAX_CHANNELS_PER_TYPE; i++) {
+      if (table.apply(i, 0.0, CAL_REFERENCE_TEMP) != expected) torn++;
+    }
+    if (table.version > 0 && expected != (float)table.version) torn++;
+  }
+  writer.join();
+
+  TEST_ASSERT_EQUAL_INT(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(20000, tables->acquire().version);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_tables_start_as_identity);
+  RUN_TEST(test_apply_uses_the_temperature_coefficients);
+  RUN_TEST(test_reader_keeps_its_table_until_acquire);
+  RUN_TEST(test_newest_of_several_publishes_wins);
+  RUN_TEST(test_concurrent_publish_never_tears_a_table);
+  return UNITY_END();
+}
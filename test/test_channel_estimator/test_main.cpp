@@ -0,0 +1,110 @@
+#include <unity.h>
+#include "ChannelEstimator.h"
+
+static ChannelEstimator estimator;
+static ChannelEstimate state;
+
+static void configure(EstimatorMode mode, float q, float r, float alpha, bool adaptive) {
+  EstimatorConfig config;
+  config.mode = mode;
+  config.processNoise = q;
+  config.measurementNoise = r;
+  config.alpha = alpha;
+  config.adaptive = adaptive;
+  estimator.configure(config);
+}
+
+void setUp() {
+  estimator = ChannelEstimator();
+  ChannelEstimator::reset(state);
+}
+
+void tearDown() {}
+
+void test_disabled_estimator_passes_readings_through() {
+  TEST_ASSERT_FALSE(estimator.isEnabled());
+  TEST_ASSERT_EQUAL_FLOAT(7.0, estimator.update(state, 7.0));
+  TEST_ASSERT_EQUAL_FLOAT(9.0, estimator.update(state, 9.0));
+  TEST_ASSERT_EQUAL_FLOAT(0.0, state.variance);
+}
+
+void test_first_reading_seeds_the_estimate() {
+  configure(ESTIMATOR_KALMAN, 0.0001, 0.01, 0.3, false);
+  TEST_ASSERT_EQUAL_FLOAT(7.0, estimator.update(state, 7.0));
+  TEST_ASSERT_TRUE(state.initialized);
+  TEST_ASSERT_EQUAL_FLOAT(0.01, state.variance);
+}
+
+// With no process noise the Kalman filter is the running mean, and its
+// variance falls as r / n
+void test_kalman_without_process_noise_is_the_running_mean() {
+  configure(ESTIMATOR_KALMAN, 0.0, 0.01, 0.3, false);
+  const float readings[] = { 7.0, 7.2, 6.9, 7.3, 6.6 };
+  float sum = 0;
+  for (int n = 1; n <= 5; n++) {
+    sum += readings[n - 1];
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, sum / n, estimator.update(state, readings[n - 1]));
+    TEST_ASSERT_FLOAT_WITHIN(1e-7, 0.01 / n, state.variance);
+  }
+}
+
+// Process noise keeps the gain up, so the estimate follows a step in the
+// true value instead of freezing
+void test_kalman_follows_a_step() {
+  configure(ESTIMATOR_KALMAN, 0.001, 0.01, 0.3, false);
+  for (int i = 0; i < 50; i++) {
+    estimator.update(state, 7.0);
+  }
+  TEST_ASSERT_TRUE(state.variance > 0.0 && state.variance < 0.01);
+  for (int i = 0; i < 50; i++) {
+    estimator.update(state, 8.0);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 8.0, state.value);
+}
+
+void test_ewma_smooths_with_alpha() {
+  configure(ESTIMATOR_EWMA, 0.0, 0.01, 0.25, false);
+  estimator.update(state, 8.0);
+  TEST_ASSERT_EQUAL_FLOAT(8.5, estimator.update(state, 10.0));
+  TEST_ASSERT_EQUAL_FLOAT(8.875, estimator.update(state, 10.0));
+}
+
+// Adaptive: jitter inside 2 sigma keeps alpha, a real step is taken at once
+void test_adaptive_ewma_takes_steps_and_smooths_jitter() {
+  configure(ESTIMATOR_EWMA, 0.0, 0.01, 0.25, true);
+  estimator.update(state, 7.0);
+  TEST_ASSERT_EQUAL_FLOAT(7.025, estimator.update(state, 7.1));
+  TEST_ASSERT_EQUAL_FLOAT(8.0, estimator.update(state, 8.0));
+  TEST_ASSERT_TRUE(state.variance > 0.0);
+}
+
+void test_configuration_is_sanitised() {
+  configure(ESTIMATOR_EWMA, -1.0, 0.0, 5.0, false);
+  TEST_ASSERT_EQUAL_FLOAT(0.0, estimator.getConfig().processNoise);
+  TEST_ASSERT_EQUAL_FLOAT(DEFAULT_ESTIMATOR_MEASUREMENT_NOISE, estimator.getConfig().measurementNoise);
+  TEST_ASSERT_EQUAL_FLOAT(1.0, estimator.getConfig().alpha);
+
+  configure(ESTIMATOR_EWMA, 0.0, 0.01, 0.0, false);
+  TEST_ASSERT_EQUAL_FLOAT(0.01, estimator.getConfig().alpha);
+}
+
+void test_mode_names_round_trip() {
+  const EstimatorMode modes[] = { ESTIMATOR_NONE, ESTIMATOR_KALMAN, ESTIMATOR_EWMA };
+  for (EstimatorMode mode : modes) {
+    TEST_ASSERT_EQUAL_INT(mode, ChannelEstimator::parseMode(ChannelEstimator::modeName(mode)));
+  }
+  TEST_ASSERT_EQUAL_INT(ESTIMATOR_NONE, ChannelEstimator::parseMode("lowpass"));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_disabled_estimator_passes_readings_through);
+  RUN_TEST(test_first_reading_seeds_the_estimate);
+  RUN_TEST(test_kalman_without_process_noise_is_the_running_mean);
+  RUN_TEST(test_kalman_follows_a_step);
+  RUN_TEST(test_ewma_smooths_with_alpha);
+  RUN_TEST(test_adaptive_ewma_takes_steps_and_smooths_jitter);
+  RUN_TEST(test_configuration_is_sanitised);
+  RUN_TEST(test_mode_names_round_trip);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#include <unity.h>
+#include "SensorBank.h"
+
+// Raw code for 1.000 V on the replay backend's linear table
+static const uint16_t oneVolt[] = { 1241 };
+
+static MultiplexerController* mux;
+static ReplayAdcBackend* adc;
+static TemperatureSensor* temperature;
+static TDSSensor* tds;
+
+void setUp() {
+  nativeGpio.reset();
+  mux = new MultiplexerController();
+  mux->addBank(MUX_EN, TEMP_ADC_PIN);
+  mux->addBank(MUX_EN, TDS_ADC_PIN);
+  mux->begin(false);
+  adc = new ReplayAdcBackend();
+  adc->addTrace(TDS_ADC_PIN, oneVolt, 1);
+  adc->begin();
+
+  // Aquarium 0 has two probes, aquarium 1 one, channel 3 is spare
+  temperature = new TemperatureSensor(mux, adc, 0);
+  temperature->setChannelCount(4);
+  temperature->assignAquarium(0, 0);
+  temperature->assignAquarium(1, 0);
+  temperature->assignAquarium(2, 1);
+  TemperatureData& data = temperature->getData();
+  data.readings[0] = 24.0;
+  data.readings[1] = 26.0;
+  data.readings[2] = 30.0;
+  data.readings[3] = 99.0;
+
+  // TDS channel 0 in aquarium 0, 1 in aquarium 1, 2 unassigned
+  tds = new TDSSensor(mux, adc, 1);
+  tds->setChannelCount(3);
+  tds->assignAquarium(0, 0);
+  tds->assignAquarium(1, 1);
+}
+
+void tearDown() {
+  delete tds;
+  delete temperature;
+  delete adc;
+  delete mux;
+}
+
+static float tdsAt(float volts) {
+  TDSTraits::State state;
+  return TDSTraits::convert(0, volts, 0, state);
+}
+
+// Compensation temperature of each TDS channel, from the temperature bank
+static void channelTemperatures(float* channels) {
+  float aquariums[MAX_AQUARIUMS];
+  int counts[MAX_AQUARIUMS];
+  temperature->averageByAquarium(aquariums, counts, CAL_REFERENCE_TEMP);
+  tds->mapFromAquariums(aquariums, CAL_REFERENCE_TEMP, channels);
+}
+
+static void readTds(const CalibrationTable* calibration) {
+  float channels[MAX_CHANNELS_PER_TYPE];
+  channelTemperatures(channels);
+  for (int i = 0; i < tds->getSensorCount(); i++) {
+    tds->sampleChannel(i);
+  }
+  tds->finishCycle(calibration, channels);
+}
+
+void test_aquarium_temperature_is_the_mean_of_its_probes() {
+  float aquariums[MAX_AQUARIUMS];
+  int counts[MAX_AQUARIUMS];
+  temperature->averageByAquarium(aquariums, counts, CAL_REFERENCE_TEMP);
+  TEST_ASSERT_EQUAL_FLOAT(25.0, aquariums[0]);
+  TEST_ASSERT_EQUAL_INT(2, counts[0]);
+  TEST_ASSERT_EQUAL_FLOAT(30.0, aquariums[1]);
+  TEST_ASSERT_EQUAL_INT(1, counts[1]);
+  TEST_ASSERT_EQUAL_FLOAT(CAL_REFERENCE_TEMP, aquariums[2]);   // No probe
+  TEST_ASSERT_EQUAL_INT(0, counts[2]);
+}
+
+void test_channels_take_their_aquariums_temperature() {
+  float channels[MAX_CHANNELS_PER_TYPE];
+  channelTemperatures(channels);
+  TEST_ASSERT_EQUAL_FLOAT(25.0, channels[0]);
+  TEST_ASSERT_EQUAL_FLOAT(30.0, channels[1]);
+  TEST_ASSERT_EQUAL_FLOAT(CAL_REFERENCE_TEMP, channels[2]);   // Unassigned
+}
+
+// Uncalibrated TDS refers the probe voltage back to 25 degC before the cubic
+void test_uncalibrated_tds_is_compensated_per_aquarium() {
+  readTds(nullptr);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, tdsAt(1.0), tds->getReading(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, tdsAt(1.0 / (1.0 + TDS_TEMP_COEFF * 5.0)), tds->getReading(1));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, tdsAt(1.0), tds->getReading(2));
+  TEST_ASSERT_TRUE(tds->getReading(1) < tds->getReading(0));
+}
+
+// A calibration that leaves the 25 degC reading alone reads the same as the
+// uncalibrated path at 25 degC, and moves the same way when warmer
+void test_calibrated_tds_matches_at_the_reference_temperature() {
+  CalibrationTableSet tables;
+  CalibrationTable& table = tables.back();
+  for (int i = 0; i < 2; i++) {
+    table.channels[i].curve.setLinear(1.0, 0.0);
+    table.channels[i].offsetTempCoeff = 0.0;
+    table.channels[i].scaleTempCoeff = TDS_TEMP_COEFF;
+    table.channels[i].calibrated = true;
+  }
+  tables.publish();
+
+  readTds(&tables.acquire());
+  TEST_ASSERT_FLOAT_WITHIN(0.01, tdsAt(1.0), tds->getReading(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, tdsAt(1.0) / (1.0 + TDS_TEMP_COEFF * 5.0), tds->getReading(1));
+}
+
+void test_reassigning_a_channel_moves_its_compensation() {
+  tds->clearAquariumMap();
+  tds->assignAquarium(0, 1);
+  readTds(nullptr);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, tdsAt(1.0 / (1.0 + TDS_TEMP_COEFF * 5.0)), tds->getReading(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, tdsAt(1.0), tds->getReading(1));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_aquarium_temperature_is_the_mean_of_its_probes);
+  RUN_TEST(test_channels_take_their_aquariums_temperature);
+  RUN_TEST(test_uncalibrated_tds_is_compensated_per_aquarium);
+  RUN_TEST(test_calibrated_tds_matches_at_the_reference_temperature);
+  RUN_TEST(test_reassigning_a_channel_moves_its_compensation);
+  return UNITY_END();
+}
@@ -0,0 +1,275 @@
+#include <unity.h>
+#include <memory>
+#include <string>
+#include "HttpConnectionTable.h"
+
+// Routes for the table: the path comes back as the body, and /big answers
+// with more than a send window. Secure connections use a stand-in for TLS
+// whose handshake is the client sending "HELLO".
+class TestHandler : public HttpConnectionHandler {
+public:
+  HttpConnectionTable* table;
+  int handshakesEnded;
+
+  bool beginSecure(HttpConnection& conn) override {
+    return true;
+  }
+
+  int continueHandshake(HttpConnection& conn, unsigned long now) override {
+    if (conn.client.available() < 5) return 0;
+    uint8_t hello[5];
+    conn.client.read(hello, sizeof(hello));
+    return memcmp(hello, "HELLO", 5) == 0 ? 1 : -1;
+  }
+
+  int secureRead(HttpConnection& conn, uint8_t* buf, size_t len) override {
+    int available = conn.client.available();
+    return available > 0 ? conn.client.read(buf, min(len, (size_t)available)) : 0;
+  }
+
+  int secureWrite(HttpConnection& conn, const uint8_t* buf, size_t len) override {
+    return conn.client.write(buf, len);
+  }
+
+  void endSecure(HttpConnection& conn) override {
+    handshakesEnded++;
+  }
+
+  void handleRequest(HttpConnection& conn) override {
+    String path = conn.parser.getPath();
+    if (path == "/big") {
+      table->sendResponse(conn, 200, "text/plain", String(std::string(20000, 'b')));
+    } else {
+      table->sendResponse(conn, 200, "text/plain", path);
+    }
+  }
+};
+
+static HttpConnectionTable* table;
+static TestHandler* handler;
+static WiFiServer* plainServer;
+static WiFiServer* secureServer;
+static unsigned long now;
+
+typedef std::shared_ptr<NativeSocket> Peer;
+
+static Peer connectWith(const char* request) {
+  Peer peer = nativeConnect(80);
+  peer->send(request);
+  return peer;
+}
+
+// Loop passes 10 ms apart
+static void run(int passes) {
+  for (int i = 0; i < passes; i++) {
+    table->handleClients(*plainServer, secureServer, now);
+    now += 10;
+  }
+}
+
+// Passes until 'ms' have gone by
+static void runFor(unsigned long ms) {
+  run(ms / 10);
+}
+
+static bool startsWith(const std::string& text, const char* prefix) {
+  return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+static bool endsWith(const std::string& text, const std::string& suffix) {
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void setUp() {
+  nativeBacklog.clear();
+  handler = new TestHandler();
+  handler->handshakesEnded = 0;
+  table = new HttpConnectionTable();
+  handler->table = table;
+  table->setHandler(handler);
+  plainServer = new WiFiServer(80);
+  plainServer->begin();
+  secureServer = new WiFiServer(443);
+  secureServer->begin();
+  now = 1000;
+}
+
+void tearDown() {
+  delete plainServer;
+  delete secureServer;
+  delete table;
+  delete handler;
+}
+
+void test_keep_alive_connection_serves_requests_in_turn() {
+  Peer peer = connectWith("GET /one HTTP/1.1\r\nHost: aqua\r\n\r\n");
+  run(3);
+  std::string response = peer->receive();
+  TEST_ASSERT_TRUE(startsWith(response, "HTTP/1.1 200 OK\r\n"));
+  TEST_ASSERT_TRUE(response.find("Connection: keep-alive\r\n") != std::string::npos);
+  TEST_ASSERT_TRUE(endsWith(response, "\r\n\r\n/one"));
+  TEST_ASSERT_TRUE(peer->deviceOpen);
+
+  // Two pipelined requests on the same connection
+  peer->send("GET /two HTTP/1.1\r\n\r\nGET /three HTTP/1.1\r\nConnection: close\r\n\r\n");
+  run(6);
+  response = peer->receive();
+  TEST_ASSERT_TRUE(response.find("/two") < response.find("/three"));
+  TEST_ASSERT_TRUE(endsWith(response, "/three"));
+  TEST_ASSERT_FALSE(peer->deviceOpen);
+
+  const HttpServerStats& stats = table->getStats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.accepted);
+  TEST_ASSERT_EQUAL_UINT32(3, stats.requests);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.keepAliveReuses);
+  TEST_ASSERT_EQUAL_INT(0, stats.activeConnections);
+}
+
+// Six clients for four slots, the first stalled halfway through its
+// request: the other five are all answered while it holds its slot, and
+// the stalled one gets a 408 once HTTP_REQUEST_TIMEOUT_MS has passed
+void test_stalled_client_does_not_hold_up_the_others() {
+  Peer stalled = connectWith("GET /slow HTTP/1.1\r\nHost: aq");
+  Peer others[5];
+  for (int i = 0; i < 5; i++) {
+    char request[64];
+    snprintf(request, sizeof(request), "GET /client%d HTTP/1.1\r\nConnection: close\r\n\r\n", i);
+    others[i] = connectWith(request);
+  }
+
+  run(30);
+  for (int i = 0; i < 5; i++) {
+    char body[16];
+    snprintf(body, sizeof(body), "/client%d", i);
+    std::string response = others[i]->receive();
+    TEST_ASSERT_TRUE(startsWith(response, "HTTP/1.1 200 OK\r\n"));
+    TEST_ASSERT_TRUE(endsWith(response, body));
+    TEST_ASSERT_FALSE(others[i]->deviceOpen);
+  }
+  TEST_ASSERT_TRUE(stalled->receive().empty());
+  TEST_ASSERT_TRUE(stalled->deviceOpen);
+
+  const HttpServerStats& stats = table->getStats();
+  TEST_ASSERT_EQUAL_UINT32(6, stats.accepted);
+  TEST_ASSERT_EQUAL_INT(MAX_HTTP_CONNECTIONS, stats.peakConnections);
+  TEST_ASSERT_EQUAL_INT(1, stats.activeConnections);
+
+  runFor(HTTP_REQUEST_TIMEOUT_MS);
+  TEST_ASSERT_TRUE(startsWith(stalled->receive(), "HTTP/1.1 408 Request Timeout\r\n"));
+  TEST_ASSERT_FALSE(stalled->deviceOpen);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.timeouts);
+  TEST_ASSERT_EQUAL_INT(0, stats.activeConnections);
+}
+
+// Four idle keep-alive clients fill the table. New clients wait in the
+// backlog until HTTP_IDLE_TIMEOUT_MS frees the slots, then get served.
+void test_idle_slots_are_reclaimed_for_waiting_clients() {
+  Peer idle[MAX_HTTP_CONNECTIONS];
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS - 1; i++) {
+    idle[i] = connectWith("GET / HTTP/1.1\r\n\r\n");
+  }
+  idle[MAX_HTTP_CONNECTIONS - 1] = nativeConnect(80);   // Connects and says nothing
+  run(10);
+  Peer waiting[2] = { connectWith("GET /late HTTP/1.1\r\n\r\n"), connectWith("GET /later HTTP/1.1\r\n\r\n") };
+
+  runFor(HTTP_IDLE_TIMEOUT_MS - 200);
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    TEST_ASSERT_TRUE(idle[i]->deviceOpen);
+  }
+  TEST_ASSERT_TRUE(waiting[0]->receive().empty());
+  TEST_ASSERT_EQUAL_INT(MAX_HTTP_CONNECTIONS, table->getStats().activeConnections);
+
+  runFor(400);
+  for (int i = 0; i < MAX_HTTP_CONNECTIONS; i++) {
+    TEST_ASSERT_FALSE(idle[i]->deviceOpen);
+  }
+  TEST_ASSERT_TRUE(endsWith(waiting[0]->receive(), "/late"));
+  TEST_ASSERT_TRUE(endsWith(waiting[1]->receive(), "/later"));
+  TEST_ASSERT_EQUAL_INT(2, table->getStats().activeConnections);
+  TEST_ASSERT_EQUAL_UINT32(0, table->getStats().timeouts);   // Idle closes are not timeouts
+}
+
+// A client that stops reading halfway through a large response is dropped
+// HTTP_REQUEST_TIMEOUT_MS after its last progress; another client is
+// served in the meantime
+void test_client_that_stops_reading_is_dropped() {
+  Peer slowReader = connectWith("GET /big HTTP/1.1\r\n\r\n");
+  slowReader->sendWindow = 3000;
+  run(10);
+  TEST_ASSERT_EQUAL_UINT32(3000, slowReader->toPeer.size());   // Window full, nothing read
+
+  Peer other = connectWith("GET /quick HTTP/1.1\r\nConnection: close\r\n\r\n");
+  run(5);
+  TEST_ASSERT_TRUE(endsWith(other->receive(), "/quick"));
+
+  runFor(HTTP_REQUEST_TIMEOUT_MS - 200);
+  TEST_ASSERT_TRUE(slowReader->deviceOpen);
+  runFor(300);
+  TEST_ASSERT_FALSE(slowReader->deviceOpen);
+  TEST_ASSERT_EQUAL_UINT32(1, table->getStats().timeouts);
+  TEST_ASSERT_EQUAL_INT(0, table->getStats().activeConnections);
+}
+
+// A response larger than the window arrives whole when the peer keeps reading
+void test_large_response_is_written_in_chunks() {
+  Peer peer = connectWith("GET /big HTTP/1.1\r\nConnection: close\r\n\r\n");
+  std::string response;
+  for (int pass = 0; pass < 40 && peer->deviceOpen; pass++) {
+    run(1);
+    std::string part = peer->receive();
+    TEST_ASSERT_TRUE(part.size() <= HTTP_WRITE_CHUNK);
+    response += part;
+  }
+  TEST_ASSERT_FALSE(peer->deviceOpen);
+  TEST_ASSERT_TRUE(endsWith(response, "\r\n\r\n" + std::string(20000, 'b')));
+}
+
+void test_client_gone_before_its_request_frees_the_slot() {
+  Peer peer = connectWith("GET /part");
+  run(2);
+  TEST_ASSERT_EQUAL_INT(1, table->getStats().activeConnections);
+  peer->close();
+  run(1);
+  TEST_ASSERT_EQUAL_INT(0, table->getStats().activeConnections);
+  TEST_ASSERT_FALSE(peer->deviceOpen);
+}
+
+void test_bad_request_is_answered_and_closed() {
+  Peer peer = connectWith("BREW /pot HTTP/1.1\r\n\r\n");
+  run(3);
+  TEST_ASSERT_TRUE(startsWith(peer->receive(), "HTTP/1.1 501 Not Implemented\r\n"));
+  TEST_ASSERT_FALSE(peer->deviceOpen);
+  TEST_ASSERT_EQUAL_UINT32(1, table->getStats().parseErrors);
+}
+
+// HTTPS slots go through the handler, and one that never finishes its
+// handshake is dropped rather than holding the slot
+void test_secure_connections_and_stalled_handshakes() {
+  Peer secure = nativeConnect(443);
+  secure->send("HELLOGET /secure HTTP/1.1\r\nConnection: close\r\n\r\n");
+  Peer silent = nativeConnect(443);
+  run(6);
+  TEST_ASSERT_TRUE(endsWith(secure->receive(), "/secure"));
+  TEST_ASSERT_FALSE(secure->deviceOpen);
+  TEST_ASSERT_EQUAL_INT(1, handler->handshakesEnded);
+
+  TEST_ASSERT_TRUE(silent->deviceOpen);
+  runFor(HTTP_REQUEST_TIMEOUT_MS);
+  TEST_ASSERT_FALSE(silent->deviceOpen);
+  TEST_ASSERT_EQUAL_INT(2, handler->handshakesEnded);
+  TEST_ASSERT_EQUAL_UINT32(1, table->getStats().timeouts);
+  TEST_ASSERT_EQUAL_INT(0, table->getStats().activeConnections);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_keep_alive_connection_serves_requests_in_turn);
+  RUN_TEST(test_stalled_client_does_not_hold_up_the_others);
+  RUN_TEST(test_idle_slots_are_reclaimed_for_waiting_clients);
+  RUN_TEST(test_client_that_stops_reading_is_dropped);
+  RUN_TEST(test_large_response_is_written_in_chunks);
+  RUN_TEST(test_client_gone_before_its_request_frees_the_slot);
+  RUN_TEST(test_bad_request_is_answered_and_closed);
+  RUN_TEST(test_secure_connections_and_stalled_handshakes);
+  return UNITY_END();
+}
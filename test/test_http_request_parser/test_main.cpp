@@ -0,0 +1,389 @@
+#include <unity.h>
+#include <new>
+#include "HttpRequestParser.h"
+
+static HttpRequestParser parser;
+
+// Every heap allocation in the test binary goes through here, so a test
+// can check the parser makes none
+static size_t allocations;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* block = malloc(size ? size : 1);
+  if (!block) throw std::bad_alloc();
+  return block;
+}
+
+void operator delete(void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+
+// Requests as a browser, the calibration page and curl sent them to the device
+static const char* const CAPTURED[] = {
+  "GET / HTTP/1.1\r\nHost: 192.168.1.50\r\nConnection: keep-alive\r\n"
+  "Upgrade-Insecure-Requests: 1\r\n"
+  "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/118.0.0.0 Safari/537.36\r\n"
+  "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+  "Accept-Encoding: gzip, deflate\r\nAccept-Language: en-GB,en;q=0.9\r\n\r\n",
+
+  "POST /api/calibration/session/point HTTP/1.1\r\nHost: 192.168.1.50\r\nConnection: keep-alive\r\n"
+  "Content-Length: 40\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+  "Origin: http://192.168.1.50\r\nReferer: http://192.168.1.50/calibration\r\n\r\n"
+  "sensor=ph&channel=2&value=7.01&temp=25.0",
+
+  "GET /api/sensors?type=tds&channel=5 HTTP/1.1\r\nHost: aquarium.local\r\nUser-Agent: curl/8.4.0\r\nAccept: */*\r\n\r\n",
+
+  "GET /favicon.ico HTTP/1.0\r\nHost: 192.168.1.50\r\nConnection: close\r\n\r\n"
+};
+static const int CAPTURED_COUNT = sizeof(CAPTURED) / sizeof(CAPTURED[0]);
+
+static void feedText(const char* text) {
+  parser.feed((const uint8_t*)text, strlen(text));
+}
+
+void setUp() {
+  parser.reset();
+}
+
+void tearDown() {}
+
+void test_get_with_query_and_headers() {
+  feedText("GET /api/sensors?type=ph&id=2 HTTP/1.1\r\nHost: aqua\r\nX-Probe:  tank 1 \r\n\r\n");
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_TRUE(parser.getMethod() == HttpMethod::GET);
+  TEST_ASSERT_EQUAL_STRING("GET", parser.getMethodText());
+  TEST_ASSERT_EQUAL_STRING("/api/sensors", parser.getPath());
+  TEST_ASSERT_EQUAL_STRING("type=ph&id=2", parser.getQuery());
+  TEST_ASSERT_TRUE(parser.isHttp11());
+  TEST_ASSERT_EQUAL_INT(2, parser.getHeaderCount());
+  TEST_ASSERT_EQUAL_STRING("aqua", parser.getHeader("host"));
+  TEST_ASSERT_EQUAL_STRING("tank 1", parser.getHeader("X-PROBE"));   // Value trimmed
+  TEST_ASSERT_NULL(parser.getHeader("Cookie"));
+  TEST_ASSERT_EQUAL_UINT32(0, parser.getBodyLength());
+}
+
+void test_request_split_across_reads() {
+  const char* request = "POST /api/config HTTP/1.1\r\nContent-Length: 11\r\n\r\nmode=manual";
+  for (const char* p = request; *p; p++) {
+    TEST_ASSERT_FALSE(parser.isComplete());
+    parser.feed((const uint8_t*)p, 1);
+  }
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_TRUE(parser.getMethod() == HttpMethod::POST);
+  TEST_ASSERT_EQUAL_UINT32(11, parser.getBodyLength());
+  TEST_ASSERT_EQUAL_MEMORY("mode=manual", parser.getBody(), 11);
+}
+
+void test_body_waits_for_content_length() {
+  feedText("POST /x HTTP/1.1\r\nContent-Length: 10\r\n\r\n12345");
+  TEST_ASSERT_TRUE(parser.getState() == HttpParseState::BODY);
+  TEST_ASSERT_EQUAL_UINT32(0, parser.getBodyLength());
+  feedText("67890");
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_EQUAL_MEMORY("1234567890", parser.getBody(), 10);
+}
+
+void test_bare_lf_line_endings() {
+  feedText("GET / HTTP/1.0\nHost: aqua\n\n");
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_EQUAL_STRING("/", parser.getPath());
+  TEST_ASSERT_FALSE(parser.isHttp11());
+  TEST_ASSERT_EQUAL_STRING("aqua", parser.getHeader("Host"));
+}
+
+void test_bulk_write_through_write_ptr() {
+  const char* request = "GET /status HTTP/1.1\r\n\r\n";
+  memcpy(parser.writePtr(), request, strlen(request));
+  parser.commit(strlen(request));
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_EQUAL_STRING("/status", parser.getPath());
+}
+
+static void expectError(const char* request, int status) {
+  parser.reset();
+  feedText(request);
+  TEST_ASSERT_TRUE(parser.hasError());
+  TEST_ASSERT_EQUAL_INT(status, parser.getErrorStatus());
+}
+
+void test_malformed_requests_are_rejected() {
+  expectError("GET\r\n\r\n", 400);
+  expectError("GET / HTTP/2.0\r\n\r\n", 505);
+  expectError("BREW /pot HTTP/1.1\r\n\r\n", 501);
+  expectError("GET relative HTTP/1.1\r\n\r\n", 400);
+  expectError("GET / HTTP/1.1\r\nNoColon\r\n\r\n", 400);
+  expectError("POST / HTTP/1.1\r\nContent-Length: 12x\r\n\r\n", 400);
+  expectError("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", 501);
+  expectError("POST / HTTP/1.1\r\nContent-Length: 999999\r\n\r\n", 413);
+}
+
+void test_oversized_header_block_is_rejected() {
+  feedText("GET / HTTP/1.1\r\nX-Long: ");
+  static char filler[HTTP_MAX_REQUEST_SIZE];
+  memset(filler, 'a', sizeof(filler));
+  parser.feed((const uint8_t*)filler, sizeof(filler));
+  TEST_ASSERT_TRUE(parser.hasError());
+  TEST_ASSERT_EQUAL_INT(431, parser.getErrorStatus());
+}
+
+void test_query_and_form_params_are_decoded() {
+  feedText("POST /cal?sensor=ph&note=a%2Fb+c HTTP/1.1\r\nContent-Length: 17\r\n\r\nvalue=7.01&flag=1");
+  TEST_ASSERT_TRUE(parser.isComplete());
+  char out[32];
+  TEST_ASSERT_TRUE(parser.getQueryParam("sensor", out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING("ph", out);
+  TEST_ASSERT_TRUE(parser.getQueryParam("note", out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING("a/b c", out);
+  TEST_ASSERT_FALSE(parser.getQueryParam("sens", out, sizeof(out)));
+  TEST_ASSERT_TRUE(parser.getFormParam("value", out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING("7.01", out);
+  TEST_ASSERT_TRUE(parser.getFormParam("flag", out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING("1", out);
+
+  char small[4];
+  TEST_ASSERT_TRUE(parser.getFormParam("value", small, sizeof(small)));
+  TEST_ASSERT_EQUAL_STRING("7.0", small);   // Truncated to the buffer
+}
+
+void test_keep_alive_follows_version_and_connection_header() {
+  feedText("GET / HTTP/1.1\r\n\r\n");
+  TEST_ASSERT_TRUE(parser.keepAlive());
+
+  parser.reset();
+  feedText("GET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+  TEST_ASSERT_FALSE(parser.keepAlive());
+
+  parser.reset();
+  feedText("GET / HTTP/1.0\r\n\r\n");
+  TEST_ASSERT_FALSE(parser.keepAlive());
+
+  parser.reset();
+  feedText("GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n");
+  TEST_ASSERT_TRUE(parser.keepAlive());
+}
+
+void test_pipelined_requests_are_served_in_turn() {
+  feedText("GET /first HTTP/1.1\r\n\r\n"
+           "POST /second HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"
+           "GET /thi");
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_EQUAL_STRING("/first", parser.getPath());
+
+  parser.consumeRequest();
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_EQUAL_STRING("/second", parser.getPath());
+  TEST_ASSERT_EQUAL_MEMORY("abc", parser.getBody(), 3);
+
+  // The partial third request waits for the rest of its bytes
+  parser.consumeRequest();
+  TEST_ASSERT_FALSE(parser.isComplete());
+  TEST_ASSERT_FALSE(parser.isIdle());
+  feedText("rd HTTP/1.1\r\n\r\n");
+  TEST_ASSERT_TRUE(parser.isComplete());
+  TEST_ASSERT_EQUAL_STRING("/third", parser.getPath());
+
+  parser.consumeRequest();
+  TEST_ASSERT_TRUE(parser.isIdle());
+}
+
+void test_consuming_an_unfinished_request_resets() {
+  feedText("GET /partial HTTP/1.1\r\nHost: aq");
+  parser.consumeRequest();
+  TEST_ASSERT_TRUE(parser.isIdle());
+  TEST_ASSERT_TRUE(parser.getState() == HttpParseState::REQUEST_LINE);
+}
+
+// What a parse ended with, kept in fixed buffers so recording it allocates nothing
+struct ParseOutcome {
+  HttpParseState state;
+  int status;
+  int headerCount;
+  size_t bodyLength;
+  char method[16];
+  char path[128];
+  char query[128];
+  char host[64];
+  char body[64];
+};
+
+static void recordOutcome(const HttpRequestParser& from, ParseOutcome& out) {
+  memset(&out, 0, sizeof(out));
+  out.state = from.getState();
+  out.status = from.getErrorStatus();
+  if (out.state != HttpParseState::COMPLETE) return;
+  out.headerCount = from.getHeaderCount();
+  out.bodyLength = from.getBodyLength();
+  strncpy(out.method, from.getMethodText(), sizeof(out.method) - 1);
+  strncpy(out.path, from.getPath(), sizeof(out.path) - 1);
+  strncpy(out.query, from.getQuery(), sizeof(out.query) - 1);
+  const char* host = from.getHeader("Host");
+  if (host) strncpy(out.host, host, sizeof(out.host) - 1);
+  memcpy(out.body, from.getBody(), min(out.bodyLength, sizeof(out.body)));
+}
+
+// Guard bytes either side of the parser catch writes past its buffer
+struct GuardedParser {
+  uint8_t before[64];
+  HttpRequestParser parser;
+  uint8_t after[64];
+};
+
+static const uint8_t GUARD = 0xA5;
+
+static bool pointsIntoParser(const GuardedParser& guarded, const char* text) {
+  const char* start = (const char*)&guarded.parser;
+  return (text >= start && text < start + sizeof(guarded.parser)) || text[0] == '\0';
+}
+
+static void checkGuards(const GuardedParser& guarded) {
+  for (size_t i = 0; i < sizeof(guarded.before); i++) {
+    TEST_ASSERT_EQUAL_HEX8(GUARD, guarded.before[i]);
+    TEST_ASSERT_EQUAL_HEX8(GUARD, guarded.after[i]);
+  }
+  const HttpRequestParser& p = guarded.parser;
+  if (!p.isComplete()) return;
+  TEST_ASSERT_TRUE(pointsIntoParser(guarded, p.getMethodText()));
+  TEST_ASSERT_TRUE(pointsIntoParser(guarded, p.getPath()));
+  TEST_ASSERT_TRUE(pointsIntoParser(guarded, p.getQuery()));
+  const char* end = (const char*)&guarded.parser + sizeof(guarded.parser);
+  TEST_ASSERT_TRUE(p.getBody() + p.getBodyLength() <= end);
+}
+
+// Random splits and byte mutations of the captured requests: however the
+// bytes arrive, the parser reaches the same verdict and stays in its buffer
+void test_fuzzed_requests_parse_the_same_however_split() {
+  static GuardedParser guarded;
+  memset(guarded.before, GUARD, sizeof(guarded.before));
+  memset(guarded.after, GUARD, sizeof(guarded.after));
+  HttpRequestParser& p = guarded.parser;
+  srand(28);
+
+  static char request[HTTP_MAX_REQUEST_SIZE + 256];
+  int completed = 0;
+  for (int round = 0; round < 4000; round++) {
+    const char* source = CAPTURED[round % CAPTURED_COUNT];
+    size_t length = strlen(source);
+    memcpy(request, source, length);
+
+    // Three rounds in four damage up to eight bytes; some also run on
+    // past the buffer with filler
+    if (round % 4 != 0) {
+      int changes = 1 + rand() % 8;
+      for (int i = 0; i < changes; i++) {
+        request[rand() % length] = (char)(rand() % 256);
+      }
+    }
+    if (round % 16 == 5) {
+      size_t extra = sizeof(request) - length;
+      memset(request + length, 'x', extra);
+      length += extra;
+    }
+
+    ParseOutcome whole;
+    p.reset();
+    p.feed((const uint8_t*)request, length);
+    checkGuards(guarded);
+    recordOutcome(p, whole);
+
+    ParseOutcome split;
+    p.reset();
+    for (size_t at = 0; at < length; ) {
+      size_t chunk = min((size_t)(1 + rand() % 48), length - at);
+      p.feed((const uint8_t*)request + at, chunk);
+      checkGuards(guarded);
+      at += chunk;
+    }
+    recordOutcome(p, split);
+
+    TEST_ASSERT_EQUAL_MEMORY(&whole, &split, sizeof(whole));
+    if (whole.state == HttpParseState::ERROR) {
+      TEST_ASSERT_TRUE(whole.status >= 400 && whole.status <= 505);
+    }
+    if (round % 4 == 0) {
+      TEST_ASSERT_TRUE(whole.state == HttpParseState::COMPLETE);
+      completed++;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(1000, completed);
+}
+
+// Parsing, parameter lookups and pipelining never touch the heap
+void test_parsing_allocates_nothing() {
+  allocations = 0;
+  delete new int(1);
+  TEST_ASSERT_EQUAL_UINT32(1, allocations);   // The counter is live
+
+  char pipelined[HTTP_MAX_REQUEST_SIZE];
+  size_t length = 0;
+  for (int i = 0; i < CAPTURED_COUNT; i++) {
+    size_t part = strlen(CAPTURED[i]);
+    memcpy(pipelined + length, CAPTURED[i], part);
+    length += part;
+  }
+
+  allocations = 0;
+  char value[32];
+  for (int round = 0; round < 100; round++) {
+    parser.reset();
+    for (size_t at = 0; at < length; at += 7) {
+      parser.feed((const uint8_t*)pipelined + at, min((size_t)7, length - at));
+    }
+    int served = 0;
+    while (parser.isComplete()) {
+      parser.getHeader("Content-Type");
+      parser.getQueryParam("channel", value, sizeof(value));
+      parser.getFormParam("value", value, sizeof(value));
+      parser.consumeRequest();
+      served++;
+    }
+    TEST_ASSERT_EQUAL_INT(CAPTURED_COUNT, served);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+// Host throughput over the captured requests, for comparing parser changes
+void test_parse_throughput() {
+  const int rounds = 50000;
+  size_t lengths[CAPTURED_COUNT];
+  size_t bytes = 0;
+  for (int i = 0; i < CAPTURED_COUNT; i++) {
+    lengths[i] = strlen(CAPTURED[i]);
+    bytes += lengths[i];
+  }
+
+  int completed = 0;
+  unsigned long start = micros();
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < CAPTURED_COUNT; i++) {
+      parser.reset();
+      parser.feed((const uint8_t*)CAPTURED[i], lengths[i]);
+      completed += parser.isComplete();
+    }
+  }
+  unsigned long elapsed = max(micros() - start, 1UL);
+  TEST_ASSERT_EQUAL_INT(rounds * CAPTURED_COUNT, completed);
+
+  char report[96];
+  snprintf(report, sizeof(report), "Parser: %.1f MB/s, %.0f ns per request",
+           (double)bytes * rounds / elapsed, elapsed * 1000.0 / completed);
+  TEST_MESSAGE(report);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_get_with_query_and_headers);
+  RUN_TEST(test_request_split_across_reads);
+  RUN_TEST(test_body_waits_for_content_length);
+  RUN_TEST(test_bare_lf_line_endings);
+  RUN_TEST(test_bulk_write_through_write_ptr);
+  RUN_TEST(test_malformed_requests_are_rejected);
+  RUN_TEST(test_oversized_header_block_is_rejected);
+  RUN_TEST(test_query_and_form_params_are_decoded);
+  RUN_TEST(test_keep_alive_follows_version_and_connection_header);
+  RUN_TEST(test_pipelined_requests_are_served_in_turn);
+  RUN_TEST(test_consuming_an_unfinished_request_resets);
+  RUN_TEST(test_fuzzed_requests_parse_the_same_however_split);
+  RUN_TEST(test_parsing_allocates_nothing);
+  RUN_TEST(test_parse_throughput);
+  return UNITY_END();
+}
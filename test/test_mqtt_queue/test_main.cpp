@@ -0,0 +1,184 @@
+#include <unity.h>
+#include "MqttQueue.h"
+
+static MemoryMqttStorage* storage;
+static MqttQueue* queue;
+
+static MqttMessage makeMessage(const char* payload, uint8_t qos, bool urgent) {
+  MqttMessage message;
+  memset(&message, 0, sizeof(message));
+  strcpy(message.topic, urgent ? "aqua/test/alarm" : "aqua/test/telemetry");
+  strcpy(message.payload, payload);
+  message.length = strlen(payload);
+  message.qos = qos;
+  message.urgent = urgent;
+  return message;
+}
+
+// Peeks and pops the front message, returning its payload
+static String takeFront() {
+  static MqttMessage message;
+  if (!queue->peek(message)) return String("");
+  message.payload[message.length] = '\0';
+  queue->pop();
+  return String(message.payload);
+}
+
+// A new queue over the same bytes, as after a reboot
+static void restart() {
+  delete queue;
+  queue = new MqttQueue();
+  queue->setStorage(storage);
+  TEST_ASSERT_TRUE(queue->begin());
+}
+
+void setUp() {
+  storage = new MemoryMqttStorage();
+  queue = new MqttQueue();
+  queue->setStorage(storage);
+  TEST_ASSERT_TRUE(queue->begin());
+}
+
+void tearDown() {
+  delete queue;
+  delete storage;
+}
+
+void test_messages_leave_in_push_order() {
+  TEST_ASSERT_TRUE(queue->isEmpty());
+  for (int i = 0; i < 3; i++) {
+    MqttMessage message = makeMessage(String(i).c_str(), 1, false);
+    TEST_ASSERT_TRUE(queue->push(message));
+  }
+  TEST_ASSERT_EQUAL_INT(3, queue->size());
+  TEST_ASSERT_EQUAL_STRING("0", takeFront().c_str());
+  TEST_ASSERT_EQUAL_STRING("1", takeFront().c_str());
+  TEST_ASSERT_EQUAL_STRING("2", takeFront().c_str());
+  TEST_ASSERT_TRUE(queue->isEmpty());
+}
+
+void test_peek_returns_the_whole_message() {
+  MqttMessage message = makeMessage("{\"ph\":7.1}", 1, false);
+  message.retained = true;
+  TEST_ASSERT_TRUE(queue->push(message));
+
+  MqttMessage front;
+  TEST_ASSERT_TRUE(queue->peek(front));
+  TEST_ASSERT_EQUAL_STRING("aqua/test/telemetry", front.topic);
+  TEST_ASSERT_EQUAL_UINT16(message.length, front.length);
+  TEST_ASSERT_EQUAL_MEMORY(message.payload, front.payload, message.length);
+  TEST_ASSERT_EQUAL_UINT8(1, front.qos);
+  TEST_ASSERT_TRUE(front.retained);
+  TEST_ASSERT_FALSE(front.urgent);
+  TEST_ASSERT_EQUAL_INT(1, queue->size());   // peek() leaves it queued
+}
+
+void test_alarms_leave_first_in_their_own_order() {
+  MqttMessage message;
+  message = makeMessage("t1", 0, false);
+  queue->push(message);
+  message = makeMessage("a1", 1, true);
+  queue->push(message);
+  message = makeMessage("t2", 0, false);
+  queue->push(message);
+  message = makeMessage("a2", 1, true);
+  queue->push(message);
+  TEST_ASSERT_EQUAL_INT(2, queue->urgentCount());
+
+  TEST_ASSERT_EQUAL_STRING("a1", takeFront().c_str());
+  TEST_ASSERT_EQUAL_STRING("a2", takeFront().c_str());
+  TEST_ASSERT_EQUAL_INT(0, queue->urgentCount());
+  TEST_ASSERT_EQUAL_STRING("t1", takeFront().c_str());
+  TEST_ASSERT_EQUAL_STRING("t2", takeFront().c_str());
+}
+
+void test_restart_restores_messages_and_sequence() {
+  MqttMessage message;
+  message = makeMessage("t1", 1, false);
+  queue->push(message);
+  message = makeMessage("a1", 1, true);
+  queue->push(message);
+
+  restart();
+  TEST_ASSERT_EQUAL_INT(2, queue->size());
+  TEST_ASSERT_EQUAL_INT(1, queue->urgentCount());
+
+  // New messages go behind the restored ones
+  message = makeMessage("t2", 1, false);
+  queue->push(message);
+  TEST_ASSERT_EQUAL_STRING("a1", takeFront().c_str());
+  TEST_ASSERT_EQUAL_STRING("t1", takeFront().c_str());
+  TEST_ASSERT_EQUAL_STRING("t2", takeFront().c_str());
+}
+
+void test_full_queue_drops_oldest_qos0_first() {
+  MqttMessage message = makeMessage("first-qos1", 1, false);
+  queue->push(message);
+  message = makeMessage("first-qos0", 0, false);
+  queue->push(message);
+  for (int i = 2; i < queue->capacity(); i++) {
+    message = makeMessage("qos1", 1, false);
+    queue->push(message);
+  }
+  TEST_ASSERT_EQUAL_INT(queue->capacity(), queue->size());
+
+  message = makeMessage("overflow", 1, false);
+  TEST_ASSERT_TRUE(queue->push(message));
+  TEST_ASSERT_EQUAL_INT(queue->capacity(), queue->size());
+  TEST_ASSERT_EQUAL_UINT32(1, queue->getDropped());
+  TEST_ASSERT_EQUAL_STRING("first-qos1", takeFront().c_str());
+
+  // No QoS 0 left: the oldest message of all makes room
+  message = makeMessage("overflow", 1, false);
+  queue->push(message);
+  message = makeMessage("overflow", 1, false);
+  queue->push(message);
+  TEST_ASSERT_EQUAL_UINT32(2, queue->getDropped());
+}
+
+void test_corrupt_record_is_dropped_at_the_front() {
+  MqttMessage message = makeMessage("good-1", 1, false);
+  queue->push(message);
+  message = makeMessage("good-2", 1, false);
+  queue->push(message);
+
+  // Flip a payload byte of the first record (slot 0)
+  storage->data()[sizeof(MqttRecordHeader) + strlen(message.topic)] ^= 0xFF;
+
+  TEST_ASSERT_EQUAL_STRING("good-2", takeFront().c_str());
+  TEST_ASSERT_EQUAL_UINT32(1, queue->getDropped());
+  TEST_ASSERT_TRUE(queue->isEmpty());
+}
+
+void test_slot_without_header_reads_as_free() {
+  MqttMessage message = makeMessage("kept", 1, false);
+  queue->push(message);
+  message = makeMessage("torn", 1, false);
+  queue->push(message);
+
+  // Power lost before the second header was written
+  memset(storage->data() + MQTT_SLOT_BYTES, 0, sizeof(MqttRecordHeader));
+  restart();
+  TEST_ASSERT_EQUAL_INT(1, queue->size());
+  TEST_ASSERT_EQUAL_STRING("kept", takeFront().c_str());
+}
+
+void test_oversized_message_is_refused() {
+  MqttMessage message = makeMessage("x", 1, false);
+  message.length = MQTT_PAYLOAD_LENGTH + 1;
+  TEST_ASSERT_FALSE(queue->push(message));
+  TEST_ASSERT_TRUE(queue->isEmpty());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_messages_leave_in_push_order);
+  RUN_TEST(test_peek_returns_the_whole_message);
+  RUN_TEST(test_alarms_leave_first_in_their_own_order);
+  RUN_TEST(test_restart_restores_messages_and_sequence);
+  RUN_TEST(test_full_queue_drops_oldest_qos0_first);
+  RUN_TEST(test_corrupt_record_is_dropped_at_the_front);
+  RUN_TEST(test_slot_without_header_reads_as_free);
+  RUN_TEST(test_oversized_message_is_refused);
+  return UNITY_END();
+}
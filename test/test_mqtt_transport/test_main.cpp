@@ -0,0 +1,206 @@
+#include <unity.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "MqttTransport.h"
+
+// One-connection MQTT broker on a loopback port, run on its own thread.
+// Records what the client sent and answers CONNECT, QoS 1 PUBLISH and
+// PINGREQ unless told to stay silent. Read the records after finish().
+struct Published {
+  std::string topic;
+  std::string payload;
+  int qos;
+  bool retained;
+};
+
+class LoopbackBroker {
+private:
+  int listener;
+  std::thread worker;
+
+  static bool readExact(int fd, uint8_t* data, size_t length) {
+    size_t received = 0;
+    while (received < length) {
+      ssize_t got = recv(fd, data + received, length - received, 0);
+      if (got <= 0) return false;
+      received += got;
+    }
+    return true;
+  }
+
+  static std::string readString(const std::string& body, size_t& at) {
+    size_t length = ((uint8_t)body[at] << 8) | (uint8_t)body[at + 1];
+    std::string text = body.substr(at + 2, length);
+    at += 2 + length;
+    return text;
+  }
+
+  void serve() {
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) return;
+    for (;;) {
+      uint8_t type;
+      if (!readExact(fd, &type, 1)) break;
+      size_t length = 0, multiplier = 1;
+      uint8_t digit;
+      do {
+        if (!readExact(fd, &digit, 1)) break;
+        length += (digit & 0x7F) * multiplier;
+        multiplier *= 128;
+      } while (digit & 0x80);
+      std::string body(length, '\0');
+      if (length > 0 && !readExact(fd, (uint8_t*)&body[0], length)) break;
+
+      uint8_t kind = type & 0xF0;
+      if (kind == 0x10) {                     // CONNECT
+        size_t at = 0;
+        readString(body, at);                 // "MQTT"
+        at += 4;                              // Level, flags, keepalive
+        clientId = readString(body, at);
+        willTopic = readString(body, at);
+        if (answer) send(fd, "\x20\x02\x00\x00", 4, MSG_NOSIGNAL);
+      } else if (kind == 0x30) {              // PUBLISH
+        Published message;
+        message.qos = (type >> 1) & 0x03;
+        message.retained = type & 0x01;
+        size_t at = 0;
+        message.topic = readString(body, at);
+        uint16_t id = 0;
+        if (message.qos > 0) {
+          id = ((uint8_t)body[at] << 8) | (uint8_t)body[at + 1];
+          at += 2;
+        }
+        message.payload = body.substr(at);
+        messages.push_back(message);
+        if (message.qos > 0 && answer) {
+          uint8_t ack[4] = { 0x40, 0x02, (uint8_t)(id >> 8), (uint8_t)(id & 0xFF) };
+          send(fd, ack, sizeof(ack), MSG_NOSIGNAL);
+        }
+      } else if (kind == 0xC0) {              // PINGREQ
+        pings++;
+        if (answer) send(fd, "\xD0\x00", 2, MSG_NOSIGNAL);
+      } else if (kind == 0xE0) {              // DISCONNECT
+        disconnected = true;
+        break;
+      }
+    }
+    close(fd);
+  }
+
+public:
+  std::vector<Published> messages;
+  std::string clientId;
+  std::string willTopic;
+  int pings;
+  bool disconnected;
+  std::atomic<bool> answer;
+  int port;
+
+  LoopbackBroker() : pings(0), disconnected(false), answer(true), port(0) {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (sockaddr*)&address, sizeof(address));
+    socklen_t size = sizeof(address);
+    getsockname(listener, (sockaddr*)&address, &size);
+    port = ntohs(address.sin_port);
+    listen(listener, 1);
+    worker = std::thread(&LoopbackBroker::serve, this);
+  }
+
+  ~LoopbackBroker() {
+    shutdown(listener, SHUT_RDWR);
+    close(listener);
+    finish();
+  }
+
+  // Waits until the client has disconnected
+  void finish() {
+    if (worker.joinable()) worker.join();
+  }
+};
+
+static LoopbackBroker* broker;
+static PosixMqttTransport* transport;
+
+void setUp() {
+  broker = new LoopbackBroker();
+  transport = new PosixMqttTransport();
+  transport->begin("127.0.0.1", broker->port, 30);
+}
+
+void tearDown() {
+  delete transport;                           // Closes the socket, so the broker thread ends
+  delete broker;
+}
+
+void test_connect_sends_client_id_and_will() {
+  TEST_ASSERT_TRUE(transport->connect("aqua-test", "", "", "aqua/aqua-test/status", "offline"));
+  TEST_ASSERT_TRUE(transport->connected());
+  transport->disconnect();
+  TEST_ASSERT_FALSE(transport->connected());
+  broker->finish();
+
+  TEST_ASSERT_EQUAL_STRING("aqua-test", broker->clientId.c_str());
+  TEST_ASSERT_EQUAL_STRING("aqua/aqua-test/status", broker->willTopic.c_str());
+}
+
+void test_connect_fails_without_a_broker() {
+  transport->begin("127.0.0.1", 1, 30);       // Nothing listens on port 1
+  TEST_ASSERT_FALSE(transport->connect("aqua-test", "", "", "t", "offline"));
+  TEST_ASSERT_FALSE(transport->connected());
+}
+
+void test_publish_qos0_and_qos1() {
+  TEST_ASSERT_TRUE(transport->connect("aqua-test", "", "", "t", "offline"));
+  TEST_ASSERT_TRUE(transport->publish("aqua/telemetry", "{\"ph\":7}", 8, false, 0));
+  TEST_ASSERT_TRUE(transport->publish("aqua/alarm", "{\"raised\":1}", 12, true, 1));
+  transport->disconnect();
+  broker->finish();
+
+  TEST_ASSERT_TRUE(broker->disconnected);
+  TEST_ASSERT_EQUAL_INT(2, broker->messages.size());
+  TEST_ASSERT_EQUAL_STRING("aqua/telemetry", broker->messages[0].topic.c_str());
+  TEST_ASSERT_EQUAL_STRING("{\"ph\":7}", broker->messages[0].payload.c_str());
+  TEST_ASSERT_EQUAL_INT(0, broker->messages[0].qos);
+  TEST_ASSERT_FALSE(broker->messages[0].retained);
+  TEST_ASSERT_EQUAL_STRING("aqua/alarm", broker->messages[1].topic.c_str());
+  TEST_ASSERT_EQUAL_INT(1, broker->messages[1].qos);
+  TEST_ASSERT_TRUE(broker->messages[1].retained);
+}
+
+void test_qos1_publish_fails_without_puback() {
+  TEST_ASSERT_TRUE(transport->connect("aqua-test", "", "", "t", "offline"));
+  broker->answer = false;
+  TEST_ASSERT_FALSE(transport->publish("aqua/alarm", "x", 1, false, 1));
+  TEST_ASSERT_FALSE(transport->connected());
+}
+
+void test_large_payload_is_framed() {
+  static char payload[MQTT_PAYLOAD_LENGTH];
+  memset(payload, 'x', sizeof(payload));
+  TEST_ASSERT_TRUE(transport->connect("aqua-test", "", "", "t", "offline"));
+  TEST_ASSERT_TRUE(transport->publish("aqua/telemetry", payload, sizeof(payload), false, 1));
+  transport->disconnect();
+  broker->finish();
+
+  TEST_ASSERT_EQUAL_INT(1, broker->messages.size());
+  TEST_ASSERT_EQUAL_INT(sizeof(payload), broker->messages[0].payload.size());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_connect_sends_client_id_and_will);
+  RUN_TEST(test_connect_fails_without_a_broker);
+  RUN_TEST(test_publish_qos0_and_qos1);
+  RUN_TEST(test_qos1_publish_fails_without_puback);
+  RUN_TEST(test_large_payload_is_framed);
+  return UNITY_END();
+}
@@ -0,0 +1,199 @@
+#include <unity.h>
+#include "MultiplexerController.h"
+#include "AdcBackend.h"
+
+// Six banks: TEMP and PH on the shared bus with their own ADC pins, two TDS
+// muxes on one ADC pin told apart by their enable lines, and two banks on
+// their own address lines
+#define TDS_B_EN      22
+#define OWN_A_EN      23
+#define OWN_B_EN      25
+#define OWN_ADC_PIN   34
+
+static const int ownPinsA[MUX_ADDRESS_LINES] = { 12, 13, 14, 15 };
+static const int ownPinsB[MUX_ADDRESS_LINES] = { 26, 27, 16, 17 };
+
+static MultiplexerController* mux;
+static int tempBank, phBank, tdsA, tdsB, ownA, ownB;
+
+void setUp() {
+  nativeGpio.reset();
+  mux = new MultiplexerController();
+  tempBank = mux->addBank(MUX_EN, TEMP_ADC_PIN);
+  phBank = mux->addBank(MUX_EN, PH_ADC_PIN);
+  tdsA = mux->addBank(MUX_EN, TDS_ADC_PIN);
+  tdsB = mux->addBank(TDS_B_EN, TDS_ADC_PIN);
+  ownA = mux->addBank(OWN_A_EN, OWN_ADC_PIN, ownPinsA);
+  ownB = mux->addBank(OWN_B_EN, OWN_ADC_PIN, ownPinsB);
+  mux->begin(false);
+}
+
+void tearDown() {
+  delete mux;
+}
+
+void test_banks_start_disabled() {
+  TEST_ASSERT_EQUAL_INT(MAX_MUX_BANKS, mux->getBankCount());
+  TEST_ASSERT_EQUAL_INT(OUTPUT, nativeGpio.mode[TDS_B_EN]);
+  TEST_ASSERT_EQUAL_INT(OUTPUT, nativeGpio.mode[ownPinsB[3]]);
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(MUX_EN));
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(TDS_B_EN));
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(OWN_A_EN));
+  TEST_ASSERT_EQUAL_INT(TDS_ADC_PIN, mux->getAdcPin(tdsB));
+  TEST_ASSERT_EQUAL_INT(-1, mux->getAdcPin(MAX_MUX_BANKS));
+}
+
+void test_bank_limit() {
+  TEST_ASSERT_EQUAL_INT(-1, mux->addBank(32, TEMP_ADC_PIN));
+  TEST_ASSERT_EQUAL_INT(MAX_MUX_BANKS, mux->getBankCount());
+}
+
+void test_select_drives_shared_bus_and_enable() {
+  TEST_ASSERT_TRUE(mux->select(tempBank, 5));   // 0101
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(MUX_S0));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(MUX_S1));
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(MUX_S2));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(MUX_S3));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(MUX_EN));
+
+  // PH shares the bus and the enable line: nothing left to change
+  TEST_ASSERT_FALSE(mux->select(phBank, 5));
+  TEST_ASSERT_EQUAL_UINT32(1, mux->getSelectCount());
+}
+
+void test_own_address_lines_leave_shared_bus_alone() {
+  mux->select(tempBank, 0);
+  mux->select(ownA, 9);                         // 1001
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(ownPinsA[0]));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(ownPinsA[1]));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(ownPinsA[2]));
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(ownPinsA[3]));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(MUX_S0));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(MUX_S3));
+}
+
+void test_banks_on_one_adc_pin_take_turns() {
+  mux->select(tdsA, 3);
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(MUX_EN));
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(TDS_B_EN));
+
+  mux->select(tdsB, 3);
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(MUX_EN));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(TDS_B_EN));
+
+  mux->select(ownA, 0);
+  mux->select(ownB, 0);
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(OWN_A_EN));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(OWN_B_EN));
+}
+
+void test_preselect_only_when_the_current_path_is_untouched() {
+  mux->select(tempBank, 4);
+
+  // Same shared bus: only the channel already selected is free
+  TEST_ASSERT_TRUE(mux->canPreselect(tempBank, phBank, 4));
+  TEST_ASSERT_FALSE(mux->canPreselect(tempBank, phBank, 5));
+  // Own address lines and ADC pin
+  TEST_ASSERT_TRUE(mux->canPreselect(tempBank, ownA, 7));
+  // Same ADC pin, other enable line: would disconnect the current bank
+  mux->select(tdsA, 4);
+  TEST_ASSERT_FALSE(mux->canPreselect(tdsA, tdsB, 4));
+  mux->select(ownA, 2);
+  TEST_ASSERT_FALSE(mux->canPreselect(ownA, ownB, 2));
+  TEST_ASSERT_FALSE(mux->canPreselect(ownA, MAX_MUX_BANKS, 0));
+}
+
+void test_enable_edges_are_counted() {
+  mux->select(tdsA, 0);                         // 4 unknown lines + EN
+  TEST_ASSERT_EQUAL_UINT32(5, mux->getEdgeCount());
+  mux->select(tdsB, 0);                         // EN off, TDS_B on
+  TEST_ASSERT_EQUAL_UINT32(7, mux->getEdgeCount());
+}
+
+// Costs for the cycle simulation, charged to the stub clock: the default
+// settle time after a select, and a oneshot ADC1 read of roughly 12 us
+#define SIM_SETTLE_US      100
+#define SIM_CONVERSION_US  12
+#define SIM_SAMPLES        10
+
+class TimedAdcBackend : public AdcBackend {
+public:
+  void begin() {}
+  int readRaw(int pin) {
+    delayMicroseconds(SIM_CONVERSION_US);
+    return 2048;
+  }
+  const char* name() const { return "timed"; }
+};
+
+// Every channel of every bank in scan plan order (mux channel, then bank),
+// as SensorController::updateAllReadings() runs it, optionally selecting
+// the next bank while this one is converted. Returns the cycle in us.
+static unsigned long scanCycle(MultiplexerController& rack, AdcBackend& adc, bool interleave) {
+  uint16_t raw[SIM_SAMPLES];
+  int banks = rack.getBankCount();
+  unsigned long start = micros();
+  for (int i = 0; i < MUX_CHANNEL_CAPACITY; i++) {
+    int channel = MultiplexerController::scanChannel(i);
+    for (int bank = 0; bank < banks; bank++) {
+      rack.select(bank, channel);
+      bool lastBank = bank + 1 == banks;
+      if (interleave && (!lastBank || i + 1 < MUX_CHANNEL_CAPACITY)) {
+        int nextBank = lastBank ? 0 : bank + 1;
+        int nextChannel = lastBank ? MultiplexerController::scanChannel(i + 1) : channel;
+        if (rack.canPreselect(bank, nextBank, nextChannel)) {
+          rack.select(nextBank, nextChannel);
+        }
+      }
+      rack.waitSettled(bank, SIM_SETTLE_US);
+      adc.readSamples(rack.getAdcPin(bank), raw, SIM_SAMPLES, 0);
+    }
+  }
+  return micros() - start;
+}
+
+// Six banks on the shared bus, two per ADC pin with their own enable lines,
+// so every step changes an enable line and has to settle. Serially that is
+// settle + conversions per step. Interleaved, each bank settles during the
+// previous bank's conversions; only the first bank of each channel, after
+// the shared bus moved, waits out its settle time.
+void test_interleaved_scan_of_six_banks() {
+  static const int enables[6] = { MUX_EN, TDS_B_EN, OWN_A_EN, OWN_B_EN, 18, 19 };
+  static const int adcPins[6] = { TEMP_ADC_PIN, PH_ADC_PIN, TDS_ADC_PIN, TEMP_ADC_PIN, PH_ADC_PIN, TDS_ADC_PIN };
+  MultiplexerController rack;
+  for (int i = 0; i < 6; i++) {
+    rack.addBank(enables[i], adcPins[i]);
+  }
+  rack.begin(false);
+  TimedAdcBackend adc;
+
+  unsigned long serialUs = scanCycle(rack, adc, false);
+  unsigned long interleavedUs = scanCycle(rack, adc, true);
+
+  const unsigned long conversionUs = SIM_SAMPLES * SIM_CONVERSION_US;
+  const unsigned long steps = 6 * MUX_CHANNEL_CAPACITY;
+  const unsigned long expectedSerial = steps * (SIM_SETTLE_US + conversionUs);
+  const unsigned long expectedInterleaved = MUX_CHANNEL_CAPACITY * SIM_SETTLE_US + steps * conversionUs;
+
+  char message[128];
+  snprintf(message, sizeof(message), "6 banks x 16 channels: serial %lu us, interleaved %lu us (%.0f%% of serial)",
+           serialUs, interleavedUs, 100.0 * interleavedUs / serialUs);
+  TEST_MESSAGE(message);
+
+  // Host time between the simulated waits is the only slack
+  TEST_ASSERT_UINT32_WITHIN(expectedSerial / 50, expectedSerial, serialUs);
+  TEST_ASSERT_UINT32_WITHIN(expectedInterleaved / 50, expectedInterleaved, interleavedUs);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_banks_start_disabled);
+  RUN_TEST(test_bank_limit);
+  RUN_TEST(test_select_drives_shared_bus_and_enable);
+  RUN_TEST(test_own_address_lines_leave_shared_bus_alone);
+  RUN_TEST(test_banks_on_one_adc_pin_take_turns);
+  RUN_TEST(test_preselect_only_when_the_current_path_is_untouched);
+  RUN_TEST(test_enable_edges_are_counted);
+  RUN_TEST(test_interleaved_scan_of_six_banks);
+  return UNITY_END();
+}
@@ -0,0 +1,142 @@
+#include <unity.h>
+#include <chrono>
+#include "MultiplexerController.h"
+
+static MultiplexerController* mux;
+static int bank;
+
+void setUp() {
+  nativeGpio.reset();
+  mux = new MultiplexerController();
+  bank = mux->addBank(MUX_EN, TEMP_ADC_PIN);
+  mux->begin(false);
+}
+
+void tearDown() {
+  delete mux;
+}
+
+static int addressOnPins() {
+  return digitalRead(MUX_S0) | (digitalRead(MUX_S1) << 1) |
+         (digitalRead(MUX_S2) << 2) | (digitalRead(MUX_S3) << 3);
+}
+
+void test_scan_order_visits_every_channel_once() {
+  bool seen[MUX_CHANNEL_CAPACITY] = {};
+  for (int i = 0; i < MUX_CHANNEL_CAPACITY; i++) {
+    int channel = MultiplexerController::scanChannel(i);
+    TEST_ASSERT_TRUE(channel >= 0 && channel < MUX_CHANNEL_CAPACITY);
+    TEST_ASSERT_FALSE(seen[channel]);
+    seen[channel] = true;
+  }
+  TEST_ASSERT_EQUAL_INT(3, MultiplexerController::scanChannel(2));
+  TEST_ASSERT_EQUAL_INT(2, MultiplexerController::scanChannel(3));
+  TEST_ASSERT_EQUAL_INT(8, MultiplexerController::scanChannel(15));
+}
+
+// After the first select, each step flips one address line with one
+// set or clear register write
+void test_each_step_is_one_edge_and_one_write() {
+  mux->select(bank, MultiplexerController::scanChannel(0));
+  for (int i = 1; i < MUX_CHANNEL_CAPACITY; i++) {
+    int channel = MultiplexerController::scanChannel(i);
+    unsigned long edges = mux->getEdgeCount();
+    unsigned long writes = nativeGpio.writes;
+    TEST_ASSERT_TRUE(mux->select(bank, channel));
+    TEST_ASSERT_EQUAL_UINT32(edges + 1, mux->getEdgeCount());
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, nativeGpio.writes);
+    TEST_ASSERT_EQUAL_INT(channel, addressOnPins());
+  }
+}
+
+// A full scan: 4 lines and the enable to start, then one line per step.
+// Index order flips 26 lines over the same 15 steps.
+void test_scan_edges_per_cycle() {
+  for (int i = 0; i < MUX_CHANNEL_CAPACITY; i++) {
+    mux->select(bank, MultiplexerController::scanChannel(i));
+  }
+  TEST_ASSERT_EQUAL_UINT32(4 + 1 + 15, mux->getEdgeCount());
+  TEST_ASSERT_EQUAL_UINT32(MUX_CHANNEL_CAPACITY, mux->getSelectCount());
+
+  unsigned long edges = mux->getEdgeCount();
+  for (int channel = 0; channel < MUX_CHANNEL_CAPACITY; channel++) {
+    mux->select(bank, channel);
+  }
+  TEST_ASSERT_EQUAL_UINT32(edges + 1 + 26, mux->getEdgeCount());   // 8 -> 0 first
+}
+
+void test_reselecting_the_channel_writes_nothing() {
+  mux->select(bank, 6);
+  unsigned long writes = nativeGpio.writes;
+  TEST_ASSERT_FALSE(mux->select(bank, 6));
+  TEST_ASSERT_EQUAL_UINT32(writes, nativeGpio.writes);
+}
+
+// GPIO32 and above are outside the set/clear register: one digitalWrite per line
+void test_high_pins_fall_back_to_digital_write() {
+  delete mux;
+  nativeGpio.reset();
+  mux = new MultiplexerController();
+  mux->setSharedAddressPins(MUX_S0, MUX_S1, MUX_S2, 32);
+  bank = mux->addBank(MUX_EN, TEMP_ADC_PIN);
+  mux->begin(false);
+
+  mux->select(bank, 0);
+  unsigned long writes = nativeGpio.writes;
+  mux->select(bank, 8);
+  TEST_ASSERT_EQUAL_UINT32(writes + MUX_ADDRESS_LINES, nativeGpio.writes);
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(32));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(MUX_S0));
+}
+
+// Repeated scan cycles of one bank; fills in ns per select on the host and
+// the edges and GPIO writes of one steady-state cycle
+static void timeSelects(bool grayOrder, double& nsPerSelect, unsigned long& edges, unsigned long& writes) {
+  const int cycles = 20000;
+  const int last = MUX_CHANNEL_CAPACITY - 1;
+  mux->select(bank, grayOrder ? MultiplexerController::scanChannel(last) : last);   // As a cycle ends
+  unsigned long edgesBefore = mux->getEdgeCount();
+  unsigned long writesBefore = nativeGpio.writes;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int cycle = 0; cycle < cycles; cycle++) {
+    for (int i = 0; i < MUX_CHANNEL_CAPACITY; i++) {
+      mux->select(bank, grayOrder ? MultiplexerController::scanChannel(i) : i);
+    }
+  }
+  std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  nsPerSelect = (double)elapsed.count() / (cycles * MUX_CHANNEL_CAPACITY);
+  edges = (mux->getEdgeCount() - edgesBefore) / cycles;
+  writes = (nativeGpio.writes - writesBefore) / cycles;
+}
+
+// Host time includes the stub's emulation of the set/clear registers, so
+// only the edge and write counts carry over to the ESP32 as they are
+void test_select_microbenchmark() {
+  double grayNs, indexNs;
+  unsigned long grayEdges, grayWrites, indexEdges, indexWrites;
+  timeSelects(true, grayNs, grayEdges, grayWrites);
+  timeSelects(false, indexNs, indexEdges, indexWrites);
+
+  char message[160];
+  snprintf(message, sizeof(message),
+           "Per cycle of 16 selects: Gray %.1f ns/select, %lu edges, %lu writes; index %.1f ns/select, %lu edges, %lu writes",
+           grayNs, grayEdges, grayWrites, indexNs, indexEdges, indexWrites);
+  TEST_MESSAGE(message);
+
+  // Gray order wraps 8 -> 0 with one edge too: one edge and one write per select
+  TEST_ASSERT_EQUAL_UINT32(MUX_CHANNEL_CAPACITY, grayEdges);
+  TEST_ASSERT_EQUAL_UINT32(MUX_CHANNEL_CAPACITY, grayWrites);
+  TEST_ASSERT_EQUAL_UINT32(26 + 4, indexEdges);   // 15 -> 0 flips all four
+  TEST_ASSERT_GREATER_THAN(MUX_CHANNEL_CAPACITY, indexWrites);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_scan_order_visits_every_channel_once);
+  RUN_TEST(test_each_step_is_one_edge_and_one_write);
+  RUN_TEST(test_scan_edges_per_cycle);
+  RUN_TEST(test_reselecting_the_channel_writes_nothing);
+  RUN_TEST(test_high_pins_fall_back_to_digital_write);
+  RUN_TEST(test_select_microbenchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,239 @@
+#include <unity.h>
+#include "NetworkManager.h"
+
+static NetworkManager* network;
+static unsigned long now;
+
+static const uint8_t AP_BSSID[6] = { 0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56 };
+
+// 1 s first retry, 10 s attempt timeout
+static void begin() {
+  WiFiSettings wifi;
+  wifi.ssid = "tank-room";
+  wifi.password = "secret";
+  wifi.backoffMinMs = 1000;
+  wifi.backoffMaxMs = 8000;
+  wifi.connectTimeoutMs = 10000;
+  network->begin(wifi);
+}
+
+// The access point the driver reports once associated
+static void setAccessPoint(int channel) {
+  memcpy(WiFi.apBssid, AP_BSSID, sizeof(AP_BSSID));
+  WiFi.hasBssid = true;
+  WiFi.apChannel = channel;
+  WiFi.rssi = -58;
+}
+
+static bool step(unsigned long ms) {
+  now += ms;
+  return network->update(now);
+}
+
+// Starts the machine and brings the link up at t + 200 ms
+static void connect() {
+  TEST_ASSERT_TRUE(network->startConnect());
+  now = millis() + 200;
+  network->handleEvent(NetworkEvent::GOT_IP, 0, now);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTED, (int)network->getState());
+}
+
+void setUp() {
+  WiFi.reset();
+  network = new NetworkManager();
+  begin();
+  setAccessPoint(11);
+}
+
+void tearDown() {
+  delete network;
+}
+
+void test_start_needs_settings() {
+  NetworkManager unconfigured;
+  TEST_ASSERT_FALSE(unconfigured.startConnect());
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::IDLE, (int)unconfigured.getState());
+}
+
+void test_connects_and_reports_the_link_once() {
+  TEST_ASSERT_EQUAL_INT(WIFI_STA, WiFi.lastMode);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::IDLE, (int)network->getState());
+  TEST_ASSERT_TRUE(network->startConnect());
+  now = millis();
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+  TEST_ASSERT_EQUAL_INT(1, WiFi.beginCalls);
+  TEST_ASSERT_EQUAL_STRING("tank-room", WiFi.lastSsid.c_str());
+  TEST_ASSERT_FALSE(WiFi.lastUsedBssid);   // Nothing cached yet: full scan
+
+  network->handleEvent(NetworkEvent::STA_CONNECTED, 0, now + 100);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());   // Still waiting for DHCP
+  network->handleEvent(NetworkEvent::GOT_IP, 0, now + 400);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTED, (int)network->getState());
+  TEST_ASSERT_TRUE(network->checkConnection());
+
+  now += 400;
+  TEST_ASSERT_TRUE(step(10));
+  TEST_ASSERT_FALSE(step(10));
+  const LinkStats& stats = network->getLinkStats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.connects);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.fastReconnects);
+  TEST_ASSERT_EQUAL_INT(-58, stats.rssi);
+}
+
+// A dropped link goes through BACKOFF with no delay and retries the cached AP
+void test_dropped_link_reconnects_to_the_cached_ap() {
+  connect();
+  network->handleEvent(NetworkEvent::DISCONNECTED, 8, now + 5000);
+  now += 5000;
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::BACKOFF, (int)network->getState());
+  TEST_ASSERT_FALSE(network->checkConnection());
+  TEST_ASSERT_EQUAL_UINT32(1, network->getLinkStats().disconnects);
+  TEST_ASSERT_EQUAL_UINT8(8, network->getLinkStats().lastDisconnectReason);
+
+  step(0);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+  TEST_ASSERT_EQUAL_INT(2, WiFi.beginCalls);
+  TEST_ASSERT_TRUE(WiFi.lastUsedBssid);
+  TEST_ASSERT_EQUAL_MEMORY(AP_BSSID, WiFi.lastBssid, sizeof(AP_BSSID));
+  TEST_ASSERT_EQUAL_INT(11, WiFi.lastChannel);
+
+  network->handleEvent(NetworkEvent::GOT_IP, 0, now + 300);
+  const LinkStats& stats = network->getLinkStats();
+  TEST_ASSERT_EQUAL_UINT32(2, stats.connects);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.fastReconnects);
+  TEST_ASSERT_EQUAL_UINT32(300, stats.lastConnectMs);   // From the drop, not the attempt
+  TEST_ASSERT_EQUAL_UINT32(5000, stats.totalConnectedMs);
+}
+
+// An attempt that never gets an IP times out into a jittered backoff.
+// startConnect() reads millis() itself, which may tick once before 'now'.
+void test_attempt_times_out_into_backoff() {
+  network->startConnect();
+  now = millis();
+  step(9998);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+  step(2);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::BACKOFF, (int)network->getState());
+  TEST_ASSERT_EQUAL_INT(1, WiFi.disconnectCalls);
+  TEST_ASSERT_EQUAL_UINT32(1, network->getLinkStats().failedAttempts);
+
+  // One failure: 1 s +/-25%
+  step(749);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::BACKOFF, (int)network->getState());
+  TEST_ASSERT_EQUAL_INT(1, WiFi.beginCalls);
+  step(501);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+  TEST_ASSERT_EQUAL_INT(2, WiFi.beginCalls);
+}
+
+// The echo of our own WiFi.disconnect() while backing off is not another failure
+void test_disconnect_while_backing_off_is_ignored() {
+  network->startConnect();
+  now = millis();
+  step(10000);
+  network->handleEvent(NetworkEvent::DISCONNECTED, 8, now);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::BACKOFF, (int)network->getState());
+  TEST_ASSERT_EQUAL_UINT32(1, network->getLinkStats().failedAttempts);
+}
+
+// Backoff doubles with each failure and stops at the cap
+void test_backoff_grows_to_the_cap() {
+  network->startConnect();
+  now = millis();
+  for (int failures = 1; failures <= 6; failures++) {
+    network->handleEvent(NetworkEvent::DISCONNECTED, 201, now);   // No AP found
+    unsigned long expected = min(1000UL << (failures - 1), 8000UL);
+    step(expected * 3 / 4 - 1);
+    TEST_ASSERT_EQUAL_INT((int)NetworkState::BACKOFF, (int)network->getState());
+    step(expected / 2 + 1);
+    TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+  }
+  TEST_ASSERT_EQUAL_UINT32(6, network->getLinkStats().failedAttempts);
+  TEST_ASSERT_EQUAL_INT(7, WiFi.beginCalls);
+}
+
+// A failed attempt on the cached AP drops it, so the retries after it scan
+// until a connection caches the AP again
+void test_failed_cached_attempt_drops_the_cache() {
+  connect();
+  network->handleEvent(NetworkEvent::DISCONNECTED, 8, now);
+  step(0);
+  TEST_ASSERT_TRUE(WiFi.lastUsedBssid);
+
+  network->handleEvent(NetworkEvent::DISCONNECTED, 15, now);   // Handshake timeout on the cached AP
+  step(1250);
+  TEST_ASSERT_EQUAL_INT(3, WiFi.beginCalls);
+  TEST_ASSERT_FALSE(WiFi.lastUsedBssid);
+  TEST_ASSERT_EQUAL_INT(0, WiFi.lastChannel);
+
+  network->handleEvent(NetworkEvent::DISCONNECTED, 201, now);
+  step(2500);
+  TEST_ASSERT_EQUAL_INT(4, WiFi.beginCalls);
+  TEST_ASSERT_FALSE(WiFi.lastUsedBssid);
+
+  // The AP came back on another channel
+  setAccessPoint(6);
+  network->handleEvent(NetworkEvent::GOT_IP, 0, now + 500);
+  now += 500;
+  TEST_ASSERT_EQUAL_UINT32(0, network->getLinkStats().fastReconnects);
+  network->handleEvent(NetworkEvent::LOST_IP, 0, now + 1000);
+  now += 1000;
+  step(0);
+  TEST_ASSERT_TRUE(WiFi.lastUsedBssid);
+  TEST_ASSERT_EQUAL_INT(6, WiFi.lastChannel);
+}
+
+// Driver events are queued on the WiFi task and only acted on in update()
+void test_driver_events_wait_for_update() {
+  network->startConnect();
+  now = millis();
+  WiFi.fire(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+  WiFi.fire(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+  TEST_ASSERT_TRUE(step(50));
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTED, (int)network->getState());
+
+  WiFi.fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, 200);
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTED, (int)network->getState());
+  step(50);
+  // Dropped, and the zero-delay retry has already started on the same update
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+  TEST_ASSERT_EQUAL_UINT8(200, network->getLinkStats().lastDisconnectReason);
+  TEST_ASSERT_TRUE(WiFi.lastUsedBssid);
+}
+
+// A full queue drops new events rather than overwriting queued ones
+void test_full_event_queue_drops_the_newest() {
+  network->startConnect();
+  now = millis();
+  for (int i = 0; i < NETWORK_EVENT_QUEUE_SIZE - 1; i++) {
+    WiFi.fire(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+  }
+  WiFi.fire(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  TEST_ASSERT_FALSE(step(10));
+  TEST_ASSERT_EQUAL_INT((int)NetworkState::CONNECTING, (int)network->getState());
+
+  WiFi.fire(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  TEST_ASSERT_TRUE(step(10));
+}
+
+void test_state_names() {
+  TEST_ASSERT_EQUAL_STRING("IDLE", network->getStateName());
+  network->startConnect();
+  TEST_ASSERT_EQUAL_STRING("CONNECTING", network->getStateName());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_start_needs_settings);
+  RUN_TEST(test_connects_and_reports_the_link_once);
+  RUN_TEST(test_dropped_link_reconnects_to_the_cached_ap);
+  RUN_TEST(test_attempt_times_out_into_backoff);
+  RUN_TEST(test_disconnect_while_backing_off_is_ignored);
+  RUN_TEST(test_backoff_grows_to_the_cap);
+  RUN_TEST(test_failed_cached_attempt_drops_the_cache);
+  RUN_TEST(test_driver_events_wait_for_update);
+  RUN_TEST(test_full_event_queue_drops_the_newest);
+  RUN_TEST(test_state_names);
+  return UNITY_END();
+}
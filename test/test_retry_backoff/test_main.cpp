@@ -0,0 +1,40 @@
+#include <unity.h>
+#include "RetryBackoff.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_no_failure_means_no_wait() {
+  TEST_ASSERT_EQUAL_UINT32(0, retryBackoffMs(0, 1000, 60000, 12345));
+}
+
+// Entropy 0 puts the jitter at its low end, 25% under the nominal delay
+void test_delay_doubles_per_failure() {
+  TEST_ASSERT_EQUAL_UINT32(750, retryBackoffMs(1, 1000, 60000, 0));
+  TEST_ASSERT_EQUAL_UINT32(1500, retryBackoffMs(2, 1000, 60000, 0));
+  TEST_ASSERT_EQUAL_UINT32(3000, retryBackoffMs(3, 1000, 60000, 0));
+  TEST_ASSERT_EQUAL_UINT32(6000, retryBackoffMs(4, 1000, 60000, 0));
+}
+
+void test_delay_is_capped() {
+  TEST_ASSERT_EQUAL_UINT32(45000, retryBackoffMs(7, 1000, 60000, 0));
+  TEST_ASSERT_EQUAL_UINT32(45000, retryBackoffMs(1000, 1000, 60000, 0));   // Shift clamped, no overflow
+}
+
+void test_jitter_stays_within_25_percent() {
+  for (uint32_t entropy = 0; entropy < 5000; entropy += 37) {
+    unsigned long delayMs = retryBackoffMs(3, 1000, 60000, entropy);
+    TEST_ASSERT_GREATER_OR_EQUAL(3000, delayMs);
+    TEST_ASSERT_LESS_OR_EQUAL(5000, delayMs);
+  }
+  TEST_ASSERT_EQUAL_UINT32(5000, retryBackoffMs(3, 1000, 60000, 2000));   // Top of the span
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_failure_means_no_wait);
+  RUN_TEST(test_delay_doubles_per_failure);
+  RUN_TEST(test_delay_is_capped);
+  RUN_TEST(test_jitter_stays_within_25_percent);
+  return UNITY_END();
+}
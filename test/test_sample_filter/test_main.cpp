@@ -0,0 +1,189 @@
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "SampleFilter.h"
+
+static SampleFilter filter;
+
+static float filterOf(SampleFilterMode mode, const float* values, int count, int trim = 20) {
+  filter.configure(mode, trim);
+  for (int i = 0; i < count; i++) {
+    filter.add(values[i]);
+  }
+  return filter.result();
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Against a full sort, for sizes up to the buffer and runs of equal values
+void test_select_kth_matches_sorting() {
+  srand(7);
+  for (int round = 0; round < 200; round++) {
+    int count = 1 + rand() % SAMPLE_FILTER_MAX_SAMPLES;
+    std::vector<float> values(count);
+    for (int i = 0; i < count; i++) {
+      values[i] = rand() % 16;
+    }
+    std::vector<float> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+
+    int k = rand() % count;
+    float kth = selectKth(values.data(), count, k);
+    TEST_ASSERT_EQUAL_FLOAT(sorted[k], kth);
+    for (int i = 0; i < count; i++) {
+      if (i < k) TEST_ASSERT_TRUE(values[i] <= kth);
+      if (i > k) TEST_ASSERT_TRUE(values[i] >= kth);
+    }
+  }
+}
+
+void test_no_samples_give_zero() {
+  filter.configure(FILTER_MEDIAN);
+  TEST_ASSERT_EQUAL_FLOAT(0.0, filter.result());
+}
+
+void test_mean() {
+  const float values[] = { 1, 2, 3, 10 };
+  TEST_ASSERT_EQUAL_FLOAT(4.0, filterOf(FILTER_MEAN, values, 4));
+}
+
+void test_median_odd_and_even() {
+  const float odd[] = { 9, 1, 5, 3, 7 };
+  TEST_ASSERT_EQUAL_FLOAT(5.0, filterOf(FILTER_MEDIAN, odd, 5));
+  const float even[] = { 9, 1, 5, 3, 7, 100 };
+  TEST_ASSERT_EQUAL_FLOAT(6.0, filterOf(FILTER_MEDIAN, even, 6));
+}
+
+// 20% of 10 reads: the lowest two and highest two are dropped
+void test_trimmed_mean_drops_the_outliers() {
+  const float values[] = { 1000, 10, 9, 10, -500, 10, 11, -400, 10, 2000 };
+  TEST_ASSERT_EQUAL_FLOAT(10.0, filterOf(FILTER_TRIMMED_MEAN, values, 10));
+}
+
+void test_trim_too_small_to_drop_anything_is_the_mean() {
+  const float values[] = { 1, 2, 9 };
+  TEST_ASSERT_EQUAL_FLOAT(4.0, filterOf(FILTER_TRIMMED_MEAN, values, 3));
+}
+
+// Trim is capped at 45%, so something is always kept
+void test_trim_is_capped() {
+  const float values[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+  filterOf(FILTER_TRIMMED_MEAN, values, 10, 90);
+  TEST_ASSERT_EQUAL_FLOAT(5.5, filter.result());
+}
+
+// The mean keeps every read past the buffer, order statistics the first 64
+void test_reads_past_the_buffer() {
+  filter.configure(FILTER_MEAN);
+  for (int i = 0; i < SAMPLE_FILTER_MAX_SAMPLES; i++) filter.add(1.0);
+  for (int i = 0; i < SAMPLE_FILTER_MAX_SAMPLES; i++) filter.add(3.0);
+  TEST_ASSERT_EQUAL_INT(2 * SAMPLE_FILTER_MAX_SAMPLES, filter.getCount());
+  TEST_ASSERT_EQUAL_FLOAT(2.0, filter.result());
+}
+
+void test_running_median_rejects_a_spike() {
+  RunningMedian median;
+  median.setWindow(5);
+  TEST_ASSERT_EQUAL_FLOAT(7.0, median.push(7.0));
+  median.push(7.0);
+  median.push(7.0);
+  TEST_ASSERT_EQUAL_FLOAT(7.0, median.push(14.0));   // Spike
+  TEST_ASSERT_EQUAL_FLOAT(7.0, median.push(7.2));
+
+  // The window slides: old values leave it
+  median.push(8.0);
+  median.push(8.0);
+  TEST_ASSERT_EQUAL_FLOAT(8.0, median.push(8.0));
+}
+
+void test_running_median_window_is_bounded() {
+  RunningMedian median;
+  median.setWindow(0);
+  TEST_ASSERT_EQUAL_FLOAT(3.0, median.push(3.0));
+  TEST_ASSERT_EQUAL_FLOAT(9.0, median.push(9.0));   // Window of one
+
+  // Capped at SAMPLE_FILTER_MAX_WINDOW: the median of 0-99 is that of the last 15
+  median.setWindow(SAMPLE_FILTER_MAX_WINDOW + 10);
+  float last = 0;
+  for (int i = 0; i < 100; i++) {
+    last = median.push(i);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(99 - SAMPLE_FILTER_MAX_WINDOW / 2, last);
+}
+
+void test_mode_names_round_trip() {
+  const SampleFilterMode modes[] = { FILTER_MEAN, FILTER_MEDIAN, FILTER_TRIMMED_MEAN, FILTER_RUNNING_MEDIAN };
+  for (SampleFilterMode mode : modes) {
+    TEST_ASSERT_EQUAL_INT(mode, SampleFilter::parseMode(SampleFilter::modeName(mode)));
+  }
+  TEST_ASSERT_EQUAL_INT(FILTER_MEAN, SampleFilter::parseMode("bogus"));
+}
+
+// The median the TDS sensor used before SampleFilter: a bubble sort of a copy
+static float bubbleSortMedian(const float* values, int count) {
+  float sorted[SAMPLE_FILTER_MAX_SAMPLES];
+  for (int i = 0; i < count; i++) sorted[i] = values[i];
+  for (int j = 0; j < count - 1; j++) {
+    for (int i = 0; i < count - j - 1; i++) {
+      if (sorted[i] > sorted[i + 1]) {
+        float tmp = sorted[i];
+        sorted[i] = sorted[i + 1];
+        sorted[i + 1] = tmp;
+      }
+    }
+  }
+  return count % 2 == 1 ? sorted[count / 2] : (sorted[count / 2] + sorted[count / 2 - 1]) / 2.0;
+}
+
+// Average ns per median of 'count' noisy reads, by SampleFilter or by the old sort
+static double medianNs(int count, bool bubbleSort, float& checksum) {
+  const int rounds = 20000;
+  float values[SAMPLE_FILTER_MAX_SAMPLES];
+  srand(11);
+  checksum = 0;
+  std::chrono::nanoseconds elapsed(0);
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < count; i++) values[i] = 2000 + rand() % 64;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    checksum += bubbleSort ? bubbleSortMedian(values, count) : filterOf(FILTER_MEDIAN, values, count);
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+  return (double)elapsed.count() / rounds;
+}
+
+// Host timing at the old TDS buffer of 30 reads and at the full 64. The
+// two must give the same medians; quickselect is O(n) against O(n^2).
+void test_median_against_bubble_sort_benchmark() {
+  const int sizes[] = { 30, SAMPLE_FILTER_MAX_SAMPLES };
+  for (int count : sizes) {
+    float selectSum, bubbleSum;
+    double selectNs = medianNs(count, false, selectSum);
+    double bubbleNs = medianNs(count, true, bubbleSum);
+
+    char message[128];
+    snprintf(message, sizeof(message), "Median of %d: quickselect %.0f ns, bubble sort %.0f ns (%.1fx)",
+             count, selectNs, bubbleNs, bubbleNs / selectNs);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_EQUAL_FLOAT(bubbleSum, selectSum);
+    TEST_ASSERT_TRUE(selectNs < bubbleNs);
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_select_kth_matches_sorting);
+  RUN_TEST(test_no_samples_give_zero);
+  RUN_TEST(test_mean);
+  RUN_TEST(test_median_odd_and_even);
+  RUN_TEST(test_trimmed_mean_drops_the_outliers);
+  RUN_TEST(test_trim_too_small_to_drop_anything_is_the_mean);
+  RUN_TEST(test_trim_is_capped);
+  RUN_TEST(test_reads_past_the_buffer);
+  RUN_TEST(test_running_median_rejects_a_spike);
+  RUN_TEST(test_running_median_window_is_bounded);
+  RUN_TEST(test_mode_names_round_trip);
+  RUN_TEST(test_median_against_bubble_sort_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,250 @@
+#include <unity.h>
+#include <math.h>
+#include "SampleScheduler.h"
+
+static SampleScheduler scheduler;
+
+static void configureType(int type, unsigned long baseMs, unsigned long minMs, unsigned long maxMs, float threshold) {
+  SamplingConfig config;
+  config.baseMs = baseMs;
+  config.minMs = minMs;
+  config.maxMs = maxMs;
+  config.changeThreshold = threshold;
+  scheduler.configureType(type, config);
+}
+
+static void updateAll(int type, int channel, const float* values, int count) {
+  for (int i = 0; i < count; i++) {
+    scheduler.update(type, channel, values[i]);
+  }
+  scheduler.rebalance();
+}
+
+// Two pH channels at a 5 s base, so the old fixed-rate scan made 0.4 reads/s
+void setUp() {
+  scheduler = SampleScheduler();
+  scheduler.configure(true, 0.1, 5000);
+  configureType(SENSOR_PH, 5000, 1250, 30000, 0.1);
+  scheduler.setChannelCount(SENSOR_PH, 2);
+  scheduler.reset();
+}
+
+void tearDown() {}
+
+void test_disabled_scheduler_samples_every_scan() {
+  scheduler.configure(false, 0.1, 5000);
+  scheduler.markSampled(SENSOR_PH, 0, 1000);
+  TEST_ASSERT_TRUE(scheduler.isDue(SENSOR_PH, 0, 1000));
+  const float values[] = { 7.0, 7.5 };
+  updateAll(SENSOR_PH, 0, values, 2);
+  TEST_ASSERT_EQUAL_UINT32(5000, scheduler.getPeriod(SENSOR_PH, 0));
+}
+
+void test_channel_is_due_after_its_period() {
+  TEST_ASSERT_TRUE(scheduler.isDue(SENSOR_PH, 0, 0));   // Never read
+  scheduler.markSampled(SENSOR_PH, 0, 1000);
+  TEST_ASSERT_FALSE(scheduler.isDue(SENSOR_PH, 0, 5999));
+  TEST_ASSERT_TRUE(scheduler.isDue(SENSOR_PH, 0, 6000));
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.getReads(SENSOR_PH, 0));
+}
+
+// Within 10% of the range width of a limit, the channel runs at min_ms
+void test_near_alarm_runs_at_the_fastest_period() {
+  scheduler.setAlarmRange(SENSOR_PH, 0, 6.5, 8.0);
+  const float near[] = { 6.6 };
+  updateAll(SENSOR_PH, 0, near, 1);
+  TEST_ASSERT_EQUAL_UINT32(1250, scheduler.getPeriod(SENSOR_PH, 0));
+  TEST_ASSERT_EQUAL_INT(RATE_ALARM, scheduler.getReason(SENSOR_PH, 0));
+
+  const float inside[] = { 7.2 };
+  updateAll(SENSOR_PH, 0, inside, 1);
+  TEST_ASSERT_NOT_EQUAL(RATE_ALARM, scheduler.getReason(SENSOR_PH, 0));
+}
+
+void test_fast_change_halves_the_period_down_to_min() {
+  const float values[] = { 7.0, 7.2 };
+  updateAll(SENSOR_PH, 0, values, 2);
+  TEST_ASSERT_EQUAL_UINT32(2500, scheduler.getPeriod(SENSOR_PH, 0));
+  TEST_ASSERT_EQUAL_INT(RATE_FAST, scheduler.getReason(SENSOR_PH, 0));
+
+  const float faster[] = { 7.4, 7.6, 7.8 };
+  updateAll(SENSOR_PH, 0, faster, 3);
+  TEST_ASSERT_EQUAL_UINT32(1250, scheduler.getPeriod(SENSOR_PH, 0));
+}
+
+// SAMPLING_FLAT_READS quiet reads double the period, up to max_ms
+void test_flat_channel_stretches_to_max() {
+  const float flat[] = { 7.0, 7.0, 7.01, 7.0 };
+  updateAll(SENSOR_PH, 0, flat, 1 + SAMPLING_FLAT_READS);
+  TEST_ASSERT_EQUAL_UINT32(10000, scheduler.getPeriod(SENSOR_PH, 0));
+  TEST_ASSERT_EQUAL_INT(RATE_FLAT, scheduler.getReason(SENSOR_PH, 0));
+
+  for (int i = 0; i < 4 * SAMPLING_FLAT_READS; i++) {
+    scheduler.update(SENSOR_PH, 0, 7.0);
+  }
+  scheduler.rebalance();
+  TEST_ASSERT_EQUAL_UINT32(30000, scheduler.getPeriod(SENSOR_PH, 0));
+}
+
+// A change between quiet and fast walks the period back to base
+void test_moderate_change_returns_to_base() {
+  const float flat[] = { 7.0, 7.0, 7.0, 7.0 };
+  updateAll(SENSOR_PH, 0, flat, 4);
+  TEST_ASSERT_EQUAL_UINT32(10000, scheduler.getPeriod(SENSOR_PH, 0));
+  const float moving[] = { 7.05 };
+  updateAll(SENSOR_PH, 0, moving, 1);
+  TEST_ASSERT_EQUAL_UINT32(5000, scheduler.getPeriod(SENSOR_PH, 0));
+  TEST_ASSERT_EQUAL_INT(RATE_BASE, scheduler.getReason(SENSOR_PH, 0));
+}
+
+// Six channels at 5 s give 1.2 reads/s. One pH channel at 2.5 s takes
+// 0.4 of it, so the other five share 0.8 and stretch from 5 s to 6.25 s
+// (less a millisecond of float rounding).
+void test_urgent_channels_are_paid_for_by_the_rest() {
+  configureType(SENSOR_TEMPERATURE, 5000, 1250, 30000, 0.5);
+  scheduler.setChannelCount(SENSOR_TEMPERATURE, 4);
+  scheduler.reset();
+  const float values[] = { 7.0, 7.2 };
+  updateAll(SENSOR_PH, 0, values, 2);
+
+  TEST_ASSERT_EQUAL_UINT32(2500, scheduler.getPeriod(SENSOR_PH, 0));
+  TEST_ASSERT_UINT32_WITHIN(1, 6250, scheduler.getPeriod(SENSOR_PH, 1));
+  TEST_ASSERT_EQUAL_INT(RATE_BUDGET, scheduler.getReason(SENSOR_PH, 1));
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_UINT32_WITHIN(1, 6250, scheduler.getPeriod(SENSOR_TEMPERATURE, i));
+  }
+}
+
+// Urgent channels alone over the budget: the rest go to max_ms
+void test_budget_stretch_is_capped_at_max() {
+  const float values[] = { 7.0, 7.2, 7.4 };
+  updateAll(SENSOR_PH, 0, values, 3);
+  TEST_ASSERT_EQUAL_UINT32(1250, scheduler.getPeriod(SENSOR_PH, 0));
+  TEST_ASSERT_EQUAL_UINT32(30000, scheduler.getPeriod(SENSOR_PH, 1));
+}
+
+void test_type_config_is_sanitised() {
+  configureType(SENSOR_TDS, 0, 0, 0, 1.0);
+  scheduler.setChannelCount(SENSOR_TDS, 1);
+  scheduler.reset();
+  TEST_ASSERT_EQUAL_UINT32(DEFAULT_SENSOR_READ_DELAY, scheduler.getPeriod(SENSOR_TDS, 0));
+
+  // min above base and max below it both collapse onto base
+  configureType(SENSOR_TDS, 4000, 8000, 2000, 1.0);
+  scheduler.reset();
+  for (int i = 0; i < 10; i++) {
+    scheduler.update(SENSOR_TDS, 0, i * 10.0);
+  }
+  scheduler.rebalance();
+  TEST_ASSERT_EQUAL_UINT32(4000, scheduler.getPeriod(SENSOR_TDS, 0));
+}
+
+void test_tick_is_the_fastest_period_in_use() {
+  TEST_ASSERT_EQUAL_UINT32(1250, scheduler.getTickMs());
+  configureType(SENSOR_TDS, 1000, 100, 1000, 1.0);
+  TEST_ASSERT_EQUAL_UINT32(1250, scheduler.getTickMs());   // No TDS channels
+  scheduler.setChannelCount(SENSOR_TDS, 1);
+  TEST_ASSERT_EQUAL_UINT32(SAMPLING_MIN_TICK_MS, scheduler.getTickMs());
+}
+
+void test_total_reads_and_reason_names() {
+  scheduler.markSampled(SENSOR_PH, 0, 0);
+  scheduler.markSampled(SENSOR_PH, 1, 0);
+  scheduler.markSampled(SENSOR_PH, 1, 5000);
+  TEST_ASSERT_EQUAL_UINT32(3, scheduler.getTotalReads());
+  TEST_ASSERT_EQUAL_STRING("budget", SampleScheduler::reasonName(RATE_BUDGET));
+  TEST_ASSERT_EQUAL_STRING("base", SampleScheduler::reasonName(200));
+}
+
+// A rack of 24 channels, 8 per type, read for an hour. Every trace is
+// flat but for a little noise, except pH channel 3, which falls at
+// 0.002 pH/s from 30 minutes in and leaves its 6.5-8.0 range at 2151.7 s.
+static const int SIM_CHANNELS = 8;
+static const unsigned long SIM_INTERVAL_MS = 5000;
+static const unsigned long SIM_DURATION_MS = 3600000;
+static const unsigned long SIM_EXCURSION_MS = 1801700;
+static const float SIM_TYPE_LEVEL[SENSOR_TYPE_COUNT] = { 25.0, 7.2, 300.0 };
+static const float SIM_TYPE_NOISE[SENSOR_TYPE_COUNT] = { 0.005, 0.001, 0.1 };
+
+static float simulatedValue(int type, int channel, unsigned long now) {
+  float value = SIM_TYPE_LEVEL[type] + SIM_TYPE_NOISE[type] * sin(now * 0.001 + channel);
+  if (type == SENSOR_PH && channel == 3 && now > SIM_EXCURSION_MS) {
+    value -= 0.002 * (now - SIM_EXCURSION_MS) / 1000.0;
+  }
+  return value;
+}
+
+// Runs the rack at the scheduler's tick (the fixed interval when it is
+// disabled); returns when the excursion was first read out of range
+static unsigned long simulateRack(bool adaptive) {
+  scheduler = SampleScheduler();
+  scheduler.configure(adaptive, 0.1, SIM_INTERVAL_MS);
+  configureType(SENSOR_TEMPERATURE, 5000, 1250, 30000, 0.5);
+  configureType(SENSOR_PH, 5000, 1250, 30000, 0.1);
+  configureType(SENSOR_TDS, 5000, 1250, 30000, 10.0);
+  const float ranges[SENSOR_TYPE_COUNT][2] = { { 22.0, 28.0 }, { 6.5, 8.0 }, { 100.0, 500.0 } };
+  for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+    scheduler.setChannelCount(t, SIM_CHANNELS);
+    for (int i = 0; i < SIM_CHANNELS; i++) {
+      scheduler.setAlarmRange(t, i, ranges[t][0], ranges[t][1]);
+    }
+  }
+  scheduler.reset();
+
+  unsigned long detectedAt = 0;
+  unsigned long tick = adaptive ? scheduler.getTickMs() : SIM_INTERVAL_MS;
+  for (unsigned long now = 0; now < SIM_DURATION_MS; now += tick) {
+    for (int t = 0; t < SENSOR_TYPE_COUNT; t++) {
+      for (int i = 0; i < SIM_CHANNELS; i++) {
+        if (!scheduler.isDue(t, i, now)) continue;
+        float value = simulatedValue(t, i, now);
+        scheduler.markSampled(t, i, now);
+        scheduler.update(t, i, value);
+        if (detectedAt == 0 && value < ranges[t][0]) detectedAt = now;
+      }
+    }
+    scheduler.rebalance();
+  }
+  return detectedAt;
+}
+
+// Adaptive sampling makes fewer reads than the fixed-rate scan over the
+// hour and still catches the excursion no later than it does
+void test_rack_simulation_reads_less_and_detects_the_excursion() {
+  const unsigned long crossing = SIM_EXCURSION_MS + 350000;   // 0.7 pH at 0.002 pH/s
+  unsigned long fixedDetected = simulateRack(false);
+  uint32_t fixedReads = scheduler.getTotalReads();
+  unsigned long adaptiveDetected = simulateRack(true);
+  uint32_t adaptiveReads = scheduler.getTotalReads();
+
+  char message[160];
+  snprintf(message, sizeof(message),
+           "24 channels, 1 h: fixed-rate %u reads, detected after %lu ms; adaptive %u reads (%.0f%%), detected after %lu ms",
+           (unsigned)fixedReads, fixedDetected - crossing, (unsigned)adaptiveReads,
+           100.0 * adaptiveReads / fixedReads, adaptiveDetected - crossing);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_EQUAL_UINT32(3 * SIM_CHANNELS * (SIM_DURATION_MS / SIM_INTERVAL_MS), fixedReads);
+  TEST_ASSERT_TRUE(adaptiveReads < fixedReads);
+  TEST_ASSERT_TRUE(fixedDetected >= crossing);
+  TEST_ASSERT_TRUE(adaptiveDetected >= crossing);
+  TEST_ASSERT_TRUE(adaptiveDetected - crossing <= fixedDetected - crossing);
+  TEST_ASSERT_TRUE(adaptiveDetected - crossing <= SIM_INTERVAL_MS);   // The fixed-rate worst case
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_disabled_scheduler_samples_every_scan);
+  RUN_TEST(test_channel_is_due_after_its_period);
+  RUN_TEST(test_near_alarm_runs_at_the_fastest_period);
+  RUN_TEST(test_fast_change_halves_the_period_down_to_min);
+  RUN_TEST(test_flat_channel_stretches_to_max);
+  RUN_TEST(test_moderate_change_returns_to_base);
+  RUN_TEST(test_urgent_channels_are_paid_for_by_the_rest);
+  RUN_TEST(test_budget_stretch_is_capped_at_max);
+  RUN_TEST(test_type_config_is_sanitised);
+  RUN_TEST(test_tick_is_the_fastest_period_in_use);
+  RUN_TEST(test_total_reads_and_reason_names);
+  RUN_TEST(test_rack_simulation_reads_less_and_detects_the_excursion);
+  return UNITY_END();
+}
@@ -0,0 +1,144 @@
+#include <unity.h>
+#include "SensorBank.h"
+
+#define SECOND_TDS_EN  22
+
+// Raw code for about 1.0 V on the replay backend's linear 0-3.3 V table
+static const uint16_t oneVolt[] = { 1241 };
+
+static MultiplexerController* mux;
+static ReplayAdcBackend* adc;
+static TDSSensor* tds;
+
+void setUp() {
+  nativeGpio.reset();
+  mux = new MultiplexerController();
+  mux->addBank(MUX_EN, TEMP_ADC_PIN);
+  mux->addBank(MUX_EN, PH_ADC_PIN);
+  mux->addBank(MUX_EN, TDS_ADC_PIN);
+  mux->addBank(SECOND_TDS_EN, TDS_ADC_PIN);   // Second TDS mux on the same ADC pin
+  mux->begin(false);
+
+  adc = new ReplayAdcBackend();
+  adc->addTrace(TDS_ADC_PIN, oneVolt, 1);
+  adc->begin();
+  tds = new TDSSensor(mux, adc, 2);
+}
+
+void tearDown() {
+  delete tds;
+  delete adc;
+  delete mux;
+}
+
+void test_count_defaults_to_config_h() {
+  TEST_ASSERT_EQUAL_INT(DEFAULT_NUM_TDS_SENSORS, tds->getSensorCount());
+}
+
+void test_count_is_clamped_to_attached_muxes() {
+  tds->setChannelCount(20);
+  TEST_ASSERT_EQUAL_INT(MUX_CHANNEL_CAPACITY, tds->getSensorCount());
+  tds->setChannelCount(-1);
+  TEST_ASSERT_EQUAL_INT(0, tds->getSensorCount());
+
+  TEST_ASSERT_TRUE(tds->attachMuxBank(3));
+  TEST_ASSERT_FALSE(tds->canAttachMuxBank());
+  TEST_ASSERT_FALSE(tds->attachMuxBank(1));
+  tds->setChannelCount(MAX_CHANNELS_PER_TYPE);
+  TEST_ASSERT_EQUAL_INT(MAX_CHANNELS_PER_TYPE, tds->getSensorCount());
+}
+
+void test_channels_past_16_use_the_next_mux() {
+  tds->attachMuxBank(3);
+  TEST_ASSERT_EQUAL_INT(2, tds->getMuxBank(0));
+  TEST_ASSERT_EQUAL_INT(2, tds->getMuxBank(15));
+  TEST_ASSERT_EQUAL_INT(3, tds->getMuxBank(16));
+  TEST_ASSERT_EQUAL_INT(15, tds->getMuxChannel(15));
+  TEST_ASSERT_EQUAL_INT(4, tds->getMuxChannel(20));
+}
+
+void test_aquarium_map_covers_only_channels_in_use() {
+  tds->setChannelCount(4);
+  TEST_ASSERT_EQUAL_INT(NO_AQUARIUM, tds->getAquarium(0));
+  TEST_ASSERT_TRUE(tds->assignAquarium(3, 1));
+  TEST_ASSERT_FALSE(tds->assignAquarium(4, 1));
+  TEST_ASSERT_EQUAL_INT(1, tds->getAquarium(3));
+  TEST_ASSERT_EQUAL_INT(NO_AQUARIUM, tds->getAquarium(4));
+
+  tds->clearAquariumMap();
+  TEST_ASSERT_EQUAL_INT(NO_AQUARIUM, tds->getAquarium(3));
+}
+
+// 32 TDS channels on one ADC pin: every channel is read, and the second
+// mux's enable line takes over from the first for channels 16-31
+void test_all_channels_of_two_muxes_are_read() {
+  tds->attachMuxBank(3);
+  tds->setChannelCount(MAX_CHANNELS_PER_TYPE);
+  tds->updateAllReadings();
+
+  float expected = 133.42 - 255.86 + 857.39;   // TDS cubic at 1.0 V, k = 1
+  for (int i = 0; i < MAX_CHANNELS_PER_TYPE; i++) {
+    TEST_ASSERT_FLOAT_WITHIN(2.0, expected, tds->getReading(i));
+  }
+  TEST_ASSERT_EQUAL_FLOAT(0.0, tds->getReading(MAX_CHANNELS_PER_TYPE));
+  TEST_ASSERT_EQUAL_INT(HIGH, digitalRead(MUX_EN));
+  TEST_ASSERT_EQUAL_INT(LOW, digitalRead(SECOND_TDS_EN));
+}
+
+// One scan cycle over the three types with 'perType' channels each, in
+// scan plan order (mux channel, then bank), through the same three ADC
+// pins. Simulated time is what the settle waits and sample delays would
+// take on the device; ADC conversion time is not modelled.
+static void timeCycle(int perType, unsigned long& simulatedUs, unsigned long& hostUs) {
+  TemperatureSensor temp(mux, adc, 0);
+  PHSensor ph(mux, adc, 1);
+  temp.setChannelCount(perType);
+  ph.setChannelCount(perType);
+  tds->setChannelCount(perType);
+
+  unsigned long skippedBefore = nativeSkippedUs;
+  unsigned long start = micros();
+  for (int ch = 0; ch < perType; ch++) {
+    temp.sampleChannel(ch);
+    ph.sampleChannel(ch);
+    tds->sampleChannel(ch);
+  }
+  temp.finishCycle();
+  ph.finishCycle();
+  tds->finishCycle();
+  simulatedUs = nativeSkippedUs - skippedBefore;
+  hostUs = micros() - start - simulatedUs;
+}
+
+// 24 and 48 channels on the same pins and build: the cycle grows with the
+// channel count and nothing else
+void test_cycle_time_at_24_and_48_channels() {
+  adc->addTrace(TEMP_ADC_PIN, oneVolt, 1);
+  adc->addTrace(PH_ADC_PIN, oneVolt, 1);
+  unsigned long simulated24, host24, simulated48, host48;
+  timeCycle(8, simulated24, host24);
+  timeCycle(16, simulated48, host48);
+
+  char message[160];
+  snprintf(message, sizeof(message),
+           "Cycle: 24 channels %lu us simulated + %lu us host, 48 channels %lu us simulated + %lu us host",
+           simulated24, host24, simulated48, host48);
+  TEST_MESSAGE(message);
+
+  // Per-channel settle and sample delays are fixed, so twice the channels
+  // is twice the simulated time; settle waits that overlap host time make
+  // it slightly less
+  TEST_ASSERT_GREATER_THAN(0, simulated24);
+  TEST_ASSERT_FLOAT_WITHIN(0.1, 2.0, (double)simulated48 / simulated24);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_count_defaults_to_config_h);
+  RUN_TEST(test_count_is_clamped_to_attached_muxes);
+  RUN_TEST(test_channels_past_16_use_the_next_mux);
+  RUN_TEST(test_aquarium_map_covers_only_channels_in_use);
+  RUN_TEST(test_all_channels_of_two_muxes_are_read);
+  RUN_TEST(test_cycle_time_at_24_and_48_channels);
+  return UNITY_END();
+}
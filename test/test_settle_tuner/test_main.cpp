@@ -0,0 +1,143 @@
+#include <unity.h>
+#include "SettleTuner.h"
+
+#define FAST_CHANNEL      2
+#define SLOW_CHANNEL      4
+#define FLOATING_CHANNEL  6
+
+// Mux output after a switch from the neighbouring channel: an RC step from
+// the neighbour's level with the channel's time constant. The floating
+// channel keeps drifting and never settles.
+class SettlingAdc : public AdcBackend {
+public:
+  int levels[MUX_CHANNEL_CAPACITY];
+  float tauUs[MUX_CHANNEL_CAPACITY];
+
+  SettlingAdc() {
+    for (int i = 0; i < MUX_CHANNEL_CAPACITY; i++) {
+      levels[i] = (i & 0x01) ? 3000 : 1000;
+      tauUs[i] = 1.0;
+    }
+  }
+
+  void begin() { buildLinearLut(3300.0); }
+  const char* name() const { return "settling"; }
+
+  int readRaw(int pin) {
+    const int pins[MUX_ADDRESS_LINES] = { MUX_S0, MUX_S1, MUX_S2, MUX_S3 };
+    int channel = 0;
+    unsigned long switchedAt = 0;
+    for (int i = 0; i < MUX_ADDRESS_LINES; i++) {
+      channel |= digitalRead(pins[i]) << i;
+      switchedAt = max(switchedAt, nativeGpio.changedAt[pins[i]]);
+    }
+    float since = micros() - switchedAt;
+    if (channel == FLOATING_CHANNEL) {
+      return (int)since;
+    }
+    int from = levels[channel ^ 0x01];
+    return levels[channel] + (int)((from - levels[channel]) * exp(-since / tauUs[channel]));
+  }
+};
+
+static MultiplexerController* mux;
+static SettlingAdc* adc;
+static SettleTuner* tuner;
+static int bank;
+
+void setUp() {
+  nativeGpio.reset();
+  mux = new MultiplexerController();
+  bank = mux->addBank(MUX_EN, PH_ADC_PIN);
+  mux->begin(false);
+  adc = new SettlingAdc();
+  adc->begin();
+  adc->tauUs[SLOW_CHANNEL] = 100.0;
+  tuner = new SettleTuner();
+  tuner->configure(true, 8, 20000, 60);
+}
+
+void tearDown() {
+  delete tuner;
+  delete adc;
+  delete mux;
+}
+
+// Settled by the first probe: SETTLE_MIN_US plus the margin
+void test_low_impedance_channel_gets_the_minimum() {
+  TEST_ASSERT_EQUAL_UINT32(SETTLE_MIN_US * (100 + SETTLE_MARGIN_PERCENT) / 100,
+                           tuner->measure(*mux, *adc, bank, FAST_CHANNEL));
+}
+
+// 2000 LSB step, tau 100us: the 640us and 1280us reads are the first to
+// agree within 8 LSB
+void test_high_impedance_channel_waits_for_its_time_constant() {
+  TEST_ASSERT_EQUAL_UINT32(640 * (100 + SETTLE_MARGIN_PERCENT) / 100,
+                           tuner->measure(*mux, *adc, bank, SLOW_CHANNEL));
+}
+
+void test_channel_that_never_settles_gets_the_bound() {
+  TEST_ASSERT_EQUAL_UINT32(20000, tuner->measure(*mux, *adc, bank, FLOATING_CHANNEL));
+}
+
+void test_measurements_are_spread_out() {
+  TEST_ASSERT_TRUE(tuner->canMeasure(millis()));
+  tuner->measure(*mux, *adc, bank, SLOW_CHANNEL);
+  // About 21ms spent, so the next one waits 19 times as long
+  unsigned long now = millis();
+  TEST_ASSERT_FALSE(tuner->canMeasure(now));
+  TEST_ASSERT_FALSE(tuner->canMeasure(now + 350));
+  TEST_ASSERT_TRUE(tuner->canMeasure(now + 500));
+}
+
+void test_untuned_channels_come_due_round_robin() {
+  tuner->setChannelCount(SENSOR_TEMPERATURE, 2);
+  tuner->setChannelCount(SENSOR_PH, 0);
+  tuner->setChannelCount(SENSOR_TDS, 1);
+  int type, channel;
+  unsigned long now = millis();
+  TEST_ASSERT_TRUE(tuner->nextDue(now, type, channel));
+  TEST_ASSERT_EQUAL_INT(SENSOR_TEMPERATURE, type);
+  TEST_ASSERT_EQUAL_INT(0, channel);
+  TEST_ASSERT_TRUE(tuner->nextDue(now, type, channel));
+  TEST_ASSERT_EQUAL_INT(1, channel);
+  TEST_ASSERT_TRUE(tuner->nextDue(now, type, channel));
+  TEST_ASSERT_EQUAL_INT(SENSOR_TDS, type);
+  TEST_ASSERT_EQUAL_INT(0, channel);
+  TEST_ASSERT_TRUE(tuner->nextDue(now, type, channel));
+  TEST_ASSERT_EQUAL_INT(SENSOR_TEMPERATURE, type);
+}
+
+void test_tuned_channels_wait_for_the_recheck() {
+  tuner->setChannelCount(SENSOR_TEMPERATURE, 1);
+  tuner->setChannelCount(SENSOR_PH, 1);
+  tuner->setChannelCount(SENSOR_TDS, 0);
+  tuner->setSettleTime(SENSOR_TEMPERATURE, 0, 150);
+  tuner->setSettleTime(SENSOR_PH, 0, 800);
+
+  int type, channel;
+  unsigned long now = millis();
+  TEST_ASSERT_FALSE(tuner->nextDue(now, type, channel));
+  TEST_ASSERT_TRUE(tuner->nextDue(now + 60 * 60000UL, type, channel));
+  TEST_ASSERT_EQUAL_UINT16(800, tuner->getTable(SENSOR_PH)[0]);
+}
+
+void test_stored_times_fit_the_table() {
+  tuner->setSettleTime(SENSOR_PH, 3, 100000);
+  TEST_ASSERT_EQUAL_UINT32(SETTLE_MAX_STORED_US, tuner->getSettleTime(SENSOR_PH, 3));
+  tuner->setSettleTime(SENSOR_PH, MAX_CHANNELS_PER_TYPE, 100);
+  TEST_ASSERT_EQUAL_UINT32(0, tuner->getSettleTime(SENSOR_PH, MAX_CHANNELS_PER_TYPE));
+  TEST_ASSERT_NULL(tuner->getTable(SENSOR_TYPE_COUNT));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_low_impedance_channel_gets_the_minimum);
+  RUN_TEST(test_high_impedance_channel_waits_for_its_time_constant);
+  RUN_TEST(test_channel_that_never_settles_gets_the_bound);
+  RUN_TEST(test_measurements_are_spread_out);
+  RUN_TEST(test_untuned_channels_come_due_round_robin);
+  RUN_TEST(test_tuned_channels_wait_for_the_recheck);
+  RUN_TEST(test_stored_times_fit_the_table);
+  return UNITY_END();
+}
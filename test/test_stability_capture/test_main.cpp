@@ -0,0 +1,172 @@
+#include <unity.h>
+#include <math.h>
+#include "StabilityCapture.h"
+
+static StabilityCapture capture;
+static unsigned long now;
+
+static CaptureCriteria criteriaOf(int window, float maxStdev, float maxDrift, unsigned long timeoutMs) {
+  CaptureCriteria criteria;
+  criteria.windowSamples = window;
+  criteria.maxStdev = maxStdev;
+  criteria.maxDrift = maxDrift;
+  criteria.timeoutMs = timeoutMs;
+  return criteria;
+}
+
+// Reads 50 ms apart, as at the default capture interval; true if one ended the capture
+static bool feed(const float* values, int count) {
+  bool ended = false;
+  for (int i = 0; i < count && !ended; i++) {
+    now += 50;
+    ended = capture.add(values[i], now);
+  }
+  return ended;
+}
+
+void setUp() {
+  now = 1000;
+  capture.reset();
+}
+
+void tearDown() {}
+
+void test_reads_are_grouped_into_windows() {
+  capture.start(1, 3, criteriaOf(4, 1.0, 1.0, 0), now);
+  TEST_ASSERT_TRUE(capture.isActive());
+  TEST_ASSERT_EQUAL_INT(1, capture.getSensorType());
+  TEST_ASSERT_EQUAL_INT(3, capture.getChannel());
+
+  const float values[] = { 1, 2, 3, 6 };
+  feed(values, 3);
+  TEST_ASSERT_EQUAL_INT(3, capture.getWindowProgress());
+  TEST_ASSERT_EQUAL_INT(0, capture.getWindows());
+  TEST_ASSERT_FALSE(capture.hasCompletedWindow());
+  TEST_ASSERT_EQUAL_FLOAT(2.0, capture.getCurrentMean());
+
+  // The first window has nothing to compare its mean with, so it never ends the capture
+  TEST_ASSERT_FALSE(feed(values + 3, 1));
+  TEST_ASSERT_EQUAL_INT(1, capture.getWindows());
+  TEST_ASSERT_EQUAL_INT(0, capture.getWindowProgress());
+  TEST_ASSERT_TRUE(capture.hasCompletedWindow());
+  TEST_ASSERT_EQUAL_FLOAT(3.0, capture.getWindowMean());
+  TEST_ASSERT_EQUAL_UINT32(4, capture.getTotalSamples());
+  TEST_ASSERT_EQUAL_INT(CAPTURE_SAMPLING, capture.getState());
+}
+
+void test_window_is_at_least_two_reads() {
+  capture.start(0, 0, criteriaOf(1, 1.0, 1.0, 0), now);
+  TEST_ASSERT_EQUAL_INT(2, capture.getCriteria().windowSamples);
+}
+
+static double twoPassStdev(const float* values, int count) {
+  double mean = 0;
+  for (int i = 0; i < count; i++) mean += values[i];
+  mean /= count;
+  double squares = 0;
+  for (int i = 0; i < count; i++) squares += (values[i] - mean) * (values[i] - mean);
+  return sqrt(squares / (count - 1));
+}
+
+// Welford's running variance against the two-pass formula, on raw values
+// whose square would swamp the spread in a naive sum of squares
+void test_welford_stdev_matches_two_pass() {
+  const int window = 32;
+  float values[window];
+  srand(3);
+  double mean = 0;
+  for (int i = 0; i < window; i++) {
+    values[i] = 40000.0 + (rand() % 64) * 0.25;
+    mean += values[i];
+  }
+  mean /= window;
+
+  capture.start(0, 0, criteriaOf(window, 0.0, 0.0, 0), now);
+  feed(values, window - 1);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, twoPassStdev(values, window - 1), capture.getCurrentStdev());
+  feed(values + window - 1, 1);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, twoPassStdev(values, window), capture.getWindowStdev());
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, mean, capture.getWindowMean());
+}
+
+// A quiet signal is stable at the end of its second window, and the result
+// is that window's mean
+void test_quiet_signal_is_accepted() {
+  capture.start(1, 0, criteriaOf(10, 0.05, 0.05, 0), now);
+  float values[30];
+  for (int i = 0; i < 30; i++) values[i] = 7.0 + ((i % 2) ? 0.02 : -0.02);
+
+  TEST_ASSERT_TRUE(feed(values, 30));
+  TEST_ASSERT_EQUAL_INT(CAPTURE_STABLE, capture.getState());
+  TEST_ASSERT_EQUAL_UINT32(20, capture.getTotalSamples());
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 7.0, capture.getWindowMean());
+  TEST_ASSERT_TRUE(capture.getDrift() <= 0.05);
+  TEST_ASSERT_FALSE(capture.isActive());
+  TEST_ASSERT_FALSE(capture.add(7.0, now));   // Finished: reads are ignored
+  TEST_ASSERT_EQUAL_UINT32(20, capture.getTotalSamples());
+}
+
+// A probe still creeping towards the solution's value: every window is
+// smooth enough, but its mean keeps moving, so the capture times out
+void test_creeping_signal_is_rejected_by_drift() {
+  const float step = 0.01;   // Window stdev 0.029, drift 0.1 per window
+  capture.start(1, 0, criteriaOf(10, 0.05, 0.05, 5000), now);
+  float values[200];
+  for (int i = 0; i < 200; i++) values[i] = 6.0 + step * i;
+
+  TEST_ASSERT_TRUE(feed(values, 200));
+  TEST_ASSERT_EQUAL_INT(CAPTURE_TIMED_OUT, capture.getState());
+  TEST_ASSERT_EQUAL_UINT32(100, capture.getTotalSamples());   // 5 s of reads 50 ms apart
+  TEST_ASSERT_TRUE(capture.getWindowStdev() <= 0.05);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 0.1, capture.getDrift());
+  TEST_ASSERT_EQUAL_UINT32(5000, capture.getElapsedMs(now + 1000));
+}
+
+// The loop checks the timeout even when no reads arrive
+void test_timeout_without_reads() {
+  capture.start(0, 0, criteriaOf(10, 0.1, 0.1, 2000), now);
+  TEST_ASSERT_FALSE(capture.checkTimeout(now + 1999));
+  TEST_ASSERT_TRUE(capture.checkTimeout(now + 2000));
+  TEST_ASSERT_EQUAL_INT(CAPTURE_TIMED_OUT, capture.getState());
+  TEST_ASSERT_FALSE(capture.checkTimeout(now + 3000));   // Only once
+
+  // No timeout configured: samples until stable or cancelled
+  capture.start(0, 0, criteriaOf(10, 0.1, 0.1, 0), now);
+  TEST_ASSERT_FALSE(capture.checkTimeout(now + 3600000));
+  TEST_ASSERT_TRUE(capture.isActive());
+}
+
+void test_cancel_and_reset() {
+  uint32_t revision = capture.getRevision();
+  capture.cancel(now);   // Idle: nothing to cancel
+  TEST_ASSERT_EQUAL_INT(CAPTURE_IDLE, capture.getState());
+  TEST_ASSERT_EQUAL_UINT32(revision, capture.getRevision());
+
+  unsigned long started = now;
+  capture.start(2, 5, criteriaOf(10, 1.0, 1.0, 0), now);
+  const float values[] = { 300, 301, 302 };
+  feed(values, 3);
+  capture.cancel(now + 10);
+  TEST_ASSERT_EQUAL_INT(CAPTURE_CANCELLED, capture.getState());
+  TEST_ASSERT_EQUAL_STRING("cancelled", StabilityCapture::stateName(capture.getState()));
+  TEST_ASSERT_FALSE(capture.add(303, now + 20));
+  TEST_ASSERT_EQUAL_UINT32(3, capture.getTotalSamples());
+  TEST_ASSERT_EQUAL_UINT32(now + 10 - started, capture.getElapsedMs(now + 5000));   // Stopped at the cancel
+
+  capture.reset();
+  TEST_ASSERT_EQUAL_INT(CAPTURE_IDLE, capture.getState());
+  TEST_ASSERT_EQUAL_UINT32(0, capture.getTotalSamples());
+  TEST_ASSERT_EQUAL_UINT32(0, capture.getElapsedMs(now));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reads_are_grouped_into_windows);
+  RUN_TEST(test_window_is_at_least_two_reads);
+  RUN_TEST(test_welford_stdev_matches_two_pass);
+  RUN_TEST(test_quiet_signal_is_accepted);
+  RUN_TEST(test_creeping_signal_is_rejected_by_drift);
+  RUN_TEST(test_timeout_without_reads);
+  RUN_TEST(test_cancel_and_reset);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+#include <unity.h>
+
+#ifdef NATIVE_MBEDTLS
+#include <memory>
+#include "TlsServer.h"
+#include "test_certs.h"
+
+// The browser end of one connection: an mbedtls client playing the peer side
+// of a NativeSocket. It does not check the certificate, like a browser the
+// user has told to trust it.
+struct TlsClient {
+  mbedtls_ssl_context ssl;
+  std::shared_ptr<NativeSocket> socket;
+
+  TlsClient(const mbedtls_ssl_config* conf, std::shared_ptr<NativeSocket> peer) : socket(peer) {
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_setup(&ssl, conf);
+    mbedtls_ssl_set_bio(&ssl, this, send, recv, nullptr);
+  }
+
+  ~TlsClient() { mbedtls_ssl_free(&ssl); }
+
+  static int send(void* ctx, const unsigned char* buf, size_t len) {
+    static_cast<TlsClient*>(ctx)->socket->send(std::string((const char*)buf, len));
+    return len;
+  }
+
+  static int recv(void* ctx, unsigned char* buf, size_t len) {
+    std::string& pending = static_cast<TlsClient*>(ctx)->socket->toPeer;
+    if (pending.empty()) return MBEDTLS_ERR_SSL_WANT_READ;
+    size_t count = min(len, pending.size());
+    memcpy(buf, pending.data(), count);
+    pending.erase(0, count);
+    return count;
+  }
+};
+
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context ctrDrbg;
+static mbedtls_ssl_config ticketClient;     // Offers and keeps session tickets
+static mbedtls_ssl_config sessionIdClient;  // Resumes by session ID only
+static TlsServer* tls;
+static WiFiServer* listener;
+
+static void initClientConfig(mbedtls_ssl_config* conf, int tickets) {
+  mbedtls_ssl_config_init(conf);
+  mbedtls_ssl_config_defaults(conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+  mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
+  mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &ctrDrbg);
+  mbedtls_ssl_conf_session_tickets(conf, tickets);
+}
+
+// Connects once, resuming 'session' when given, and sends a request over the
+// new session. 'session' is left holding the session to resume next time.
+// Returns false if either end failed.
+static bool connect(const mbedtls_ssl_config* conf, mbedtls_ssl_session* session, bool resume) {
+  TlsClient client(conf, nativeConnect(443));
+  if (resume) mbedtls_ssl_set_session(&client.ssl, session);
+  WiFiClient socket = listener->available();
+  TlsConnection conn;
+  if (!conn.begin(*tls, socket)) return false;
+
+  // Both ends step in turn over the in-memory socket until both are done
+  int clientResult = MBEDTLS_ERR_SSL_WANT_READ;
+  int serverResult = 0;
+  for (int step = 0; step < 20 && (clientResult != 0 || serverResult != 1); step++) {
+    if (clientResult != 0) {
+      clientResult = mbedtls_ssl_handshake(&client.ssl);
+      if (clientResult != 0 && clientResult != MBEDTLS_ERR_SSL_WANT_READ) return false;
+    }
+    if (serverResult != 1) {
+      serverResult = conn.handshake(millis());
+      if (serverResult < 0) return false;
+    }
+  }
+  if (clientResult != 0 || serverResult != 1) return false;
+
+  const char request[] = "GET / HTTP/1.1\r\n\r\n";
+  mbedtls_ssl_write(&client.ssl, (const unsigned char*)request, sizeof(request) - 1);
+  uint8_t received[64];
+  int bytesRead = conn.read(received, sizeof(received));
+  if (bytesRead != (int)sizeof(request) - 1 || memcmp(received, request, bytesRead) != 0) return false;
+
+  mbedtls_ssl_session_free(session);
+  mbedtls_ssl_session_init(session);
+  mbedtls_ssl_get_session(&client.ssl, session);
+  conn.stop();
+  return true;
+}
+
+void setUp() {
+  nativeBacklog.clear();
+  mbedtls_entropy_init(&entropy);
+  mbedtls_ctr_drbg_init(&ctrDrbg);
+  mbedtls_ctr_drbg_seed(&ctrDrbg, mbedtls_entropy_func, &entropy, (const unsigned char*)"client", 6);
+  initClientConfig(&ticketClient, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+  initClientConfig(&sessionIdClient, MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+
+  tls = new TlsServer();
+  TEST_ASSERT_TRUE(tls->begin(P256_CERT, P256_KEY));
+  listener = new WiFiServer(443);
+  listener->begin();
+}
+
+void tearDown() {
+  delete listener;
+  delete tls;
+  mbedtls_ssl_config_free(&sessionIdClient);
+  mbedtls_ssl_config_free(&ticketClient);
+  mbedtls_ctr_drbg_free(&ctrDrbg);
+  mbedtls_entropy_free(&entropy);
+}
+
+void test_full_handshake_then_ticket_resumption() {
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  TEST_ASSERT_TRUE(connect(&ticketClient, &session, false));
+  TEST_ASSERT_TRUE(connect(&ticketClient, &session, true));
+  mbedtls_ssl_session_free(&session);
+
+  const TlsStats& stats = tls->getStats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.fullHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.resumedHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.ticketResumes);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.failedHandshakes);
+}
+
+// A client without ticket support resumes from the session-ID cache
+void test_session_id_resumption_without_tickets() {
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  TEST_ASSERT_TRUE(connect(&sessionIdClient, &session, false));
+  TEST_ASSERT_TRUE(connect(&sessionIdClient, &session, true));
+  mbedtls_ssl_session_free(&session);
+
+  const TlsStats& stats = tls->getStats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.fullHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.resumedHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.ticketResumes);
+}
+
+// Server CPU per handshake as TlsStats counts it on the device: full
+// handshakes against resumptions by ticket and by session ID. Host numbers;
+// what carries over to the ESP32 is the ratio.
+void test_resumption_benchmark() {
+  const int rounds = 16;
+  const int cached = TLS_SESSION_CACHE_SIZE;   // Session IDs beyond this are evicted
+  const TlsStats& stats = tls->getStats();
+  mbedtls_ssl_session tickets[rounds];
+  mbedtls_ssl_session sessionIds[cached];
+  for (int i = 0; i < rounds; i++) mbedtls_ssl_session_init(&tickets[i]);
+  for (int i = 0; i < cached; i++) mbedtls_ssl_session_init(&sessionIds[i]);
+
+  bool connected = true;
+  for (int i = 0; i < rounds; i++) connected &= connect(&ticketClient, &tickets[i], false);
+  for (int i = 0; i < cached; i++) connected &= connect(&sessionIdClient, &sessionIds[i], false);
+  float fullMs = stats.averageFullCpuMs();
+
+  unsigned long before = stats.resumedHandshakeCpuUsTotal;
+  for (int i = 0; i < rounds; i++) connected &= connect(&ticketClient, &tickets[i], true);
+  float ticketMs = (stats.resumedHandshakeCpuUsTotal - before) / 1000.0f / rounds;
+
+  before = stats.resumedHandshakeCpuUsTotal;
+  for (int i = 0; i < cached; i++) connected &= connect(&sessionIdClient, &sessionIds[i], true);
+  float sessionIdMs = (stats.resumedHandshakeCpuUsTotal - before) / 1000.0f / cached;
+
+  for (int i = 0; i < rounds; i++) mbedtls_ssl_session_free(&tickets[i]);
+  for (int i = 0; i < cached; i++) mbedtls_ssl_session_free(&sessionIds[i]);
+
+  TEST_ASSERT_TRUE(connected);
+  TEST_ASSERT_EQUAL_UINT32(rounds + cached, stats.fullHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(rounds + cached, stats.resumedHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(rounds, stats.ticketResumes);
+
+  char message[160];
+  snprintf(message, sizeof(message),
+           "P-256 server CPU: full %.3f ms, ticket resume %.3f ms (%.0fx), session-ID resume %.3f ms (%.0fx)",
+           fullMs, ticketMs, fullMs / ticketMs, sessionIdMs, fullMs / sessionIdMs);
+  TEST_MESSAGE(message);
+
+  // Resumption skips the ECDHE and signing operations
+  TEST_ASSERT_TRUE(ticketMs * 3 < fullMs);
+  TEST_ASSERT_TRUE(sessionIdMs * 3 < fullMs);
+}
+
+// Average server CPU of 'rounds' full handshakes on a server with this key
+static float fullHandshakeCpuMs(const char* cert, const char* key, int rounds) {
+  delete tls;
+  tls = new TlsServer();
+  if (!tls->begin(cert, key)) return 0.0f;
+
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  for (int i = 0; i < rounds; i++) {
+    connect(&ticketClient, &session, false);
+  }
+  mbedtls_ssl_session_free(&session);
+  return tls->getStats().fullHandshakes == (unsigned long)rounds ? tls->getStats().averageFullCpuMs() : 0.0f;
+}
+
+// Full handshakes with the two key types the server accepts. Both use
+// ECDHE on P-256; the difference is the RSA-2048 signature against the
+// ECDSA P-256 one. Host numbers; the ratio is what to compare with the
+// device's avgFullCpuMs.
+void test_rsa_and_p256_full_handshake_benchmark() {
+  const int rounds = 16;
+  float rsaMs = fullHandshakeCpuMs(RSA2048_CERT, RSA2048_KEY, rounds);
+  TEST_ASSERT_FALSE(tls->isEcdsa());
+  float p256Ms = fullHandshakeCpuMs(P256_CERT, P256_KEY, rounds);
+  TEST_ASSERT_TRUE(tls->isEcdsa());
+  TEST_ASSERT_TRUE(rsaMs > 0.0f);
+  TEST_ASSERT_TRUE(p256Ms > 0.0f);
+
+  char message[128];
+  snprintf(message, sizeof(message), "Full handshake server CPU: RSA-2048 %.3f ms, P-256 %.3f ms (RSA/P-256 %.2f)",
+           rsaMs, p256Ms, rsaMs / p256Ms);
+  TEST_MESSAGE(message);
+
+  // About 1.6x on the host; only the order is asserted
+  TEST_ASSERT_TRUE(p256Ms < rsaMs);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_handshake_then_ticket_resumption);
+  RUN_TEST(test_session_id_resumption_without_tickets);
+  RUN_TEST(test_resumption_benchmark);
+  RUN_TEST(test_rsa_and_p256_full_handshake_benchmark);
+  return UNITY_END();
+}
+
+#else
+
+void setUp() {}
+void tearDown() {}
+
+void test_needs_mbedtls() {
+  TEST_IGNORE_MESSAGE("No mbedtls 2.x on this host, see scripts/native_tls.py");
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_needs_mbedtls);
+  return UNITY_END();
+}
+
+#endif
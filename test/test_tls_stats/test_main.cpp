@@ -0,0 +1,68 @@
+#include <unity.h>
+#include "TlsStats.h"
+
+static TlsStats stats;
+
+void setUp() {
+  memset(&stats, 0, sizeof(stats));
+}
+
+void tearDown() {}
+
+void test_empty_stats_report_zero() {
+  TEST_ASSERT_EQUAL_UINT32(0, stats.averageFullMs());
+  TEST_ASSERT_EQUAL_UINT32(0, stats.averageResumedMs());
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.resumeRate());
+}
+
+void test_full_and_resumed_handshakes_are_counted_apart() {
+  stats.recordHandshake(false, false, 900, 800000);
+  stats.recordHandshake(false, false, 1100, 820000);
+  stats.recordHandshake(true, false, 60, 9000);
+  stats.recordHandshake(true, true, 40, 7000);
+
+  TEST_ASSERT_EQUAL_UINT32(4, stats.handshakes);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.fullHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.resumedHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(1000, stats.averageFullMs());
+  TEST_ASSERT_EQUAL_UINT32(50, stats.averageResumedMs());
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, stats.resumeRate());
+  TEST_ASSERT_EQUAL_UINT32(40, stats.lastHandshakeMs);
+}
+
+void test_ticket_counts_only_for_resumed_handshakes() {
+  stats.recordHandshake(true, true, 50, 5000);
+  stats.recordHandshake(false, true, 900, 800000);   // Ticket rejected, full handshake
+  TEST_ASSERT_EQUAL_UINT32(1, stats.ticketResumes);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.resumedHandshakes);
+}
+
+void test_failures_do_not_count_as_handshakes() {
+  stats.recordFailure();
+  stats.recordFailure();
+  TEST_ASSERT_EQUAL_UINT32(2, stats.failedHandshakes);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.handshakes);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.resumeRate());
+}
+
+// The handshake cost benchmark: CPU time inside the TLS library per kind
+void test_cpu_time_is_averaged_per_kind() {
+  stats.recordHandshake(false, false, 1200, 750000);
+  stats.recordHandshake(false, false, 1300, 850000);
+  stats.recordHandshake(true, false, 80, 12000);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 800.0f, stats.averageFullCpuMs());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 12.0f, stats.averageResumedCpuMs());
+  TEST_ASSERT_EQUAL_UINT32(12000, stats.lastHandshakeCpuUs);
+  TEST_ASSERT_EQUAL_UINT32(1600000, stats.fullHandshakeCpuUsTotal);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_stats_report_zero);
+  RUN_TEST(test_full_and_resumed_handshakes_are_counted_apart);
+  RUN_TEST(test_ticket_counts_only_for_resumed_handshakes);
+  RUN_TEST(test_failures_do_not_count_as_handshakes);
+  RUN_TEST(test_cpu_time_is_averaged_per_kind);
+  return UNITY_END();
+}
@@ -0,0 +1,140 @@
+#include <unity.h>
+#include <vector>
+#include "TrendEstimator.h"
+
+static TrendEstimator* trends;
+
+struct Reading {
+  unsigned long at;
+  float value;
+};
+
+// Least squares over the readings a 'windowMs' window still holds, in units per minute
+static float bruteForceSlope(const std::vector<Reading>& readings, unsigned long windowMs) {
+  unsigned long now = readings.back().at;
+  double n = 0, sumT = 0, sumV = 0, sumTT = 0, sumTV = 0;
+  int start = readings.size() > TREND_WINDOW_SAMPLES ? readings.size() - TREND_WINDOW_SAMPLES : 0;
+  for (size_t i = start; i < readings.size(); i++) {
+    if (now - readings[i].at > windowMs) continue;
+    double t = (readings[i].at - readings[start].at) / 1000.0;
+    n++;
+    sumT += t;
+    sumV += readings[i].value;
+    sumTT += t * t;
+    sumTV += t * readings[i].value;
+  }
+  return (n * sumTV - sumT * sumV) / (n * sumTT - sumT * sumT) * 60.0;
+}
+
+void setUp() {
+  trends = new TrendEstimator();
+  trends->configure(300);
+}
+
+void tearDown() {
+  delete trends;
+}
+
+// 300 s over 12 slots: readings less than 25 s apart are not stored
+void test_close_readings_are_skipped() {
+  TEST_ASSERT_TRUE(trends->add(SENSOR_PH, 0, 7.0, 0));
+  TEST_ASSERT_FALSE(trends->add(SENSOR_PH, 0, 7.0, 24999));
+  TEST_ASSERT_TRUE(trends->add(SENSOR_PH, 0, 7.0, 25000));
+  TEST_ASSERT_EQUAL_INT(2, trends->getSampleCount(SENSOR_PH, 0));
+  TEST_ASSERT_EQUAL_INT(0, trends->getSampleCount(SENSOR_PH, 1));
+  TEST_ASSERT_FALSE(trends->add(SENSOR_PH, MAX_CHANNELS_PER_TYPE, 7.0, 0));
+}
+
+void test_no_slope_until_enough_readings() {
+  float perMinute;
+  for (int i = 0; i < TREND_MIN_SAMPLES - 1; i++) {
+    trends->add(SENSOR_PH, 0, 7.0 + i, i * 30000UL);
+  }
+  TEST_ASSERT_FALSE(trends->getSlope(SENSOR_PH, 0, perMinute));
+  trends->add(SENSOR_PH, 0, 10.0, 90000);
+  TEST_ASSERT_TRUE(trends->getSlope(SENSOR_PH, 0, perMinute));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 2.0, perMinute);
+}
+
+// Four readings that only span a sixth of the window are not a trend
+void test_no_slope_over_a_short_span() {
+  trends->configure(1200);
+  float perMinute;
+  for (int i = 0; i < 5; i++) {
+    trends->add(SENSOR_TDS, 2, 500 + i, i * 50000UL);
+  }
+  TEST_ASSERT_FALSE(trends->getSlope(SENSOR_TDS, 2, perMinute));
+  trends->add(SENSOR_TDS, 2, 510, 300000);
+  TEST_ASSERT_TRUE(trends->getSlope(SENSOR_TDS, 2, perMinute));
+}
+
+void test_ramp_gives_its_slope() {
+  float perMinute;
+  for (int i = 0; i <= 20; i++) {
+    trends->add(SENSOR_TEMPERATURE, 3, 24.0 + 0.05 * i, i * 30000UL);   // 0.1 per minute
+  }
+  TEST_ASSERT_TRUE(trends->getSlope(SENSOR_TEMPERATURE, 3, perMinute));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.1, perMinute);
+  TEST_ASSERT_EQUAL_INT(11, trends->getSampleCount(SENSOR_TEMPERATURE, 3));   // 0..300 s old
+}
+
+// A gap longer than the window starts the trend again
+void test_gap_empties_the_window() {
+  float perMinute;
+  for (int i = 0; i < 8; i++) {
+    trends->add(SENSOR_PH, 0, 7.0 + 0.01 * i, i * 30000UL);
+  }
+  trends->add(SENSOR_PH, 0, 6.0, 7 * 30000UL + 301000);
+  TEST_ASSERT_EQUAL_INT(1, trends->getSampleCount(SENSOR_PH, 0));
+  TEST_ASSERT_FALSE(trends->getSlope(SENSOR_PH, 0, perMinute));
+}
+
+// Days of noisy readings with the ring rebasing as it goes: the running
+// sums still match a fit done from scratch over the window
+void test_running_sums_match_a_full_fit() {
+  srand(11);
+  std::vector<Reading> readings;
+  unsigned long now = 0;
+  float perMinute = 0;
+  for (int i = 0; i < 20000; i++) {
+    now += 25000 + rand() % 20000;
+    float value = 1000.0 + 50.0 * sin(now / 3.6e6) + (rand() % 100) / 10.0;
+    TEST_ASSERT_TRUE(trends->add(SENSOR_TDS, 0, value, now));
+    readings.push_back({ now, value });
+    if (i % 997 == 0 && trends->getSlope(SENSOR_TDS, 0, perMinute)) {
+      TEST_ASSERT_FLOAT_WITHIN(0.02, bruteForceSlope(readings, 300000), perMinute);
+    }
+  }
+  TEST_ASSERT_TRUE(trends->getSlope(SENSOR_TDS, 0, perMinute));
+  TEST_ASSERT_FLOAT_WITHIN(0.02, bruteForceSlope(readings, 300000), perMinute);
+}
+
+void test_reset_forgets_every_channel() {
+  for (int i = 0; i < 5; i++) {
+    trends->add(SENSOR_PH, 1, 7.0, i * 30000UL);
+  }
+  trends->reset();
+  TEST_ASSERT_EQUAL_INT(0, trends->getSampleCount(SENSOR_PH, 1));
+}
+
+void test_seconds_to_threshold() {
+  TEST_ASSERT_EQUAL_INT(600, TrendEstimator::secondsToThreshold(7.0, 0.1, 6.5, 8.0));
+  TEST_ASSERT_EQUAL_INT(300, TrendEstimator::secondsToThreshold(7.0, -0.1, 6.5, 8.0));
+  TEST_ASSERT_EQUAL_INT(0, TrendEstimator::secondsToThreshold(8.2, -0.1, 6.5, 8.0));
+  TEST_ASSERT_EQUAL_INT(-1, TrendEstimator::secondsToThreshold(7.0, 0.0, 6.5, 8.0));
+  // Ten weeks out is beyond TREND_MAX_PROJECTION_S
+  TEST_ASSERT_EQUAL_INT(-1, TrendEstimator::secondsToThreshold(7.0, 1.0 / 100800, 6.5, 8.0));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_close_readings_are_skipped);
+  RUN_TEST(test_no_slope_until_enough_readings);
+  RUN_TEST(test_no_slope_over_a_short_span);
+  RUN_TEST(test_ramp_gives_its_slope);
+  RUN_TEST(test_gap_empties_the_window);
+  RUN_TEST(test_running_sums_match_a_full_fit);
+  RUN_TEST(test_reset_forgets_every_channel);
+  RUN_TEST(test_seconds_to_threshold);
+  return UNITY_END();
+}